@@ -5,6 +5,7 @@ use std::sync::Arc;
 
 use libeir_intern::Symbol;
 
+use liblumen_core::atoms::AtomIndexBuilder;
 use liblumen_llvm as llvm;
 use liblumen_llvm::builder::ModuleBuilder;
 use liblumen_llvm::enums::Linkage;
@@ -14,16 +15,18 @@ use liblumen_session::{Input, Options, OutputType};
 use crate::meta::CompiledModule;
 use crate::Result;
 
-/// Generates an LLVM module containing the raw atom table data for the current build
+/// Generates an LLVM module containing the atom table image for the current build
 ///
-/// Process is as follows:
+/// The image is used in place by the runtime, so everything needed to look up atoms
+/// by id or by name is computed here, rather than at startup. Process is as follows:
 /// - Generate a constant for each atom string
-/// - Generate a constant array containing `ConstantAtom` structs for all atoms:
-///   - Has type `{ i64, i8* }`
-///   - First field is the id of the `Symbol`
-///   - Second field is the pointer to the string constant
-/// - Generate the __LUMEN_ATOM_TABLE global as a pointer to the first element of the array
-/// - Generate the __LUMEN_ATOM_TABLE_SIZE global with the number of elements in the array
+/// - Generate a constant array of `AtomName` structs, indexed by atom id:
+///   - Has type `{ i8*, usize }`
+///   - First field is the pointer to the string constant, or null if no atom has the id
+///   - Second field is the length of the string in bytes
+/// - Construct a minimal perfect hash over the atom strings, and generate constant arrays
+/// for its bucket displacements (`{ i32, i32 }`) and slots (the `i32` id in each slot)
+/// - Generate the __LUMEN_ATOM_INDEX global as an `AtomIndex` struct referencing the above
 pub fn generate(
     options: &Options,
     context: &llvm::Context,
@@ -44,7 +47,7 @@ pub fn generate(
     atoms.insert(Symbol::intern("normal"));
 
     fn insert_atom<'ctx>(builder: &ModuleBuilder<'ctx>, atom: Symbol) -> Result<llvm::Value> {
-        // We remap true/false to 1/0 respectively
+        // The atom id is its interned symbol id, and its index in the names table
         let id = atom.as_usize();
         // Each atom must be a null-terminated string
         let s = atom.as_str().get();
@@ -65,48 +68,101 @@ pub fn generate(
         values.push((atom, insert_atom(&builder, atom)?));
     }
 
-    // Generate constants array entries
     let i8_type = builder.get_i8_type();
     let i8ptr_type = builder.get_pointer_type(i8_type);
+    let i32_type = builder.get_i32_type();
     let i64_type = builder.get_i64_type();
-    let entry_type = builder.get_struct_type(Some("ConstantAtom"), &[i64_type, i8ptr_type]);
-
-    let mut entries = Vec::with_capacity(values.len());
+    let usize_type = builder.get_usize_type();
+
+    // Generate the dense array of names, indexed by id
+    let name_type = builder.get_struct_type(Some("AtomName"), &[i8ptr_type, usize_type]);
+    let names_len = values
+        .iter()
+        .map(|(sym, _)| sym.as_usize() + 1)
+        .max()
+        .unwrap_or(0);
+    let null_name = {
+        let value = builder.build_constant_null(i8ptr_type);
+        let len = builder.build_constant_uint(usize_type, 0);
+        builder.build_constant_struct(name_type, &[value, len])
+    };
+    let mut names = vec![null_name; names_len];
     for (sym, value) in values.iter() {
-        let id = builder.build_constant_uint(i64_type, sym.as_usize() as u64);
         let ptr = builder.build_const_inbounds_gep(*value, &[0, 0]);
-        entries.push(builder.build_constant_struct(entry_type, &[id, ptr]));
+        let len = builder.build_constant_uint(usize_type, sym.as_str().get().len() as u64);
+        names[sym.as_usize()] = builder.build_constant_struct(name_type, &[ptr, len]);
     }
+    let names_global = build_constant_table(
+        &builder,
+        name_type,
+        names.as_slice(),
+        "__LUMEN_ATOM_INDEX_NAMES",
+    );
+
+    // Generate the perfect hash from name to id
+    let hashed = values
+        .iter()
+        .map(|(sym, _)| (sym.as_usize(), sym.as_str().get()))
+        .collect::<Vec<_>>();
+    let index = AtomIndexBuilder::new(hashed.as_slice());
+
+    let displacement_type =
+        builder.get_struct_type(Some("AtomDisplacement"), &[i32_type, i32_type]);
+    let displacements = index
+        .displacements
+        .iter()
+        .map(|d| {
+            let d1 = builder.build_constant_uint(i32_type, d.d1 as u64);
+            let d2 = builder.build_constant_uint(i32_type, d.d2 as u64);
+            builder.build_constant_struct(displacement_type, &[d1, d2])
+        })
+        .collect::<Vec<_>>();
+    let displacements_global = build_constant_table(
+        &builder,
+        displacement_type,
+        displacements.as_slice(),
+        "__LUMEN_ATOM_INDEX_DISPLACEMENTS",
+    );
 
-    // Generate constants array
-    let entries_const_init = builder.build_constant_array(entry_type, entries.as_slice());
-    let entries_const_ty = builder.type_of(entries_const_init);
-    let entries_const = builder.build_constant(
-        entries_const_ty,
-        "__LUMEN_ATOM_TABLE_ENTRIES",
-        Some(entries_const_init),
+    let slots = index
+        .slots
+        .iter()
+        .map(|id| builder.build_constant_uint(i32_type, *id as u64))
+        .collect::<Vec<_>>();
+    let slots_global = build_constant_table(
+        &builder,
+        i32_type,
+        slots.as_slice(),
+        "__LUMEN_ATOM_INDEX_SLOTS",
     );
-    builder.set_linkage(entries_const, Linkage::Private);
-    builder.set_alignment(entries_const, 8);
-
-    // Generate atom table global itself
-    let entry_ptr_type = builder.get_pointer_type(entry_type);
-    let table_global_init = builder.build_const_inbounds_gep(entries_const, &[0, 0]);
-    let table_global = builder.build_global(
-        entry_ptr_type,
-        "__LUMEN_ATOM_TABLE",
-        Some(table_global_init),
+
+    // Generate the atom table image itself
+    let index_type = builder.get_struct_type(
+        Some("AtomIndex"),
+        &[
+            i64_type,
+            usize_type,
+            builder.get_pointer_type(name_type),
+            usize_type,
+            builder.get_pointer_type(displacement_type),
+            usize_type,
+            builder.get_pointer_type(i32_type),
+        ],
     );
-    builder.set_alignment(table_global, 8);
-
-    // Generate atom table size global
-    let table_size_global_init = builder.build_constant_uint(i64_type, entries.len() as u64);
-    let table_size_global = builder.build_global(
-        i64_type,
-        "__LUMEN_ATOM_TABLE_SIZE",
-        Some(table_size_global_init),
+    let index_init = builder.build_constant_struct(
+        index_type,
+        &[
+            builder.build_constant_uint(i64_type, index.seed),
+            builder.build_constant_uint(usize_type, names.len() as u64),
+            names_global,
+            builder.build_constant_uint(usize_type, displacements.len() as u64),
+            displacements_global,
+            builder.build_constant_uint(usize_type, slots.len() as u64),
+            slots_global,
+        ],
     );
-    builder.set_alignment(table_size_global, 8);
+    let index_global = builder.build_constant(index_type, "__LUMEN_ATOM_INDEX", Some(index_init));
+    builder.set_alignment(index_global, 8);
 
     // Finalize module
     let module = builder.finish()?;
@@ -147,3 +203,19 @@ pub fn generate(
         None,
     )))
 }
+
+/// Generates a private constant array from the given values, returning a pointer to its
+/// first element
+fn build_constant_table<'ctx>(
+    builder: &ModuleBuilder<'ctx>,
+    ty: llvm::Type,
+    values: &[llvm::Value],
+    name: &str,
+) -> llvm::Value {
+    let init = builder.build_constant_array(ty, values);
+    let init_ty = builder.type_of(init);
+    let table = builder.build_constant(init_ty, name, Some(init));
+    builder.set_linkage(table, Linkage::Private);
+    builder.set_alignment(table, 8);
+    builder.build_const_inbounds_gep(table, &[0, 0])
+}
@@ -7,7 +7,7 @@ use std::sync::Arc;
 use libeir_intern::{Ident, Symbol};
 use libeir_ir::FunctionIdent;
 
-use liblumen_core::symbols::FunctionSymbol;
+use liblumen_core::symbols::{FunctionSymbol, ModuleSymbols};
 use liblumen_llvm as llvm;
 use liblumen_llvm::builder::ModuleBuilder;
 use liblumen_llvm::enums::{Linkage, ThreadLocalMode};
@@ -22,8 +22,13 @@ use crate::Result;
 /// This is similar to the atom table generation, but simpler, in that we just generate
 /// a large list of `FunctionSybmol` structs, which reference extern declarations of all
 /// the functions defined by the build. At link time these will be resolved to pointers
-/// to the actual functions, and when we boot the runtime, we can reify this array into
-/// a more efficient search structure for dispatch.
+/// to the actual functions.
+///
+/// Since atom ids are fixed at compile time, the list is sorted by module, function and
+/// arity, and is accompanied by an index of `ModuleSymbols` structs, which records the
+/// range of the list occupied by each module. Together these form the search structure
+/// used for dynamic dispatch, so the runtime uses them in place rather than building
+/// one of its own at startup.
 pub fn generate(
     options: &Options,
     context: &llvm::Context,
@@ -59,6 +64,23 @@ pub fn generate(
         &[usize_type, usize_type, i8_type, fn_ptr_type],
     );
 
+    // The runtime binary searches this table, so the order here must match
+    // `compare_symbols` in `liblumen_alloc::erts::apply`
+    let mut symbols = symbols.into_iter().collect::<Vec<_>>();
+    symbols.sort_unstable_by_key(|symbol| (symbol.module, symbol.function, symbol.arity));
+
+    let mut modules: Vec<ModuleSymbols> = Vec::new();
+    for (offset, symbol) in symbols.iter().enumerate() {
+        match modules.last_mut() {
+            Some(entry) if entry.module == symbol.module => entry.len += 1,
+            _ => modules.push(ModuleSymbols {
+                module: symbol.module,
+                offset,
+                len: 1,
+            }),
+        }
+    }
+
     // Build values for array
     let mut functions = Vec::with_capacity(symbols.len());
     for symbol in symbols.iter() {
@@ -102,6 +124,46 @@ pub fn generate(
     );
     builder.set_alignment(table_size_global, 8);
 
+    // Generate the module index
+    let module_symbols_type =
+        builder.get_struct_type(Some("ModuleSymbols"), &[usize_type, usize_type, usize_type]);
+    let mut module_entries = Vec::with_capacity(modules.len());
+    for entry in modules.iter() {
+        let module = builder.build_constant_uint(usize_type, entry.module as u64);
+        let offset = builder.build_constant_uint(usize_type, entry.offset as u64);
+        let len = builder.build_constant_uint(usize_type, entry.len as u64);
+        module_entries
+            .push(builder.build_constant_struct(module_symbols_type, &[module, offset, len]));
+    }
+
+    let modules_const_init =
+        builder.build_constant_array(module_symbols_type, module_entries.as_slice());
+    let modules_const_ty = builder.type_of(modules_const_init);
+    let modules_const = builder.build_constant(
+        modules_const_ty,
+        "__LUMEN_SYMBOL_MODULES_ENTRIES",
+        Some(modules_const_init),
+    );
+    builder.set_linkage(modules_const, Linkage::Private);
+    builder.set_alignment(modules_const, 8);
+
+    let module_symbols_ptr_type = builder.get_pointer_type(module_symbols_type);
+    let modules_global_init = builder.build_const_inbounds_gep(modules_const, &[0, 0]);
+    let modules_global = builder.build_global(
+        module_symbols_ptr_type,
+        "__LUMEN_SYMBOL_MODULES",
+        Some(modules_global_init),
+    );
+    builder.set_alignment(modules_global, 8);
+
+    let modules_size_global_init = builder.build_constant_uint(usize_type, modules.len() as u64);
+    let modules_size_global = builder.build_global(
+        usize_type,
+        "__LUMEN_SYMBOL_MODULES_SIZE",
+        Some(modules_size_global_init),
+    );
+    builder.set_alignment(modules_size_global, 8);
+
     // Generate thread local variable for current reduction count
     let i32_type = builder.get_i32_type();
     let reduction_count_init = builder.build_constant_uint(i32_type, 0);
@@ -122,6 +184,20 @@ pub fn generate(
     builder.set_linkage(process_signal_global, Linkage::External);
     builder.set_alignment(process_signal_global, 8);
 
+    // Generate thread local variable for the bump-allocation bounds of the
+    // current process heap, this is set by the scheduler when swapping in a
+    // process, and is read by generated code for inline heap allocation
+    let i8ptrptr_type = builder.get_pointer_type(builder.get_pointer_type(i8_type));
+    let process_heap_init = builder.build_constant_null(i8ptrptr_type);
+    let process_heap_global = builder.build_global(
+        i8ptrptr_type,
+        "__lumen_process_heap",
+        Some(process_heap_init),
+    );
+    builder.set_thread_local_mode(process_heap_global, ThreadLocalMode::LocalExec);
+    builder.set_linkage(process_heap_global, Linkage::External);
+    builder.set_alignment(process_heap_global, 8);
+
     // We have to build a shim for the Rust libstd `lang_start_internal`
     // function to start the Rust runtime. Since that symbol is internal,
     // we locate the mangled symbol name at build time and build a shim
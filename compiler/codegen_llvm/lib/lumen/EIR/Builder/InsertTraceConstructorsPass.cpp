@@ -18,6 +18,9 @@ using ::mlir::OpOperand;
 using ::mlir::PassWrapper;
 using ::mlir::Value;
 
+using ::llvm::SmallPtrSet;
+using ::llvm::SmallPtrSetImpl;
+using ::llvm::SmallVector;
 using ::llvm::cast;
 using ::llvm::dyn_cast_or_null;
 using ::llvm::isa;
@@ -27,6 +30,7 @@ namespace {
 using namespace ::lumen::eir;
 
 void forAllTraceUses(OpBuilder &, Location, Value, Value, unsigned);
+bool isTraceUnused(Value, SmallPtrSetImpl<Value> &);
 
 struct InsertTraceConstructorsPass
     : public PassWrapper<InsertTraceConstructorsPass, OperationPass<FuncOp>> {
@@ -44,11 +48,70 @@ struct InsertTraceConstructorsPass
             Value trace = landingPad.trace();
             forAllTraceUses(builder, landingPad.getLoc(), trace, Value(), 0);
         });
+        // Exceptions caught in the function that raised them are passed to
+        // the catch block with the trace reference they captured, rather
+        // than through a landing pad
+        SmallVector<TraceCaptureOp, 2> captures;
+        op.walk([&](TraceCaptureOp capture) { captures.push_back(capture); });
+        for (TraceCaptureOp capture : captures) {
+            Value trace = capture.capture();
+            // Most catch blocks never look at the trace, if that is the case
+            // for every block this trace can reach, the capture is elided, and
+            // a null reference is passed along in its place
+            SmallPtrSet<Value, 4> visited;
+            if (isTraceUnused(trace, visited)) {
+                builder.setInsertionPoint(capture);
+                auto null = builder.create<NullOp>(capture.getLoc(),
+                                                   trace.getType());
+                trace.replaceAllUsesWith(null.getResult());
+                capture.erase();
+                continue;
+            }
+            forAllTraceUses(builder, capture.getLoc(), trace, Value(), 0);
+        }
+        // The same goes for traces re-raised by `erlang:raise/3`
+        op.walk([&](TraceFromTermOp conversion) {
+            Value trace = conversion.traceRef();
+            forAllTraceUses(builder, conversion.getLoc(), trace, Value(), 0);
+        });
 
         return;
     }
 };
 
+// Returns true if the given trace reference is only ever passed along to
+// blocks which do not use it, i.e. it is never thrown, printed or constructed
+bool isTraceUnused(Value trace, SmallPtrSetImpl<Value> &visited) {
+    // Blocks can pass the trace back around a loop, which tells us nothing new
+    if (!visited.insert(trace).second) return true;
+
+    for (OpOperand &use : trace.getUses()) {
+        Operation *user = use.getOwner();
+        auto index = use.getOperandNumber();
+        BlockArgument arg;
+        if (auto brOp = dyn_cast_or_null<BranchOp>(user)) {
+            arg = brOp.getDest()->getArgument(index);
+        } else if (auto condbrOp = dyn_cast_or_null<CondBranchOp>(user)) {
+            // The first operand is the condition
+            if (index == 0) return false;
+            index -= 1;
+            auto numTrueOperands = condbrOp.getNumTrueOperands();
+            if (index >= numTrueOperands) {
+                arg = condbrOp.getFalseDest()->getArgument(index -
+                                                           numTrueOperands);
+            } else {
+                arg = condbrOp.getTrueDest()->getArgument(index);
+            }
+        } else {
+            return false;
+        }
+
+        if (!isTraceUnused(arg, visited)) return false;
+    }
+
+    return true;
+}
+
 void forAllTraceUses(OpBuilder &builder, Location loc, Value root,
                      Value traceTerm, unsigned depth) {
     for (OpOperand &use : root.getUses()) {
@@ -66,9 +129,10 @@ void forAllTraceUses(OpBuilder &builder, Location loc, Value root,
             forAllTraceUses(builder, loc, arg, traceTerm, depth + 1);
             continue;
         } else if (auto condbrOp = dyn_cast_or_null<CondBranchOp>(user)) {
-            auto index = use.getOperandNumber();
+            // The first operand is the condition
+            auto index = use.getOperandNumber() - 1;
             auto numTrueOperands = condbrOp.getNumTrueOperands();
-            if (index > numTrueOperands) {
+            if (index >= numTrueOperands) {
                 auto successor = condbrOp.getFalseDest();
                 BlockArgument arg =
                     successor->getArgument(index - numTrueOperands);
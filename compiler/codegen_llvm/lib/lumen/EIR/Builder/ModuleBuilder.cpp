@@ -1120,6 +1120,10 @@ static Optional<Value> buildIntrinsicRaiseOp(ModuleBuilder *modBuilder,
     Value kind = args[0];
     Value reason = args[1];
     Value trace = args[2];
+    // The trace is a reference when re-raising from a catch block, otherwise
+    // it is a stack trace term which needs to be converted to a reference
+    if (!trace.getType().isa<TraceRefType>())
+        trace = builder.create<TraceFromTermOp>(loc, trace);
     builder.create<ThrowOp>(loc, kind, reason, trace);
 
     return llvm::None;
@@ -1278,7 +1282,8 @@ extern "C" void MLIRBuildStaticCall(MLIRModuleBuilderRef b,
 
 bool ModuleBuilder::maybe_build_intrinsic(Location loc, StringRef target,
                                           ArrayRef<Value> args, bool isTail,
-                                          Block *ok, ArrayRef<Value> okArgs) {
+                                          Block *ok, ArrayRef<Value> okArgs,
+                                          Block *err) {
     // If this is a call to an intrinsic, lower accordingly
     auto buildIntrinsicFnOpt = getIntrinsicBuilder(target);
 
@@ -1294,7 +1299,12 @@ bool ModuleBuilder::maybe_build_intrinsic(Location loc, StringRef target,
                        .Case("erlang:raise/3", true)
                        .Default(false);
 
-    if (isThrow) return true;
+    if (isThrow) {
+        // If the exception is caught in this function, there is no need to
+        // unwind to the catch block, we can branch to it directly
+        if (err) build_local_catch(loc, err);
+        return true;
+    }
 
     auto termTy = builder.getType<TermType>();
     // Tail calls directly return to caller
@@ -1334,7 +1344,8 @@ void ModuleBuilder::build_static_invoke(Location loc, StringRef target,
                                         Block *err, ArrayRef<Value> errArgs) {
     ScopedContext scope(builder, loc);
 
-    if (maybe_build_intrinsic(loc, target, args, isTail, ok, okArgs)) return;
+    if (maybe_build_intrinsic(loc, target, args, isTail, ok, okArgs, err))
+        return;
 
     auto termType = builder.getType<TermType>();
 
@@ -1382,6 +1393,42 @@ void ModuleBuilder::build_static_invoke(Location loc, StringRef target,
     }
 }
 
+/// Replaces the throw just built by an intrinsic with a branch to the block
+/// which catches it, carrying the same `{class, reason, trace}` values the
+/// landing pad of the block would produce.
+///
+/// Throws which escape this function still unwind. The trace of every throw
+/// is a reference, as `erlang:raise/3` converts a trace given as a term, so
+/// the catch block receives it the same way whether it was captured here or
+/// re-raised.
+void ModuleBuilder::build_local_catch(Location loc, Block *err) {
+    Block *block = builder.getInsertionBlock();
+    assert(!block->empty() && "expected intrinsic to have built a throw");
+    auto throwOp = cast<ThrowOp>(&block->back());
+
+    Type traceTy = TraceRefType::get(builder.getContext());
+    assert(throwOp.trace().getType() == traceTy &&
+           "expected throw to carry a trace reference");
+
+    err->getArgument(2).setType(traceTy);
+
+    // Cast the exception values as necessary
+    SmallVector<Value, 3> errArgs;
+    for (auto it : llvm::zip(throwOp.getOperands(), err->getArguments())) {
+        Value arg = std::get<0>(it);
+        Type expectedType = std::get<1>(it).getType();
+        if (arg.getType() != expectedType) {
+            auto castOp = builder.create<CastOp>(loc, arg, expectedType);
+            errArgs.push_back(castOp.getResult());
+        } else {
+            errArgs.push_back(arg);
+        }
+    }
+
+    throwOp.erase();
+    eir_br(err, errArgs);
+}
+
 void ModuleBuilder::build_static_call(Location loc, StringRef target,
                                       ArrayRef<Value> args, bool isTail,
                                       Block *cont, ArrayRef<Value> contArgs) {
@@ -69,7 +69,8 @@ class ModuleBuilder {
 
     bool maybe_build_intrinsic(Location loc, StringRef target,
                                ArrayRef<Value> args, bool isTail, Block *ok,
-                               ArrayRef<Value> okArgs);
+                               ArrayRef<Value> okArgs, Block *err = nullptr);
+    void build_local_catch(Location loc, Block *err);
     void build_static_invoke(Location loc, StringRef target,
                              ArrayRef<Value> args, bool isTail, Block *ok,
                              ArrayRef<Value> okArgs, Block *err,
@@ -0,0 +1,119 @@
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Dominance.h"
+
+#include "lumen/EIR/Builder/Passes.h"
+#include "lumen/EIR/IR/EIRDialect.h"
+#include "lumen/EIR/IR/EIROps.h"
+#include "lumen/EIR/IR/EIRTypes.h"
+
+using ::mlir::Block;
+using ::mlir::DialectRegistry;
+using ::mlir::DominanceInfo;
+using ::mlir::OpBuilder;
+using ::mlir::OpOperand;
+using ::mlir::Operation;
+using ::mlir::OperationPass;
+using ::mlir::PassWrapper;
+using ::mlir::Value;
+
+using ::llvm::dyn_cast_or_null;
+using ::llvm::SmallVector;
+
+namespace {
+
+using namespace ::lumen::eir;
+
+/// Resolves type checks whose outcome is implied by a dominating branch on an
+/// identical check, e.g. in the following, the second check is always true:
+///
+///     %0 = eir.typeof %x is !eir.tuple<2>
+///     eir.cond_br %0, ^bb1, ^bb2
+///   ^bb1:
+///     %1 = eir.typeof %x is !eir.tuple<2>
+///
+/// CSE runs first, and will already have replaced `%1` with `%0`, so uses of
+/// the dominating check within `^bb1` are resolved as well as any identical
+/// checks which remain.
+struct SimplifyTypeChecksPass
+    : public PassWrapper<SimplifyTypeChecksPass, OperationPass<FuncOp>> {
+    void getDependentDialects(DialectRegistry &registry) const override {
+        registry.insert<mlir::StandardOpsDialect, mlir::LLVM::LLVMDialect,
+                        lumen::eir::eirDialect>();
+    }
+
+    void runOnOperation() override {
+        FuncOp op = getOperation();
+        if (op.isExternal()) return;
+
+        auto &domInfo = getAnalysis<DominanceInfo>();
+
+        // Checks are erased as we go, so gather the branches up front
+        SmallVector<CondBranchOp, 8> branches;
+        op.walk([&](CondBranchOp condbr) { branches.push_back(condbr); });
+
+        for (auto condbr : branches) {
+            Operation *condOp = condbr.condition().getDefiningOp();
+            auto check = dyn_cast_or_null<IsTypeOp>(condOp);
+            if (!check) continue;
+
+            Block *trueDest = condbr.getTrueDest();
+            Block *falseDest = condbr.getFalseDest();
+            if (trueDest == falseDest) continue;
+
+            Block *branchBlock = condbr.getOperation()->getBlock();
+            simplifyDominatedChecks(domInfo, check, branchBlock, trueDest,
+                                    /*isMatch=*/true);
+            simplifyDominatedChecks(domInfo, check, branchBlock, falseDest,
+                                    /*isMatch=*/false);
+        }
+    }
+
+    void simplifyDominatedChecks(DominanceInfo &domInfo, IsTypeOp check,
+                                 Block *branchBlock, Block *dest,
+                                 bool isMatch) {
+        // The outcome is only known if the destination is reachable solely
+        // through this edge
+        if (dest->getSinglePredecessor() != branchBlock) return;
+
+        Value value = check.value();
+        auto matchType = check.getMatchType();
+
+        SmallVector<OpOperand *, 4> uses;
+        for (OpOperand &use : check.getResult().getUses()) {
+            if (domInfo.dominates(dest, use.getOwner()->getBlock()))
+                uses.push_back(&use);
+        }
+
+        SmallVector<IsTypeOp, 4> redundant;
+        for (Operation *user : value.getUsers()) {
+            auto other = dyn_cast_or_null<IsTypeOp>(user);
+            if (!other || other == check) continue;
+            if (other.getMatchType() != matchType) continue;
+            if (!domInfo.dominates(dest, other.getOperation()->getBlock()))
+                continue;
+            redundant.push_back(other);
+        }
+
+        if (uses.empty() && redundant.empty()) return;
+
+        OpBuilder builder(dest, dest->begin());
+        auto i1Ty = builder.getI1Type();
+        Value result =
+            builder.create<ConstantBoolOp>(check.getLoc(), i1Ty, isMatch);
+        for (OpOperand *use : uses) use->set(result);
+        for (auto other : redundant) {
+            other.replaceAllUsesWith(result);
+            other.erase();
+        }
+    }
+};
+}  // namespace
+
+namespace lumen {
+namespace eir {
+std::unique_ptr<mlir::Pass> createSimplifyTypeChecksPass() {
+    return std::make_unique<SimplifyTypeChecksPass>();
+}
+}  // namespace eir
+}  // namespace lumen
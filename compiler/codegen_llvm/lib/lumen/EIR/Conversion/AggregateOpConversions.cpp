@@ -3,8 +3,24 @@
 namespace lumen {
 namespace eir {
 
-struct ConsOpConversion : public EIROpConversion<ConsOp> {
-    using EIROpConversion::EIROpConversion;
+// Writes a cons cell to the memory pointed to by `cellPtr`
+static void storeConsCell(OpConversionContext &ctx, Value cellPtr, Value head,
+                          Value tail) {
+    auto termPtrTy = ctx.getUsizeType().getPointerTo();
+    auto i32Ty = ctx.getI32Type();
+
+    Value zero = llvm_constant(i32Ty, ctx.getI32Attr(0));
+    Value one = llvm_constant(i32Ty, ctx.getI32Attr(1));
+    ArrayRef<Value> headIndices{zero, zero};
+    Value headPtr = llvm_gep(termPtrTy, cellPtr, headIndices);
+    llvm_store(head, headPtr);
+    ArrayRef<Value> tailIndices{zero, one};
+    Value tailPtr = llvm_gep(termPtrTy, cellPtr, tailIndices);
+    llvm_store(tail, tailPtr);
+}
+
+struct ConsOpConversion : public EIRHeapAllocOpConversion<ConsOp> {
+    using EIRHeapAllocOpConversion::EIRHeapAllocOpConversion;
 
     LogicalResult matchAndRewrite(
         ConsOp op, ArrayRef<Value> operands,
@@ -12,30 +28,15 @@ struct ConsOpConversion : public EIROpConversion<ConsOp> {
         auto ctx = getRewriteContext(op, rewriter);
         ConsOpAdaptor adaptor(operands);
 
-        auto termTy = ctx.getUsizeType();
-        auto termPtrTy = termTy.getPointerTo();
-        auto i32Ty = ctx.getI32Type();
         auto consTy = ctx.targetInfo.getConsType();
 
         auto head = adaptor.head();
         auto tail = adaptor.tail();
 
-        // Allocate header on heap, write values to header, then box
-        OpaqueTermType kind = rewriter.getType<ConsType>();
-        Value zero = llvm_constant(i32Ty, ctx.getI32Attr(0));
-        Value one = llvm_constant(i32Ty, ctx.getI32Attr(1));
-        Value arity = llvm_zext(termTy, zero);
-        // TODO(pauls): We should optimize this for allocating multiple
-        // cells by providing an optional pointer and index at which to
-        // allocate this cell, by offsetting the pointer by `index *
-        // sizeof(cell)` and then storing directly into that memory
-        Value cellPtr = ctx.buildMalloc(consTy, TypeKind::Cons, arity);
-        ArrayRef<Value> headIndices{zero, zero};
-        Value headPtr = llvm_gep(termPtrTy, cellPtr, headIndices);
-        llvm_store(head, headPtr);
-        ArrayRef<Value> tailIndices{zero, one};
-        Value tailPtr = llvm_gep(termPtrTy, cellPtr, tailIndices);
-        llvm_store(tail, tailPtr);
+        // Allocate cell on heap, write values to cell, then box
+        auto size = plan.getAllocationSize(op).getValue();
+        Value cellPtr = allocate(ctx, consTy, size);
+        storeConsCell(ctx, cellPtr, head, tail);
 
         auto boxed = ctx.encodeList(cellPtr);
         rewriter.replaceOp(op, boxed);
@@ -43,8 +44,8 @@ struct ConsOpConversion : public EIROpConversion<ConsOp> {
     }
 };
 
-struct ListOpConversion : public EIROpConversion<ListOp> {
-    using EIROpConversion::EIROpConversion;
+struct ListOpConversion : public EIRHeapAllocOpConversion<ListOp> {
+    using EIRHeapAllocOpConversion::EIRHeapAllocOpConversion;
 
     LogicalResult matchAndRewrite(
         ListOp op, ArrayRef<Value> operands,
@@ -61,27 +62,38 @@ struct ListOpConversion : public EIROpConversion<ListOp> {
             return success();
         }
 
-        // Lower to single cons cell if it fits
+        auto termTy = ctx.getUsizeType();
+        auto consTy = ctx.targetInfo.getConsType();
+        auto consPtrTy = consTy.getPointerTo();
+
+        // A single element is lowered to a single proper cell, otherwise the
+        // last element is used as the tail of the list
+        Value last;
+        unsigned cellsRequired;
         if (numElements < 2) {
-            Value head = elements.front();
-            Value list = eir_cons(head, eir_nil());
-            rewriter.replaceOp(op, list);
-            return success();
+            last = eir_nil();
+            cellsRequired = 1;
+        } else {
+            last = elements.back();
+            cellsRequired = numElements - 1;
         }
 
-        unsigned cellsRequired = numElements;
-        unsigned currentIndex = numElements;
+        // Allocate all of the cells at once, as an array of cells, then write
+        // each cell so that it points to the one following it
+        auto size = plan.getAllocationSize(op).getValue();
+        auto cellsTy = LLVMType::getArrayTy(consTy, cellsRequired);
+        Value cells = allocate(ctx, cellsTy, size);
 
+        Value zero = llvm_constant(termTy, ctx.getIntegerAttr(0));
+        Value tail = last;
         Value list;
-        while (currentIndex > 0) {
-            if (!list) {
-                Value tail = elements[--currentIndex];
-                Value head = elements[--currentIndex];
-                list = eir_cons(head, tail);
-            } else {
-                Value head = elements[--currentIndex];
-                list = eir_cons(head, list);
-            }
+        for (unsigned i = cellsRequired; i > 0; i--) {
+            Value idx = llvm_constant(termTy, ctx.getIntegerAttr(i - 1));
+            Value cellPtr =
+                llvm_gep(consPtrTy, cells, ArrayRef<Value>{zero, idx});
+            storeConsCell(ctx, cellPtr, elements[i - 1], tail);
+            list = ctx.encodeList(cellPtr);
+            tail = list;
         }
 
         rewriter.replaceOp(op, list);
@@ -89,8 +101,8 @@ struct ListOpConversion : public EIROpConversion<ListOp> {
     }
 };
 
-struct TupleOpConversion : public EIROpConversion<TupleOp> {
-    using EIROpConversion::EIROpConversion;
+struct TupleOpConversion : public EIRHeapAllocOpConversion<TupleOp> {
+    using EIRHeapAllocOpConversion::EIRHeapAllocOpConversion;
 
     LogicalResult matchAndRewrite(
         TupleOp op, ArrayRef<Value> operands,
@@ -106,8 +118,8 @@ struct TupleOpConversion : public EIROpConversion<TupleOp> {
         auto tupleTy = ctx.getTupleType(numElements);
 
         // Allocate header on heap, write values to header, then box
-        Value arity = llvm_constant(termTy, ctx.getIntegerAttr(numElements));
-        Value ptr = ctx.buildMalloc(tupleTy, TypeKind::Tuple, arity);
+        auto size = plan.getAllocationSize(op).getValue();
+        Value ptr = allocate(ctx, tupleTy, size);
 
         Value zero = llvm_constant(i32Ty, ctx.getI32Attr(0));
         auto headerRaw =
@@ -136,9 +148,10 @@ struct TupleOpConversion : public EIROpConversion<TupleOp> {
 void populateAggregateOpConversionPatterns(OwningRewritePatternList &patterns,
                                            MLIRContext *context,
                                            EirTypeConverter &converter,
-                                           TargetInfo &targetInfo) {
+                                           TargetInfo &targetInfo,
+                                           HeapAllocationPlan &heapPlan) {
     patterns.insert<ConsOpConversion, ListOpConversion, TupleOpConversion>(
-        context, converter, targetInfo);
+        context, converter, targetInfo, heapPlan);
 }
 
 }  // namespace eir
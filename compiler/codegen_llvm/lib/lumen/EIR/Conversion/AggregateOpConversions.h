@@ -2,6 +2,7 @@
 #define LUMEN_EIR_CONVERSION_AGGREGATE_OP_CONVERSION
 
 #include "lumen/EIR/Conversion/ConversionSupport.h"
+#include "lumen/EIR/Conversion/HeapAllocation.h"
 
 namespace lumen {
 namespace eir {
@@ -12,7 +13,8 @@ class TupleOpConversion;
 void populateAggregateOpConversionPatterns(OwningRewritePatternList &patterns,
                                            MLIRContext *context,
                                            EirTypeConverter &converter,
-                                           TargetInfo &targetInfo);
+                                           TargetInfo &targetInfo,
+                                           HeapAllocationPlan &heapPlan);
 }  // namespace eir
 }  // namespace lumen
 
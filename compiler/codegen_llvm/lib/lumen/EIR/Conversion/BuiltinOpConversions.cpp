@@ -11,17 +11,18 @@ struct IncrementReductionsOpConversion
         IncrementReductionsOp op, ArrayRef<Value> operands,
         ConversionPatternRewriter &rewriter) const override {
         auto ctx = getRewriteContext(op, rewriter);
-        ModuleOp mod = ctx.getModule();
 
         auto i32Ty = ctx.getI32Type();
 
-        auto reductionCount = ctx.getOrInsertGlobal(
+        auto reductionCountGlobal = ctx.getOrInsertGlobal(
             "CURRENT_REDUCTION_COUNT", i32Ty, nullptr, LLVM::Linkage::External,
             LLVM::ThreadLocalMode::LocalExec);
 
+        // The count is thread-local, and only ever read by the scheduler on
+        // the same thread, so there is no need for an atomic update
         Value increment = llvm_constant(i32Ty, ctx.getI32Attr(op.increment()));
-        llvm_atomicrmw(i32Ty, LLVM::AtomicBinOp::add, reductionCount, increment,
-                       LLVM::AtomicOrdering::monotonic);
+        Value reductionCount = llvm_load(reductionCountGlobal);
+        llvm_store(llvm_add(reductionCount, increment), reductionCountGlobal);
         rewriter.eraseOp(op);
         return success();
     }
@@ -51,20 +52,7 @@ struct IsTypeOpConversion : public EIROpConversion<IsTypeOp> {
                 boxedType = matchType;
             }
 
-            // Lists have a unique pointer tag, so we can avoid the function
-            // call
-            if (boxedType.isa<ConsType>()) {
-                Value listTag = llvm_constant(
-                    termTy, ctx.getIntegerAttr(ctx.targetInfo.listTag()));
-                Value listMask = llvm_constant(
-                    termTy, ctx.getIntegerAttr(ctx.targetInfo.listMask()));
-                Value masked = llvm_and(adaptor.value(), listMask);
-                rewriter.replaceOpWithNewOp<LLVM::ICmpOp>(
-                    op, LLVM::ICmpPredicate::eq, listTag, masked);
-                return success();
-            }
-
-            // For tuples we have a dedicated op
+            // For tuples with a known arity we have a dedicated op
             if (auto tupleType = boxedType.dyn_cast_or_null<eir::TupleType>()) {
                 if (tupleType.hasStaticShape()) {
                     Value arity = llvm_constant(
@@ -72,10 +60,6 @@ struct IsTypeOpConversion : public EIROpConversion<IsTypeOp> {
                     rewriter.replaceOpWithNewOp<IsTupleOp>(op, adaptor.value(),
                                                            arity);
                     return success();
-                } else {
-                    rewriter.replaceOpWithNewOp<IsTupleOp>(op, adaptor.value(),
-                                                           llvm::None);
-                    return success();
                 }
             }
 
@@ -86,15 +70,18 @@ struct IsTypeOpConversion : public EIROpConversion<IsTypeOp> {
                 return success();
             }
 
-            StringRef symbolName("__lumen_builtin_is_boxed_type");
-            // If we're matching floats but the target doesn't use boxed floats,
-            // use the correct type check function
-            if (boxedType.isa<FloatType>() &&
-                !ctx.targetInfo.requiresPackedFloats())
-                symbolName = StringRef("__lumen_builtin_is_type");
-
-            // For all other boxed types, the check is performed via builtin
+            // All other boxed types are checked inline against the header,
+            // lists and unboxed floats are checked against the value itself
             auto matchKind = boxedType.getTypeKind().getValue();
+            Value isType = ctx.buildTypeCheck(adaptor.value(), matchKind,
+                                              /*boxedOnly=*/true);
+            if (isType) {
+                rewriter.replaceOp(op, isType);
+                return success();
+            }
+
+            // Otherwise, the check is performed via builtin
+            StringRef symbolName("__lumen_builtin_is_boxed_type");
             Value matchConst =
                 llvm_constant(int32Ty, ctx.getI32Attr(matchKind));
             auto callee =
@@ -102,27 +89,31 @@ struct IsTypeOpConversion : public EIROpConversion<IsTypeOp> {
             Value input = adaptor.value();
             auto calleeSymbol =
                 FlatSymbolRefAttr::get(symbolName, callee->getContext());
-            Operation *isType =
+            Operation *isTypeCall =
                 std_call(calleeSymbol, int1Ty, ValueRange{matchConst, input});
-            rewriter.replaceOp(op, isType->getResults());
+            rewriter.replaceOp(op, isTypeCall->getResults());
             return success();
         }
 
-        // For immediates, the check is performed via builtin
-        //
-        // TODO: With some additional foundation-laying, we could lower
-        // these checks to precise bit masking/shift operations, rather
-        // than a function call
+        // Immediates are checked inline via the tag tests of the encoding,
+        // only polymorphic types (e.g. term) need to go through the builtin
         auto matchKind = matchType.getTypeKind().getValue();
+        Value isType = ctx.buildTypeCheck(adaptor.value(), matchKind,
+                                          /*boxedOnly=*/false);
+        if (isType) {
+            rewriter.replaceOp(op, isType);
+            return success();
+        }
+
         Value matchConst = llvm_constant(int32Ty, ctx.getI32Attr(matchKind));
         StringRef symbolName("__lumen_builtin_is_type");
         auto callee =
             ctx.getOrInsertFunction(symbolName, int1Ty, {int32Ty, termTy});
         auto calleeSymbol =
             FlatSymbolRefAttr::get(symbolName, callee->getContext());
-        Operation *isType = std_call(calleeSymbol, int1Ty,
-                                     ValueRange{matchConst, adaptor.value()});
-        rewriter.replaceOp(op, isType->getResults());
+        Operation *isTypeCall = std_call(
+            calleeSymbol, int1Ty, ValueRange{matchConst, adaptor.value()});
+        rewriter.replaceOp(op, isTypeCall->getResults());
         return success();
     }
 };
@@ -155,7 +146,14 @@ struct IsTupleOpConversion : public EIROpConversion<IsTupleOp> {
             return success();
         }
 
-        // Otherwise we fall back to the generic boxed type builtin
+        // Otherwise only the header needs to be checked
+        Value isType =
+            ctx.buildTypeCheck(input, TypeKind::Tuple, /*boxedOnly=*/true);
+        if (isType) {
+            rewriter.replaceOp(op, isType);
+            return success();
+        }
+
         Value matchConst =
             llvm_constant(int32Ty, ctx.getI32Attr(TypeKind::Tuple));
         StringRef symbolName("__lumen_builtin_is_boxed_type");
@@ -163,9 +161,9 @@ struct IsTupleOpConversion : public EIROpConversion<IsTupleOp> {
             ctx.getOrInsertFunction(symbolName, int1Ty, {int32Ty, termTy});
         auto calleeSymbol =
             FlatSymbolRefAttr::get(symbolName, callee->getContext());
-        Operation *isType =
+        Operation *isTypeCall =
             std_call(calleeSymbol, int1Ty, ValueRange{matchConst, input});
-        rewriter.replaceOp(op, isType->getResults());
+        rewriter.replaceOp(op, isTypeCall->getResults());
         return success();
     }
 };
@@ -198,7 +196,14 @@ struct IsFunctionOpConversion : public EIROpConversion<IsFunctionOp> {
             return success();
         }
 
-        // Otherwise we fall back to the generic boxed type builtin
+        // Otherwise only the header needs to be checked
+        Value isType =
+            ctx.buildTypeCheck(input, TypeKind::Closure, /*boxedOnly=*/true);
+        if (isType) {
+            rewriter.replaceOp(op, isType);
+            return success();
+        }
+
         Value matchConst =
             llvm_constant(int32Ty, ctx.getI32Attr(TypeKind::Closure));
         StringRef symbolName("__lumen_builtin_is_boxed_type");
@@ -206,9 +211,9 @@ struct IsFunctionOpConversion : public EIROpConversion<IsFunctionOp> {
             ctx.getOrInsertFunction(symbolName, int1Ty, {int32Ty, termTy});
         auto calleeSymbol =
             FlatSymbolRefAttr::get(symbolName, callee->getContext());
-        Operation *isType =
+        Operation *isTypeCall =
             std_call(calleeSymbol, int1Ty, ValueRange{matchConst, input});
-        rewriter.replaceOp(op, isType->getResults());
+        rewriter.replaceOp(op, isTypeCall->getResults());
         return success();
     }
 };
@@ -314,6 +319,31 @@ struct TraceConstructOpConversion : public EIROpConversion<TraceConstructOp> {
     }
 };
 
+struct TraceFromTermOpConversion : public EIROpConversion<TraceFromTermOp> {
+    using EIROpConversion::EIROpConversion;
+
+    LogicalResult matchAndRewrite(
+        TraceFromTermOp op, ArrayRef<Value> operands,
+        ConversionPatternRewriter &rewriter) const override {
+        auto ctx = getRewriteContext(op, rewriter);
+        TraceFromTermOpAdaptor adaptor(operands);
+
+        Value trace = adaptor.trace();
+
+        auto termTy = ctx.getUsizeType();
+        auto termPtrTy = termTy.getPointerTo();
+
+        StringRef symbolName("__lumen_builtin_trace.from_term");
+        auto callee = ctx.getOrInsertFunction(symbolName, termPtrTy, {termTy});
+
+        auto calleeSymbol =
+            FlatSymbolRefAttr::get(symbolName, callee->getContext());
+        rewriter.replaceOpWithNewOp<mlir::CallOp>(op, calleeSymbol, termPtrTy,
+                                                  ValueRange(trace));
+        return success();
+    }
+};
+
 void populateBuiltinOpConversionPatterns(OwningRewritePatternList &patterns,
                                          MLIRContext *context,
                                          EirTypeConverter &converter,
@@ -321,7 +351,8 @@ void populateBuiltinOpConversionPatterns(OwningRewritePatternList &patterns,
     patterns.insert<IncrementReductionsOpConversion, IsTypeOpConversion,
                     IsTupleOpConversion, IsFunctionOpConversion,
                     PrintOpConversion, TraceCaptureOpConversion,
-                    TraceConstructOpConversion, TracePrintOpConversion>(
+                    TraceConstructOpConversion, TraceFromTermOpConversion,
+                    TracePrintOpConversion>(
         context, converter, targetInfo);
 }
 
@@ -12,6 +12,7 @@ class IsFunctionOpConversion;
 class PrintOpConversion;
 class TraceCaptureOpConversion;
 class TraceConstructOpConversion;
+class TraceFromTermOpConversion;
 class TracePrintOpConversion;
 
 void populateBuiltinOpConversionPatterns(OwningRewritePatternList &patterns,
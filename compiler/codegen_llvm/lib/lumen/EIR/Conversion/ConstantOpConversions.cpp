@@ -3,10 +3,42 @@
 namespace lumen {
 namespace eir {
 
+// This magic constant here matches the same value in the term encoding in Rust
+const uint64_t MIN_DOUBLE = ~((uint64_t)(INT64_MIN >> 12));
+
 template <typename Op>
 static Value lowerElementValue(RewritePatternContext<Op> &ctx,
                                Attribute elementAttr);
 
+template <typename Op>
+static bool isStaticLiteral(RewritePatternContext<Op> &ctx,
+                            Attribute elementAttr);
+
+template <typename Op>
+static Value buildLiteralValue(RewritePatternContext<Op> &ctx,
+                               Attribute elementAttr);
+
+template <typename Op>
+static LLVM::GlobalOp getOrInsertBinaryLiteral(RewritePatternContext<Op> &ctx,
+                                               BinaryAttr binAttr);
+
+template <typename Op>
+static LLVM::GlobalOp getOrInsertFloatLiteral(RewritePatternContext<Op> &ctx,
+                                              APFloat value);
+
+template <typename Op>
+static LLVM::GlobalOp getOrInsertTupleLiteral(RewritePatternContext<Op> &ctx,
+                                              SeqAttr attr);
+
+template <typename Op>
+static LLVM::GlobalOp getOrInsertListLiteral(RewritePatternContext<Op> &ctx,
+                                             SeqAttr attr);
+
+template <typename Op>
+static Value buildCachedLiteral(RewritePatternContext<Op> &ctx,
+                                StringRef cacheName, StringRef builtin,
+                                ArrayRef<Value> args);
+
 struct NullOpConversion : public EIROpConversion<NullOp> {
     using EIROpConversion::EIROpConversion;
 
@@ -110,20 +142,20 @@ struct ConstantBigIntOpConversion : public EIROpConversion<ConstantBigIntOp> {
         auto name = bigIntAttr.getHash();
         auto bytesGlobal = ctx.getOrInsertConstantString(name, bigIntStr);
 
-        // Invoke the runtime function that will reify a BigInt term from the
-        // constant string
         auto globalPtr = llvm_bitcast(i8PtrTy, llvm_addressof(bytesGlobal));
         Value size =
             llvm_constant(termTy, ctx.getIntegerAttr(bigIntStr.size()));
 
-        StringRef symbolName("__lumen_builtin_bigint_from_cstr");
-        auto callee =
-            ctx.getOrInsertFunction(symbolName, termTy, {i8PtrTy, termTy});
+        // The runtime reifies the BigInt term from the constant string the
+        // first time this constant is evaluated, after which the cached
+        // literal is used
+        StringRef symbolName("__lumen_builtin_bigint_literal");
+        ctx.getOrInsertFunction(symbolName, termTy, {i8PtrTy, termTy});
 
-        auto calleeSymbol =
-            FlatSymbolRefAttr::get(symbolName, callee->getContext());
-        rewriter.replaceOpWithNewOp<mlir::CallOp>(
-            op, calleeSymbol, termTy, ArrayRef<Value>{globalPtr, size});
+        auto cacheName = std::string("bigint_") + name;
+        Value literal = buildCachedLiteral(ctx, cacheName, symbolName,
+                                           ArrayRef<Value>{globalPtr, size});
+        rewriter.replaceOp(op, literal);
 
         return success();
     }
@@ -138,48 +170,7 @@ struct ConstantBinaryOpConversion : public EIROpConversion<ConstantBinaryOp> {
         auto ctx = getRewriteContext(op, rewriter);
 
         auto binAttr = op.getValue().cast<BinaryAttr>();
-        auto bytes = binAttr.getValue();
-        auto byteSize = bytes.size();
-        auto ty = ctx.targetInfo.getBinaryType();
-        auto termTy = ctx.getUsizeType();
-
-        // We use the SHA-1 hash of the value as the name of the global,
-        // this provides a nice way to de-duplicate constant strings while
-        // not requiring any global state
-        auto name = binAttr.getHash();
-        auto bytesGlobal = ctx.getOrInsertConstantString(name, bytes);
-        auto headerName = std::string("binary_") + name;
-        ModuleOp mod = ctx.getModule();
-        LLVM::GlobalOp headerConst =
-            mod.lookupSymbol<LLVM::GlobalOp>(headerName);
-        if (!headerConst) {
-            auto i64Ty = ctx.getI64Type();
-            auto i8Ty = ctx.getI8Type();
-            auto i8PtrTy = i8Ty.getPointerTo();
-
-            PatternRewriter::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointAfter(bytesGlobal);
-            headerConst = ctx.getOrInsertGlobalConstantOp(headerName, ty);
-
-            auto &initRegion = headerConst.getInitializerRegion();
-            auto *initBlock = rewriter.createBlock(&initRegion);
-            auto globalPtr = llvm_addressof(bytesGlobal);
-            Value zero = llvm_constant(i64Ty, ctx.getIntegerAttr(0));
-            Value headerTerm =
-                llvm_constant(termTy, ctx.getIntegerAttr(binAttr.getHeader()));
-            Value flags =
-                llvm_constant(termTy, ctx.getIntegerAttr(binAttr.getFlags()));
-            Value header = llvm_undef(ty);
-            Value address =
-                llvm_gep(i8PtrTy, globalPtr, ArrayRef<Value>{zero, zero});
-            header = llvm_insertvalue(ty, header, headerTerm,
-                                      rewriter.getI64ArrayAttr(0));
-            header = llvm_insertvalue(ty, header, flags,
-                                      rewriter.getI64ArrayAttr(1));
-            header = llvm_insertvalue(ty, header, address,
-                                      rewriter.getI64ArrayAttr(2));
-            rewriter.create<LLVM::ReturnOp>(op.getLoc(), header);
-        }
+        auto headerConst = getOrInsertBinaryLiteral(ctx, binAttr);
 
         // Box the constant address
         auto headerPtr = llvm_addressof(headerConst);
@@ -190,9 +181,6 @@ struct ConstantBinaryOpConversion : public EIROpConversion<ConstantBinaryOp> {
     }
 };
 
-// This magic constant here matches the same value in the term encoding in Rust
-const uint64_t MIN_DOUBLE = ~((uint64_t)(INT64_MIN >> 12));
-
 struct ConstantFloatOpConversion : public EIROpConversion<ConstantFloatOp> {
     using EIROpConversion::EIROpConversion;
 
@@ -221,42 +209,7 @@ struct ConstantFloatOpConversion : public EIROpConversion<ConstantFloatOp> {
         // which can then either be placed on the heap and boxed, or
         // passed by value on the stack and accessed directly
 
-        auto floatTy = ctx.targetInfo.getFloatType();
-        auto val = llvm_constant(
-            floatTy, rewriter.getF64FloatAttr(apVal.convertToDouble()));
-        auto headerName =
-            std::string("float_") +
-            std::to_string(apVal.bitcastToAPInt().getLimitedValue());
-        ModuleOp mod = ctx.getModule();
-        LLVM::GlobalOp headerConst =
-            mod.lookupSymbol<LLVM::GlobalOp>(headerName);
-        if (!headerConst) {
-            auto i64Ty = ctx.getI64Type();
-            auto f64Ty = ctx.getDoubleType();
-            auto i8Ty = ctx.getI8Type();
-            auto i8PtrTy = i8Ty.getPointerTo();
-
-            PatternRewriter::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointToStart(mod.getBody());
-            headerConst = ctx.getOrInsertGlobalConstantOp(headerName, floatTy);
-
-            auto &initRegion = headerConst.getInitializerRegion();
-            auto *initBlock = rewriter.createBlock(&initRegion);
-            Value zero = llvm_constant(i64Ty, ctx.getIntegerAttr(0));
-
-            APInt headerTermVal =
-                ctx.targetInfo.encodeHeader(TypeKind::Float, 2);
-            Value headerTerm = llvm_constant(
-                termTy, ctx.getIntegerAttr(headerTermVal.getLimitedValue()));
-            Value floatVal = llvm_constant(
-                f64Ty, rewriter.getF64FloatAttr(apVal.convertToDouble()));
-            Value header = llvm_undef(floatTy);
-            header = llvm_insertvalue(floatTy, header, headerTerm,
-                                      rewriter.getI64ArrayAttr(0));
-            header = llvm_insertvalue(floatTy, header, floatVal,
-                                      rewriter.getI64ArrayAttr(1));
-            rewriter.create<LLVM::ReturnOp>(op.getLoc(), header);
-        }
+        auto headerConst = getOrInsertFloatLiteral(ctx, apVal);
 
         // Box the constant address
         auto headerPtr = llvm_addressof(headerConst);
@@ -343,6 +296,13 @@ struct ConstantListOpConversion : public EIROpConversion<ConstantListOp> {
             return success();
         }
 
+        // Lists composed entirely of literals are emitted as a constant
+        // array of cons cells, which requires no allocation at runtime
+        if (isStaticLiteral(ctx, attr)) {
+            rewriter.replaceOp(op, buildLiteralValue(ctx, attr));
+            return success();
+        }
+
         SmallVector<Value, 4> elementValues;
         for (auto element : elements) {
             Value elementVal = lowerElementValue(ctx, element);
@@ -367,6 +327,51 @@ struct ConstantMapOpConversion : public EIROpConversion<ConstantMapOp> {
         auto attr = op.getValue().cast<SeqAttr>();
         auto elementAttrs = attr.getValue();
 
+        // Maps can't be emitted as a static image, as the runtime owns their
+        // representation, but if all of the keys and values are literals,
+        // the map is constructed only once, outside of any process heap, and
+        // then cached as a literal
+        auto isStatic = [&](Attribute a) { return isStaticLiteral(ctx, a); };
+        if (llvm::all_of(elementAttrs, isStatic)) {
+            auto numElements = elementAttrs.size();
+            auto termPtrTy = termTy.getPointerTo();
+            auto name = attr.getHash();
+            auto entriesName = std::string("map_entries_") + name;
+            auto entriesTy = LLVMType::getArrayTy(termTy, numElements);
+            ModuleOp mod = ctx.getModule();
+            LLVM::GlobalOp entriesConst =
+                mod.lookupSymbol<LLVM::GlobalOp>(entriesName);
+            if (!entriesConst) {
+                PatternRewriter::InsertionGuard insertGuard(rewriter);
+                rewriter.setInsertionPointToStart(mod.getBody());
+                entriesConst =
+                    ctx.getOrInsertGlobalConstantOp(entriesName, entriesTy);
+
+                auto &initRegion = entriesConst.getInitializerRegion();
+                rewriter.createBlock(&initRegion);
+                Value entries = llvm_undef(entriesTy);
+                for (unsigned i = 0; i < numElements; i++) {
+                    Value element = buildLiteralValue(ctx, elementAttrs[i]);
+                    entries = llvm_insertvalue(entriesTy, entries, element,
+                                               rewriter.getI64ArrayAttr(i));
+                }
+                rewriter.create<LLVM::ReturnOp>(op.getLoc(), entries);
+            }
+
+            StringRef symbolName("__lumen_builtin_map_literal");
+            ctx.getOrInsertFunction(symbolName, termTy, {termPtrTy, termTy});
+
+            Value entriesPtr =
+                llvm_bitcast(termPtrTy, llvm_addressof(entriesConst));
+            Value len =
+                llvm_constant(termTy, ctx.getIntegerAttr(numElements / 2));
+            auto cacheName = std::string("map_") + name;
+            Value literal = buildCachedLiteral(
+                ctx, cacheName, symbolName, ArrayRef<Value>{entriesPtr, len});
+            rewriter.replaceOp(op, literal);
+            return success();
+        }
+
         SmallVector<Value, 2> elements;
         for (auto elementAttr : elementAttrs) {
             auto element = lowerElementValue(ctx, elementAttr);
@@ -393,6 +398,13 @@ struct ConstantTupleOpConversion : public EIROpConversion<ConstantTupleOp> {
         auto attr = op.getValue().cast<SeqAttr>();
         auto elementAttrs = attr.getValue();
 
+        // Tuples composed entirely of literals are emitted as a constant
+        // tuple, which requires no allocation at runtime
+        if (isStaticLiteral(ctx, attr)) {
+            rewriter.replaceOp(op, buildLiteralValue(ctx, attr));
+            return success();
+        }
+
         SmallVector<Value, 2> elements;
         for (auto elementAttr : elementAttrs) {
             auto element = lowerElementValue(ctx, elementAttr);
@@ -414,6 +426,9 @@ static Value lowerElementValue(RewritePatternContext<Op> &ctx,
     auto termTy = ctx.getUsizeType();
     auto eirTermType = ctx.rewriter.template getType<TermType>();
 
+    if (isStaticLiteral(ctx, elementAttr))
+        return buildLiteralValue(ctx, elementAttr);
+
     // Symbols
     if (auto symAttr = elementAttr.dyn_cast_or_null<FlatSymbolRefAttr>()) {
         ModuleOp mod = ctx.getModule();
@@ -562,6 +577,399 @@ static Value lowerElementValue(RewritePatternContext<Op> &ctx,
     return nullptr;
 }
 
+// Returns the type of term described by the given sequence attribute, i.e.
+// tuple, cons or map, looking through the box of top-level constants
+static Type getSeqElementType(SeqAttr attr) {
+    Type type = attr.getType();
+    if (auto boxTy = type.dyn_cast_or_null<BoxType>())
+        return boxTy.getBoxedType();
+    return type;
+}
+
+// Returns true if the given attribute can be represented entirely by
+// constant data, i.e. it is an immediate, or a literal which can be placed
+// in a read-only global, and so requires no code to construct at runtime.
+//
+// NOTE: Maps are never static, see ConstantMapOpConversion
+template <typename Op>
+static bool isStaticLiteral(RewritePatternContext<Op> &ctx,
+                            Attribute elementAttr) {
+    if (!elementAttr) return false;
+
+    // Symbols
+    if (auto symAttr = elementAttr.dyn_cast<FlatSymbolRefAttr>()) {
+        ModuleOp mod = ctx.getModule();
+        Operation *referencedOp =
+            SymbolTable::lookupNearestSymbolFrom(mod, symAttr);
+        if (!dyn_cast_or_null<LLVM::GlobalOp>(referencedOp)) return false;
+        auto symName = symAttr.getValue();
+        return symName.startswith("binary_") || symName.startswith("float_") ||
+               symName.startswith("closure_");
+    }
+    // None/Nil
+    if (auto typeAttr = elementAttr.dyn_cast<TypeAttr>()) {
+        auto type = typeAttr.getValue();
+        return type.isa<NilType>() || type.isa<NoneType>();
+    }
+    // Immediates, and literals which are constructed statically
+    if (elementAttr.isa<BoolAttr>() || elementAttr.isa<AtomAttr>() ||
+        elementAttr.isa<APFloatAttr>() || elementAttr.isa<mlir::FloatAttr>() ||
+        elementAttr.isa<BinaryAttr>())
+        return true;
+    // Integers, if they fit in an immediate
+    if (auto intAttr = elementAttr.dyn_cast<APIntAttr>())
+        return intAttr.getValue().getBitWidth() <=
+               ctx.targetInfo.pointerSizeInBits;
+    if (auto intAttr = elementAttr.dyn_cast<IntegerAttr>())
+        return intAttr.getValue().getBitWidth() <=
+               ctx.targetInfo.pointerSizeInBits;
+    // Aggregates, if all of their elements are static
+    if (auto aggAttr = elementAttr.dyn_cast<SeqAttr>()) {
+        auto elementAttrs = aggAttr.getValue();
+        auto type = getSeqElementType(aggAttr);
+        if (type.isa<ConsType>()) {
+            if (elementAttrs.empty()) return true;
+            // On targets where the literal tag overlaps the list tag, lists
+            // must be constructed on the process heap
+            if (!ctx.targetInfo.supportsLiteralLists()) return false;
+        } else if (!type.isa<TupleType>()) {
+            return false;
+        }
+        for (auto attr : elementAttrs)
+            if (!isStaticLiteral(ctx, attr)) return false;
+        return true;
+    }
+
+    return false;
+}
+
+// Builds the term value for an attribute for which `isStaticLiteral` holds.
+//
+// This only produces constant expressions, and so may be used in the
+// initializer of a global as well as in a function body. Nested literals are
+// emitted as globals of their own.
+template <typename Op>
+static Value buildLiteralValue(RewritePatternContext<Op> &ctx,
+                               Attribute elementAttr) {
+    auto termTy = ctx.getUsizeType();
+
+    // Symbols
+    if (auto symAttr = elementAttr.dyn_cast<FlatSymbolRefAttr>()) {
+        ModuleOp mod = ctx.getModule();
+        auto global = cast<LLVM::GlobalOp>(
+            SymbolTable::lookupNearestSymbolFrom(mod, symAttr));
+        return ctx.encodeLiteral(llvm_addressof(global));
+    }
+    // None/Nil
+    if (auto typeAttr = elementAttr.dyn_cast<TypeAttr>()) {
+        if (typeAttr.getValue().isa<NilType>())
+            return llvm_constant(
+                termTy, ctx.getIntegerAttr(ctx.targetInfo.getNilValue()));
+        return llvm_constant(
+            termTy, ctx.getIntegerAttr(ctx.targetInfo.getNoneValue()));
+    }
+    // Booleans
+    if (auto boolAttr = elementAttr.dyn_cast<BoolAttr>()) {
+        uint64_t id = boolAttr.getValue() ? 1 : 0;
+        auto tagged = ctx.targetInfo.encodeImmediate(TypeKind::Atom, id);
+        return llvm_constant(termTy, ctx.getIntegerAttr(tagged));
+    }
+    // Atoms
+    if (auto atomAttr = elementAttr.dyn_cast<AtomAttr>()) {
+        auto id = atomAttr.getValue().getLimitedValue();
+        auto tagged = ctx.targetInfo.encodeImmediate(TypeKind::Atom, id);
+        return llvm_constant(termTy, ctx.getIntegerAttr(tagged));
+    }
+    // Integers
+    if (auto intAttr = elementAttr.dyn_cast<APIntAttr>()) {
+        auto tagged = ctx.targetInfo.encodeImmediate(
+            TypeKind::Fixnum, intAttr.getValue().getLimitedValue());
+        return llvm_constant(termTy, ctx.getIntegerAttr(tagged));
+    }
+    if (auto intAttr = elementAttr.dyn_cast<IntegerAttr>()) {
+        auto tagged = ctx.targetInfo.encodeImmediate(
+            TypeKind::Fixnum, intAttr.getValue().getLimitedValue());
+        return llvm_constant(termTy, ctx.getIntegerAttr(tagged));
+    }
+    // Floats
+    Optional<APFloat> floatVal;
+    if (auto floatAttr = elementAttr.dyn_cast<APFloatAttr>())
+        floatVal = floatAttr.getValue();
+    else if (auto floatAttr = elementAttr.dyn_cast<mlir::FloatAttr>())
+        floatVal = floatAttr.getValue();
+    if (floatVal.hasValue()) {
+        if (!ctx.targetInfo.requiresPackedFloats()) {
+            auto f = floatVal.getValue().bitcastToAPInt() + MIN_DOUBLE;
+            return llvm_constant(termTy,
+                                 ctx.getIntegerAttr(f.getLimitedValue()));
+        }
+        auto global = getOrInsertFloatLiteral(ctx, floatVal.getValue());
+        return ctx.encodeLiteral(llvm_addressof(global));
+    }
+    // Binaries
+    if (auto binAttr = elementAttr.dyn_cast<BinaryAttr>()) {
+        auto global = getOrInsertBinaryLiteral(ctx, binAttr);
+        return ctx.encodeLiteral(llvm_addressof(global));
+    }
+    // Nested aggregates
+    auto aggAttr = elementAttr.cast<SeqAttr>();
+    auto type = getSeqElementType(aggAttr);
+    if (type.isa<TupleType>()) {
+        auto global = getOrInsertTupleLiteral(ctx, aggAttr);
+        return ctx.encodeLiteral(llvm_addressof(global));
+    }
+    assert(type.isa<ConsType>() && "unsupported literal aggregate");
+    if (aggAttr.getValue().empty())
+        return llvm_constant(
+            termTy, ctx.getIntegerAttr(ctx.targetInfo.getNilValue()));
+    auto consPtrTy = ctx.targetInfo.getConsType().getPointerTo();
+    auto i32Ty = ctx.getI32Type();
+    auto global = getOrInsertListLiteral(ctx, aggAttr);
+    Value zero = llvm_constant(i32Ty, ctx.getI32Attr(0));
+    Value head = llvm_gep(consPtrTy, llvm_addressof(global),
+                          ArrayRef<Value>{zero, zero});
+    return ctx.encodeList(head, /*isLiteral=*/true);
+}
+
+template <typename Op>
+static LLVM::GlobalOp getOrInsertBinaryLiteral(RewritePatternContext<Op> &ctx,
+                                               BinaryAttr binAttr) {
+    auto &rewriter = ctx.rewriter;
+    auto bytes = binAttr.getValue();
+    auto ty = ctx.targetInfo.getBinaryType();
+    auto termTy = ctx.getUsizeType();
+
+    // We use the SHA-1 hash of the value as the name of the global,
+    // this provides a nice way to de-duplicate constant strings while
+    // not requiring any global state
+    auto name = binAttr.getHash();
+    auto bytesGlobal = ctx.getOrInsertConstantString(name, bytes);
+    auto headerName = std::string("binary_") + name;
+    ModuleOp mod = ctx.getModule();
+    LLVM::GlobalOp headerConst = mod.lookupSymbol<LLVM::GlobalOp>(headerName);
+    if (headerConst) return headerConst;
+
+    auto i64Ty = ctx.getI64Type();
+    auto i8Ty = ctx.getI8Type();
+    auto i8PtrTy = i8Ty.getPointerTo();
+
+    PatternRewriter::InsertionGuard insertGuard(rewriter);
+    rewriter.setInsertionPointAfter(bytesGlobal);
+    headerConst = ctx.getOrInsertGlobalConstantOp(headerName, ty);
+
+    auto &initRegion = headerConst.getInitializerRegion();
+    rewriter.createBlock(&initRegion);
+    auto globalPtr = llvm_addressof(bytesGlobal);
+    Value zero = llvm_constant(i64Ty, ctx.getIntegerAttr(0));
+    Value headerTerm =
+        llvm_constant(termTy, ctx.getIntegerAttr(binAttr.getHeader()));
+    Value flags = llvm_constant(termTy, ctx.getIntegerAttr(binAttr.getFlags()));
+    Value header = llvm_undef(ty);
+    Value address = llvm_gep(i8PtrTy, globalPtr, ArrayRef<Value>{zero, zero});
+    header = llvm_insertvalue(ty, header, headerTerm,
+                              rewriter.getI64ArrayAttr(0));
+    header = llvm_insertvalue(ty, header, flags, rewriter.getI64ArrayAttr(1));
+    header = llvm_insertvalue(ty, header, address, rewriter.getI64ArrayAttr(2));
+    rewriter.create<LLVM::ReturnOp>(ctx.op.getLoc(), header);
+
+    return headerConst;
+}
+
+template <typename Op>
+static LLVM::GlobalOp getOrInsertFloatLiteral(RewritePatternContext<Op> &ctx,
+                                              APFloat value) {
+    auto &rewriter = ctx.rewriter;
+    auto floatTy = ctx.targetInfo.getFloatType();
+    auto termTy = ctx.getUsizeType();
+    auto headerName =
+        std::string("float_") +
+        std::to_string(value.bitcastToAPInt().getLimitedValue());
+    ModuleOp mod = ctx.getModule();
+    LLVM::GlobalOp headerConst = mod.lookupSymbol<LLVM::GlobalOp>(headerName);
+    if (headerConst) return headerConst;
+
+    auto f64Ty = ctx.getDoubleType();
+
+    PatternRewriter::InsertionGuard insertGuard(rewriter);
+    rewriter.setInsertionPointToStart(mod.getBody());
+    headerConst = ctx.getOrInsertGlobalConstantOp(headerName, floatTy);
+
+    auto &initRegion = headerConst.getInitializerRegion();
+    rewriter.createBlock(&initRegion);
+
+    APInt headerTermVal = ctx.targetInfo.encodeHeader(TypeKind::Float, 2);
+    Value headerTerm = llvm_constant(
+        termTy, ctx.getIntegerAttr(headerTermVal.getLimitedValue()));
+    Value floatVal = llvm_constant(
+        f64Ty, rewriter.getF64FloatAttr(value.convertToDouble()));
+    Value header = llvm_undef(floatTy);
+    header = llvm_insertvalue(floatTy, header, headerTerm,
+                              rewriter.getI64ArrayAttr(0));
+    header = llvm_insertvalue(floatTy, header, floatVal,
+                              rewriter.getI64ArrayAttr(1));
+    rewriter.create<LLVM::ReturnOp>(ctx.op.getLoc(), header);
+
+    return headerConst;
+}
+
+// Constant tuples are emitted as a fully-formed tuple, i.e. header followed
+// by its elements, which is then referenced via a literal box
+template <typename Op>
+static LLVM::GlobalOp getOrInsertTupleLiteral(RewritePatternContext<Op> &ctx,
+                                              SeqAttr attr) {
+    auto &rewriter = ctx.rewriter;
+    auto name = std::string("tuple_") + attr.getHash();
+    ModuleOp mod = ctx.getModule();
+    LLVM::GlobalOp tupleConst = mod.lookupSymbol<LLVM::GlobalOp>(name);
+    if (tupleConst) return tupleConst;
+
+    auto termTy = ctx.getUsizeType();
+    auto elementAttrs = attr.getValue();
+    auto arity = elementAttrs.size();
+    auto tupleTy = ctx.getTupleType(arity);
+
+    PatternRewriter::InsertionGuard insertGuard(rewriter);
+    rewriter.setInsertionPointToStart(mod.getBody());
+    tupleConst = ctx.getOrInsertGlobalConstantOp(name, tupleTy);
+
+    auto &initRegion = tupleConst.getInitializerRegion();
+    rewriter.createBlock(&initRegion);
+
+    auto headerRaw = ctx.targetInfo.encodeHeader(TypeKind::Tuple, arity);
+    Value headerTerm = llvm_constant(termTy, ctx.getIntegerAttr(headerRaw));
+    Value tuple = llvm_undef(tupleTy);
+    tuple = llvm_insertvalue(tupleTy, tuple, headerTerm,
+                             rewriter.getI64ArrayAttr(0));
+    for (unsigned i = 0; i < arity; i++) {
+        Value element = buildLiteralValue(ctx, elementAttrs[i]);
+        tuple = llvm_insertvalue(tupleTy, tuple, element,
+                                 rewriter.getI64ArrayAttr(i + 1));
+    }
+    rewriter.create<LLVM::ReturnOp>(ctx.op.getLoc(), tuple);
+
+    return tupleConst;
+}
+
+// Constant lists are emitted as an array of cons cells, each of which refers
+// to the next cell in the array via a literal list pointer.
+//
+// The layout of the cells matches ListOpConversion, i.e. when more than one
+// element is given, the last element is the tail of the final cell.
+template <typename Op>
+static LLVM::GlobalOp getOrInsertListLiteral(RewritePatternContext<Op> &ctx,
+                                             SeqAttr attr) {
+    auto &rewriter = ctx.rewriter;
+    auto name = std::string("list_") + attr.getHash();
+    ModuleOp mod = ctx.getModule();
+    LLVM::GlobalOp listConst = mod.lookupSymbol<LLVM::GlobalOp>(name);
+    if (listConst) return listConst;
+
+    auto termTy = ctx.getUsizeType();
+    auto i32Ty = ctx.getI32Type();
+    auto consTy = ctx.targetInfo.getConsType();
+    auto consPtrTy = consTy.getPointerTo();
+    auto elementAttrs = attr.getValue();
+    auto numElements = elementAttrs.size();
+    assert(numElements > 0 && "empty lists should be lowered to nil");
+    auto numCells = numElements == 1 ? 1 : numElements - 1;
+    auto cellsTy = LLVMType::getArrayTy(consTy, numCells);
+
+    PatternRewriter::InsertionGuard insertGuard(rewriter);
+    rewriter.setInsertionPointToStart(mod.getBody());
+    listConst = ctx.getOrInsertGlobalConstantOp(name, cellsTy);
+
+    auto &initRegion = listConst.getInitializerRegion();
+    rewriter.createBlock(&initRegion);
+
+    Value zero = llvm_constant(i32Ty, ctx.getI32Attr(0));
+    Value cellsPtr = llvm_addressof(listConst);
+    Value cells = llvm_undef(cellsTy);
+    for (unsigned i = 0; i < numCells; i++) {
+        Value head = buildLiteralValue(ctx, elementAttrs[i]);
+        Value tail;
+        if (i + 1 < numCells) {
+            Value next = llvm_constant(i32Ty, ctx.getI32Attr(i + 1));
+            Value nextPtr =
+                llvm_gep(consPtrTy, cellsPtr, ArrayRef<Value>{zero, next});
+            tail = ctx.encodeList(nextPtr, /*isLiteral=*/true);
+        } else if (numElements == 1) {
+            tail = llvm_constant(
+                termTy, ctx.getIntegerAttr(ctx.targetInfo.getNilValue()));
+        } else {
+            tail = buildLiteralValue(ctx, elementAttrs[numElements - 1]);
+        }
+        cells = llvm_insertvalue(cellsTy, cells, head,
+                                 rewriter.getI64ArrayAttr({i, 0}));
+        cells = llvm_insertvalue(cellsTy, cells, tail,
+                                 rewriter.getI64ArrayAttr({i, 1}));
+    }
+    rewriter.create<LLVM::ReturnOp>(ctx.op.getLoc(), cells);
+
+    return listConst;
+}
+
+// Some literals (i.e. bigints and maps) can't be emitted as a static image,
+// as their representation is owned by the runtime. Instead, the given
+// builtin is called to construct the literal outside of any process heap the
+// first time it is needed, and the result is cached in a global. Subsequent
+// evaluations only load the cached term.
+//
+// The literal is published with a compare-and-swap, so that concurrent
+// schedulers racing to initialize the cache all agree on the winning value;
+// the losing value is simply leaked. The release ordering of the publish
+// orders the construction of the literal before the term is visible, and
+// readers only access the literal through the loaded term, so the address
+// dependency orders their reads after it.
+template <typename Op>
+static Value buildCachedLiteral(RewritePatternContext<Op> &ctx,
+                                StringRef cacheName, StringRef builtin,
+                                ArrayRef<Value> args) {
+    auto &rewriter = ctx.rewriter;
+    auto termTy = ctx.getUsizeType();
+
+    Value cachePtr =
+        ctx.getOrInsertGlobal(cacheName, termTy, ctx.getIntegerAttr(0));
+    Value zero = llvm_constant(termTy, ctx.getIntegerAttr(0));
+    Value cached = llvm_load(cachePtr);
+    Value isCached = llvm_icmp(LLVM::ICmpPredicate::ne, cached, zero);
+
+    // Split the block at the use of the literal, which is passed to the
+    // continuation as a block argument
+    Block *current = rewriter.getInsertionBlock();
+    Block *cont = rewriter.splitBlock(current, rewriter.getInsertionPoint());
+    cont->addArgument(termTy);
+
+    Block *init = new Block();
+    current->getParent()->getBlocks().insert(
+        std::next(Region::iterator(current)), init);
+
+    rewriter.setInsertionPointToEnd(current);
+    llvm_condbr(isCached, cont, ValueRange(cached), init, ValueRange());
+
+    // First use, construct the literal and cache it
+    rewriter.setInsertionPointToEnd(init);
+    auto callee = rewriter.getSymbolRefAttr(builtin);
+    Operation *call = llvm_call(ArrayRef<Type>{termTy}, callee, args);
+    Value constructed = call->getResult(0);
+    auto i1Ty = ctx.getI1Type();
+    auto pairTy = LLVMType::getStructTy(rewriter.getContext(),
+                                        ArrayRef<LLVMType>{termTy, i1Ty},
+                                        /*packed=*/false);
+    Operation *cmpxchg = llvm_cmpxchg(
+        pairTy, cachePtr, zero, constructed, LLVM::AtomicOrdering::acq_rel,
+        LLVM::AtomicOrdering::acquire);
+    // The previous value of the cache is only zero if this initialization won
+    Value previous = llvm_extractvalue(termTy, cmpxchg->getResult(0),
+                                       ctx.getI64ArrayAttr(0));
+    Value published = llvm_extractvalue(i1Ty, cmpxchg->getResult(0),
+                                        ctx.getI64ArrayAttr(1));
+    Value literal = llvm_select(published, constructed, previous);
+    llvm_br(ValueRange(literal), cont);
+
+    rewriter.setInsertionPointToStart(cont);
+    return cont->getArgument(0);
+}
+
 void populateConstantOpConversionPatterns(OwningRewritePatternList &patterns,
                                           MLIRContext *context,
                                           EirTypeConverter &converter,
@@ -55,9 +55,6 @@ struct CallOpConversion : public EIROpConversion<CallOp> {
         auto ctx = getRewriteContext(op, rewriter);
         auto termTy = ctx.getUsizeType();
 
-        // Always increment reduction count when performing a call
-        rewriter.create<IncrementReductionsOp>(op.getLoc());
-
         // Results need to be converted, or use void if no result is returned
         SmallVector<Type, 1> resultTypes;
         if (op.getNumResults() > 0) {
@@ -101,9 +98,6 @@ struct InvokeOpConversion : public EIROpConversion<InvokeOp> {
         auto ctx = getRewriteContext(op, rewriter);
         auto termTy = ctx.getUsizeType();
 
-        // Always increment reduction count when performing a call
-        rewriter.create<IncrementReductionsOp>(op.getLoc());
-
         // The result types are based on the block arguments of the normal block
         auto ok = op.okDest();
         ValueRange okArgs = op.okDestOperands();
@@ -310,8 +304,8 @@ struct YieldCheckOpConversion : public EIROpConversion<YieldCheckOp> {
     LogicalResult matchAndRewrite(
         YieldCheckOp op, ArrayRef<Value> operands,
         ConversionPatternRewriter &rewriter) const override {
+        YieldCheckOpAdaptor adaptor(operands);
         auto ctx = getRewriteContext(op, rewriter);
-        ModuleOp mod = ctx.getModule();
 
         auto i32Ty = ctx.getI32Type();
         auto reductionCountGlobal = ctx.getOrInsertGlobal(
@@ -321,7 +315,7 @@ struct YieldCheckOpConversion : public EIROpConversion<YieldCheckOp> {
         // Load the current reduction count
         Value reductionCount = llvm_load(reductionCountGlobal);
         // If greater than or equal to the max reduction count, yield
-        Value maxReductions = op.getMaxReductions();
+        Value maxReductions = adaptor.maxReductions();
         Value shouldYield =
             llvm_icmp(LLVM::ICmpPredicate::uge, reductionCount, maxReductions);
 
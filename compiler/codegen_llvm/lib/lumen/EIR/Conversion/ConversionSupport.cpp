@@ -324,6 +324,180 @@ Value OpConversionContext::buildMalloc(ModuleOp mod, LLVMType ty,
     return llvm_bitcast(ptrTy, call->getResult(0));
 }
 
+// Reserves `bytes` on the heap of the current process, returning an i8* to
+// the start of the reservation.
+//
+// The fast path bumps the heap top inline, using the bounds published by the
+// scheduler in `__lumen_process_heap`, which points to a pair of pointers,
+// the first being the current heap top, and the second the heap limit. If the
+// reservation doesn't fit, we call into the runtime, which will allocate a
+// heap fragment and schedule a collection if necessary.
+//
+// NOTE: This splits the current block at the insertion point, on return the
+// insertion point is at the start of the continuation block.
+Value OpConversionContext::buildHeapReserve(ModuleOp mod,
+                                            uint64_t bytes) const {
+    auto termTy = getUsizeType();
+    auto i8PtrTy = getI8Type().getPointerTo();
+    auto i8PtrPtrTy = i8PtrTy.getPointerTo();
+    StringRef slowPathSymbol("__lumen_builtin_heap_reserve");
+    getOrInsertFunction(mod, slowPathSymbol, i8PtrTy, {termTy});
+
+    auto processHeapGlobal = getOrInsertGlobal(
+        mod, "__lumen_process_heap", i8PtrPtrTy, nullptr,
+        LLVM::Linkage::External, LLVM::ThreadLocalMode::LocalExec);
+
+    // Load the heap bounds and check if the reservation fits
+    Value size = llvm_constant(termTy, getIntegerAttr(bytes));
+    Value one = llvm_constant(termTy, getIntegerAttr(1));
+    Value topPtr = llvm_load(processHeapGlobal);
+    Value limitPtr = llvm_gep(i8PtrPtrTy, topPtr, ArrayRef<Value>{one});
+    Value top = llvm_load(topPtr);
+    Value limit = llvm_load(limitPtr);
+    Value newTop = llvm_gep(i8PtrTy, top, ArrayRef<Value>{size});
+    Value fits =
+        llvm_icmp(LLVM::ICmpPredicate::ule, llvm_ptrtoint(termTy, newTop),
+                  llvm_ptrtoint(termTy, limit));
+
+    // Split the block at the reservation, the result of which is passed to
+    // the continuation as a block argument
+    Block *current = rewriter.getInsertionBlock();
+    Block *cont = rewriter.splitBlock(current, rewriter.getInsertionPoint());
+    cont->addArgument(i8PtrTy);
+
+    Block *fast = new Block();
+    Block *slow = new Block();
+    auto nextIt = std::next(Region::iterator(current));
+    current->getParent()->getBlocks().insert(nextIt, fast);
+    current->getParent()->getBlocks().insert(nextIt, slow);
+
+    rewriter.setInsertionPointToEnd(current);
+    llvm_condbr(fits, fast, ValueRange(), slow, ValueRange());
+
+    // The reservation fits, so bump the heap top
+    rewriter.setInsertionPointToEnd(fast);
+    llvm_store(newTop, topPtr);
+    llvm_br(ValueRange(top), cont);
+
+    // The heap is exhausted, defer to the runtime
+    rewriter.setInsertionPointToEnd(slow);
+    auto slowPathCallee = rewriter.getSymbolRefAttr(slowPathSymbol);
+    Operation *slowPathCall = llvm_call(ArrayRef<Type>{i8PtrTy}, slowPathCallee,
+                                        ArrayRef<Value>{size});
+    llvm_br(slowPathCall->getResults(), cont);
+
+    rewriter.setInsertionPointToStart(cont);
+    return cont->getArgument(0);
+}
+
+// Tests `val` against the given tag check, producing an i1 result
+Value OpConversionContext::buildTagCheck(Value val,
+                                         const TagCheck &check) const {
+    auto termTy = getUsizeType();
+    uint64_t allOnes = targetInfo.pointerSizeInBits == 64
+                           ? ~uint64_t(0)
+                           : (uint64_t(1) << targetInfo.pointerSizeInBits) - 1;
+
+    Value masked = val;
+    if ((check.mask & allOnes) != allOnes) {
+        Value mask = llvm_constant(termTy, getIntegerAttr(check.mask));
+        masked = llvm_and(val, mask);
+    }
+
+    if (check.isExact()) {
+        Value expected = llvm_constant(termTy, getIntegerAttr(check.min));
+        return llvm_icmp(LLVM::ICmpPredicate::eq, masked, expected);
+    }
+
+    // Range checks are folded into a single unsigned comparison
+    if (check.min != 0) {
+        Value min = llvm_constant(termTy, getIntegerAttr(check.min));
+        masked = llvm_sub(masked, min);
+    }
+    Value range =
+        llvm_constant(termTy, getIntegerAttr(check.max - check.min));
+    return llvm_icmp(LLVM::ICmpPredicate::ule, masked, range);
+}
+
+// Builds an inline check that `val` is a term of the given type, using the
+// tag tests provided by the term encoding. If `boxedOnly` is set, the value
+// is known to be a box, and only the header tests are performed.
+//
+// Returns a null value if the check cannot be performed inline.
+Value OpConversionContext::buildTypeCheck(Value val, uint32_t type,
+                                          bool boxedOnly) const {
+    auto check = targetInfo.typeCheck(type);
+    if (!check.isInline) return nullptr;
+
+    auto termTy = getUsizeType();
+    auto i1Ty = getI1Type();
+
+    auto anyOf = [&](Value acc, Value next) -> Value {
+        if (!acc) return next;
+        return llvm_or(acc, next);
+    };
+
+    bool hasHeaderChecks = llvm::any_of(
+        check.header, [](const TagCheck &c) { return c.isEnabled(); });
+
+    // Some types (e.g. floats when nanboxed) are never boxed, in which case
+    // the immediate checks are sufficient even for boxed values
+    Value isType;
+    if (!boxedOnly || !hasHeaderChecks) {
+        for (auto &immediate : check.immediate) {
+            if (!immediate.isEnabled()) continue;
+            isType = anyOf(isType, buildTagCheck(val, immediate));
+        }
+    }
+    if (!hasHeaderChecks) {
+        if (!isType) return llvm_constant(i1Ty, getI1Attr(false));
+        return isType;
+    }
+
+    auto &boxCheck = targetInfo.boxCheck();
+    Value isBox;
+    if (boxCheck.tag.isEnabled()) isBox = buildTagCheck(val, boxCheck.tag);
+    if (boxCheck.pointer.isEnabled()) {
+        Value isPointer = buildTagCheck(val, boxCheck.pointer);
+        isBox = isBox ? llvm_and(isBox, isPointer) : isPointer;
+    }
+
+    // The header may only be loaded once we know the value is a box, so the
+    // header checks are placed in their own block, and the result of the
+    // check is passed to the continuation as a block argument
+    Block *current = rewriter.getInsertionBlock();
+    Block *cont = rewriter.splitBlock(current, rewriter.getInsertionPoint());
+    cont->addArgument(i1Ty);
+
+    Block *boxed = new Block();
+    Block *notBoxed = new Block();
+    auto nextIt = std::next(Region::iterator(current));
+    current->getParent()->getBlocks().insert(nextIt, boxed);
+    current->getParent()->getBlocks().insert(nextIt, notBoxed);
+
+    // Boxes never pass an immediate check, so only the header matters
+    rewriter.setInsertionPointToEnd(current);
+    llvm_condbr(isBox, boxed, ValueRange(), notBoxed, ValueRange());
+
+    rewriter.setInsertionPointToEnd(boxed);
+    Value headerPtr = decodeBox(termTy, val);
+    Value header = llvm_load(headerPtr);
+    Value isHeaderType;
+    for (auto &headerCheck : check.header) {
+        if (!headerCheck.isEnabled()) continue;
+        isHeaderType = anyOf(isHeaderType, buildTagCheck(header, headerCheck));
+    }
+    llvm_br(ValueRange(isHeaderType), cont);
+
+    rewriter.setInsertionPointToEnd(notBoxed);
+    Value notBoxedResult =
+        isType ? isType : llvm_constant(i1Ty, getI1Attr(false));
+    llvm_br(ValueRange(notBoxedResult), cont);
+
+    rewriter.setInsertionPointToStart(cont);
+    return cont->getArgument(0);
+}
+
 Value OpConversionContext::encodeList(Value cons, bool isLiteral) const {
     auto termTy = getUsizeType();
     Value ptrInt = llvm_ptrtoint(termTy, cons);
@@ -361,26 +535,50 @@ Value OpConversionContext::encodeLiteral(Value val) const {
     return llvm_or(ptrInt, tag);
 }
 
-Value OpConversionContext::encodeImmediate(ModuleOp mod, Location loc,
-                                           OpaqueTermType ty, Value val) const {
+Value OpConversionContext::encodeImmediate(OpaqueTermType ty,
+                                           Value val) const {
     auto termTy = getUsizeType();
-    auto i32Ty = getI32Type();
-    StringRef symbolName("__lumen_builtin_encode_immediate");
-    auto callee = getOrInsertFunction(mod, symbolName, termTy, {i32Ty, termTy});
-    auto calleeSymbol =
-        FlatSymbolRefAttr::get(symbolName, callee->getContext());
+    auto kind = ty.getTypeKind().getValue();
+
+    // These have no value, so the encoding is a constant
+    if (kind == TypeKind::Nil)
+        return llvm_constant(termTy, getIntegerAttr(targetInfo.getNilValue()));
+    if (kind == TypeKind::None)
+        return llvm_constant(termTy,
+                             getIntegerAttr(targetInfo.getNoneValue()));
+    // Immediate floats are stored as-is
+    if (kind == TypeKind::Float) {
+        assert(!targetInfo.requiresPackedFloats() &&
+               "floats are not immediate on this target");
+        return val;
+    }
 
-    Value kind = llvm_constant(i32Ty, getI32Attr(ty.getTypeKind().getValue()));
-    ArrayRef<Value> args{kind, val};
-    Operation *call = std_call(calleeSymbol, ArrayRef<Type>{termTy}, args);
-    return call->getResult(0);
+    // All other immediates are encoded as (value << shift) | tag, where the
+    // tag is the encoding of zero for that type
+    auto maskInfo = targetInfo.immediateMask();
+    Value payload;
+    if (maskInfo.requiresShift()) {
+        // The shift discards any bits which do not fit
+        Value shift = llvm_constant(termTy, getIntegerAttr(maskInfo.shift));
+        payload = llvm_shl(val, shift);
+    } else {
+        // The mask removes any bits which would overlap the tag
+        Value mask = llvm_constant(termTy, getIntegerAttr(maskInfo.mask));
+        payload = llvm_and(val, mask);
+    }
+    auto rawTag = targetInfo.encodeImmediate(kind, 0);
+    if (rawTag.isNullValue()) return payload;
+
+    Value tag = llvm_constant(termTy, getIntegerAttr(rawTag));
+    return llvm_or(payload, tag);
 }
 
 Value OpConversionContext::decodeBox(LLVMType innerTy, Value box) const {
     auto termTy = getUsizeType();
     auto boxTy = box.getType().cast<LLVMType>();
     assert(boxTy == termTy && "expected boxed pointer type");
-    auto rawTag = targetInfo.boxTag();
+    // Boxes may point to literals, so the literal tag must be stripped too
+    auto rawTag = targetInfo.boxTag() | targetInfo.literalTag();
     // No unboxing required, pointers are pointers
     if (rawTag == 0) {
         return llvm_inttoptr(innerTy.getPointerTo(), box);
@@ -394,7 +592,9 @@ Value OpConversionContext::decodeBox(LLVMType innerTy, Value box) const {
 
 Value OpConversionContext::decodeList(Value box) const {
     auto termTy = targetInfo.getUsizeType();
-    Value mask = llvm_constant(termTy, getIntegerAttr(targetInfo.listMask()));
+    auto rawMask = targetInfo.listMask();
+    if (targetInfo.supportsLiteralLists()) rawMask |= targetInfo.literalTag();
+    Value mask = llvm_constant(termTy, getIntegerAttr(rawMask));
     Value neg1 = llvm_constant(termTy, getIntegerAttr(-1));
     Value untagged = llvm_and(box, llvm_xor(mask, neg1));
     return llvm_inttoptr(targetInfo.getConsType().getPointerTo(), untagged);
@@ -404,13 +604,15 @@ Value OpConversionContext::decodeImmediate(Value val) const {
     auto termTy = getUsizeType();
     auto maskInfo = targetInfo.immediateMask();
 
-    Value mask = llvm_constant(termTy, getIntegerAttr(maskInfo.mask));
-    Value masked = llvm_and(val, mask);
+    // When the tag is below the value, shifting removes it, otherwise the
+    // mask covers the value bits. The shift is arithmetic, so that the sign
+    // of negative fixnums is preserved
     if (maskInfo.requiresShift()) {
         Value shift = llvm_constant(termTy, getIntegerAttr(maskInfo.shift));
-        return llvm_shr(masked, shift);
+        return llvm_ashr(val, shift);
     } else {
-        return masked;
+        Value mask = llvm_constant(termTy, getIntegerAttr(maskInfo.mask));
+        return llvm_and(val, mask);
     }
 }
 }  // namespace eir
@@ -56,6 +56,7 @@ using llvm_or = ValueBuilder<LLVM::OrOp>;
 using llvm_xor = ValueBuilder<LLVM::XOrOp>;
 using llvm_shl = ValueBuilder<LLVM::ShlOp>;
 using llvm_shr = ValueBuilder<LLVM::LShrOp>;
+using llvm_ashr = ValueBuilder<LLVM::AShrOp>;
 using llvm_bitcast = ValueBuilder<LLVM::BitcastOp>;
 using llvm_zext = ValueBuilder<LLVM::ZExtOp>;
 using llvm_sext = ValueBuilder<LLVM::SExtOp>;
@@ -73,6 +74,7 @@ using llvm_icmp = ValueBuilder<LLVM::ICmpOp>;
 using llvm_load = ValueBuilder<LLVM::LoadOp>;
 using llvm_store = OperationBuilder<LLVM::StoreOp>;
 using llvm_atomicrmw = OperationBuilder<LLVM::AtomicRMWOp>;
+using llvm_cmpxchg = OperationBuilder<LLVM::AtomicCmpXchgOp>;
 using llvm_select = ValueBuilder<LLVM::SelectOp>;
 using llvm_mul = ValueBuilder<LLVM::MulOp>;
 using llvm_ptrtoint = ValueBuilder<LLVM::PtrToIntOp>;
@@ -333,12 +335,14 @@ class OpConversionContext : public ConversionContext {
 
     Value buildMalloc(ModuleOp mod, LLVMType ty, unsigned allocTy,
                       Value arity) const;
+    Value buildHeapReserve(ModuleOp mod, uint64_t bytes) const;
+    Value buildTagCheck(Value val, const TagCheck &check) const;
+    Value buildTypeCheck(Value val, uint32_t type, bool boxedOnly) const;
 
     Value encodeList(Value cons, bool isLiteral = false) const;
     Value encodeBox(Value val) const;
     Value encodeLiteral(Value val) const;
-    Value encodeImmediate(ModuleOp mod, Location loc, OpaqueTermType ty,
-                          Value val) const;
+    Value encodeImmediate(OpaqueTermType ty, Value val) const;
     Value decodeBox(LLVMType innerTy, Value box) const;
     Value decodeList(Value box) const;
     Value decodeImmediate(Value val) const;
@@ -359,11 +363,14 @@ class RewritePatternContext : public OpConversionContext {
     ScopedContext scope;
 
     using OpConversionContext::context;
+    using OpConversionContext::buildTagCheck;
+    using OpConversionContext::buildTypeCheck;
     using OpConversionContext::decodeBox;
     using OpConversionContext::decodeImmediate;
     using OpConversionContext::decodeList;
     using OpConversionContext::encodeBox;
     using OpConversionContext::encodeHeaderConstant;
+    using OpConversionContext::encodeImmediate;
     using OpConversionContext::encodeImmediateConstant;
     using OpConversionContext::encodeList;
     using OpConversionContext::encodeLiteral;
@@ -463,9 +470,9 @@ class RewritePatternContext : public OpConversionContext {
         ModuleOp mod = getModule();
         return OpConversionContext::buildMalloc(mod, ty, allocTy, arity);
     }
-    Value encodeImmediate(OpaqueTermType ty, Value val) const {
+    Value buildHeapReserve(uint64_t bytes) const {
         ModuleOp mod = getModule();
-        return OpConversionContext::encodeImmediate(mod, val.getLoc(), ty, val);
+        return OpConversionContext::buildHeapReserve(mod, bytes);
     }
 };
 
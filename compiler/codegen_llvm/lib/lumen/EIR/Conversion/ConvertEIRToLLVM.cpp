@@ -8,6 +8,7 @@
 #include "lumen/EIR/Conversion/ControlFlowOpConversions.h"
 #include "lumen/EIR/Conversion/ConversionSupport.h"
 #include "lumen/EIR/Conversion/FuncLikeOpConversions.h"
+#include "lumen/EIR/Conversion/HeapAllocation.h"
 #include "lumen/EIR/Conversion/MapOpConversions.h"
 #include "lumen/EIR/Conversion/MathOpConversions.h"
 #include "lumen/EIR/Conversion/MemoryOpConversions.h"
@@ -53,6 +54,12 @@ class ConvertEIRToLLVMPass
         });
         converter.addConversion([](LLVMType type) { return type; });
 
+        // Group heap allocations so that each group can be lowered to a
+        // single reservation on the process heap
+        mlir::ModuleOp moduleOp = getOperation();
+        HeapAllocationPlan heapPlan(targetInfo);
+        heapPlan.analyze(moduleOp);
+
         // Populate conversion patterns
         OwningRewritePatternList patterns;
 
@@ -65,7 +72,7 @@ class ConvertEIRToLLVMPass
 
         // Add conversions from EIR to LLVM
         populateAggregateOpConversionPatterns(patterns, &context, converter,
-                                              targetInfo);
+                                              targetInfo, heapPlan);
         populateBinaryOpConversionPatterns(patterns, &context, converter,
                                            targetInfo);
         populateBuiltinOpConversionPatterns(patterns, &context, converter,
@@ -77,7 +84,7 @@ class ConvertEIRToLLVMPass
         populateControlFlowOpConversionPatterns(patterns, &context, converter,
                                                 targetInfo);
         populateFuncLikeOpConversionPatterns(patterns, &context, converter,
-                                             targetInfo);
+                                             targetInfo, heapPlan);
         populateMapOpConversionPatterns(patterns, &context, converter,
                                         targetInfo);
         populateMathOpConversionPatterns(patterns, &context, converter,
@@ -90,7 +97,6 @@ class ConvertEIRToLLVMPass
         conversionTarget.addLegalDialect<mlir::LLVM::LLVMDialect>();
         conversionTarget.addLegalOp<ModuleOp, mlir::ModuleTerminatorOp>();
 
-        mlir::ModuleOp moduleOp = getOperation();
         if (failed(applyFullConversion(moduleOp, conversionTarget, patterns))) {
             return signalPassFailure();
         }
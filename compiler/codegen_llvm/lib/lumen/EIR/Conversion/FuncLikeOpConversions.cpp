@@ -7,21 +7,16 @@ const unsigned CLOSURE_ENV_INDEX = 5;
 
 // The purpose of this conversion is to build a function that contains
 // all of the prologue setup our Erlang functions need (in cases where
-// this isn't a declaration). Specifically:
+// this isn't a declaration).
 //
-// - Check if reduction count is exceeded
-// - Check if we should garbage collect
-//   - If either of the above are true, yield
+// NOTE: Reduction counting and yield checks are inserted before lowering,
+// by the InsertReductionChecks pass.
 struct FuncOpConversion : public EIROpConversion<eir::FuncOp> {
     using EIROpConversion::EIROpConversion;
 
     LogicalResult matchAndRewrite(
         eir::FuncOp op, ArrayRef<Value> operands,
         ConversionPatternRewriter &rewriter) const override {
-        auto ctx = getRewriteContext(op, rewriter);
-
-        auto i32Ty = ctx.getI32Type();
-
         SmallVector<NamedAttribute, 2> attrs;
         for (auto fa : op.getAttrs()) {
             if (fa.first == SymbolTable::getSymbolAttrName() ||
@@ -41,44 +36,12 @@ struct FuncOpConversion : public EIROpConversion<eir::FuncOp> {
                                     newFunc.end());
         rewriter.eraseOp(op);
 
-        // Insert yield check if this function is not extern
-        auto *region = newFunc.getCallableRegion();
-        if (region) {
-            auto ip = rewriter.saveInsertionPoint();
-            auto entry = &region->front();
-            auto entryOp = &entry->front();
-            // Splits `entry` returning a block containing all the previous
-            // contents of entry since we're splitting on the first op. This
-            // block is `doYield` because split it a second time to give us
-            // the success block. Since the values in `entry` dominate both
-            // splits, we don't have to pass arguments
-            Block *doYield = entry->splitBlock(&entry->front());
-            Block *dontYield = doYield->splitBlock(&doYield->front());
-            // Insert yield check in original entry block
-            rewriter.setInsertionPointToEnd(entry);
-
-            const uint32_t MAX_REDUCTIONS =
-                20;  // TODO: Move this up in the compiler
-            Value maxReductions =
-                llvm_constant(i32Ty, ctx.getI32Attr(MAX_REDUCTIONS));
-            rewriter.create<YieldCheckOp>(op.getLoc(), maxReductions, doYield,
-                                          ValueRange{}, dontYield,
-                                          ValueRange{});
-            // Then insert the actual yield point in the yield block
-            rewriter.setInsertionPointToEnd(doYield);
-            rewriter.create<YieldOp>(op.getLoc());
-            // Then post-yield, branch to the real entry block
-            rewriter.create<BranchOp>(op.getLoc(), dontYield);
-            // Reset the builder to where it was originally
-            rewriter.restoreInsertionPoint(ip);
-        }
-
         return success();
     }
 };
 
-struct ClosureOpConversion : public EIROpConversion<ClosureOp> {
-    using EIROpConversion::EIROpConversion;
+struct ClosureOpConversion : public EIRHeapAllocOpConversion<ClosureOp> {
+    using EIRHeapAllocOpConversion::EIRHeapAllocOpConversion;
 
     LogicalResult matchAndRewrite(
         ClosureOp op, ArrayRef<Value> operands,
@@ -86,8 +49,6 @@ struct ClosureOpConversion : public EIROpConversion<ClosureOp> {
         ClosureOpAdaptor adaptor(operands);
         auto ctx = getRewriteContext(op, rewriter);
 
-        auto loc = op.getLoc();
-
         auto envLen = op.envLen();
         unsigned arity = op.arity();
         unsigned index = op.index();
@@ -141,15 +102,9 @@ struct ClosureOpConversion : public EIROpConversion<ClosureOp> {
         LLVMType defTy = ctx.targetInfo.getClosureDefinitionType();
 
         // Allocate closure header block
-        auto boxedClosureTy =
-            BoxType::get(rewriter.getType<ClosureType>(envLen));
-        auto closurePtrTy = PtrType::get(rewriter.getType<ClosureType>(envLen));
         auto headerArity = ctx.targetInfo.closureHeaderArity(envLen);
-        Value headerArityConst =
-            llvm_constant(termTy, ctx.getIntegerAttr(headerArity));
-        auto mallocOp =
-            rewriter.create<MallocOp>(loc, closurePtrTy, headerArityConst);
-        auto valRef = mallocOp.getResult();
+        auto size = plan.getAllocationSize(op).getValue();
+        Value valRef = allocate(ctx, closureTy, size);
 
         // Calculate pointers to each field in the header and write the
         // corresponding data to it
@@ -292,10 +247,12 @@ struct UnpackEnvOpConversion : public EIROpConversion<UnpackEnvOp> {
 void populateFuncLikeOpConversionPatterns(OwningRewritePatternList &patterns,
                                           MLIRContext *context,
                                           EirTypeConverter &converter,
-                                          TargetInfo &targetInfo) {
-    patterns
-        .insert<FuncOpConversion, ClosureOpConversion, UnpackEnvOpConversion>(
-            context, converter, targetInfo);
+                                          TargetInfo &targetInfo,
+                                          HeapAllocationPlan &heapPlan) {
+    patterns.insert<FuncOpConversion, UnpackEnvOpConversion>(
+        context, converter, targetInfo);
+    patterns.insert<ClosureOpConversion>(context, converter, targetInfo,
+                                         heapPlan);
 }
 
 }  // namespace eir
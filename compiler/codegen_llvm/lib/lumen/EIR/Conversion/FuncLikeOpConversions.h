@@ -2,6 +2,7 @@
 #define LUMEN_EIR_CONVERSION_FUNCLIKE_OP_CONVERSION
 
 #include "lumen/EIR/Conversion/ConversionSupport.h"
+#include "lumen/EIR/Conversion/HeapAllocation.h"
 
 namespace lumen {
 namespace eir {
@@ -12,7 +13,8 @@ class UnpackEnvOpConversion;
 void populateFuncLikeOpConversionPatterns(OwningRewritePatternList &patterns,
                                           MLIRContext *context,
                                           EirTypeConverter &converter,
-                                          TargetInfo &targetInfo);
+                                          TargetInfo &targetInfo,
+                                          HeapAllocationPlan &heapPlan);
 }  // namespace eir
 }  // namespace lumen
 
@@ -0,0 +1,86 @@
+#include "lumen/EIR/Conversion/HeapAllocation.h"
+
+#include "llvm/Support/MathExtras.h"
+
+namespace lumen {
+namespace eir {
+
+// All heap allocations are aligned to at least 8 bytes, as required for
+// pointer tagging on all supported targets
+static constexpr uint64_t MIN_HEAP_ALIGN = 8;
+
+// Returns true if the given operation can be placed between two allocations
+// sharing a reservation, i.e. it is guaranteed not to yield, call into
+// Erlang code, or otherwise give the garbage collector an opportunity to run.
+static bool canBeFusedAcross(Operation *op) {
+    if (op->hasTrait<mlir::OpTrait::ConstantLike>()) return true;
+
+    return isa<CastOp, GetElementPtrOp, NullOp, IsTypeOp, IsTupleOp,
+               IsFunctionOp>(op);
+}
+
+Optional<uint64_t> HeapAllocationPlan::getAllocationSize(Operation *op) const {
+    uint64_t wordSize = targetInfo.pointerSizeInBits / 8;
+    uint64_t words;
+
+    if (auto consOp = dyn_cast<ConsOp>(op)) {
+        words = 2;
+    } else if (auto tupleOp = dyn_cast<TupleOp>(op)) {
+        words = tupleOp.elements().size() + 1;
+    } else if (auto listOp = dyn_cast<ListOp>(op)) {
+        // See ListOpConversion, the last element is used as the tail of
+        // the list when more than one element is given
+        auto numElements = listOp.elements().size();
+        if (numElements == 0) return llvm::None;
+        auto cells = numElements == 1 ? 1 : numElements - 1;
+        words = cells * 2;
+    } else if (auto closureOp = dyn_cast<ClosureOp>(op)) {
+        words = targetInfo.closureHeaderArity(closureOp.envLen()) + 1;
+    } else {
+        return llvm::None;
+    }
+
+    auto align = std::max(wordSize, MIN_HEAP_ALIGN);
+    return llvm::alignTo(words * wordSize, align);
+}
+
+Optional<HeapSlot> HeapAllocationPlan::lookup(Operation *op) const {
+    auto it = slots.find(op);
+    if (it == slots.end()) return llvm::None;
+    return it->second;
+}
+
+void HeapAllocationPlan::analyze(ModuleOp mod) {
+    mod.walk([&](Operation *op) {
+        for (auto &region : op->getRegions())
+            for (auto &block : region) analyzeBlock(block);
+    });
+}
+
+void HeapAllocationPlan::analyzeBlock(Block &block) {
+    SmallVector<std::pair<Operation *, uint64_t>, 4> run;
+    uint64_t reserved = 0;
+
+    auto finishRun = [&]() {
+        if (!run.empty()) {
+            Operation *leader = run.front().first;
+            for (auto &entry : run)
+                slots[entry.first] = HeapSlot{leader, entry.second, reserved};
+        }
+        run.clear();
+        reserved = 0;
+    };
+
+    for (auto &op : block) {
+        if (auto size = getAllocationSize(&op)) {
+            run.push_back(std::make_pair(&op, reserved));
+            reserved += size.getValue();
+            continue;
+        }
+        if (!canBeFusedAcross(&op)) finishRun();
+    }
+    finishRun();
+}
+
+}  // namespace eir
+}  // namespace lumen
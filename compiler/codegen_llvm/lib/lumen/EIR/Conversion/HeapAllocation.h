@@ -0,0 +1,125 @@
+#ifndef LUMEN_EIR_CONVERSION_HEAP_ALLOCATION_H
+#define LUMEN_EIR_CONVERSION_HEAP_ALLOCATION_H
+
+#include "lumen/EIR/Conversion/ConversionSupport.h"
+
+#include "llvm/ADT/DenseMap.h"
+
+namespace lumen {
+namespace eir {
+
+/// Describes the location of a single allocation within the heap
+/// reservation made on behalf of its group.
+struct HeapSlot {
+    // The operation which makes the reservation for the group
+    Operation *leader;
+    // The offset (in bytes) of this allocation from the start of the
+    // reservation
+    uint64_t offset;
+    // The total size (in bytes) of the reservation for the group
+    uint64_t reserved;
+};
+
+/// This class groups the allocating operations (i.e. cons cells, lists,
+/// tuples and closures) of each block into runs which can share a single
+/// reservation on the process heap.
+///
+/// A run is broken by any operation which might call into the runtime, as
+/// the reserved memory is uninitialized until each allocation in the run has
+/// been written, and must not be observed by the garbage collector.
+///
+/// The plan is computed before conversion; the first operation of each run to
+/// be lowered makes the reservation, and the rest of the run is lowered
+/// relative to it. Operations introduced during conversion are not part of
+/// any run, and are allocated individually.
+class HeapAllocationPlan {
+   public:
+    explicit HeapAllocationPlan(TargetInfo &ti) : targetInfo(ti) {}
+
+    /// Computes allocation groups for every block in the given module
+    void analyze(ModuleOp mod);
+
+    /// Returns the number of bytes the given op will allocate on the process
+    /// heap, or None if it does not allocate
+    Optional<uint64_t> getAllocationSize(Operation *op) const;
+
+    /// Returns the slot assigned to the given op, if it was grouped
+    Optional<HeapSlot> lookup(Operation *op) const;
+
+    /// Returns the reservation made by the given group leader, if it has
+    /// been lowered
+    Value getReservation(Operation *leader) const {
+        return reservations.lookup(leader);
+    }
+
+    void setReservation(Operation *leader, Value base) {
+        reservations[leader] = base;
+    }
+
+   private:
+    void analyzeBlock(Block &block);
+
+    TargetInfo &targetInfo;
+    llvm::DenseMap<Operation *, HeapSlot> slots;
+    llvm::DenseMap<Operation *, Value> reservations;
+};
+
+/// Base class for the lowering of operations which allocate on the process
+/// heap.
+template <typename Op>
+class EIRHeapAllocOpConversion : public EIROpConversion<Op> {
+   public:
+    explicit EIRHeapAllocOpConversion(MLIRContext *context,
+                                      EirTypeConverter &tc, TargetInfo &ti,
+                                      HeapAllocationPlan &plan,
+                                      mlir::PatternBenefit benefit = 1)
+        : EIROpConversion<Op>(context, tc, ti, benefit), plan(plan) {}
+
+   protected:
+    /// Allocates `bytes` of memory for `op` on the process heap, returning a
+    /// pointer of type `ty*` to the allocation.
+    ///
+    /// If `op` is part of a group, the leader reserves memory for the entire
+    /// group, and subsequent members are offset from that reservation.
+    Value allocate(RewritePatternContext<Op> &ctx, LLVMType ty,
+                   uint64_t bytes) const {
+        Operation *rawOp = ctx.op.getOperation();
+        auto i8PtrTy = ctx.getI8Type().getPointerTo();
+        auto ptrTy = ty.getPointerTo();
+
+        auto maybeSlot = plan.lookup(rawOp);
+        if (!maybeSlot.hasValue()) {
+            Value ptr = ctx.buildHeapReserve(bytes);
+            return llvm_bitcast(ptrTy, ptr);
+        }
+
+        auto slot = maybeSlot.getValue();
+        Value base;
+        if (slot.leader == rawOp) {
+            base = ctx.buildHeapReserve(slot.reserved);
+            plan.setReservation(rawOp, base);
+        } else {
+            base = plan.getReservation(slot.leader);
+            // The leader was not lowered through this path, so fall back to
+            // allocating individually
+            if (!base) {
+                Value ptr = ctx.buildHeapReserve(bytes);
+                return llvm_bitcast(ptrTy, ptr);
+            }
+        }
+
+        if (slot.offset == 0) return llvm_bitcast(ptrTy, base);
+
+        auto termTy = ctx.getUsizeType();
+        Value offset = llvm_constant(termTy, ctx.getIntegerAttr(slot.offset));
+        Value ptr = llvm_gep(i8PtrTy, base, ArrayRef<Value>{offset});
+        return llvm_bitcast(ptrTy, ptr);
+    }
+
+    HeapAllocationPlan &plan;
+};
+
+}  // namespace eir
+}  // namespace lumen
+
+#endif  // LUMEN_EIR_CONVERSION_HEAP_ALLOCATION_H
@@ -0,0 +1,158 @@
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+
+#include "lumen/EIR/Conversion/Passes.h"
+#include "lumen/EIR/IR/EIRDialect.h"
+#include "lumen/EIR/IR/EIROps.h"
+
+#include "llvm/ADT/DenseMap.h"
+
+using ::mlir::Block;
+using ::mlir::DialectRegistry;
+using ::mlir::OpBuilder;
+using ::mlir::Operation;
+using ::mlir::OperationPass;
+using ::mlir::PassWrapper;
+using ::mlir::Region;
+using ::mlir::Value;
+using ::mlir::ValueRange;
+
+using ::llvm::DenseMap;
+using ::llvm::isa;
+using ::llvm::SmallVector;
+using ::llvm::SmallVectorImpl;
+
+namespace {
+
+using namespace ::lumen::eir;
+
+/// Inserts the reduction counting and yield checks which give the scheduler
+/// a chance to preempt a process.
+///
+/// Every call made by a function costs a reduction, but rather than count
+/// each call separately, the calls made by a block are counted together, at
+/// the first call in the block.
+///
+/// A process can only run indefinitely by making calls or by looping.
+/// Functions which make calls check the reduction count against the budget
+/// on entry, which covers recursion, the usual way Erlang code loops. Loops
+/// within the body of a function, such as those introduced by `receive`, are
+/// checked at their headers instead. Leaf functions with an acyclic body are
+/// bounded, so their check is elided entirely.
+struct InsertReductionChecksPass
+    : public PassWrapper<InsertReductionChecksPass, OperationPass<FuncOp>> {
+    InsertReductionChecksPass(unsigned budget) : budget(budget) {}
+    InsertReductionChecksPass(const InsertReductionChecksPass &other)
+        : budget(other.budget) {}
+
+    void getDependentDialects(DialectRegistry &registry) const override {
+        registry.insert<mlir::StandardOpsDialect, mlir::LLVM::LLVMDialect,
+                        lumen::eir::eirDialect>();
+    }
+
+    void runOnOperation() override {
+        FuncOp op = getOperation();
+        if (op.isExternal()) return;
+
+        Region &body = op.getBody();
+
+        bool hasCalls = false;
+        for (Block &block : body) hasCalls |= countReductions(block);
+
+        SmallVector<Block *, 2> loopHeaders;
+        findLoopHeaders(body, loopHeaders);
+
+        for (Block *header : loopHeaders) insertYieldCheck(op, header);
+        // Functions which make calls need to check on entry, even if the
+        // entry block is a loop header
+        if (hasCalls && !llvm::is_contained(loopHeaders, &body.front()))
+            insertYieldCheck(op, &body.front());
+    }
+
+    /// Coalesces the reductions for all calls in `block` into a single
+    /// increment, returning true if there were any calls
+    bool countReductions(Block &block) {
+        Operation *firstCall = nullptr;
+        unsigned numCalls = 0;
+        for (Operation &op : block) {
+            if (!isa<CallOp>(op) && !isa<InvokeOp>(op)) continue;
+            if (!firstCall) firstCall = &op;
+            ++numCalls;
+        }
+        if (!firstCall) return false;
+
+        OpBuilder builder(firstCall);
+        builder.create<IncrementReductionsOp>(
+            firstCall->getLoc(), builder.getI32IntegerAttr(numCalls));
+        return true;
+    }
+
+    /// Finds the targets of all back-edges in `body`, i.e. the headers of
+    /// any loops
+    void findLoopHeaders(Region &body, SmallVectorImpl<Block *> &headers) {
+        enum class Visit { InProgress, Done };
+        DenseMap<Block *, Visit> visited;
+        SmallVector<std::pair<Block *, unsigned>, 8> worklist;
+
+        Block *entry = &body.front();
+        visited[entry] = Visit::InProgress;
+        worklist.push_back({entry, 0});
+        while (!worklist.empty()) {
+            Block *block = worklist.back().first;
+            unsigned index = worklist.back().second;
+            if (index == block->getNumSuccessors()) {
+                visited[block] = Visit::Done;
+                worklist.pop_back();
+                continue;
+            }
+            ++worklist.back().second;
+
+            Block *succ = block->getSuccessor(index);
+            auto it = visited.find(succ);
+            if (it == visited.end()) {
+                visited[succ] = Visit::InProgress;
+                worklist.push_back({succ, 0});
+            } else if (it->second == Visit::InProgress) {
+                if (!llvm::is_contained(headers, succ)) headers.push_back(succ);
+            }
+        }
+    }
+
+    /// Splits `block` so that it begins with a check of the reduction count
+    /// against the budget, which yields to the scheduler when exhausted
+    void insertYieldCheck(FuncOp op, Block *block) {
+        auto loc = op.getLoc();
+
+        // Move the contents of `block` into a new block, which becomes the
+        // successor of the check. Since the values in `block` dominate the
+        // split, we don't have to pass arguments
+        Block *dontYield = block->splitBlock(&block->front());
+        Block *doYield = new Block();
+        op.getBody().getBlocks().insertAfter(Region::iterator(block), doYield);
+
+        OpBuilder builder(op.getContext());
+        builder.setInsertionPointToEnd(block);
+        Value maxReductions = builder.create<mlir::ConstantIntOp>(
+            loc, budget, builder.getIntegerType(32));
+        builder.create<YieldCheckOp>(loc, maxReductions, doYield, ValueRange{},
+                                     dontYield, ValueRange{});
+
+        // Then insert the actual yield point in the yield block, and resume
+        // afterwards
+        builder.setInsertionPointToEnd(doYield);
+        builder.create<YieldOp>(loc);
+        builder.create<BranchOp>(loc, dontYield);
+    }
+
+   private:
+    unsigned budget;
+};
+}  // namespace
+
+namespace lumen {
+namespace eir {
+std::unique_ptr<mlir::Pass> createInsertReductionChecksPass(unsigned budget) {
+    return std::make_unique<InsertReductionChecksPass>(budget);
+}
+}  // namespace eir
+}  // namespace lumen
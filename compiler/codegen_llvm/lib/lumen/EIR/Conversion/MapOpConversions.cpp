@@ -3,6 +3,114 @@
 namespace lumen {
 namespace eir {
 
+// Maps with at most this many entries are stored as a flatmap, which is a
+// tuple of alternating keys and values, see `Map` in liblumen_alloc
+static constexpr uint64_t MAX_FLATMAP_SIZE = 32;
+
+// Returns true if `key` is an atom known at compile time, which is only ever
+// equal to a term with the same encoding
+static bool isConstantAtom(Value key) {
+    Operation *definingOp = key.getDefiningOp();
+    if (auto castOp = dyn_cast_or_null<CastOp>(definingOp))
+        definingOp = castOp.input().getDefiningOp();
+    return definingOp && isa<ConstantAtomOp>(definingOp);
+}
+
+// Looks up `key` in `map`, producing the value of the key, or the none value
+// if the key is not present.
+//
+// When the key is a constant atom, flatmaps are searched inline by comparing
+// the key against each key slot of the map, and only larger maps are
+// deferred to the runtime.
+template <typename Op>
+static Value buildMapLookup(RewritePatternContext<Op> &ctx, Value map,
+                            Value key, bool isAtomKey) {
+    auto &rewriter = ctx.rewriter;
+    auto termTy = ctx.getUsizeType();
+    auto termPtrTy = termTy.getPointerTo();
+
+    StringRef symbolName("__lumen_builtin_map.get");
+    auto callee =
+        ctx.getOrInsertFunction(symbolName, termTy, {termTy, termTy});
+    auto calleeSymbol =
+        FlatSymbolRefAttr::get(symbolName, callee->getContext());
+
+    if (!isAtomKey) {
+        Operation *call = llvm_call(ArrayRef<Type>{termTy}, calleeSymbol,
+                                    ArrayRef<Value>{map, key});
+        return call->getResult(0);
+    }
+
+    // A map is a header, followed by its size and root, which for flatmaps
+    // is a tuple of alternating keys and values
+    Value zero = llvm_constant(termTy, ctx.getIntegerAttr(0));
+    Value one = llvm_constant(termTy, ctx.getIntegerAttr(1));
+    Value two = llvm_constant(termTy, ctx.getIntegerAttr(2));
+    Value maxFlatmapSize =
+        llvm_constant(termTy, ctx.getIntegerAttr(MAX_FLATMAP_SIZE));
+    Value noneVal = llvm_constant(
+        termTy,
+        ctx.getIntegerAttr(ctx.targetInfo.getNoneValue().getLimitedValue()));
+    Value mapPtr = ctx.decodeBox(termTy, map);
+    Value size = ctx.decodeImmediate(
+        llvm_load(llvm_gep(termPtrTy, mapPtr, ArrayRef<Value>{one})));
+    Value root = llvm_load(llvm_gep(termPtrTy, mapPtr, ArrayRef<Value>{two}));
+    Value isFlatmap = llvm_icmp(LLVM::ICmpPredicate::ule, size, maxFlatmapSize);
+
+    // The value found is passed to the continuation as a block argument
+    Block *current = rewriter.getInsertionBlock();
+    Block *cont = rewriter.splitBlock(current, rewriter.getInsertionPoint());
+    cont->addArgument(termTy);
+
+    Block *scan = new Block();
+    Block *loop = new Block();
+    Block *body = new Block();
+    Block *found = new Block();
+    Block *slow = new Block();
+    loop->addArgument(termTy);
+    auto nextIt = std::next(Region::iterator(current));
+    auto &blocks = current->getParent()->getBlocks();
+    for (Block *block : {scan, loop, body, found, slow})
+        blocks.insert(nextIt, block);
+
+    rewriter.setInsertionPointToEnd(current);
+    llvm_condbr(isFlatmap, scan, ValueRange(), slow, ValueRange());
+
+    rewriter.setInsertionPointToEnd(scan);
+    Value tuplePtr = ctx.decodeBox(termTy, root);
+    llvm_br(ValueRange(zero), loop);
+
+    // Entries are scanned in order until the key or the end of the map is
+    // reached, key slots follow the tuple header at odd indices
+    rewriter.setInsertionPointToEnd(loop);
+    Value index = loop->getArgument(0);
+    Value isEnd = llvm_icmp(LLVM::ICmpPredicate::eq, index, size);
+    llvm_condbr(isEnd, cont, ValueRange(noneVal), body, ValueRange());
+
+    rewriter.setInsertionPointToEnd(body);
+    Value keyIndex = llvm_add(llvm_mul(index, two), one);
+    Value entryKey =
+        llvm_load(llvm_gep(termPtrTy, tuplePtr, ArrayRef<Value>{keyIndex}));
+    Value isKey = llvm_icmp(LLVM::ICmpPredicate::eq, entryKey, key);
+    Value nextIndex = llvm_add(index, one);
+    llvm_condbr(isKey, found, ValueRange(), loop, ValueRange(nextIndex));
+
+    rewriter.setInsertionPointToEnd(found);
+    Value valueIndex = llvm_add(keyIndex, one);
+    Value value =
+        llvm_load(llvm_gep(termPtrTy, tuplePtr, ArrayRef<Value>{valueIndex}));
+    llvm_br(ValueRange(value), cont);
+
+    // Tries are hashed, which is left to the runtime
+    rewriter.setInsertionPointToEnd(slow);
+    Operation *call = llvm_call(ArrayRef<Type>{termTy}, calleeSymbol,
+                                ArrayRef<Value>{map, key});
+    llvm_br(call->getResults(), cont);
+
+    rewriter.setInsertionPointToStart(cont);
+    return cont->getArgument(0);
+}
+
 struct MapOpConversion : public EIROpConversion<MapOp> {
     using EIROpConversion::EIROpConversion;
 
@@ -128,6 +236,19 @@ struct MapContainsKeyOpConversion : public EIROpConversion<MapContainsKeyOp> {
         auto ctx = getRewriteContext(op, rewriter);
         MapContainsKeyOpAdaptor adaptor(operands);
 
+        Value map = adaptor.map();
+        Value key = adaptor.key();
+        if (isConstantAtom(op.key())) {
+            auto termTy = ctx.getUsizeType();
+            Value noneVal = llvm_constant(
+                termTy, ctx.getIntegerAttr(
+                            ctx.targetInfo.getNoneValue().getLimitedValue()));
+            Value value = buildMapLookup(ctx, map, key, /*isAtomKey=*/true);
+            Value isKey = llvm_icmp(LLVM::ICmpPredicate::ne, value, noneVal);
+            rewriter.replaceOp(op, {isKey});
+            return success();
+        }
+
         auto termTy = ctx.getUsizeType();
         auto i1Ty = ctx.getI1Type();
         StringRef symbolName("__lumen_builtin_map.is_key");
@@ -136,8 +257,6 @@ struct MapContainsKeyOpConversion : public EIROpConversion<MapContainsKeyOp> {
         auto calleeSymbol =
             FlatSymbolRefAttr::get(symbolName, callee->getContext());
 
-        Value map = adaptor.map();
-        Value key = adaptor.key();
         rewriter.replaceOpWithNewOp<mlir::CallOp>(op, calleeSymbol, i1Ty,
                                                   ArrayRef<Value>{map, key});
         return success();
@@ -154,16 +273,15 @@ struct MapGetKeyOpConversion : public EIROpConversion<MapGetKeyOp> {
         MapGetKeyOpAdaptor adaptor(operands);
 
         auto termTy = ctx.getUsizeType();
-        StringRef symbolName("__lumen_builtin_map.get");
-        auto callee =
-            ctx.getOrInsertFunction(symbolName, termTy, {termTy, termTy});
-        auto calleeSymbol =
-            FlatSymbolRefAttr::get(symbolName, callee->getContext());
-
         Value map = adaptor.map();
         Value key = adaptor.key();
-        rewriter.replaceOpWithNewOp<mlir::CallOp>(op, calleeSymbol, termTy,
-                                                  ArrayRef<Value>{map, key});
+        Value value = buildMapLookup(ctx, map, key, isConstantAtom(op.key()));
+        Value noneVal = llvm_constant(
+            termTy, ctx.getIntegerAttr(
+                        ctx.targetInfo.getNoneValue().getLimitedValue()));
+        Value found = llvm_icmp(LLVM::ICmpPredicate::ne, value, noneVal);
+
+        rewriter.replaceOp(op, {value, found});
         return success();
     }
 };
@@ -57,11 +57,11 @@ static void buildDeoptimizationPath(Location loc,
     // block where we re-encode the result and continue
     // execution where we left off
     ctx.rewriter.setInsertionPointToEnd(current);
-    llvm_condbr(obit, normal, ValueRange(), overflow, ValueRange());
+    llvm_condbr(obit, overflow, ValueRange(), normal, ValueRange());
 
-    // Handle normal
+    // Handle normal, the result is signed, so it must be sign-extended
     ctx.rewriter.setInsertionPointToEnd(normal);
-    Value extended = llvm_zext(termTy, resultFix);
+    Value extended = llvm_sext(termTy, resultFix);
     Value encoded = ctx.encodeImmediate(concreteTy, extended);
     llvm_br(ValueRange(encoded), cont);
 
@@ -9,7 +9,9 @@
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Pass/PassRegistry.h"
 
+#include "lumen/EIR/Builder/Passes.h"
 #include "lumen/EIR/Conversion/ConvertEIRToLLVM.h"
+#include "lumen/EIR/Conversion/Passes.h"
 #include "lumen/EIR/IR/EIROps.h"
 #include "lumen/llvm/Target.h"
 #include "lumen/mlir/MLIR.h"
@@ -40,6 +42,7 @@ struct PassManagerOptions {
     bool printAfterPass;
     bool printModuleScopeAlways;
     bool printAfterOnlyOnChange;
+    uint32_t reductionBudget;
 };
 }
 
@@ -70,9 +73,12 @@ extern "C" MLIRPassManagerRef MLIRCreatePassManager(
         llvm::errs(), printerFlags);
 
     // Configure Pass Timing
+    //
+    // The same passes run both before and after lowering, so timings are
+    // reported per-pipeline to tell them apart
     if (options->enableTiming) {
         auto config = std::make_unique<PassManager::PassTimingConfig>(
-            PassDisplayMode::List);
+            PassDisplayMode::Pipeline);
         pm->enableTiming(std::move(config));
     }
     if (options->enableStatistics) {
@@ -85,29 +91,44 @@ extern "C" MLIRPassManagerRef MLIRCreatePassManager(
     // TODO: Hook driver into instrumentation
     // pm.addInstrumentation(...);
 
+    // Optimize at the EIR level first, while term types are still visible
+    if (optLevel > CodeGenOptLevel::None) {
+        OpPassManager &eirPM = pm->nest<::lumen::eir::FuncOp>();
+        // Fold constants through casts, and strip redundant casts and
+        // trace captures
+        eirPM.addPass(mlir::createCanonicalizerPass());
+        // Merge identical type checks, and anything made identical by the
+        // canonicalizer
+        eirPM.addPass(mlir::createCSEPass());
+        // Resolve type checks implied by a dominating branch on the same check
+        eirPM.addPass(::lumen::eir::createSimplifyTypeChecksPass());
+        if (optLevel >= CodeGenOptLevel::Default) {
+            // Propagate the resolved checks through the control-flow graph
+            eirPM.addPass(mlir::createSCCPPass());
+        }
+        eirPM.addPass(mlir::createCanonicalizerPass());
+    }
+
+    // Count reductions and insert yield checks, this runs after optimization
+    // so that the checks reflect the calls which remain
+    pm->nest<::lumen::eir::FuncOp>().addPass(
+        ::lumen::eir::createInsertReductionChecksPass(options->reductionBudget));
+
     // Convert EIR to LLVM dialect
     pm->addPass(::lumen::eir::createConvertEIRToLLVMPass(targetMachine));
 
     // Canonicalize
-    pm->addNestedPass<::mlir::LLVM::LLVMFuncOp>(
-        mlir::createCanonicalizerPass());
+    OpPassManager &llvmPM = pm->nest<::mlir::LLVM::LLVMFuncOp>();
+    llvmPM.addPass(mlir::createCanonicalizerPass());
 
-    // Add optimizations if enabled
+    // Clean up after lowering, LLVM takes care of the rest
     if (optLevel > CodeGenOptLevel::None) {
-        // When optimizing for size, avoid aggressive inlining
-        if (sizeLevel == 0) {
-            // pm->addPass(mlir::createInlinerPass());
+        llvmPM.addPass(mlir::createCSEPass());
+        // When optimizing for size, skip the more expensive passes
+        if (optLevel == CodeGenOptLevel::Aggressive && sizeLevel == 0) {
+            llvmPM.addPass(mlir::createSCCPPass());
+            llvmPM.addPass(mlir::createCanonicalizerPass());
         }
-
-        // Canonicalize generated LLVM dialect, and perform optimizations
-        // OpPassManager &optPM = pm->nest<::mlir::LLVM::LLVMFuncOp>();
-        // optPM.addPass(mlir::createCanonicalizerPass());
-        // Sparse conditional constant propagation
-        // optPM.addPass(mlir::createSCCPPass());
-        // Common sub-expression elimination
-        // optPM.addPass(mlir::createCSEPass());
-        // Remove dead/unreachable symbols
-        // pm->addPass(mlir::createSymbolDCEPass());
     }
 
     return wrap(pm);
@@ -0,0 +1,14 @@
+#ifndef LUMEN_EIR_CONVERSION_PASSES_H
+#define LUMEN_EIR_CONVERSION_PASSES_H
+
+#include "mlir/Pass/Pass.h"
+
+#include <memory>
+
+namespace lumen {
+namespace eir {
+std::unique_ptr<mlir::Pass> createInsertReductionChecksPass(unsigned budget);
+}
+}  // namespace lumen
+
+#endif
@@ -130,6 +130,7 @@ TargetInfo::TargetInfo(llvm::TargetMachine *targetMachine, MLIRContext *ctx)
     impl->literalTag = lumen_literal_tag(&impl->encoding);
     impl->immediateMask = lumen_immediate_mask(&impl->encoding);
     impl->headerMask = lumen_header_mask(&impl->encoding);
+    impl->boxCheck = lumen_box_check(&impl->encoding);
 
     auto maxAllowedImmediateVal =
         APInt(64, impl->immediateMask.maxAllowedValue, /*signed=*/false);
@@ -243,5 +244,10 @@ uint32_t TargetInfo::closureHeaderArity(uint32_t envLen) const {
 }
 MaskInfo &TargetInfo::immediateMask() const { return impl->immediateMask; }
 MaskInfo &TargetInfo::headerMask() const { return impl->headerMask; }
+BoxCheck &TargetInfo::boxCheck() const { return impl->boxCheck; }
+
+TypeCheck TargetInfo::typeCheck(uint32_t type) const {
+    return lumen_type_check(&impl->encoding, type);
+}
 
 }  // namespace lumen
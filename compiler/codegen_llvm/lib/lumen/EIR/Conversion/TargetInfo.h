@@ -55,6 +55,7 @@ struct TargetInfoImpl {
           literalTag(other.literalTag),
           immediateMask(other.immediateMask),
           headerMask(other.headerMask),
+          boxCheck(other.boxCheck),
           immediateBits(other.immediateBits) {}
 
     std::string triple;
@@ -81,6 +82,7 @@ struct TargetInfoImpl {
     uint64_t literalTag;
     MaskInfo immediateMask;
     MaskInfo headerMask;
+    BoxCheck boxCheck;
     uint8_t immediateBits;
 };
 
@@ -96,6 +98,11 @@ class TargetInfo {
         return archType == llvm::Triple::ArchType::wasm32;
     }
     bool requiresPackedFloats() const { return !is_x86_64(); }
+    // Lists can only be flagged as literals when the literal tag does not
+    // overlap with the list tag, which is only the case for nanboxed targets
+    bool supportsLiteralLists() const {
+        return (impl->literalTag & impl->listMask) == 0;
+    }
 
     mlir::LLVM::LLVMType getConsType() { return impl->consTy; }
     mlir::LLVM::LLVMType getFloatType() { return impl->floatTy; }
@@ -148,6 +155,8 @@ class TargetInfo {
     uint32_t closureHeaderArity(uint32_t envLen) const;
     MaskInfo &immediateMask() const;
     MaskInfo &headerMask() const;
+    BoxCheck &boxCheck() const;
+    TypeCheck typeCheck(uint32_t type) const;
 
     unsigned pointerSizeInBits;
 
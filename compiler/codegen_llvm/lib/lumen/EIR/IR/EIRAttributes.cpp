@@ -388,3 +388,16 @@ SeqAttr SeqAttr::getChecked(Type type, ArrayRef<Attribute> value,
 }
 
 ArrayRef<Attribute> &SeqAttr::getValue() const { return getImpl()->value; }
+
+// The hash is derived from the printed form of the sequence, which includes
+// the type and all elements, so it is stable across compilations
+std::string SeqAttr::getHash() const {
+    std::string printed;
+    llvm::raw_string_ostream os(printed);
+    print(os);
+    os.flush();
+
+    llvm::SHA1 hasher;
+    hasher.update(ArrayRef<uint8_t>((uint8_t *)printed.data(), printed.size()));
+    return llvm::toHex(hasher.result(), true);
+}
@@ -138,6 +138,7 @@ class SeqAttr : public Attribute::AttrBase<SeqAttr, Attribute,
                               Location loc);
 
     ArrayRef<Attribute> &getValue() const;
+    std::string getHash() const;
 
     /// Support range iteration.
     using iterator = ArrayRef<Attribute>::iterator;
@@ -1064,6 +1064,41 @@ OpFoldResult IsTypeOp::fold(ArrayRef<Attribute> operands) {
     return nullptr;
 }
 
+namespace {
+/// Casting a term to an opaque term does not change the encoded value, so a
+/// type check on the result of such a cast can be performed on the input
+/// instead. This exposes the more precise type (or constant value) of the
+/// input to folding, and allows equivalent checks to be eliminated as common
+/// subexpressions.
+///
+/// eir.is_type(eir.cast(%0 : A -> term), T) -> eir.is_type(%0 : A, T)
+struct IsTypeThroughCast : public OpRewritePattern<IsTypeOp> {
+    using OpRewritePattern<IsTypeOp>::OpRewritePattern;
+
+    LogicalResult matchAndRewrite(IsTypeOp op,
+                                  PatternRewriter &rewriter) const override {
+        auto castOp = dyn_cast_or_null<CastOp>(op.value().getDefiningOp());
+        if (!castOp) return failure();
+
+        // Casts to a more precise type carry information the input does not
+        Value input = castOp.input();
+        auto destType = castOp.getType().dyn_cast<OpaqueTermType>();
+        if (!input.getType().isa<OpaqueTermType>() || !destType ||
+            !destType.isOpaque())
+            return failure();
+
+        rewriter.updateRootInPlace(
+            op, [&]() { op.getOperation()->setOperand(0, input); });
+        return success();
+    }
+};
+}  // end anonymous namespace.
+
+void IsTypeOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
+                                           MLIRContext *context) {
+    results.insert<IsTypeThroughCast>(context);
+}
+
 //===----------------------------------------------------------------------===//
 // eir.is_tuple
 //===----------------------------------------------------------------------===//
@@ -1261,6 +1296,53 @@ static LogicalResult verify(CastOp op) {
     return op.emitError("invalid cast type, source type is unsupported");
 }
 
+// Returns true if a cast between the given term types is lowered as a no-op,
+// see CastOpConversion
+static bool isNoopTermCast(OpaqueTermType srcType, OpaqueTermType destType) {
+    if (srcType == destType) return true;
+    if (srcType.isOpaque() || destType.isOpaque()) return true;
+    if (srcType.isBox() && destType.isBox()) return true;
+    return false;
+}
+
+namespace {
+/// Removes redundant chains of casts between term types, i.e. boxing a value
+/// only to unbox it again, or casting to an opaque term and back.
+///
+/// eir.cast(eir.cast(%0 : A -> B) : B -> A) -> %0
+/// eir.cast(eir.cast(%0 : A -> B) : B -> C) -> eir.cast(%0 : A -> C)
+struct SimplifyCastChain : public OpRewritePattern<CastOp> {
+    using OpRewritePattern<CastOp>::OpRewritePattern;
+
+    LogicalResult matchAndRewrite(CastOp op,
+                                  PatternRewriter &rewriter) const override {
+        auto parent = dyn_cast_or_null<CastOp>(op.input().getDefiningOp());
+        if (!parent) return failure();
+
+        Value input = parent.input();
+        auto srcType = input.getType().dyn_cast<OpaqueTermType>();
+        auto midType = parent.getType().dyn_cast<OpaqueTermType>();
+        auto destType = op.getType().dyn_cast<OpaqueTermType>();
+        if (!srcType || !midType || !destType) return failure();
+
+        if (srcType == destType) {
+            rewriter.replaceOp(op, input);
+            return success();
+        }
+
+        if (!isNoopTermCast(srcType, destType)) return failure();
+
+        rewriter.replaceOpWithNewOp<CastOp>(op, input, destType);
+        return success();
+    }
+};
+}  // end anonymous namespace.
+
+void CastOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
+                                         MLIRContext *context) {
+    results.insert<SimplifyCastChain>(context);
+}
+
 //===----------------------------------------------------------------------===//
 // eir.match
 //===----------------------------------------------------------------------===//
@@ -1470,13 +1552,11 @@ LogicalResult lowerPatternMatch(OpBuilder &builder, Location loc,
         case MatchPatternType::MapItem: {
             assert(nextPatternBlock != nullptr &&
                    "last match block must end in unconditional branch");
-            // 1. Split block twice, and conditionally branch to the first split
-            // if is_map, otherwise the next pattern
+            // 1. Split block, and conditionally branch to the split if is_map,
+            // otherwise the next pattern
             auto cip = builder.saveInsertionPoint();
-            Block *split2 =
-                builder.createBlock(region, Region::iterator(nextPatternBlock));
             Block *split =
-                builder.createBlock(region, Region::iterator(split2));
+                builder.createBlock(region, Region::iterator(nextPatternBlock));
             builder.restoreInsertionPoint(cip);
             auto *pattern = b.getPatternTypeOrNull<MapPattern>();
             auto key = pattern->getKey();
@@ -1487,31 +1567,23 @@ LogicalResult lowerPatternMatch(OpBuilder &builder, Location loc,
             auto ifOp = builder.create<CondBranchOp>(
                 branchLoc, isMapCond, split, emptyArgs, nextPatternBlock,
                 withSelectorArgs);
-            // 2. In the split, call runtime function `is_map_key` to confirm
-            // existence of the key in the map,
-            //    then conditionally branch to the second split if successful,
-            //    otherwise the next pattern
+            // 2. In the split, look up the key, which both confirms its
+            // existence and obtains its value in a single lookup
             builder.setInsertionPointToEnd(split);
-            auto hasKeyOp =
-                builder.create<MapContainsKeyOp>(branchLoc, selectorArg, key);
-            auto hasKeyCond = hasKeyOp.getResult();
-            builder.create<CondBranchOp>(branchLoc, hasKeyCond, split2,
-                                         emptyArgs, nextPatternBlock,
-                                         withSelectorArgs);
-            // 3. In the second split, call runtime function `map_get` to obtain
-            // the value for the key
-            builder.setInsertionPointToEnd(split2);
             auto mapGetOp =
                 builder.create<MapGetKeyOp>(branchLoc, selectorArg, key);
-            auto valueTerm = mapGetOp.getResult();
+            auto valueTerm = mapGetOp.value();
+            auto foundCond = mapGetOp.found();
             unsigned i = numBaseDestArgs > 0 ? numBaseDestArgs - 1 : 0;
             dest->getArgument(i).setType(valueTerm.getType());
-            // 4. Unconditionally branch to the destination, with the key's
-            // value as an additional destArg
+            // 3. Conditionally branch to the destination if the key was found,
+            // with the key's value as an additional destArg, otherwise the
+            // next pattern
             SmallVector<Value, 2> destArgs(baseDestArgs.begin(),
                                            baseDestArgs.end());
             destArgs.push_back(valueTerm);
-            builder.create<BranchOp>(branchLoc, dest, destArgs);
+            builder.create<CondBranchOp>(branchLoc, foundCond, dest, destArgs,
+                                         nextPatternBlock, withSelectorArgs);
             break;
         }
 
@@ -2601,6 +2673,32 @@ void TupleOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
     results.insert<CanonicalizeTuple>(context);
 }
 
+//===----------------------------------------------------------------------===//
+// eir.trace_capture
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// The trace is only ever handed to the runtime explicitly, so a capture
+/// which is never used can be removed, along with the cost of walking the
+/// stack.
+struct EraseDeadTraceCapture : public OpRewritePattern<TraceCaptureOp> {
+    using OpRewritePattern<TraceCaptureOp>::OpRewritePattern;
+
+    LogicalResult matchAndRewrite(TraceCaptureOp op,
+                                  PatternRewriter &rewriter) const override {
+        if (!op.use_empty()) return failure();
+
+        rewriter.eraseOp(op);
+        return success();
+    }
+};
+}  // end anonymous namespace.
+
+void TraceCaptureOp::getCanonicalizationPatterns(
+    OwningRewritePatternList &results, MLIRContext *context) {
+    results.insert<EraseDeadTraceCapture>(context);
+}
+
 //===----------------------------------------------------------------------===//
 // eir.map.*
 //===----------------------------------------------------------------------===//
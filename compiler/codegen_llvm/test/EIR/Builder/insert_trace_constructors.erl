@@ -0,0 +1,30 @@
+% RUN: lumen compile -O0 --emit=mlir-eir --output-dir Output/insert_trace_constructors %s
+% RUN: LumenFileCheck %s < Output/insert_trace_constructors/insert_trace_constructors.eir.mlir
+-module(insert_trace_constructors).
+
+-export([unused/1, used/1]).
+
+% The catch block never looks at the stack trace, so it is never captured,
+% and a null reference is passed along instead
+%
+% CHECK-LABEL: eir.func @"insert_trace_constructors:unused/1"
+% CHECK-NOT: eir.trace_capture
+% CHECK: eir.null : !eir.trace_ref
+% CHECK-NOT: eir.trace_capture
+% CHECK-NOT: eir.trace_construct
+unused(X) ->
+    try throw(X)
+    catch _:Reason -> Reason
+    end.
+
+% Here the trace is used as a term, so it is captured when thrown, and only
+% constructed in the catch block which needs it
+%
+% CHECK-LABEL: eir.func @"insert_trace_constructors:used/1"
+% CHECK-NOT: eir.null : !eir.trace_ref
+% CHECK: eir.trace_capture : !eir.trace_ref
+% CHECK: eir.trace_construct(%{{.+}}) : (!eir.trace_ref) -> !eir.box<!eir.cons>
+used(X) ->
+    try throw(X)
+    catch _:Reason:Stacktrace -> {Reason, Stacktrace}
+    end.
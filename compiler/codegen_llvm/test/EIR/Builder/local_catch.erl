@@ -0,0 +1,32 @@
+% RUN: lumen compile -O0 --emit=mlir-eir --output-dir Output/local_catch %s
+% RUN: LumenFileCheck %s < Output/local_catch/local_catch.eir.mlir
+-module(local_catch).
+
+-export([catch_throw/1, catch_raise/2]).
+
+% Exceptions caught in the function which raises them branch straight to the
+% catch block, rather than unwinding to a landing pad
+%
+% CHECK-LABEL: eir.func @"local_catch:catch_throw/1"
+% CHECK-NOT: eir.throw
+% CHECK-NOT: eir.landing_pad
+% CHECK: eir.br
+% CHECK-NOT: eir.throw
+% CHECK-NOT: eir.landing_pad
+catch_throw(X) ->
+    try throw(X)
+    catch _:Reason -> Reason
+    end.
+
+% The same goes for erlang:raise/3, whose trace is given as a term, and is
+% converted to the trace reference the catch block expects
+%
+% CHECK-LABEL: eir.func @"local_catch:catch_raise/2"
+% CHECK-NOT: eir.throw
+% CHECK: eir.trace_from_term(%{{.+}}) : (!eir.{{.+}}) -> !eir.trace_ref
+% CHECK-NOT: eir.throw
+% CHECK-NOT: eir.landing_pad
+catch_raise(Reason, Stacktrace) ->
+    try erlang:raise(error, Reason, Stacktrace)
+    catch _:Caught -> Caught
+    end.
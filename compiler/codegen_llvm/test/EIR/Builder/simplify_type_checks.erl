@@ -0,0 +1,28 @@
+% RUN: lumen compile -O1 -Z print-passes-after -Z print-passes-on-change=false --emit=mlir-eir --output-dir Output/simplify_type_checks %s 2>&1 | LumenFileCheck %s
+-module(simplify_type_checks).
+
+-export([describe/1]).
+
+% The inner check is dominated by the true edge of the outer one, so it is
+% resolved to a constant, leaving a single type check in the function
+%
+% CHECK-LABEL: IR Dump After{{.*}}SimplifyTypeChecksPass
+% CHECK: eir.func @"simplify_type_checks:describe/1"
+% CHECK: %[[IS_ATOM:.+]] = eir.typeof %{{.+}} is !eir.atom
+% CHECK: eir.cond_br %[[IS_ATOM]] : i1, ^[[YES:bb[0-9]+]]
+% CHECK: ^[[YES]]{{[:(]}}
+% CHECK-NEXT: %[[TRUE:.+]] = eir.constant.bool true
+% CHECK-NOT: eir.typeof
+% CHECK: eir.cond_br %[[TRUE]]
+% CHECK-NOT: eir.typeof
+% CHECK-LABEL: IR Dump After{{.*}}Canonicalizer
+describe(X) ->
+    if
+        is_atom(X) ->
+            if
+                is_atom(X) -> atom;
+                true -> impossible
+            end;
+        true ->
+            other
+    end.
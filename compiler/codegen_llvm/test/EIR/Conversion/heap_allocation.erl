@@ -0,0 +1,33 @@
+% RUN: lumen compile -O0 --emit=mlir-llvm --output-dir Output/heap_allocation %s
+% RUN: LumenFileCheck %s < Output/heap_allocation/heap_allocation.llvm.mlir
+-module(heap_allocation).
+
+-export([pair/2, triple/1]).
+
+% Tuples bump the heap top of the current process inline, and only call into
+% the runtime when the young heap is exhausted
+%
+% CHECK-LABEL: llvm.func @"heap_allocation:pair/2"
+% CHECK-NOT: @__lumen_builtin_malloc
+% CHECK: %[[SIZE:.+]] = llvm.mlir.constant(24 : i64)
+% CHECK: llvm.mlir.addressof @__lumen_process_heap
+% CHECK: %[[FITS:.+]] = llvm.icmp "ule"
+% CHECK: llvm.cond_br %[[FITS]], ^[[FAST:bb[0-9]+]], ^[[SLOW:bb[0-9]+]]
+% CHECK: ^[[FAST]]:
+% CHECK: llvm.store
+% CHECK: ^[[SLOW]]:
+% CHECK-NEXT: llvm.call @__lumen_builtin_heap_reserve(%[[SIZE]])
+% CHECK-NOT: @__lumen_builtin_malloc
+% CHECK: llvm.return
+pair(X, Y) ->
+    {X, Y}.
+
+% All of the cells of a list share a single reservation
+%
+% CHECK-LABEL: llvm.func @"heap_allocation:triple/1"
+% CHECK: llvm.call @__lumen_builtin_heap_reserve
+% CHECK-NOT: llvm.call @__lumen_builtin_heap_reserve
+% CHECK-NOT: @__lumen_builtin_malloc
+% CHECK: llvm.return
+triple(X) ->
+    [X, X, X].
@@ -0,0 +1,20 @@
+% RUN: lumen compile -O0 --emit=mlir-llvm --output-dir Output/immediate_encoding %s
+% RUN: LumenFileCheck %s < Output/immediate_encoding/immediate_encoding.llvm.mlir
+-module(immediate_encoding).
+
+-export([atom_check/1]).
+
+% Immediates are tagged inline, so the runtime encoder is never declared
+%
+% CHECK-NOT: @__lumen_builtin_encode_immediate
+%
+% The result of a type check is promoted to a boolean atom by a shift or
+% mask of the bit, tagged as an atom
+%
+% CHECK-LABEL: llvm.func @"immediate_encoding:atom_check/1"
+% CHECK: %[[BIT:.+]] = llvm.zext %{{.+}} : !llvm.i1 to !llvm.i64
+% CHECK: %[[PAYLOAD:.+]] = llvm.{{shl|and}} %[[BIT]], %{{.+}}
+% CHECK: llvm.or %[[PAYLOAD]], %{{.+}}
+% CHECK-NOT: @__lumen_builtin_encode_immediate
+atom_check(X) ->
+    is_atom(X).
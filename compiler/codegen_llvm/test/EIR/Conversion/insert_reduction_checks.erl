@@ -0,0 +1,38 @@
+% RUN: lumen compile -O0 -C reduction-budget=4000 -Z print-passes-after -Z print-passes-on-change=false --emit=mlir-eir --output-dir Output/insert_reduction_checks %s 2>&1 | LumenFileCheck %s
+-module(insert_reduction_checks).
+
+-export([leaf/1, calls/1, wait/1]).
+
+% CHECK-LABEL: IR Dump After{{.*}}InsertReductionChecksPass
+
+% Leaf functions with an acyclic body are bounded, so they are never checked
+%
+% CHECK-LABEL: eir.func @"insert_reduction_checks:leaf/1"
+% CHECK-NOT: eir.reductions.inc
+% CHECK-NOT: eir.yield.check
+leaf(X) ->
+    {X, X}.
+
+% Functions which make calls check the budget on entry, and each block counts
+% the calls it makes at its first call
+%
+% CHECK-LABEL: eir.func @"insert_reduction_checks:calls/1"
+% CHECK: %[[BUDGET:[a-z0-9_]+]] = constant 4000 : i32
+% CHECK-NEXT: eir.yield.check %[[BUDGET]], ^[[YIELD:bb[0-9]+]], ^[[RESUME:bb[0-9]+]]
+% CHECK: ^[[YIELD]]:
+% CHECK-NEXT: eir.yield
+% CHECK-NEXT: eir.br ^[[RESUME]]
+% CHECK: ^[[RESUME]]:
+% CHECK: eir.reductions.inc 1
+% CHECK-NEXT: eir.call @"insert_reduction_checks:leaf/1"
+calls(X) ->
+    {leaf(X), leaf(X)}.
+
+% Loops are checked at their header, here the loop which waits for a message
+%
+% CHECK-LABEL: eir.func @"insert_reduction_checks:wait/1"
+% CHECK: eir.yield.check
+wait(Ref) ->
+    receive
+        {Ref, Value} -> Value
+    end.
@@ -0,0 +1,33 @@
+% RUN: lumen compile -O0 --emit=mlir-llvm --output-dir Output/map_lookup %s
+% RUN: LumenFileCheck %s < Output/map_lookup/map_lookup.llvm.mlir
+-module(map_lookup).
+
+-export([atom_key/1, term_key/2]).
+
+% Constant atom keys are found in flatmaps by scanning the key slots inline,
+% larger maps are left to the runtime
+%
+% CHECK-LABEL: llvm.func @"map_lookup:atom_key/1"
+% CHECK: %[[MAX:.+]] = llvm.mlir.constant(32 : i64)
+% CHECK: %[[IS_FLATMAP:.+]] = llvm.icmp "ule" %{{.+}}, %[[MAX]]
+% CHECK-NEXT: llvm.cond_br %[[IS_FLATMAP]], ^[[SCAN:bb[0-9]+]], ^[[SLOW:bb[0-9]+]]
+% CHECK: ^[[SCAN]]:
+% CHECK: llvm.br ^[[LOOP:bb[0-9]+]](%{{.+}} : !llvm.i64)
+% CHECK: ^[[LOOP]](%[[INDEX:.+]]: !llvm.i64):
+% CHECK-NEXT: %[[IS_END:.+]] = llvm.icmp "eq" %[[INDEX]], %{{.+}}
+% CHECK-NEXT: llvm.cond_br %[[IS_END]], ^{{bb[0-9]+}}(%{{.+}} : !llvm.i64), ^[[BODY:bb[0-9]+]]
+% CHECK: ^[[BODY]]:
+% CHECK: %[[IS_KEY:.+]] = llvm.icmp "eq"
+% CHECK: llvm.cond_br %[[IS_KEY]], ^{{bb[0-9]+}}, ^[[LOOP]](%{{.+}} : !llvm.i64)
+% CHECK: ^[[SLOW]]:
+% CHECK-NEXT: llvm.call @__lumen_builtin_map.get(
+atom_key(#{key := Value}) ->
+    Value.
+
+% Other keys are always looked up by the runtime
+%
+% CHECK-LABEL: llvm.func @"map_lookup:term_key/2"
+% CHECK-NOT: llvm.mlir.constant(32 : i64)
+% CHECK: llvm.call @__lumen_builtin_map.get(
+term_key(Key, #{Key := Value}) ->
+    Value.
@@ -0,0 +1,35 @@
+% RUN: lumen compile -O0 --emit=mlir-llvm --output-dir Output/static_literals %s
+% RUN: LumenFileCheck %s < Output/static_literals/static_literals.llvm.mlir
+-module(static_literals).
+
+-export([tuple/0, list/0, map/0]).
+
+% Constant tuples and lists are read-only globals, referenced in place
+% without allocating
+%
+% CHECK-LABEL: llvm.func @"static_literals:tuple/0"
+% CHECK-NOT: @__lumen_builtin_heap_reserve
+% CHECK: llvm.mlir.addressof @tuple_
+% CHECK-NOT: @__lumen_builtin_heap_reserve
+% CHECK: llvm.return
+tuple() ->
+    {ok, 1, [a, b]}.
+
+% CHECK-LABEL: llvm.func @"static_literals:list/0"
+% CHECK-NOT: @__lumen_builtin_heap_reserve
+% CHECK: llvm.mlir.addressof @list_
+% CHECK-NOT: @__lumen_builtin_heap_reserve
+% CHECK: llvm.return
+list() ->
+    [1, 2, 3].
+
+% Constant maps are built by the runtime the first time they are evaluated,
+% and cached as a literal from then on
+%
+% CHECK-LABEL: llvm.func @"static_literals:map/0"
+% CHECK: llvm.mlir.addressof @map_
+% CHECK: llvm.call @__lumen_builtin_map_literal
+% CHECK-NOT: @__lumen_builtin_map.insert
+% CHECK: llvm.return
+map() ->
+    #{a => 1, b => 2}.
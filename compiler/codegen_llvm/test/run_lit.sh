@@ -41,11 +41,14 @@ for runfile_path in $(find_executables "${RUNFILES_DIR}"); do
   SUBPATH="${EXEDIR}:$SUBPATH"
 done
 
+ORIGINAL_PATH="$PATH"
+
 echo "run_lit.sh: $1"
 echo "PWD=$(pwd)"
 
-# For each "// RUN:" line, run the command.
-runline_matches="$(egrep "^// RUN: " "$1")"
+# For each "// RUN:" line, run the command. Erlang sources use "% RUN:"
+# instead, as "//" is not a comment in Erlang.
+runline_matches="$(egrep "^(//|%) RUN: " "$1")"
 if [ -z "$runline_matches" ]; then
   echo "!!! No RUN lines found in test"
   exit 1
@@ -54,8 +57,7 @@ fi
 echo "$runline_matches" | while read -r runline
 do
   echo "RUNLINE: $runline"
-  match="${runline%%// RUN: *}"
-  command="${runline##// RUN: }"
+  command="${runline#*RUN: }"
   if [ -z "${command}" ]; then
     echo "ERROR: Could not extract command from runline"
     exit 1
@@ -64,8 +66,8 @@ do
   # Substitute any embedded '%s' with the file name.
   full_command="${command//\%s/$1}"
 
-  # Run it.
-  export PATH="$SUBPATH"
+  # Run it, falling back to the system path for tools like `env` and `bash`
+  export PATH="${SUBPATH}${ORIGINAL_PATH}"
   echo "RUNNING TEST: $full_command"
   echo "----------------"
   if eval "$full_command"; then
@@ -0,0 +1,548 @@
+//! An on-disk cache of compiled modules, used for incremental compilation
+//!
+//! Each entry is a directory named by a hash of everything that determines the compiled output of
+//! a module (see `CacheKeyBuilder`), holding its object file, its optimized bitcode, and the atoms
+//! and function symbols it contributes to the atom and symbol tables generated at link time.
+//!
+//! Atoms are referenced in generated code by their id in the symbol interner, and those ids
+//! depend on the order in which symbols are interned. To keep them stable between compilations,
+//! the atoms of the previous compilation are interned with their original ids before anything
+//! else is, and an entry is only reused if every atom it references still has the same id.
+use std::collections::hash_map::DefaultHasher;
+use std::collections::{HashMap, HashSet};
+use std::convert::TryInto;
+use std::fs::{self, File};
+use std::hash::Hasher;
+use std::io;
+use std::path::{Path, PathBuf};
+use std::ptr;
+
+use anyhow::{anyhow, Context};
+
+use log::debug;
+
+use parking_lot::Mutex;
+
+use libeir_intern::Symbol;
+
+use liblumen_core::symbols::FunctionSymbol;
+
+use crate::interner::InternedInput;
+
+const ATOMS_FILE: &'static str = "atoms";
+const OBJECT_FILE: &'static str = "object.o";
+const BITCODE_FILE: &'static str = "bitcode.bc";
+const METADATA_FILE: &'static str = "metadata";
+
+// Interned before the cached atoms in every compilation, so that its id is the first one free for
+// them, and ids that belonged to other symbols can be filled with placeholders
+const FIRST_FREE_ID: &'static str = "lumen$cache";
+const PLACEHOLDER_PREFIX: &'static str = "lumen$placeholder";
+
+pub struct Cache {
+    dir: PathBuf,
+    // The atoms interned from the cache, which are kept even if no module uses them anymore, so
+    // that the ids of the atoms interned after them do not change
+    atoms: Mutex<Vec<Symbol>>,
+    // The atoms and symbols of modules generated during this compilation, which are stored
+    // alongside their object files once they have been compiled
+    staged: Mutex<HashMap<InternedInput, Metadata>>,
+}
+impl Cache {
+    pub fn new(dir: PathBuf) -> Self {
+        Self {
+            dir,
+            atoms: Mutex::new(Vec::new()),
+            staged: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// Interns the atoms recorded by `save_atoms` with the ids they were originally given
+    ///
+    /// This must be called before any other symbols are interned.
+    pub fn intern_atoms(&self) -> anyhow::Result<()> {
+        let mut next_id = Symbol::intern(FIRST_FREE_ID).as_usize() + 1;
+
+        let path = self.dir.join(ATOMS_FILE);
+        let bytes = match fs::read(&path) {
+            Ok(bytes) => bytes,
+            Err(err) if err.kind() == io::ErrorKind::NotFound => return Ok(()),
+            Err(err) => return Err(err.into()),
+        };
+
+        let mut reader = Reader::new(&bytes);
+        let mut cached = reader.read_atoms()?;
+        cached.sort_unstable_by_key(|(id, _)| *id);
+
+        let mut atoms = self.atoms.lock();
+        let mut placeholders = 0;
+        for (id, name) in cached.iter() {
+            // The interner holds symbols that are not atoms too, so the ids between atoms are
+            // taken by placeholders, as those symbols are not interned yet
+            while next_id < *id {
+                Symbol::intern(&format!("{}{}", PLACEHOLDER_PREFIX, next_id));
+                next_id += 1;
+                placeholders += 1;
+            }
+
+            let atom = Symbol::intern(name);
+            if atom.as_usize() != *id {
+                debug!("cached atom {} could not be given its id {}", name, id);
+            }
+            next_id = next_id.max(atom.as_usize() + 1);
+            atoms.push(atom);
+        }
+
+        debug!(
+            "interned {} cached atoms and {} placeholders from {}",
+            cached.len(),
+            placeholders,
+            path.display()
+        );
+        Ok(())
+    }
+
+    /// Records the atoms used by this compilation, along with those interned from the cache, so
+    /// the next compilation can intern them with the same ids
+    pub fn save_atoms(&self, atoms: &HashSet<Symbol>) -> anyhow::Result<()> {
+        let mut atoms = atoms.clone();
+        atoms.extend(self.atoms.lock().iter().copied());
+        let mut atoms = atoms
+            .into_iter()
+            .map(|atom| (atom.as_usize(), atom.as_str().get().to_string()))
+            .collect::<Vec<_>>();
+        atoms.sort_unstable_by_key(|(id, _)| *id);
+
+        let mut writer = Writer::new();
+        writer.write_atoms(&atoms);
+
+        fs::create_dir_all(&self.dir)?;
+        let tmp_path = self.tmp_path();
+        fs::write(&tmp_path, writer.into_bytes())?;
+        fs::rename(&tmp_path, self.dir.join(ATOMS_FILE))?;
+        Ok(())
+    }
+
+    /// Stages the atoms and symbols generated for `input`, to be stored by `put`
+    pub fn stage(
+        &self,
+        input: InternedInput,
+        atoms: &HashSet<Symbol>,
+        symbols: &HashSet<FunctionSymbol>,
+    ) {
+        if let Some(metadata) = Metadata::new(atoms, symbols) {
+            self.staged.lock().insert(input, metadata);
+        }
+    }
+
+    /// Returns the entry for `key`, if there is one and it is still valid
+    pub fn get(&self, key: &CacheKey) -> Option<CachedModule> {
+        let entry_dir = self.dir.join(&key.0);
+        let bytes = fs::read(entry_dir.join(METADATA_FILE)).ok()?;
+        let metadata = match Metadata::decode(&bytes) {
+            Ok(metadata) => metadata,
+            Err(err) => {
+                debug!("ignoring invalid cache entry {}: {}", key.0, err);
+                return None;
+            }
+        };
+
+        let mut atoms = Vec::with_capacity(metadata.atoms.len());
+        for (id, name) in metadata.atoms.iter() {
+            let atom = Symbol::intern(name);
+            if atom.as_usize() != *id {
+                debug!(
+                    "ignoring stale cache entry {}: atom id of {} changed",
+                    key.0, name
+                );
+                return None;
+            }
+            atoms.push(atom);
+        }
+        let symbols = metadata
+            .symbols
+            .iter()
+            .map(|(module, function, arity)| FunctionSymbol {
+                module: Symbol::intern(module).as_usize(),
+                function: Symbol::intern(function).as_usize(),
+                arity: *arity,
+                ptr: ptr::null(),
+            })
+            .collect();
+
+        Some(CachedModule {
+            object: entry_dir.join(OBJECT_FILE),
+            bitcode: entry_dir.join(BITCODE_FILE),
+            atoms,
+            symbols,
+        })
+    }
+
+    /// Stores the compiled module for `input` as the entry for `key`, using the callbacks to write
+    /// its object file and bitcode
+    ///
+    /// Nothing is stored if no atoms and symbols were staged for `input`.
+    pub fn put<O, B>(
+        &self,
+        input: InternedInput,
+        key: &CacheKey,
+        object: O,
+        bitcode: B,
+    ) -> anyhow::Result<()>
+    where
+        O: FnOnce(&mut File) -> anyhow::Result<()>,
+        B: FnOnce(&mut File) -> anyhow::Result<()>,
+    {
+        let metadata = match self.staged.lock().remove(&input) {
+            None => return Ok(()),
+            Some(metadata) => metadata,
+        };
+
+        // Entries are written to a temporary directory first, and then moved into place, so
+        // that concurrent compilations never see a partially written entry
+        let tmp_dir = self.tmp_path();
+        fs::create_dir_all(&tmp_dir)?;
+        let result = File::create(tmp_dir.join(OBJECT_FILE))
+            .map_err(|err| err.into())
+            .and_then(|mut f| object(&mut f))
+            .and_then(|()| File::create(tmp_dir.join(BITCODE_FILE)).map_err(|err| err.into()))
+            .and_then(|mut f| bitcode(&mut f))
+            .and_then(|()| {
+                fs::write(tmp_dir.join(METADATA_FILE), metadata.encode()).map_err(|err| err.into())
+            })
+            .and_then(|()| {
+                let entry_dir = self.dir.join(&key.0);
+                if entry_dir.exists() {
+                    // If another compilation stored the same entry first, keep theirs, but an
+                    // entry stored when its atoms had other ids would never be used again
+                    if has_atoms_of(&entry_dir, &metadata) {
+                        return Ok(());
+                    }
+
+                    debug!("replacing stale cache entry {}", key.0);
+                    fs::remove_dir_all(&entry_dir)?;
+                }
+
+                fs::rename(&tmp_dir, &entry_dir).or_else(|err| {
+                    // Another compilation may have replaced it in the meantime
+                    if has_atoms_of(&entry_dir, &metadata) {
+                        Ok(())
+                    } else {
+                        Err(err.into())
+                    }
+                })
+            });
+
+        if tmp_dir.exists() {
+            fs::remove_dir_all(&tmp_dir).ok();
+        }
+
+        result.with_context(|| format!("failed to store cache entry {}", key.0))
+    }
+
+    fn tmp_path(&self) -> PathBuf {
+        self.dir.join(format!("tmp-{:016x}", rand::random::<u64>()))
+    }
+}
+
+/// Returns whether the entry in `entry_dir` was stored with the same atoms and ids as `metadata`
+fn has_atoms_of(entry_dir: &Path, metadata: &Metadata) -> bool {
+    fs::read(entry_dir.join(METADATA_FILE))
+        .ok()
+        .and_then(|bytes| Metadata::decode(&bytes).ok())
+        .map_or(false, |stored| stored.atoms == metadata.atoms)
+}
+
+/// The location of a cached module's artifacts, and the atoms and symbols it contributes
+pub struct CachedModule {
+    pub object: PathBuf,
+    pub bitcode: PathBuf,
+    pub atoms: Vec<Symbol>,
+    pub symbols: Vec<FunctionSymbol>,
+}
+
+/// Copies the cached artifact at `path` to `f`
+pub fn copy_to(path: &Path, f: &mut File) -> anyhow::Result<()> {
+    let mut cached = File::open(path)?;
+    io::copy(&mut cached, f)?;
+    Ok(())
+}
+
+#[derive(Clone, Debug, PartialEq, Eq, Hash)]
+pub struct CacheKey(String);
+
+/// Builds a `CacheKey` from everything that determines the compiled output of a module
+///
+/// Two independently seeded hashes are combined, to make collisions between entries
+/// impractically unlikely.
+pub struct CacheKeyBuilder {
+    hashers: [DefaultHasher; 2],
+}
+impl CacheKeyBuilder {
+    pub fn new() -> Self {
+        let mut hashers = [DefaultHasher::new(), DefaultHasher::new()];
+        for (seed, hasher) in hashers.iter_mut().enumerate() {
+            hasher.write_usize(seed);
+        }
+        let mut builder = Self { hashers };
+        builder.write_str(crate::LUMEN_RELEASE);
+        builder.write_str(crate::LUMEN_COMMIT_HASH);
+        builder
+    }
+
+    pub fn write_bytes(&mut self, bytes: &[u8]) {
+        for hasher in self.hashers.iter_mut() {
+            // The length keeps adjacent fields from being ambiguous
+            hasher.write_usize(bytes.len());
+            hasher.write(bytes);
+        }
+    }
+
+    pub fn write_str(&mut self, s: &str) {
+        self.write_bytes(s.as_bytes());
+    }
+
+    pub fn finish(self) -> CacheKey {
+        CacheKey(format!(
+            "{:016x}{:016x}",
+            self.hashers[0].finish(),
+            self.hashers[1].finish()
+        ))
+    }
+}
+
+/// The atoms and symbols of a module, by name, as stored in the cache
+#[derive(Debug, PartialEq)]
+struct Metadata {
+    // Atoms are stored with their id, which must still be the same for the entry to be used
+    atoms: Vec<(usize, String)>,
+    symbols: Vec<(String, String, u8)>,
+}
+impl Metadata {
+    fn new(atoms: &HashSet<Symbol>, symbols: &HashSet<FunctionSymbol>) -> Option<Self> {
+        let names = atoms
+            .iter()
+            .map(|atom| (atom.as_usize(), atom.as_str().get().to_string()))
+            .collect::<HashMap<_, _>>();
+
+        // Module and function names are always atoms of the module that defines them
+        let mut named_symbols = Vec::with_capacity(symbols.len());
+        for symbol in symbols.iter() {
+            let module = names.get(&symbol.module)?.clone();
+            let function = names.get(&symbol.function)?.clone();
+            named_symbols.push((module, function, symbol.arity));
+        }
+
+        let mut atoms = names.into_iter().collect::<Vec<_>>();
+        atoms.sort_unstable_by_key(|(id, _)| *id);
+
+        Some(Self {
+            atoms,
+            symbols: named_symbols,
+        })
+    }
+
+    fn encode(&self) -> Vec<u8> {
+        let mut writer = Writer::new();
+        writer.write_atoms(&self.atoms);
+        writer.write_u32(self.symbols.len() as u32);
+        for (module, function, arity) in self.symbols.iter() {
+            writer.write_str(module);
+            writer.write_str(function);
+            writer.write_u8(*arity);
+        }
+        writer.into_bytes()
+    }
+
+    fn decode(bytes: &[u8]) -> anyhow::Result<Self> {
+        let mut reader = Reader::new(bytes);
+        let atoms = reader.read_atoms()?;
+
+        let symbols_len = reader.read_u32()?;
+        let mut symbols = Vec::with_capacity(symbols_len as usize);
+        for _ in 0..symbols_len {
+            let module = reader.read_str()?.to_string();
+            let function = reader.read_str()?.to_string();
+            let arity = reader.read_u8()?;
+            symbols.push((module, function, arity));
+        }
+
+        Ok(Self { atoms, symbols })
+    }
+}
+
+struct Writer {
+    bytes: Vec<u8>,
+}
+impl Writer {
+    fn new() -> Self {
+        Self { bytes: Vec::new() }
+    }
+
+    fn write_u8(&mut self, n: u8) {
+        self.bytes.push(n);
+    }
+
+    fn write_u32(&mut self, n: u32) {
+        self.bytes.extend_from_slice(&n.to_le_bytes());
+    }
+
+    fn write_u64(&mut self, n: u64) {
+        self.bytes.extend_from_slice(&n.to_le_bytes());
+    }
+
+    fn write_str(&mut self, s: &str) {
+        self.write_u32(s.len() as u32);
+        self.bytes.extend_from_slice(s.as_bytes());
+    }
+
+    fn write_atoms(&mut self, atoms: &[(usize, String)]) {
+        self.write_u32(atoms.len() as u32);
+        for (id, name) in atoms.iter() {
+            self.write_u64(*id as u64);
+            self.write_str(name);
+        }
+    }
+
+    fn into_bytes(self) -> Vec<u8> {
+        self.bytes
+    }
+}
+
+struct Reader<'a> {
+    bytes: &'a [u8],
+}
+impl<'a> Reader<'a> {
+    fn new(bytes: &'a [u8]) -> Self {
+        Self { bytes }
+    }
+
+    fn read(&mut self, len: usize) -> anyhow::Result<&'a [u8]> {
+        if self.bytes.len() < len {
+            return Err(anyhow!("unexpected end of cache file"));
+        }
+        let (read, rest) = self.bytes.split_at(len);
+        self.bytes = rest;
+        Ok(read)
+    }
+
+    fn read_u8(&mut self) -> anyhow::Result<u8> {
+        Ok(self.read(1)?[0])
+    }
+
+    fn read_u32(&mut self) -> anyhow::Result<u32> {
+        Ok(u32::from_le_bytes(self.read(4)?.try_into().unwrap()))
+    }
+
+    fn read_u64(&mut self) -> anyhow::Result<u64> {
+        Ok(u64::from_le_bytes(self.read(8)?.try_into().unwrap()))
+    }
+
+    fn read_str(&mut self) -> anyhow::Result<&'a str> {
+        let len = self.read_u32()? as usize;
+        std::str::from_utf8(self.read(len)?).map_err(|err| err.into())
+    }
+
+    fn read_atoms(&mut self) -> anyhow::Result<Vec<(usize, String)>> {
+        let len = self.read_u32()?;
+        let mut atoms = Vec::with_capacity(len as usize);
+        for _ in 0..len {
+            let id = self.read_u64()? as usize;
+            let name = self.read_str()?.to_string();
+            atoms.push((id, name));
+        }
+        Ok(atoms)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use std::io::Write;
+
+    use salsa::{InternId, InternKey};
+
+    #[test]
+    fn metadata_decodes_what_it_encodes() {
+        let metadata = Metadata {
+            atoms: vec![(1, "true".to_string()), (70_000, "ünïcödé".to_string())],
+            symbols: vec![("ünïcödé".to_string(), "true".to_string(), 255)],
+        };
+
+        assert_eq!(Metadata::decode(&metadata.encode()).unwrap(), metadata);
+    }
+
+    #[test]
+    fn metadata_decode_with_truncated_bytes_errors() {
+        let metadata = Metadata {
+            atoms: vec![(1, "true".to_string())],
+            symbols: vec![("true".to_string(), "true".to_string(), 0)],
+        };
+        let bytes = metadata.encode();
+
+        assert!(Metadata::decode(&bytes[..bytes.len() - 1]).is_err());
+    }
+
+    #[test]
+    fn put_keeps_entry_with_same_atom_ids() {
+        let dir = tmp_dir();
+        let cache = Cache::new(dir.clone());
+        let key = CacheKeyBuilder::new().finish();
+        let atom = Symbol::intern("cache_test_kept");
+
+        put(&cache, &key, metadata(atom.as_usize(), atom), b"first");
+        put(&cache, &key, metadata(atom.as_usize(), atom), b"second");
+
+        let cached = cache.get(&key).unwrap();
+        assert_eq!(cached.atoms, vec![atom]);
+        assert_eq!(fs::read(&cached.object).unwrap(), b"first");
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn put_replaces_entry_with_stale_atom_ids() {
+        let dir = tmp_dir();
+        let cache = Cache::new(dir.clone());
+        let key = CacheKeyBuilder::new().finish();
+        let atom = Symbol::intern("cache_test_replaced");
+
+        // As stored by a compilation that gave the atom another id
+        put(&cache, &key, metadata(atom.as_usize() + 1, atom), b"stale");
+        assert!(cache.get(&key).is_none());
+
+        put(&cache, &key, metadata(atom.as_usize(), atom), b"fresh");
+
+        let cached = cache.get(&key).unwrap();
+        assert_eq!(cached.atoms, vec![atom]);
+        assert_eq!(fs::read(&cached.object).unwrap(), b"fresh");
+
+        fs::remove_dir_all(&dir).unwrap();
+    }
+
+    fn metadata(id: usize, atom: Symbol) -> Metadata {
+        Metadata {
+            atoms: vec![(id, atom.as_str().get().to_string())],
+            symbols: Vec::new(),
+        }
+    }
+
+    fn put(cache: &Cache, key: &CacheKey, metadata: Metadata, contents: &'static [u8]) {
+        let input = InternedInput::from_intern_id(InternId::from(0u32));
+        cache.staged.lock().insert(input, metadata);
+
+        cache
+            .put(
+                input,
+                key,
+                |f| f.write_all(contents).map_err(|err| err.into()),
+                |f| f.write_all(contents).map_err(|err| err.into()),
+            )
+            .unwrap();
+    }
+
+    fn tmp_dir() -> PathBuf {
+        std::env::temp_dir().join(format!("lumen-cache-test-{:016x}", rand::random::<u64>()))
+    }
+}
@@ -17,6 +17,7 @@ use liblumen_session::{CodegenOptions, DebuggingOptions, Options};
 use liblumen_util::diagnostics::{CodeMap, Emitter};
 use liblumen_util::time::HumanDuration;
 
+use crate::cache::Cache;
 use crate::commands::*;
 use crate::compiler::prelude::{Compiler as CompilerQueryGroup, *};
 use crate::compiler::Compiler;
@@ -38,11 +39,29 @@ pub fn handle_command<'a>(
     // Set up diagnostics
     let diagnostics = create_diagnostics_handler(&options, codemap.clone(), emitter);
 
+    // Set up the incremental compilation cache, if enabled
+    //
+    // NOTE: The cached atoms must be interned before anything else is, so that they are given
+    // the same ids they were given when the cached modules were compiled
+    let cache = options
+        .codegen_opts
+        .incremental
+        .as_ref()
+        .map(|dir| Arc::new(Cache::new(options.current_dir.join(dir))));
+    if let Some(ref cache) = cache {
+        if let Err(err) = cache.intern_atoms() {
+            diagnostics.warn(format!(
+                "failed to load incremental compilation cache: {:#}",
+                err
+            ));
+        }
+    }
+
     // Initialize codegen backend
     codegen::init(&options)?;
 
     // Build query database
-    let mut db = Compiler::new(codemap, diagnostics);
+    let mut db = Compiler::new(codemap, diagnostics, cache.clone());
 
     // The core of the query system is the initial set of options provided to the compiler
     //
@@ -107,6 +126,14 @@ pub fn handle_command<'a>(
     let target_machine = db.get_target_machine(thread_id);
     let atoms = db.take_atoms();
     let symbols = db.take_symbols();
+    if let Some(ref cache) = cache {
+        if let Err(err) = cache.save_atoms(&atoms) {
+            db.diagnostics().warn(format!(
+                "failed to update incremental compilation cache: {:#}",
+                err
+            ));
+        }
+    }
     codegen::generators::run(
         &options,
         &mut codegen_results,
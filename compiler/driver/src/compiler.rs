@@ -17,6 +17,7 @@ use liblumen_core::symbols::FunctionSymbol;
 use liblumen_session::{Emit, Options, OutputType};
 use liblumen_util::diagnostics::{CodeMap, DiagnosticsHandler};
 
+use crate::cache::Cache;
 use crate::diagnostics::*;
 use crate::interner::{InternedInput, Interner, InternerStorage};
 use crate::output::CompilerOutput;
@@ -40,9 +41,14 @@ pub struct Compiler {
     codemap: Arc<CodeMap>,
     atoms: Arc<Mutex<HashSet<Symbol>>>,
     symbols: Arc<Mutex<HashSet<FunctionSymbol>>>,
+    cache: Option<Arc<Cache>>,
 }
 impl Compiler {
-    pub fn new(codemap: Arc<CodeMap>, diagnostics: Arc<DiagnosticsHandler>) -> Self {
+    pub fn new(
+        codemap: Arc<CodeMap>,
+        diagnostics: Arc<DiagnosticsHandler>,
+        cache: Option<Arc<Cache>>,
+    ) -> Self {
         let mut atoms = HashSet::default();
         atoms.insert(Symbol::intern("false"));
         atoms.insert(Symbol::intern("true"));
@@ -52,6 +58,7 @@ impl Compiler {
             codemap,
             atoms: Arc::new(Mutex::new(atoms)),
             symbols: Arc::new(Mutex::new(HashSet::default())),
+            cache,
         }
     }
 }
@@ -72,6 +79,7 @@ impl salsa::ParallelDatabase for Compiler {
             codemap: self.codemap.clone(),
             atoms: self.atoms.clone(),
             symbols: self.symbols.clone(),
+            cache: self.cache.clone(),
         })
     }
 }
@@ -180,4 +188,8 @@ impl CompilerExt for Compiler {
             locked.insert(*i);
         }
     }
+
+    fn cache(&self) -> Option<&Arc<Cache>> {
+        self.cache.as_ref()
+    }
 }
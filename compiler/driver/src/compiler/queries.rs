@@ -1,3 +1,4 @@
+use std::fs;
 use std::ops::Deref;
 use std::sync::Arc;
 use std::thread::{self, ThreadId};
@@ -10,7 +11,9 @@ use liblumen_codegen as codegen;
 use liblumen_codegen::meta::CompiledModule;
 use liblumen_llvm::{self as llvm, target::TargetMachineConfig};
 use liblumen_mlir as mlir;
-use liblumen_session::{Input, InputType, OutputType};
+use liblumen_session::{Input, InputType, Options, OutputType};
+
+use crate::cache::{self, CacheKey, CacheKeyBuilder, CachedModule};
 
 use super::prelude::*;
 
@@ -120,6 +123,9 @@ where
         Ok(generated_module) => {
             db.add_atoms(generated_module.atoms.iter());
             db.add_symbols(generated_module.symbols.iter());
+            if let Some(cache) = db.cache() {
+                cache.stage(input, &generated_module.atoms, &generated_module.symbols);
+            }
             db.maybe_emit_file_with_opts(&options, input, &generated_module.module)?;
             Ok(Arc::new(generated_module.module))
         }
@@ -263,6 +269,29 @@ where
     pass_manager.debug(options.debug_assertions);
     let (speed, size) = llvm::enums::to_llvm_opt_settings(options.opt_level);
     pass_manager.optimize(PassBuilderOptLevel::from_codegen_opts(speed, size));
+    if let Some(pipeline) = options.codegen_opts.pass_pipeline.as_deref() {
+        pass_manager.pipeline(pipeline);
+    }
+    // Loop optimizations are opt-in, and explicit flags override the defaults
+    // chosen by a pipeline preset, with the -C no-* flags winning over all else
+    if options.codegen_opts.vectorize_loops {
+        pass_manager.vectorize_loops(true);
+    }
+    if options.codegen_opts.vectorize_slp {
+        pass_manager.vectorize_slp(true);
+    }
+    if options.codegen_opts.unroll_loops {
+        pass_manager.unroll_loops(true);
+    }
+    if options.codegen_opts.no_vectorize_loops {
+        pass_manager.vectorize_loops(false);
+    }
+    if options.codegen_opts.no_vectorize_slp {
+        pass_manager.vectorize_slp(false);
+    }
+    if options.codegen_opts.no_unroll_loops {
+        pass_manager.unroll_loops(false);
+    }
     if let Some(sanitizer) = options.debugging_opts.sanitizer {
         match sanitizer {
             Sanitizer::Memory => pass_manager.sanitize_memory(/* track_origins */ 0),
@@ -308,6 +337,24 @@ where
         input, &input_info, thread_id
     );
 
+    // Reuse the cached compilation of this module, unless outputs were requested that are only
+    // produced while compiling it
+    let cache = db.cache();
+    let cache_key = match cache {
+        Some(_) => get_cache_key(db, input)?,
+        None => None,
+    };
+    if let (Some(cache), Some(key)) = (cache, cache_key.as_ref()) {
+        if !emits_intermediate_outputs(&options, &input_info) {
+            if let Some(cached) = cache.get(key) {
+                debug!("using cached compilation of {:?}", input);
+                let compiled = compile_from_cache(db, &options, input, &input_info, cached)?;
+                diagnostics.success("Compiled", format!("{}", &source_name));
+                return Ok(compiled);
+            }
+        }
+    }
+
     // Get LLVM IR module
     // We provide the current thread ID as part of the query, since the context
     // object of an LLVM module is not thread-safe, we only want to fulfill a
@@ -337,6 +384,25 @@ where
         .maybe_emit(&input_info, OutputType::LLVMBitcode)
         .map(|filename| db.output_dir().join(filename));
 
+    // Store the compiled module, reusing the emitted outputs where possible
+    if let (Some(cache), Some(key)) = (cache, cache_key.as_ref()) {
+        let stored = cache.put(
+            input,
+            key,
+            |f| match obj_path {
+                Some(ref path) => cache::copy_to(path, f),
+                None => module.emit_obj(f),
+            },
+            |f| match bc_path {
+                Some(ref path) if path.exists() => cache::copy_to(path, f),
+                _ => module.emit_bc(f),
+            },
+        );
+        if let Err(err) = stored {
+            diagnostics.warn(format!("{:#}", err));
+        }
+    }
+
     let compiled = Arc::new(CompiledModule::new(
         input_info.file_stem().to_string_lossy().into_owned(),
         obj_path,
@@ -359,3 +425,97 @@ where
         Input::Str { ref name, .. } => Some(name.clone()),
     }
 }
+
+/// Computes the key of `input` in the incremental compilation cache, if it can be cached
+fn get_cache_key<C>(db: &C, input: InternedInput) -> QueryResult<Option<CacheKey>>
+where
+    C: Compiler,
+{
+    // Only modules generated from EIR have the atoms and symbols they use recorded
+    match db.input_type(input) {
+        InputType::Erlang | InputType::AbstractErlang | InputType::EIR => (),
+        _ => return Ok(None),
+    }
+
+    let options = db.options();
+    let input_info = db.lookup_intern_input(input);
+
+    let mut builder = CacheKeyBuilder::new();
+    builder.write_str(&format!("{:?}", options.target));
+    builder.write_str(&format!("{:?}", options.opt_level));
+    builder.write_str(&format!("{:?}", options.debug_info));
+    builder.write_str(&format!("{:?}", options.debug_assertions));
+    builder.write_str(&format!("{:?}", options.codegen_opts));
+    builder.write_str(&format!("{:?}", options.debugging_opts));
+    builder.write_str(&format!("{:?}", options.source_path_prefix));
+    builder.write_str(&format!("{}", input_info.source_name()));
+    match input_info {
+        Input::File(ref path) => {
+            let source = db.to_query_result(fs::read(path).map_err(|e| e.into()))?;
+            builder.write_bytes(&source);
+        }
+        Input::Str { ref input, .. } => builder.write_str(input),
+    }
+
+    // The source alone does not account for included files or macros defined on the command
+    // line, but the EIR generated from it does
+    let module = db.input_eir(input)?;
+    builder.write_str(&module.to_text_standard());
+
+    Ok(Some(builder.finish()))
+}
+
+/// Returns true if outputs were requested for `input` which are only produced while compiling it
+fn emits_intermediate_outputs(options: &Options, input_info: &Input) -> bool {
+    [
+        OutputType::MLIR,
+        OutputType::EIRDialect,
+        OutputType::StandardDialect,
+        OutputType::LLVMDialect,
+        OutputType::LLVMAssembly,
+        OutputType::Assembly,
+    ]
+    .iter()
+    .any(|output_type| {
+        options
+            .output_types
+            .maybe_emit(input_info, *output_type)
+            .is_some()
+    })
+}
+
+/// Emits the requested outputs for `input` from its cached compilation
+fn compile_from_cache<C>(
+    db: &C,
+    options: &Options,
+    input: InternedInput,
+    input_info: &Input,
+    cached: CachedModule,
+) -> QueryResult<Arc<CompiledModule>>
+where
+    C: Compiler,
+{
+    db.add_atoms(cached.atoms.iter());
+    db.add_symbols(cached.symbols.iter());
+
+    let obj_path =
+        db.maybe_emit_file_with_callback_and_opts(options, input, OutputType::Object, |outfile| {
+            debug!("copying cached object file for {:?}", input);
+            cache::copy_to(&cached.object, outfile)
+        })?;
+    let bc_path = db.maybe_emit_file_with_callback_and_opts(
+        options,
+        input,
+        OutputType::LLVMBitcode,
+        |outfile| {
+            debug!("copying cached llvm bitcode for {:?}", input);
+            cache::copy_to(&cached.bitcode, outfile)
+        },
+    )?;
+
+    Ok(Arc::new(CompiledModule::new(
+        input_info.file_stem().to_string_lossy().into_owned(),
+        obj_path,
+        bc_path,
+    )))
+}
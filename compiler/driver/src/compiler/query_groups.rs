@@ -7,6 +7,7 @@ use liblumen_core::symbols::FunctionSymbol;
 use liblumen_llvm as llvm;
 use liblumen_mlir as mlir;
 
+use crate::cache::Cache;
 use crate::compiler::queries;
 use crate::diagnostics::QueryResult;
 use crate::interner::InternedInput;
@@ -78,4 +79,5 @@ pub trait CompilerExt: CompilerOutput {
     fn add_symbols<'a, I>(&self, symbols: I)
     where
         I: Iterator<Item = &'a FunctionSymbol>;
+    fn cache(&self) -> Option<&Arc<Cache>>;
 }
@@ -1,6 +1,7 @@
 #![deny(warnings)]
 
 pub mod argparser;
+mod cache;
 mod commands;
 mod compiler;
 mod diagnostics;
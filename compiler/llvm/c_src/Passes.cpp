@@ -212,11 +212,21 @@ inline static bool sanitizerEnabled(SanitizerOptions &opts) {
   return opts.memory || opts.thread || opts.address;
 }
 
+// Controls the loop optimizations performed by the default pipelines, see
+// `LoopOptions` in passes.rs
+struct LoopOptions {
+  bool vectorize;
+  bool vectorizeSLP;
+  bool interleave;
+  bool unroll;
+};
+
 struct OptimizerConfig {
   const char *passPipeline;
   LLVMLumenPassBuilderOptLevel::Level optLevel;
   OptStage::Stage stage;
   SanitizerOptions sanitizer;
+  LoopOptions loops;
   bool debug;
   bool verify;
   bool useThinLTOBuffers;
@@ -239,12 +249,17 @@ LLVMLumenOptimize(LLVMModuleRef m,
   OptimizerConfig config = *conf;
 
   auto optLevel = fromRust(config.optLevel);
+  auto loops = config.loops;
+
+  // Pipeline presets are resolved by the driver, so this is always a textual
+  // pipeline description
+  StringRef passPipeline = config.passPipeline ? config.passPipeline : "";
 
   llvm::PipelineTuningOptions tuningOpts;
-  tuningOpts.LoopInterleaving = false;
-  tuningOpts.LoopVectorization = false;
-  tuningOpts.SLPVectorization = false;
-  tuningOpts.LoopUnrolling = false;
+  tuningOpts.LoopInterleaving = loops.interleave;
+  tuningOpts.LoopVectorization = loops.vectorize;
+  tuningOpts.SLPVectorization = loops.vectorizeSLP;
+  tuningOpts.LoopUnrolling = loops.unroll;
   tuningOpts.Coroutines = false;
 
   bool debug = config.debug;
@@ -335,11 +350,11 @@ LLVMLumenOptimize(LLVMModuleRef m,
   ModulePassManager mpm(debug);
 
   // If there is a pipeline provided, parse it and populate the pass manager with it
-  if (config.passPipeline) {
+  if (!passPipeline.empty()) {
     std::string error;
-    if (auto err = pb.parsePassPipeline(mpm, config.passPipeline, verify, debug)) {
+    if (auto err = pb.parsePassPipeline(mpm, passPipeline, verify, debug)) {
       error = "unable to parse pass pipeline description '" +
-            std::string(config.passPipeline) + "': " + llvm::toString(std::move(err));
+            passPipeline.str() + "': " + llvm::toString(std::move(err));
       *errorMessage = strdup(error.c_str());
       return true;
     }
@@ -383,9 +398,12 @@ LLVMLumenOptimize(LLVMModuleRef m,
         mpm.addPass(llvm::CanonicalizeAliasesPass());
         mpm.addPass(llvm::NameAnonGlobalPass());
     }
-
-    mpm.run(*mod, mam);
   }
 
+  // Run whatever was configured above, the instrumentation callbacks (including
+  // the self-profiler) were registered with the pass builder, so they apply
+  // regardless of how the pipeline was constructed
+  mpm.run(*mod, mam);
+
   return false;
 }
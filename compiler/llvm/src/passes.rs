@@ -1,8 +1,10 @@
+use std::ffi::CString;
 use std::ptr;
+use std::sync::Arc;
 
 use anyhow::anyhow;
 
-use liblumen_profiling::SelfProfilerRef;
+use liblumen_profiling::{SelfProfiler, SelfProfilerRef};
 
 use crate::enums::{CodeGenOptLevel, CodeGenOptSize};
 use crate::profiling::{self, LlvmSelfProfiler};
@@ -96,6 +98,19 @@ impl Default for SanitizerOptions {
     }
 }
 
+/// Controls the loop optimizations performed by the default pipelines
+///
+/// These are all disabled by default at every optimization level, as we have
+/// no cost model tuned for the code we generate, and must be opted into
+#[repr(C)]
+#[derive(Debug, Copy, Clone, Default)]
+pub struct LoopOptions {
+    vectorize: bool,
+    vectorize_slp: bool,
+    interleave: bool,
+    unroll: bool,
+}
+
 pub type SelfProfileBeforePassCallback =
     unsafe extern "C" fn(*mut libc::c_void, *const libc::c_char, *const libc::c_char);
 pub type SelfProfileAfterPassCallback = unsafe extern "C" fn(*mut libc::c_void);
@@ -107,6 +122,7 @@ pub struct OptimizerConfig {
     opt_level: PassBuilderOptLevel,
     opt_stage: OptStage,
     sanitizer_opts: SanitizerOptions,
+    loop_opts: LoopOptions,
     debug: bool,
     verify: bool,
     use_thinlto_buffers: bool,
@@ -125,6 +141,7 @@ impl Default for OptimizerConfig {
             opt_level: PassBuilderOptLevel::O0,
             opt_stage: OptStage::PreLinkNoLTO,
             sanitizer_opts: Default::default(),
+            loop_opts: Default::default(),
             debug: false,
             verify: false,
             use_thinlto_buffers: false,
@@ -141,11 +158,53 @@ impl Default for OptimizerConfig {
 
 pub struct PassManager {
     config: OptimizerConfig,
+    pipeline: Option<CString>,
+    profiler: Option<Arc<SelfProfiler>>,
 }
 impl PassManager {
     pub fn new() -> Self {
         Self {
             config: Default::default(),
+            pipeline: None,
+            profiler: None,
+        }
+    }
+
+    /// Replaces the default pipeline with the given one
+    ///
+    /// This is either one of the presets below, or a textual LLVM pass pipeline
+    /// description. A preset selects the optimization level and loop optimizations
+    /// used to build the default pipeline, which can still be adjusted afterwards,
+    /// e.g. with `vectorize_loops`.
+    ///
+    /// - fast-compile: light optimization, skipping the expensive loop passes
+    /// - throughput: everything, including vectorization and unrolling
+    /// - size: optimize for size, only vectorizing where it shrinks code
+    pub fn pipeline(&mut self, pipeline: &str) {
+        match pipeline {
+            "fast-compile" => {
+                self.config.opt_level = PassBuilderOptLevel::O1;
+                self.config.loop_opts = LoopOptions::default();
+            }
+            "throughput" => {
+                self.config.opt_level = PassBuilderOptLevel::O3;
+                self.config.loop_opts = LoopOptions {
+                    vectorize: true,
+                    vectorize_slp: true,
+                    interleave: true,
+                    unroll: true,
+                };
+            }
+            "size" => {
+                self.config.opt_level = PassBuilderOptLevel::Os;
+                self.config.loop_opts = LoopOptions {
+                    vectorize: true,
+                    vectorize_slp: true,
+                    interleave: false,
+                    unroll: false,
+                };
+            }
+            _ => self.pipeline = Some(CString::new(pipeline).unwrap()),
         }
     }
 
@@ -161,6 +220,20 @@ impl PassManager {
         self.config.opt_level = level;
     }
 
+    pub fn vectorize_loops(&mut self, enabled: bool) {
+        self.config.loop_opts.vectorize = enabled;
+        // Interleaving is performed by the loop vectorizer
+        self.config.loop_opts.interleave = enabled;
+    }
+
+    pub fn vectorize_slp(&mut self, enabled: bool) {
+        self.config.loop_opts.vectorize_slp = enabled;
+    }
+
+    pub fn unroll_loops(&mut self, enabled: bool) {
+        self.config.loop_opts.unroll = enabled;
+    }
+
     pub fn stage(&mut self, stage: OptStage) {
         self.config.opt_stage = stage;
     }
@@ -179,18 +252,31 @@ impl PassManager {
     }
 
     pub fn profile(&mut self, profiler: &SelfProfilerRef) {
-        self.config.profiler = if profiler.llvm_recording_enabled() {
-            let mut llvm_profiler = LlvmSelfProfiler::new(profiler.get_self_profiler().unwrap());
-            &mut llvm_profiler as *mut _ as *mut libc::c_void
+        self.profiler = if profiler.llvm_recording_enabled() {
+            profiler.get_self_profiler()
         } else {
-            std::ptr::null_mut()
+            None
         };
     }
 
-    pub fn run(self, module: &mut Module, target_machine: &TargetMachine) -> anyhow::Result<()> {
+    pub fn run(
+        mut self,
+        module: &mut Module,
+        target_machine: &TargetMachine,
+    ) -> anyhow::Result<()> {
         use std::ffi::CStr;
         use std::mem::MaybeUninit;
 
+        if let Some(pipeline) = self.pipeline.as_ref() {
+            self.config.pipeline = pipeline.as_ptr();
+        }
+
+        // The profiler must outlive the call, as it receives the pass callbacks
+        let mut llvm_profiler = self.profiler.take().map(LlvmSelfProfiler::new);
+        if let Some(llvm_profiler) = llvm_profiler.as_mut() {
+            self.config.profiler = llvm_profiler as *mut _ as *mut libc::c_void;
+        }
+
         let mut error = MaybeUninit::<*const libc::c_char>::uninit();
         let failed = unsafe {
             ffi::LLVMLumenOptimize(
@@ -87,6 +87,11 @@ impl Context {
             print_after_pass: options.debugging_opts.print_passes_after,
             print_module_scope_always: options.debugging_opts.print_mlir_module_scope_always,
             print_after_only_on_change: options.debugging_opts.print_passes_on_change,
+            reduction_budget: options
+                .codegen_opts
+                .reduction_budget
+                .map(|budget| budget.min(u32::MAX as u64) as u32)
+                .unwrap_or(DEFAULT_REDUCTION_BUDGET),
         };
         let pass_manager = unsafe { MLIRCreatePassManager(context, target_machine, &pass_options) };
         Self {
@@ -177,6 +182,10 @@ impl PartialEq for Context {
     }
 }
 
+/// The number of reductions a process may perform before generated code yields
+/// back to the scheduler, unless overridden with `-C reduction-budget`
+pub const DEFAULT_REDUCTION_BUDGET: u32 = 20;
+
 #[repr(C)]
 pub struct PassManagerOptions {
     opt: CodeGenOptLevel,
@@ -187,6 +196,7 @@ pub struct PassManagerOptions {
     print_after_pass: bool,
     print_module_scope_always: bool,
     print_after_only_on_change: bool,
+    reduction_budget: u32,
 }
 impl Default for PassManagerOptions {
     fn default() -> Self {
@@ -199,6 +209,7 @@ impl Default for PassManagerOptions {
             print_after_pass: false,
             print_module_scope_always: false,
             print_after_only_on_change: true,
+            reduction_budget: DEFAULT_REDUCTION_BUDGET,
         }
     }
 }
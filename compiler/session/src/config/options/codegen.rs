@@ -59,6 +59,9 @@ pub struct CodegenOptions {
     #[option(default_value("255"), value_name("N"), takes_value(true), hidden(true))]
     /// Set the threshold for inlining a function
     pub inline_threshold: Option<u64>,
+    #[option(value_name("DIR"), takes_value(true))]
+    /// Enable incremental compilation, caching compiled modules in DIR
+    pub incremental: Option<PathBuf>,
 
     #[option(value_name("PATH"), takes_value(true))]
     /// The system linker to link with
@@ -105,6 +108,15 @@ pub struct CodegenOptions {
     #[option(hidden(true))]
     /// When set, does not implicitly link the Lumen runtime
     pub no_std: Option<bool>,
+    #[option(hidden(true))]
+    /// Don't unroll loops
+    pub no_unroll_loops: bool,
+    #[option(hidden(true))]
+    /// Don't run the loop vectorization optimization passes
+    pub no_vectorize_loops: bool,
+    #[option(hidden(true))]
+    /// Don't run the superword-level parallelism vectorization optimization passes
+    pub no_vectorize_slp: bool,
     #[option(
         possible_values("abort", "unwind"),
         value_name("STRATEGY"),
@@ -113,12 +125,19 @@ pub struct CodegenOptions {
     )]
     /// Panic strategy to compile with
     pub panic: Option<PanicStrategy>,
+    #[option(value_name("PIPELINE"), takes_value(true), hidden(true))]
+    /// Replace the default LLVM pass pipeline with one of the presets
+    /// (fast-compile, throughput, size), or a textual pipeline description
+    pub pass_pipeline: Option<String>,
     #[option(value_name("PASSES"), takes_value(true), requires_delimiter(true))]
     /// A list of extra LLVM passes to run (comma separated list)
     pub passes: Vec<String>,
     #[option]
     /// Prefer dynamic linking to static linking
     pub prefer_dynamic: bool,
+    #[option(default_value("20"), value_name("N"), takes_value(true), hidden(true))]
+    /// Set the number of reductions a process may perform before yielding
+    pub reduction_budget: Option<u64>,
     #[option(value_name("MODEL"), takes_value(true), hidden(true))]
     /// Choose the relocation model to use
     pub relocation_model: Option<RelocModel>,
@@ -140,4 +159,13 @@ pub struct CodegenOptions {
     #[option(hidden(true))]
     /// Choose the TLS model to use
     pub tls_model: Option<TlsModel>,
+    #[option(hidden(true))]
+    /// Unroll loops (disabled by default, overridden by -C no-unroll-loops)
+    pub unroll_loops: bool,
+    #[option(hidden(true))]
+    /// Run the loop vectorization optimization passes (disabled by default)
+    pub vectorize_loops: bool,
+    #[option(hidden(true))]
+    /// Run the superword-level parallelism vectorization optimization passes (disabled by default)
+    pub vectorize_slp: bool,
 }
@@ -18,6 +18,33 @@ extern "C" struct MaskInfo {
   bool requiresShift() const { return shift != 0; }
 };
 
+// A value passes the check if `(value & mask) - min <= max - min`, using
+// unsigned, wrapping arithmetic. A mask of zero means the check is unused.
+extern "C" struct TagCheck {
+  uint64_t mask;
+  uint64_t min;
+  uint64_t max;
+
+  bool isEnabled() const { return mask != 0; }
+  bool isExact() const { return min == max; }
+};
+
+// Both checks must pass for a value to be a box (or literal)
+extern "C" struct BoxCheck {
+  TagCheck tag;
+  TagCheck pointer;
+};
+
+// A value is of the checked type if any of the enabled immediate checks pass
+// against the value, or if it is a box and any of the enabled header checks
+// pass against the header it points to. If `isInline` is false, the check
+// must be performed by the runtime.
+extern "C" struct TypeCheck {
+  bool isInline;
+  TagCheck immediate[2];
+  TagCheck header[3];
+};
+
 } // namespace lumen
 
 extern "C" bool lumen_is_type(::lumen::Encoding *encoding, uint32_t type,
@@ -32,5 +59,8 @@ extern "C" uint64_t lumen_box_tag(::lumen::Encoding *encoding);
 extern "C" uint64_t lumen_literal_tag(::lumen::Encoding *encoding);
 extern "C" ::lumen::MaskInfo lumen_immediate_mask(::lumen::Encoding *encoding);
 extern "C" ::lumen::MaskInfo lumen_header_mask(::lumen::Encoding *encoding);
+extern "C" ::lumen::BoxCheck lumen_box_check(::lumen::Encoding *encoding);
+extern "C" ::lumen::TypeCheck lumen_type_check(::lumen::Encoding *encoding,
+                                               uint32_t type);
 
 #endif
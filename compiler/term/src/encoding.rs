@@ -21,6 +21,79 @@ pub struct MaskInfo {
     pub max_allowed_value: u64,
 }
 
+/// Describes a test of an encoded value, which holds when `value & mask`
+/// falls in the range `min..=max`.
+///
+/// These are used by the compiler to lower type checks to a handful of
+/// instructions, see `Encoding::box_check`, `Encoding::immediate_check` and
+/// `Encoding::header_check`. A mask of zero indicates the test is unused.
+#[derive(Debug, Copy, Clone, Default, PartialEq, Eq)]
+#[repr(C)]
+pub struct TagCheck {
+    pub mask: u64,
+    pub min: u64,
+    pub max: u64,
+}
+impl TagCheck {
+    pub const NONE: Self = Self {
+        mask: 0,
+        min: 0,
+        max: 0,
+    };
+
+    #[inline]
+    pub const fn eq(mask: u64, tag: u64) -> Self {
+        Self {
+            mask,
+            min: tag,
+            max: tag,
+        }
+    }
+
+    #[inline]
+    pub fn is_enabled(&self) -> bool {
+        self.mask != 0
+    }
+
+    /// Performs the test in the same way as the generated code, i.e. using a
+    /// single unsigned comparison
+    #[inline]
+    pub fn test(&self, value: u64) -> bool {
+        (value & self.mask).wrapping_sub(self.min) <= self.max - self.min
+    }
+}
+
+/// Describes how to determine whether an encoded value is a pointer to a
+/// boxed term (including literals), both of the tests must hold
+#[derive(Debug, Copy, Clone, Default, PartialEq, Eq)]
+#[repr(C)]
+pub struct BoxCheck {
+    pub tag: TagCheck,
+    pub pointer: TagCheck,
+}
+impl BoxCheck {
+    #[inline]
+    pub fn test(&self, value: u64) -> bool {
+        let tag = !self.tag.is_enabled() || self.tag.test(value);
+        let pointer = !self.pointer.is_enabled() || self.pointer.test(value);
+        tag && pointer
+    }
+}
+
+/// Describes how to check whether an encoded value is of a given term kind.
+///
+/// The value is of the given kind if any of the immediate tests hold against
+/// the value itself, or if the value is boxed, and any of the header tests
+/// hold against the header it points to. If `is_inline` is false, the check
+/// cannot be described this way, and the runtime must be consulted.
+#[derive(Debug, Copy, Clone, Default, PartialEq, Eq)]
+#[repr(C)]
+pub struct TypeCheck {
+    pub is_inline: bool,
+    pub immediate: [TagCheck; 2],
+    pub header: [TagCheck; 3],
+}
+
 pub trait Word:
     Copy
     + PartialEq
@@ -91,6 +164,13 @@ pub trait Encoding {
     fn immediate_mask_info() -> MaskInfo;
     fn header_mask_info() -> MaskInfo;
 
+    /// Returns the test used to determine if a value is a box or literal
+    fn box_check() -> BoxCheck;
+    /// Returns the test for values of the given type, if it is immediate
+    fn immediate_check(tag: Tag<Self::Type>) -> Option<TagCheck>;
+    /// Returns the test for headers of the given type, if it is boxed
+    fn header_check(tag: Tag<Self::Type>) -> Option<TagCheck>;
+
     fn encode_immediate(value: Self::Type, tag: Self::Type) -> Self::Type;
 
     fn encode_immediate_with_tag(value: Self::Type, tag: Tag<Self::Type>) -> Self::Type;
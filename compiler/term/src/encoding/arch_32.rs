@@ -1,6 +1,6 @@
 use crate::Tag;
 
-use super::{Encoding, MaskInfo};
+use super::{BoxCheck, Encoding, MaskInfo, TagCheck};
 
 pub const PRIMARY_SHIFT: u32 = 3;
 pub const HEADER_SHIFT: u32 = 8;
@@ -130,6 +130,57 @@ impl Encoding for Encoding32 {
         }
     }
 
+    #[inline]
+    fn box_check() -> BoxCheck {
+        // Boxes and literals differ only in one bit of the primary tag
+        let tag_mask = MASK_PRIMARY & !(Self::TAG_BOXED ^ Self::TAG_LITERAL);
+        let pointer_mask = u32::max_value() as u64 & !(MASK_PRIMARY as u64);
+        BoxCheck {
+            tag: TagCheck::eq(tag_mask as u64, Self::TAG_BOXED as u64),
+            pointer: TagCheck {
+                mask: pointer_mask,
+                min: 1,
+                max: pointer_mask,
+            },
+        }
+    }
+
+    #[inline]
+    fn immediate_check(tag: Tag<u32>) -> Option<TagCheck> {
+        let tag = match tag {
+            Tag::Nil => return Some(TagCheck::eq(u32::max_value() as u64, Self::NIL as u64)),
+            Tag::SmallInteger => Self::TAG_SMALL_INTEGER,
+            Tag::Atom => Self::TAG_ATOM,
+            Tag::Pid => Self::TAG_PID,
+            Tag::Port => Self::TAG_PORT,
+            Tag::List => Self::TAG_LIST,
+            _ => return None,
+        };
+        Some(TagCheck::eq(MASK_PRIMARY as u64, tag as u64))
+    }
+
+    #[inline]
+    fn header_check(tag: Tag<u32>) -> Option<TagCheck> {
+        let tag = match tag {
+            Tag::Tuple => Self::TAG_TUPLE,
+            Tag::BigInteger => Self::TAG_BIG_INTEGER,
+            Tag::Float => Self::TAG_FLOAT,
+            Tag::Map => Self::TAG_MAP,
+            Tag::Reference => Self::TAG_REFERENCE,
+            Tag::Closure => Self::TAG_CLOSURE,
+            Tag::ResourceReference => Self::TAG_RESOURCE_REFERENCE,
+            Tag::ProcBin => Self::TAG_PROCBIN,
+            Tag::HeapBinary => Self::TAG_HEAPBIN,
+            Tag::SubBinary => Self::TAG_SUBBINARY,
+            Tag::MatchContext => Self::TAG_MATCH_CTX,
+            Tag::ExternalPid => Self::TAG_EXTERN_PID,
+            Tag::ExternalPort => Self::TAG_EXTERN_PORT,
+            Tag::ExternalReference => Self::TAG_EXTERN_REF,
+            _ => return None,
+        };
+        Some(TagCheck::eq(MASK_HEADER as u64, tag as u64))
+    }
+
     #[inline]
     fn encode_immediate(value: u32, tag: u32) -> u32 {
         debug_assert!(tag <= MASK_PRIMARY, "invalid primary tag");
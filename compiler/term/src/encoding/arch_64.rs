@@ -13,7 +13,7 @@
 ///! processors to use up to 54 bits for addresses, which would cause issues as well.
 use crate::Tag;
 
-use super::{Encoding, MaskInfo};
+use super::{BoxCheck, Encoding, MaskInfo, TagCheck};
 
 const PRIMARY_SHIFT: u64 = 3;
 const HEADER_SHIFT: u64 = 8;
@@ -143,6 +143,57 @@ impl Encoding for Encoding64 {
         }
     }
 
+    #[inline]
+    fn box_check() -> BoxCheck {
+        // Boxes and literals differ only in one bit of the primary tag
+        let tag_mask = MASK_PRIMARY & !(Self::TAG_BOXED ^ Self::TAG_LITERAL);
+        let pointer_mask = u64::max_value() & !(MASK_PRIMARY);
+        BoxCheck {
+            tag: TagCheck::eq(tag_mask, Self::TAG_BOXED),
+            pointer: TagCheck {
+                mask: pointer_mask,
+                min: 1,
+                max: pointer_mask,
+            },
+        }
+    }
+
+    #[inline]
+    fn immediate_check(tag: Tag<u64>) -> Option<TagCheck> {
+        let tag = match tag {
+            Tag::Nil => return Some(TagCheck::eq(u64::max_value(), Self::NIL)),
+            Tag::SmallInteger => Self::TAG_SMALL_INTEGER,
+            Tag::Atom => Self::TAG_ATOM,
+            Tag::Pid => Self::TAG_PID,
+            Tag::Port => Self::TAG_PORT,
+            Tag::List => Self::TAG_LIST,
+            _ => return None,
+        };
+        Some(TagCheck::eq(MASK_PRIMARY, tag))
+    }
+
+    #[inline]
+    fn header_check(tag: Tag<u64>) -> Option<TagCheck> {
+        let tag = match tag {
+            Tag::Tuple => Self::TAG_TUPLE,
+            Tag::BigInteger => Self::TAG_BIG_INTEGER,
+            Tag::Float => Self::TAG_FLOAT,
+            Tag::Map => Self::TAG_MAP,
+            Tag::Reference => Self::TAG_REFERENCE,
+            Tag::Closure => Self::TAG_CLOSURE,
+            Tag::ResourceReference => Self::TAG_RESOURCE_REFERENCE,
+            Tag::ProcBin => Self::TAG_PROCBIN,
+            Tag::HeapBinary => Self::TAG_HEAPBIN,
+            Tag::SubBinary => Self::TAG_SUBBINARY,
+            Tag::MatchContext => Self::TAG_MATCH_CTX,
+            Tag::ExternalPid => Self::TAG_EXTERN_PID,
+            Tag::ExternalPort => Self::TAG_EXTERN_PORT,
+            Tag::ExternalReference => Self::TAG_EXTERN_REF,
+            _ => return None,
+        };
+        Some(TagCheck::eq(MASK_HEADER, tag))
+    }
+
     #[inline]
     fn encode_immediate(value: u64, tag: u64) -> u64 {
         debug_assert!(tag <= MASK_PRIMARY, "invalid primary tag");
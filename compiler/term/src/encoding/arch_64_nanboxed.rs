@@ -13,7 +13,7 @@
 ///! processors to use up to 54 bits for addresses, which would cause issues as well.
 use crate::Tag;
 
-use super::{Encoding, MaskInfo};
+use super::{BoxCheck, Encoding, MaskInfo, TagCheck};
 
 const NUM_BITS: u64 = 64;
 
@@ -199,6 +199,65 @@ impl Encoding for Encoding64Nanboxed {
         }
     }
 
+    #[inline]
+    fn box_check() -> BoxCheck {
+        // Any non-zero value in the pointer range, regardless of the literal flag
+        BoxCheck {
+            tag: TagCheck::NONE,
+            pointer: TagCheck {
+                mask: u64::max_value(),
+                min: 1,
+                max: MAX_ADDR,
+            },
+        }
+    }
+
+    #[inline]
+    fn immediate_check(tag: Tag<u64>) -> Option<TagCheck> {
+        // All bits above the pointer range are checked, so that floats are
+        // never mistaken for a tagged value
+        const IMMEDIATE_TAG_MASK: u64 = !MAX_ADDR;
+
+        match tag {
+            Tag::Float => Some(TagCheck {
+                mask: u64::max_value(),
+                min: MIN_DOUBLE,
+                max: u64::max_value(),
+            }),
+            Tag::Nil => Some(TagCheck::eq(u64::max_value(), Self::NIL)),
+            Tag::SmallInteger => Some(TagCheck::eq(IMMEDIATE_TAG_MASK, Self::TAG_SMALL_INTEGER)),
+            Tag::Atom => Some(TagCheck::eq(IMMEDIATE_TAG_MASK, Self::TAG_ATOM)),
+            Tag::Pid => Some(TagCheck::eq(IMMEDIATE_TAG_MASK, Self::TAG_PID)),
+            Tag::Port => Some(TagCheck::eq(IMMEDIATE_TAG_MASK, Self::TAG_PORT)),
+            Tag::List => Some(TagCheck::eq(IMMEDIATE_TAG_MASK, Self::TAG_LIST)),
+            _ => None,
+        }
+    }
+
+    #[inline]
+    fn header_check(tag: Tag<u64>) -> Option<TagCheck> {
+        // Covers both the primary tag and the sub-tag bits
+        const HEADER_TAG_MASK: u64 = !MAX_HEADER_VALUE;
+
+        let tag = match tag {
+            Tag::Tuple => Self::TAG_TUPLE,
+            Tag::BigInteger => Self::TAG_BIG_INTEGER,
+            Tag::Map => Self::TAG_MAP,
+            Tag::Reference => Self::TAG_REFERENCE,
+            Tag::Closure => Self::TAG_CLOSURE,
+            Tag::ResourceReference => Self::TAG_RESOURCE_REFERENCE,
+            Tag::ProcBin => Self::TAG_PROCBIN,
+            Tag::HeapBinary => Self::TAG_HEAPBIN,
+            Tag::SubBinary => Self::TAG_SUBBINARY,
+            Tag::MatchContext => Self::TAG_MATCH_CTX,
+            Tag::ExternalPid => Self::TAG_EXTERN_PID,
+            Tag::ExternalPort => Self::TAG_EXTERN_PORT,
+            Tag::ExternalReference => Self::TAG_EXTERN_REF,
+            _ => return None,
+        };
+        Some(TagCheck::eq(HEADER_TAG_MASK, tag))
+    }
+
     #[inline]
     fn encode_immediate(value: u64, tag: u64) -> u64 {
         debug_assert!(tag <= TAG_MASK, "invalid primary tag: {}", tag);
@@ -287,7 +346,8 @@ impl Encoding for Encoding64Nanboxed {
     #[inline]
     unsafe fn decode_list<T>(value: u64) -> *mut T {
         debug_assert_eq!(value & TAG_MASK, Self::TAG_LIST);
-        (value & !TAG_MASK) as *const T as *mut T
+        // Constant lists emitted by the compiler are flagged as literals
+        (value & !(TAG_MASK | Self::TAG_LITERAL)) as *const T as *mut T
     }
 
     #[inline]
@@ -329,9 +389,15 @@ impl Encoding for Encoding64Nanboxed {
 
     #[inline]
     fn is_literal(value: u64) -> bool {
-        value <= MAX_ADDR
-            && value & Self::TAG_LITERAL == Self::TAG_LITERAL
-            && (value & !Self::TAG_LITERAL > 0)
+        if value & Self::TAG_LITERAL != Self::TAG_LITERAL {
+            return false;
+        }
+        if value <= MAX_ADDR {
+            return value & !Self::TAG_LITERAL > 0;
+        }
+        // Pointers to cons cells are always aligned, so the literal flag can
+        // be carried by list pointers in the same way as boxes
+        !Self::is_float(value) && value & TAG_MASK == Self::TAG_LIST
     }
 
     #[inline]
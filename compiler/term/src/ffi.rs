@@ -284,12 +284,118 @@ pub extern "C" fn header_mask(encoding: *const EncodingInfo) -> MaskInfo {
     }
 }
 
+#[unwind(allowed)]
+#[export_name = "lumen_box_check"]
+pub extern "C" fn box_check(encoding: *const EncodingInfo) -> BoxCheck {
+    let encoding = unsafe { &*encoding };
+    match encoding.pointer_size {
+        32 => Encoding32::box_check(),
+        64 if encoding.supports_nanboxing => Encoding64Nanboxed::box_check(),
+        64 => Encoding64::box_check(),
+        _ => unreachable!(),
+    }
+}
+
+#[unwind(allowed)]
+#[export_name = "lumen_type_check"]
+pub extern "C" fn type_check(encoding: *const EncodingInfo, ty: u32) -> TypeCheck {
+    let encoding = unsafe { &*encoding };
+    match encoding.pointer_size {
+        32 => do_type_check::<E32>(ty),
+        64 if encoding.supports_nanboxing => do_type_check::<E64N>(ty),
+        64 => do_type_check::<E64>(ty),
+        _ => unreachable!(),
+    }
+}
+
+/// Builds the description of an inline type check for the given term kind.
+///
+/// This must agree with `do_is_type`, the test matrix below verifies that
+/// this is so for all encodings.
+fn do_type_check<T>(ty: u32) -> TypeCheck
+where
+    T: Encoding,
+    <T as Encoding>::Type: Word,
+    <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+{
+    let kind = unwrap_term_kind!(ty);
+    let tags: &[Tag<T::Type>] = match kind {
+        // These are either trivially true/false, or aren't reducible to tag
+        // checks, so are left to the runtime
+        TermKind::None | TermKind::Term | TermKind::Box => return TypeCheck::default(),
+        // Booleans are two specific atom values
+        TermKind::Boolean => {
+            let false_atom = T::encode_immediate_with_tag(T::FALSE, Tag::Atom);
+            let true_atom = T::encode_immediate_with_tag(T::TRUE, Tag::Atom);
+            let bits = core::mem::size_of::<T::Type>() * 8;
+            let mask = u64::max_value() >> (64 - bits);
+            return TypeCheck {
+                is_inline: true,
+                immediate: [
+                    TagCheck::eq(mask, false_atom.as_usize() as u64),
+                    TagCheck::eq(mask, true_atom.as_usize() as u64),
+                ],
+                header: Default::default(),
+            };
+        }
+        TermKind::List => &[Tag::Nil, Tag::List],
+        TermKind::Number => &[Tag::SmallInteger, Tag::Float, Tag::BigInteger],
+        TermKind::Integer => &[Tag::SmallInteger, Tag::BigInteger],
+        TermKind::Binary => &[Tag::ProcBin, Tag::HeapBinary, Tag::SubBinary],
+        TermKind::Pid => &[Tag::Pid, Tag::ExternalPid],
+        TermKind::Reference => &[Tag::Reference, Tag::ExternalReference],
+        TermKind::Fixnum => &[Tag::SmallInteger],
+        TermKind::Float => &[Tag::Float],
+        TermKind::Atom => &[Tag::Atom],
+        TermKind::BigInt => &[Tag::BigInteger],
+        TermKind::Nil => &[Tag::Nil],
+        TermKind::Cons => &[Tag::List],
+        TermKind::Tuple => &[Tag::Tuple],
+        TermKind::Map => &[Tag::Map],
+        TermKind::Closure => &[Tag::Closure],
+        TermKind::HeapBin => &[Tag::HeapBinary],
+        TermKind::ProcBin => &[Tag::ProcBin],
+    };
+
+    let mut check = TypeCheck {
+        is_inline: true,
+        ..Default::default()
+    };
+    let mut num_immediate = 0;
+    let mut num_header = 0;
+    for tag in tags.iter().copied() {
+        if let Some(immediate) = T::immediate_check(tag) {
+            check.immediate[num_immediate] = immediate;
+            num_immediate += 1;
+        } else if let Some(header) = T::header_check(tag) {
+            check.header[num_header] = header;
+            num_header += 1;
+        } else {
+            unreachable!("no type check available for {:?}", tag);
+        }
+    }
+    check
+}
+
 #[inline]
 fn do_is_type<T>(ty: u32, value: usize) -> bool
 where
     T: Encoding,
     <T as Encoding>::Type: Word,
     <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+{
+    do_is_type_with::<T, _>(ty, value, |ptr| unsafe { *ptr })
+}
+
+/// The implementation of `do_is_type`, with the dereference of boxed values
+/// abstracted out, so that it can be exercised against any encoding
+#[inline]
+fn do_is_type_with<T, F>(ty: u32, value: usize, load: F) -> bool
+where
+    T: Encoding,
+    <T as Encoding>::Type: Word,
+    <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+    F: Fn(*const usize) -> usize,
 {
     let kind = unwrap_term_kind!(ty);
     let tag = T::type_of(value.try_into().unwrap());
@@ -298,7 +404,8 @@ where
     // use is_boxed_type/2 instead
     let is_boxed = tag.is_box();
     let tag = if is_boxed {
-        let value = unsafe { *(value as *const usize) };
+        let ptr = unsafe { T::decode_box::<usize>((value as usize).try_into().unwrap()) };
+        let value = load(ptr);
         T::type_of(value.try_into().unwrap())
     } else {
         tag
@@ -317,7 +424,6 @@ where
         TermKind::Binary => tag.is_binary(),
         TermKind::Pid if is_boxed => tag.is_external_pid(),
         TermKind::Pid => tag.is_pid(),
-        TermKind::Reference if is_boxed => tag.is_external_reference(),
         TermKind::Reference => tag.is_reference(),
         TermKind::Boolean => !is_boxed && T::is_boolean(value.try_into().unwrap()),
         _ if is_boxed && tag.is_boxable() => {
@@ -344,13 +450,26 @@ where
     T: Encoding,
     <T as Encoding>::Type: Word,
     <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+{
+    do_is_boxed_type_with::<T, _>(ty, value, |ptr| unsafe { *ptr })
+}
+
+#[inline]
+fn do_is_boxed_type_with<T, F>(ty: u32, value: usize, load: F) -> bool
+where
+    T: Encoding,
+    <T as Encoding>::Type: Word,
+    <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+    F: Fn(*const usize) -> usize,
 {
     let kind = unwrap_term_kind!(ty);
     let tag = T::type_of(value.try_into().unwrap());
-    if Tag::Box != tag {
+    // Literals are boxes too
+    if !tag.is_box() {
         return false;
     }
-    let value = unsafe { *(value as *const usize) };
+    let ptr = unsafe { T::decode_box::<usize>((value as usize).try_into().unwrap()) };
+    let value = load(ptr);
     let tag = T::type_of(value.try_into().unwrap());
     match kind {
         TermKind::Term => tag.is_term(),
@@ -378,10 +497,11 @@ where
     <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
 {
     let tag = T::type_of(value.try_into().unwrap());
-    if Tag::Box != tag {
+    if !tag.is_box() {
         return false;
     }
-    let value = unsafe { *(value as *const usize) };
+    let ptr = unsafe { T::decode_box::<usize>((value as usize).try_into().unwrap()) };
+    let value = unsafe { *ptr };
     let value = value.try_into().unwrap();
     if T::is_tuple(value) {
         let actual_arity = T::Type::as_usize(&T::decode_header_value(value));
@@ -398,10 +518,10 @@ where
     <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
 {
     let tag = T::type_of(value.try_into().unwrap());
-    if Tag::Box != tag {
+    if !tag.is_box() {
         return false;
     }
-    let ptr = value as *const usize;
+    let ptr = unsafe { T::decode_box::<usize>((value as usize).try_into().unwrap()) as *const usize };
     let value = unsafe { *ptr };
     let value = value.try_into().unwrap();
     if T::is_function(value) {
@@ -465,3 +585,177 @@ where
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use std::collections::HashMap;
+
+    use super::*;
+
+    /// All of the tags which are represented by a header
+    const HEADER_TAGS: &[Tag<u64>] = &[
+        Tag::BigInteger,
+        Tag::Float,
+        Tag::Tuple,
+        Tag::Map,
+        Tag::Closure,
+        Tag::ProcBin,
+        Tag::HeapBinary,
+        Tag::SubBinary,
+        Tag::MatchContext,
+        Tag::ExternalPid,
+        Tag::ExternalPort,
+        Tag::ExternalReference,
+        Tag::Reference,
+        Tag::ResourceReference,
+    ];
+
+    fn convert_tag<T: Word>(tag: Tag<u64>) -> Tag<T> {
+        match tag {
+            Tag::BigInteger => Tag::BigInteger,
+            Tag::Float => Tag::Float,
+            Tag::Tuple => Tag::Tuple,
+            Tag::Map => Tag::Map,
+            Tag::Closure => Tag::Closure,
+            Tag::ProcBin => Tag::ProcBin,
+            Tag::HeapBinary => Tag::HeapBinary,
+            Tag::SubBinary => Tag::SubBinary,
+            Tag::MatchContext => Tag::MatchContext,
+            Tag::ExternalPid => Tag::ExternalPid,
+            Tag::ExternalPort => Tag::ExternalPort,
+            Tag::ExternalReference => Tag::ExternalReference,
+            Tag::Reference => Tag::Reference,
+            Tag::ResourceReference => Tag::ResourceReference,
+            _ => unreachable!(),
+        }
+    }
+
+    /// Builds a set of sample values covering every tag in the given
+    /// encoding, along with a fake heap containing the headers of the
+    /// boxed values, indexed by address
+    fn sample_values<T>() -> (Vec<usize>, HashMap<usize, usize>)
+    where
+        T: Encoding,
+        <T as Encoding>::Type: Word,
+        <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+    {
+        let word = |value: usize| -> T::Type { value.try_into().unwrap() };
+        let mut values = vec![T::NONE.as_usize(), T::NIL.as_usize()];
+        for i in &[0usize, 1, 2, 42] {
+            for tag in &[Tag::Atom, Tag::Pid, Tag::Port, Tag::SmallInteger] {
+                let value = T::encode_immediate_with_tag(word(*i), *tag);
+                values.push(value.as_usize());
+            }
+        }
+
+        if let Some(check) = T::immediate_check(Tag::Float) {
+            for f in &[0.0f64, 1.5, -1.5] {
+                values.push((check.min + f.to_bits()) as usize);
+            }
+        }
+
+        // The fake heap is placed well within the addressable range of all
+        // encodings, it is never dereferenced
+        let mut heap = HashMap::new();
+        let mut addr = 0x1000usize;
+        for tag in HEADER_TAGS {
+            let tag = convert_tag::<T::Type>(*tag);
+            if T::header_check(tag).is_none() {
+                continue;
+            }
+            let header = T::encode_header_with_tag(word(1), tag);
+            heap.insert(addr, header.as_usize());
+            values.push(T::encode_box(addr as *const usize).as_usize());
+            values.push(T::encode_literal(addr as *const usize).as_usize());
+            addr += 0x10;
+        }
+        values.push(T::encode_list(addr as *const usize).as_usize());
+
+        (values, heap)
+    }
+
+    /// Evaluates the inline type check the same way the generated code does
+    fn eval_type_check<T, F>(check: &TypeCheck, boxed_only: bool, value: u64, load: F) -> bool
+    where
+        T: Encoding,
+        <T as Encoding>::Type: Word,
+        <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+        F: Fn(*const usize) -> usize,
+    {
+        if !boxed_only {
+            for immediate in check.immediate.iter().filter(|c| c.is_enabled()) {
+                if immediate.test(value) {
+                    return true;
+                }
+            }
+        }
+        if !T::box_check().test(value) {
+            return false;
+        }
+        let ptr = unsafe { T::decode_box::<usize>((value as usize).try_into().unwrap()) };
+        let header = load(ptr) as u64;
+        check
+            .header
+            .iter()
+            .filter(|c| c.is_enabled())
+            .any(|c| c.test(header))
+    }
+
+    fn check_type_matrix<T>()
+    where
+        T: Encoding,
+        <T as Encoding>::Type: Word,
+        <<T as Encoding>::Type as TryFrom<usize>>::Error: core::fmt::Debug,
+    {
+        let (values, heap) = sample_values::<T>();
+        let load = |ptr: *const usize| *heap.get(&(ptr as usize)).unwrap();
+
+        for ty in 0u32..32 {
+            let kind: Result<TermKind, _> = ty.try_into();
+            if kind.is_err() {
+                continue;
+            }
+            let kind = kind.unwrap();
+            let check = do_type_check::<T>(ty);
+            if !check.is_inline {
+                continue;
+            }
+            let has_header_check = check.header.iter().any(|c| c.is_enabled());
+            for value in values.iter().copied() {
+                let expected = do_is_type_with::<T, _>(ty, value, load);
+                let actual = eval_type_check::<T, _>(&check, false, value as u64, load);
+                assert_eq!(
+                    expected, actual,
+                    "is_type mismatch for {:?} with value {:#x}",
+                    kind, value
+                );
+
+                if !has_header_check {
+                    continue;
+                }
+                let expected = do_is_boxed_type_with::<T, _>(ty, value, load);
+                let actual = eval_type_check::<T, _>(&check, true, value as u64, load);
+                assert_eq!(
+                    expected, actual,
+                    "is_boxed_type mismatch for {:?} with value {:#x}",
+                    kind, value
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn inline_type_checks_match_runtime_nanboxed() {
+        check_type_matrix::<E64N>();
+    }
+
+    #[test]
+    fn inline_type_checks_match_runtime_64() {
+        check_type_matrix::<E64>();
+    }
+
+    #[test]
+    fn inline_type_checks_match_runtime_wasm32() {
+        check_type_matrix::<E32>();
+    }
+}
@@ -76,7 +76,17 @@ extern "C" _Unwind_Reason_Code __libunwind_seh_personality(
 namespace libunwind {
 
 #if defined(_LIBUNWIND_SUPPORT_DWARF_UNWIND)
+
+// Lookups which hit the per-thread cache in front of DwarfFDECache don't take
+// its lock, which otherwise serializes the unwinding of every thread.
+#if !defined(_LIBUNWIND_HAS_NO_THREADS) &&                                     \
+    (defined(__GNUC__) || defined(__clang__))
+#define _LIBUNWIND_FDE_THREAD_CACHE 1
+#endif
+
 /// Cache of recently found FDEs.
+///
+/// Entries are kept sorted by ip_start, so that lookups are a binary search.
 template <typename A>
 class _LIBUNWIND_HIDDEN DwarfFDECache {
   typedef typename A::pint_t pint_t;
@@ -97,6 +107,8 @@ private:
     pint_t fde;
   };
 
+  static pint_t findFDELocked(pint_t mh, pint_t pc, entry *found);
+
   // These fields are all static to avoid needing an initializer.
   // There is only one instance of this class per process.
   static RWMutex _lock;
@@ -108,6 +120,29 @@ private:
   static entry *_bufferUsed;
   static entry *_bufferEnd;
   static entry _initialBuffer[64];
+  // The length of the largest range in the buffer, which bounds how far back
+  // from the binary search position a range containing the pc may start.
+  static pint_t _maxRangeLength;
+
+#if defined(_LIBUNWIND_FDE_THREAD_CACHE)
+  static const size_t kThreadCacheEntryCount = 8;
+
+  struct thread_entry {
+    // The value of _generation when the entry was looked up, entries from
+    // before the last removal are stale. Zero is never a valid generation, so
+    // the zero-initialized entries start out empty.
+    uintptr_t generation;
+    entry e;
+  };
+
+  static bool findInThreadCache(pint_t mh, pint_t pc, uintptr_t generation,
+                                pint_t *fde);
+  static void addToThreadCache(const entry &e, uintptr_t generation);
+
+  static uintptr_t _generation;
+  static __thread thread_entry _threadCache[kThreadCacheEntryCount];
+  static __thread size_t _threadCacheNext;
+#endif
 };
 
 template <typename A>
@@ -125,6 +160,9 @@ DwarfFDECache<A>::_bufferEnd = &_initialBuffer[64];
 template <typename A>
 typename DwarfFDECache<A>::entry DwarfFDECache<A>::_initialBuffer[64];
 
+template <typename A>
+typename A::pint_t DwarfFDECache<A>::_maxRangeLength = 0;
+
 template <typename A>
 RWMutex DwarfFDECache<A>::_lock;
 
@@ -133,19 +171,86 @@ template <typename A>
 bool DwarfFDECache<A>::_registeredForDyldUnloads = false;
 #endif
 
+#if defined(_LIBUNWIND_FDE_THREAD_CACHE)
 template <typename A>
-typename A::pint_t DwarfFDECache<A>::findFDE(pint_t mh, pint_t pc) {
-  pint_t result = 0;
-  _LIBUNWIND_LOG_IF_FALSE(_lock.lock_shared());
-  for (entry *p = _buffer; p < _bufferUsed; ++p) {
-    if ((mh == p->mh) || (mh == 0)) {
-      if ((p->ip_start <= pc) && (pc < p->ip_end)) {
-        result = p->fde;
-        break;
+uintptr_t DwarfFDECache<A>::_generation = 1;
+
+template <typename A>
+__thread typename DwarfFDECache<A>::thread_entry
+    DwarfFDECache<A>::_threadCache[kThreadCacheEntryCount];
+
+template <typename A>
+__thread size_t DwarfFDECache<A>::_threadCacheNext;
+
+template <typename A>
+bool DwarfFDECache<A>::findInThreadCache(pint_t mh, pint_t pc,
+                                         uintptr_t generation, pint_t *fde) {
+  for (size_t i = 0; i < kThreadCacheEntryCount; ++i) {
+    const thread_entry &p = _threadCache[i];
+    if (p.generation == generation && ((mh == p.e.mh) || (mh == 0)) &&
+        (p.e.ip_start <= pc) && (pc < p.e.ip_end)) {
+      *fde = p.e.fde;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename A>
+void DwarfFDECache<A>::addToThreadCache(const entry &e, uintptr_t generation) {
+  thread_entry &p = _threadCache[_threadCacheNext];
+  p.generation = generation;
+  p.e = e;
+  _threadCacheNext = (_threadCacheNext + 1) % kThreadCacheEntryCount;
+}
+#endif
+
+template <typename A>
+typename A::pint_t DwarfFDECache<A>::findFDELocked(pint_t mh, pint_t pc,
+                                                   entry *found) {
+  // Find the first entry which starts after pc, the entry containing pc is
+  // before it, and can't start more than _maxRangeLength before pc.
+  entry *low = _buffer;
+  entry *high = _bufferUsed;
+  while (low < high) {
+    entry *mid = low + (high - low) / 2;
+    if (mid->ip_start <= pc)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  for (entry *p = low; p > _buffer; --p) {
+    entry *e = p - 1;
+    if (pc - e->ip_start >= _maxRangeLength)
+      break;
+    if ((mh == e->mh) || (mh == 0)) {
+      if (pc < e->ip_end) {
+        *found = *e;
+        return e->fde;
       }
     }
   }
+  return 0;
+}
+
+template <typename A>
+typename A::pint_t DwarfFDECache<A>::findFDE(pint_t mh, pint_t pc) {
+  pint_t result = 0;
+#if defined(_LIBUNWIND_FDE_THREAD_CACHE)
+  // Read the generation before the buffer, so that an entry removed while it
+  // is being added to the thread cache is already stale.
+  uintptr_t generation = __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+  if (findInThreadCache(mh, pc, generation, &result))
+    return result;
+#endif
+  entry found;
+  _LIBUNWIND_LOG_IF_FALSE(_lock.lock_shared());
+  result = findFDELocked(mh, pc, &found);
   _LIBUNWIND_LOG_IF_FALSE(_lock.unlock_shared());
+#if defined(_LIBUNWIND_FDE_THREAD_CACHE)
+  if (result != 0)
+    addToThreadCache(found, generation);
+#endif
   return result;
 }
 
@@ -154,9 +259,21 @@ void DwarfFDECache<A>::add(pint_t mh, pint_t ip_start, pint_t ip_end,
                            pint_t fde) {
 #if !defined(_LIBUNWIND_NO_HEAP)
   _LIBUNWIND_LOG_IF_FALSE(_lock.lock());
+  // Find the insertion point which keeps the buffer sorted by ip_start.
+  entry *pos = _bufferUsed;
+  while (pos > _buffer && (pos - 1)->ip_start > ip_start)
+    --pos;
+  // Another thread may have missed the cache for the same FDE concurrently.
+  for (entry *p = pos; p > _buffer && (p - 1)->ip_start == ip_start; --p) {
+    if ((p - 1)->mh == mh && (p - 1)->fde == fde) {
+      _LIBUNWIND_LOG_IF_FALSE(_lock.unlock());
+      return;
+    }
+  }
   if (_bufferUsed >= _bufferEnd) {
     size_t oldSize = (size_t)(_bufferEnd - _buffer);
     size_t newSize = oldSize * 4;
+    size_t posIndex = (size_t)(pos - _buffer);
     // Can't use operator new (we are below it).
     entry *newBuffer = (entry *)malloc(newSize * sizeof(entry));
     memcpy(newBuffer, _buffer, oldSize * sizeof(entry));
@@ -165,12 +282,16 @@ void DwarfFDECache<A>::add(pint_t mh, pint_t ip_start, pint_t ip_end,
     _buffer = newBuffer;
     _bufferUsed = &newBuffer[oldSize];
     _bufferEnd = &newBuffer[newSize];
+    pos = &newBuffer[posIndex];
   }
-  _bufferUsed->mh = mh;
-  _bufferUsed->ip_start = ip_start;
-  _bufferUsed->ip_end = ip_end;
-  _bufferUsed->fde = fde;
+  memmove(pos + 1, pos, (size_t)(_bufferUsed - pos) * sizeof(entry));
+  pos->mh = mh;
+  pos->ip_start = ip_start;
+  pos->ip_end = ip_end;
+  pos->fde = fde;
   ++_bufferUsed;
+  if (ip_end - ip_start > _maxRangeLength)
+    _maxRangeLength = ip_end - ip_start;
 #ifdef __APPLE__
   if (!_registeredForDyldUnloads) {
     _dyld_register_func_for_remove_image(&dyldUnloadHook);
@@ -193,6 +314,11 @@ void DwarfFDECache<A>::removeAllIn(pint_t mh) {
     }
   }
   _bufferUsed = d;
+#if defined(_LIBUNWIND_FDE_THREAD_CACHE)
+  // Invalidate the entries of every thread cache, as they may refer to the
+  // removed FDEs.
+  __atomic_add_fetch(&_generation, 1, __ATOMIC_RELEASE);
+#endif
   _LIBUNWIND_LOG_IF_FALSE(_lock.unlock());
 }
 
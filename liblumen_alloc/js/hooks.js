@@ -47,6 +47,7 @@
     }
   
     const allocators = new Map();
+    const magazines = new Map();
   
     function getStack() {
       return Error()
@@ -78,6 +79,11 @@
       allocator.onRealloc(oldSize, newSize, align, oldPointer, newPointer);
     }
   
+    function onMagazineFlush(tag, _size, hits, misses) {
+      // The counts are running totals for the allocator, so keep the latest
+      magazines.set(tag, { hits, misses });
+    }
+  
     function dumpTable(entries, { keyLabel, valueLabel, getKey, getValue }) {
       const byKey = new Map;
       let total = 0;
@@ -123,6 +129,7 @@
       on_alloc: onAlloc,
       on_dealloc: onDealloc,
       on_realloc: onRealloc,
+      on_magazine_flush: onMagazineFlush,
   
       dumpLiveAllocations(opts) {
         dumpAllocators(allocators.values(), {
@@ -147,6 +154,16 @@
           }, opts))
         })
       },
+
+      dumpMagazineHitRates() {
+        const table = [...magazines].map(([tag, { hits, misses }]) => ({
+          "Allocator": tag,
+          "Hits": hits,
+          "Misses": misses,
+          "Hit Rate": hits + misses === 0 ? 0 : hits / (hits + misses),
+        }));
+        console.table(table);
+      },
     };
   }());
   
\ No newline at end of file
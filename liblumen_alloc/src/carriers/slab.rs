@@ -72,6 +72,12 @@ where
         }
     }
 
+    /// Returns the size in bytes of the blocks in this carrier
+    #[inline]
+    pub fn block_size(&self) -> usize {
+        self.block_byte_len
+    }
+
     /// Returns the number of free blocks in this carrier
     #[allow(unused)]
     #[inline]
@@ -1,13 +1,11 @@
+use core::cmp::Ordering;
 use core::ffi::c_void;
 use core::mem;
 use core::slice;
 
-use hashbrown::{HashMap, HashSet};
-
 use once_cell::sync::OnceCell;
 
-use liblumen_arena::DroplessArena;
-use liblumen_core::symbols::FunctionSymbol;
+use liblumen_core::symbols::{FunctionSymbol, ModuleSymbols};
 #[cfg(all(unix, target_arch = "x86_64"))]
 use liblumen_core::sys::dynamic_call;
 use liblumen_core::sys::dynamic_call::DynamicCallee;
@@ -16,7 +14,6 @@ use crate::erts::term::prelude::Atom;
 #[cfg(all(unix, target_arch = "x86_64"))]
 use crate::erts::term::prelude::{Encoded, Term};
 use crate::erts::ModuleFunctionArity;
-use liblumen_core::alloc::Layout;
 
 /// Dynamically invokes the function mapped to the given symbol.
 ///
@@ -88,11 +85,38 @@ pub fn module_loaded(module: Atom) -> bool {
 /// The symbol table used by the runtime system
 static SYMBOLS: OnceCell<SymbolTable> = OnceCell::new();
 
-/// Performs one-time initialization of the atom table at program start, using the
-/// array of constant atom values present in the compiled program.
+/// Performs one-time initialization of the symbol table at program start, using the
+/// sorted symbol table and module index generated by the compiler.
 ///
-/// It is expected that this will be called by code generated by the compiler, during the
-/// earliest phase of startup, to ensure that nothing has tried to use the atom table yet.
+/// Both arrays are used in place, so no work is done here beyond recording where
+/// they are. It is expected that this will be called by code generated by the
+/// compiler, during the earliest phase of startup.
+#[no_mangle]
+pub unsafe extern "C" fn InitializeLumenDispatchIndex(
+    table: *const FunctionSymbol,
+    len: usize,
+    modules: *const ModuleSymbols,
+    modules_len: usize,
+) -> bool {
+    if (table.is_null() && len > 0) || (modules.is_null() && modules_len > 0) {
+        return false;
+    }
+    let functions = raw_slice(table, len);
+    let modules = raw_slice(modules, modules_len);
+
+    debug_assert!(functions
+        .windows(2)
+        .all(|w| compare_symbols(&w[0], &w[1]) == Ordering::Less));
+    debug_assert!(modules.windows(2).all(|w| w[0].module < w[1].module));
+
+    set_symbol_table(SymbolTable { functions, modules })
+}
+
+/// Performs one-time initialization of the symbol table from an array of symbols in
+/// arbitrary order, such as those constructed by hand in tests.
+///
+/// Unlike `InitializeLumenDispatchIndex`, this copies and sorts the symbols, and builds
+/// the module index for them, both of which live for the remainder of the program.
 #[no_mangle]
 pub unsafe extern "C" fn InitializeLumenDispatchTable(
     table: *const FunctionSymbol,
@@ -108,88 +132,112 @@ pub unsafe extern "C" fn InitializeLumenDispatchTable(
             eprintln!("Error: {}", err);
             false
         }
-        Ok(sym_table) => {
-            if let Err(_) = SYMBOLS.set(sym_table) {
-                eprintln!("tried to initialize symbol table more than once!");
-                false
-            } else {
-                true
-            }
-        }
+        Ok(sym_table) => set_symbol_table(sym_table),
     }
 }
 
-struct SymbolTable {
-    functions: HashMap<&'static ModuleFunctionArity, *const c_void>,
-    idents: HashMap<*const c_void, &'static ModuleFunctionArity>,
-    modules: HashSet<Atom>,
-    arena: DroplessArena,
+fn set_symbol_table(sym_table: SymbolTable) -> bool {
+    if let Err(_) = SYMBOLS.set(sym_table) {
+        eprintln!("tried to initialize symbol table more than once!");
+        false
+    } else {
+        true
+    }
 }
-impl SymbolTable {
-    fn new(size: usize) -> Self {
-        Self {
-            functions: HashMap::with_capacity(size),
-            idents: HashMap::with_capacity(size),
-            modules: HashSet::new(),
-            arena: DroplessArena::default(),
-        }
+
+#[inline]
+unsafe fn raw_slice<T>(ptr: *const T, len: usize) -> &'static [T] {
+    if len == 0 {
+        &[]
+    } else {
+        slice::from_raw_parts::<'static>(ptr, len)
     }
+}
 
+/// The order in which symbols are laid out in the symbol table
+///
+/// NOTE: This must match the order used by the compiler when generating the table
+#[inline]
+fn compare_symbols(a: &FunctionSymbol, b: &FunctionSymbol) -> Ordering {
+    (a.module, a.function, a.arity).cmp(&(b.module, b.function, b.arity))
+}
+
+struct SymbolTable {
+    functions: &'static [FunctionSymbol],
+    modules: &'static [ModuleSymbols],
+}
+impl SymbolTable {
     fn dump(&self) {
         eprintln!("START SymbolTable at {:p}", self);
-        for mfa in self.functions.keys() {
+        for symbol in self.functions.iter() {
+            let mfa = unsafe {
+                ModuleFunctionArity {
+                    module: Atom::from_id(symbol.module),
+                    function: Atom::from_id(symbol.function),
+                    arity: symbol.arity,
+                }
+            };
             eprintln!("{:?}", mfa);
         }
         eprintln!("END SymbolTable");
     }
 
-    /// Used to initialize the atom table from an array of null-terminated strings with static
-    /// lifetime, such as generated by codegen in order to initialize the atom table with
-    /// constant atom values in the compiled program. It is expected that this will be called
-    /// via `InitializeLumenAtomTable`
-    unsafe fn from_raw(raw_table: &'static [FunctionSymbol]) -> anyhow::Result<Self> {
-        let mut table = Self::new(raw_table.len());
-
-        for FunctionSymbol {
-            module,
-            function,
-            arity,
-            ptr,
-        } in raw_table.iter()
-        {
-            // This is safe because the underlying data is static
-            let module = Atom::from_id(*module);
-            let function = Atom::from_id(*function);
-            let callee = *ptr;
-            let size = mem::size_of::<ModuleFunctionArity>();
-            let align = mem::align_of::<ModuleFunctionArity>();
-            let layout = Layout::from_size_align(size, align)?;
-            let ptr = table.arena.alloc_raw(layout) as *mut ModuleFunctionArity;
-            ptr.write(ModuleFunctionArity {
-                module,
-                function,
-                arity: *arity,
-            });
-            let sym = mem::transmute::<&ModuleFunctionArity, &'static ModuleFunctionArity>(&*ptr);
-            assert_eq!(None, table.idents.insert(callee, sym));
-            assert_eq!(None, table.functions.insert(sym, callee));
-            table.modules.insert(sym.module);
+    /// Used to initialize the symbol table from an unsorted array of symbols. It is
+    /// expected that this will be called via `InitializeLumenDispatchTable`
+    fn from_raw(raw_table: &'static [FunctionSymbol]) -> anyhow::Result<Self> {
+        let mut functions = raw_table.to_vec();
+        functions.sort_unstable_by(compare_symbols);
+
+        let mut modules: Vec<ModuleSymbols> = Vec::new();
+        for (offset, symbol) in functions.iter().enumerate() {
+            if offset > 0 && compare_symbols(&functions[offset - 1], symbol) == Ordering::Equal {
+                let mfa = unsafe {
+                    ModuleFunctionArity {
+                        module: Atom::from_id(symbol.module),
+                        function: Atom::from_id(symbol.function),
+                        arity: symbol.arity,
+                    }
+                };
+                anyhow::bail!("duplicate entry for {:?} in symbol table", mfa);
+            }
+            match modules.last_mut() {
+                Some(entry) if entry.module == symbol.module => entry.len += 1,
+                _ => modules.push(ModuleSymbols {
+                    module: symbol.module,
+                    offset,
+                    len: 1,
+                }),
+            }
         }
 
-        Ok(table)
+        Ok(Self {
+            functions: Box::leak(functions.into_boxed_slice()),
+            modules: Box::leak(modules.into_boxed_slice()),
+        })
     }
 
-    #[allow(unused)]
-    fn get_ident(&self, function: *const c_void) -> Option<&'static ModuleFunctionArity> {
-        self.idents.get(&function).copied()
+    #[inline]
+    fn get_module(&self, module: Atom) -> Option<&'static [FunctionSymbol]> {
+        let modules = self.modules;
+        let index = modules
+            .binary_search_by_key(&module.id(), |entry| entry.module)
+            .ok()?;
+        let ModuleSymbols { offset, len, .. } = modules[index];
+        Some(&self.functions[offset..(offset + len)])
     }
 
+    #[inline]
     fn get_function(&self, ident: &ModuleFunctionArity) -> Option<*const c_void> {
-        self.functions.get(ident).copied()
+        let functions = self.get_module(ident.module)?;
+        let key = (ident.function.id(), ident.arity);
+        functions
+            .binary_search_by(|symbol| (symbol.function, symbol.arity).cmp(&key))
+            .ok()
+            .map(|index| functions[index].ptr)
     }
 
     fn contains_module(&self, module: Atom) -> bool {
-        self.modules.contains(&module)
+        self.get_module(module).is_some()
     }
 }
 
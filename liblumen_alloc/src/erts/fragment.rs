@@ -14,7 +14,7 @@ use liblumen_core::sys::sysconf::MIN_ALIGN;
 
 use crate::erts::exception::AllocResult;
 use crate::erts::module_function_arity::Arity;
-use crate::erts::process::alloc::{Heap, HeapAlloc, TermAlloc};
+use crate::erts::process::alloc::{Heap, HeapAlloc, HeapIter, TermAlloc};
 use crate::erts::term::closure::{ClosureLayout, Creator, Index, OldUnique, Unique};
 use crate::erts::term::prelude::*;
 use crate::scheduler;
@@ -119,6 +119,20 @@ impl HeapFragment {
             .map(|boxed_proc_bin| (boxed_proc_bin.into(), non_null_heap_fragment))
     }
 
+    /// Places the header of an already allocated `proc_bin` in a new fragment
+    pub fn new_procbin(proc_bin: ProcBin) -> AllocResult<(Term, NonNull<Self>)> {
+        let layout = Layout::new::<ProcBin>();
+        let mut non_null_heap_fragment = Self::new(layout)?;
+        let heap_fragment = unsafe { non_null_heap_fragment.as_mut() };
+
+        unsafe {
+            let ptr = heap_fragment.alloc_layout(layout)?.as_ptr() as *mut ProcBin;
+            ptr.write(proc_bin);
+
+            Ok((Boxed::new_unchecked(ptr).into(), non_null_heap_fragment))
+        }
+    }
+
     fn new_heapbin_from_bytes(bytes: &[u8]) -> AllocResult<(Term, NonNull<Self>)> {
         let (layout, _, _) = HeapBin::layout_for(bytes);
         let mut non_null_heap_fragment = Self::new(layout)?;
@@ -305,25 +319,59 @@ impl HeapFragment {
     pub fn new_map_from_hash_map(
         hash_map: HashMap<Term, Term>,
     ) -> AllocResult<(Boxed<Map>, NonNull<Self>)> {
-        let map = Map::from_hash_map(hash_map);
-        let layout = Layout::for_value(&map);
-        let mut non_null_heap_fragment = Self::new(layout)?;
+        let slice: Vec<(Term, Term)> = hash_map.into_iter().collect();
+
+        Self::new_map_from_slice(&slice)
+    }
+
+    pub fn new_map_from_slice(slice: &[(Term, Term)]) -> AllocResult<(Boxed<Map>, NonNull<Self>)> {
+        let mut non_null_heap_fragment =
+            Self::new_from_word_size(Map::need_in_words_from_slice(slice))?;
         let heap_fragment = unsafe { non_null_heap_fragment.as_mut() };
 
-        let term = map.clone_to_heap(heap_fragment)?;
-        let boxed_map: Boxed<Map> = term.dyn_cast();
+        let boxed_map = Map::from_slice(heap_fragment, slice)?;
 
         Ok((boxed_map, non_null_heap_fragment))
     }
 
-    pub fn new_map_from_slice(slice: &[(Term, Term)]) -> AllocResult<(Boxed<Map>, NonNull<Self>)> {
-        let mut hash_map: HashMap<Term, Term> = HashMap::with_capacity(slice.len());
+    /// Allocates the new version of `map` with `key` associated with `value`, for when the
+    /// process heap is full
+    pub fn new_map_put(
+        map: &Map,
+        key: Term,
+        value: Term,
+    ) -> AllocResult<(Boxed<Map>, NonNull<Self>)> {
+        let mut non_null_heap_fragment = Self::new_from_word_size(map.need_in_words_to_put(key))?;
+        let heap_fragment = unsafe { non_null_heap_fragment.as_mut() };
 
-        for (entry_key, entry_value) in slice {
-            hash_map.insert(*entry_key, *entry_value);
-        }
+        let boxed_map = map.put(heap_fragment, key, value)?;
 
-        Self::new_map_from_hash_map(hash_map)
+        Ok((boxed_map, non_null_heap_fragment))
+    }
+
+    /// Allocates the new version of `map` without `key`, for when the process heap is full
+    pub fn new_map_remove(map: &Map, key: Term) -> AllocResult<(Boxed<Map>, NonNull<Self>)> {
+        let mut non_null_heap_fragment =
+            Self::new_from_word_size(map.need_in_words_to_remove(key))?;
+        let heap_fragment = unsafe { non_null_heap_fragment.as_mut() };
+
+        let boxed_map = map.remove(heap_fragment, key)?;
+
+        Ok((boxed_map, non_null_heap_fragment))
+    }
+
+    /// Allocates the merge of `map` and `other`, for when the process heap is full
+    ///
+    /// Rather than inserting the entries of one map into the other, the merged map is built
+    /// from scratch, as that can be sized exactly.
+    pub fn new_map_merge(map: &Map, other: &Map) -> AllocResult<(Boxed<Map>, NonNull<Self>)> {
+        let slice: Vec<(Term, Term)> = map
+            .iter()
+            .chain(other.iter())
+            .map(|(key, value)| (*key, *value))
+            .collect();
+
+        Self::new_map_from_slice(&slice)
     }
 
     pub fn new_reference(
@@ -397,10 +445,14 @@ impl HeapFragment {
 impl Drop for HeapFragment {
     fn drop(&mut self) {
         assert!(!self.link.is_linked());
-        // Check if the contained value needs to have its destructor run
-        let ptr = self.raw.base.as_ptr() as *mut Term;
-        let term = unsafe { *ptr };
-        term.release();
+        // Every reference-counted binary header in the fragment holds a reference of its own,
+        // which is released here. Headers moved out by garbage collection are skipped, as they
+        // were overwritten with a move marker.
+        for term in self.iter_mut() {
+            if term.is_procbin() {
+                unsafe { ptr::drop_in_place(term as *mut Term as *mut ProcBin) };
+            }
+        }
         // Actually deallocate the memory backing this fragment
         let (layout, _offset) = Layout::new::<Self>().extend(self.raw.layout()).unwrap();
         unsafe {
@@ -42,6 +42,7 @@ use crate::erts::exception::{
     SystemException,
 };
 use crate::erts::module_function_arity::Arity;
+use crate::erts::string::Encoding;
 use crate::erts::term::closure::{Creator, Definition, Index, OldUnique, Unique};
 use crate::erts::term::list::optional_cons_to_term;
 use crate::erts::term::prelude::*;
@@ -55,7 +56,7 @@ use self::ffi::{set_process_signal, ProcessSignal};
 pub use self::frame::{Frame, Native};
 pub use self::frame_with_arguments::FrameWithArguments;
 pub use self::frames::{Frames, StackTrace};
-use self::gc::{GcError, RootSet};
+use self::gc::{GcError, GcPolicy, GcStatistics, RootSet};
 
 pub use self::flags::*;
 pub use self::heap::ProcessHeap;
@@ -105,16 +106,10 @@ pub struct Process {
     pub priority: Priority,
     /// Process flags, e.g. `Process.flag/1`
     flags: AtomicProcessFlags,
-    /// Minimum size of the heap that this process will start with
-    min_heap_size: usize,
-    /// The maximum size of the heap allowed for this process
-    max_heap_size: usize,
+    /// When this process is garbage collected, and how its heap is sized
+    gc_policy: GcPolicy,
     /// Minimum virtual heap size for this process
     min_vheap_size: usize,
-    /// The percentage of used to unused space at which a collection is triggered
-    gc_threshold: f64,
-    /// The maximum number of minor collections before a full sweep occurs
-    max_gen_gcs: usize,
     /// off-heap allocations
     off_heap: SpinLock<LinkedList<HeapFragmentAdapter>>,
     off_heap_size: AtomicUsize,
@@ -141,7 +136,10 @@ pub struct Process {
     pub monitor_by_reference: DashMap<Reference, Monitor>,
     /// Maps monitor references to the PID of the process being monitored by this process.
     pub monitored_pid_by_reference: DashMap<Reference, Pid>,
-    pub mailbox: Mutex<RefCell<Mailbox>>,
+    /// Messages which have been received, see `Process::mailbox`
+    mailbox: Mutex<RefCell<Mailbox>>,
+    /// Messages which have been sent, but not yet moved into `mailbox`
+    inbox: Inbox,
     pub registers: CalleeSavedRegisters,
     pub stack: Mutex<alloc::Stack>,
     // process heap, cache line aligned to avoid false sharing with rest of struct
@@ -172,17 +170,15 @@ impl Process {
 
         Self {
             flags: AtomicProcessFlags::new(ProcessFlags::Default),
-            min_heap_size: heap_size,
-            max_heap_size: 0,
+            gc_policy: GcPolicy::with_min_heap_size(heap_size),
             min_vheap_size: 0,
-            gc_threshold: 0.75,
-            max_gen_gcs: 65535,
             off_heap,
             off_heap_size: AtomicUsize::new(0),
             dictionary: Default::default(),
             pid,
             status: Default::default(),
             mailbox: Default::default(),
+            inbox: Default::default(),
             heap: Mutex::new(heap),
             stack: Default::default(),
             registers: Default::default(),
@@ -215,7 +211,7 @@ impl Process {
             heap,
             heap_size,
         );
-        p.stack = Mutex::new(self::alloc::stack(32)?);
+        p.stack = Mutex::new(self::alloc::stack(self::alloc::stack_pages())?);
         Ok(p)
     }
 
@@ -265,6 +261,22 @@ impl Process {
 
     // Alloc
 
+    /// Returns the policy for garbage collecting this process
+    #[inline]
+    pub fn gc_policy(&self) -> GcPolicy {
+        self.gc_policy
+    }
+
+    /// Replaces the policy for garbage collecting this process, before it is spawned
+    pub fn set_gc_policy(&mut self, gc_policy: GcPolicy) {
+        self.gc_policy = gc_policy;
+    }
+
+    /// Returns the garbage collection counters of this process
+    pub fn gc_statistics(&self) -> GcStatistics {
+        self.heap.lock().gc_statistics()
+    }
+
     /// Acquires exclusive access to the process heap, blocking the current thread until it is able
     /// to do so.
     ///
@@ -288,6 +300,18 @@ impl Process {
         self.heap.try_lock()
     }
 
+    /// Returns a pointer to the bounds of the free region of this process' young heap.
+    ///
+    /// While this process is `Running`, generated code allocates by bumping the heap top
+    /// through this pointer without holding the heap lock, so other processes must not
+    /// allocate on this heap during that time (see `send_from_other`). The lock is taken
+    /// here so that the scheduler, which calls this after marking the process as
+    /// `Running`, waits for any in-flight sender to finish before the process resumes.
+    #[inline]
+    pub fn heap_bump_region(&self) -> *mut *mut Term {
+        self.heap.lock().young_bump_region()
+    }
+
     /// Perform a heap allocation, but do not fall back to allocating a heap fragment
     /// if the process heap is not able to fulfill the allocation request
     #[inline]
@@ -545,20 +569,43 @@ impl Process {
 
     /// Returns `true` if the process should stop waiting and be rescheduled as runnable.
     pub fn send_from_other(&self, data: Term) {
-        match self.heap.try_lock() {
-            Some(ref mut destination_heap) => match data.clone_to_heap(destination_heap) {
-                Ok(destination_data) => {
-                    self.send_message(Message::Process(message::Process {
-                        data: destination_data,
-                    }));
-                }
-                Err(_) => {
-                    let (heap_fragment_data, heap_fragment) = data.clone_to_fragment().unwrap();
+        // A running process allocates on its heap without taking the lock, so only
+        // copy directly into the heap while it is not running. The status is held until
+        // the copy is done, so that a scheduler cannot mark the process as running and
+        // swap it in during the copy.
+        let status = self.status.read();
+        let heap_guard = if *status == Status::Running {
+            None
+        } else {
+            self.heap.try_lock()
+        };
+
+        match heap_guard {
+            Some(mut destination_heap) => {
+                let copy_start = destination_heap.heap_top();
+
+                match data.clone_to_heap(&mut destination_heap) {
+                    Ok(destination_data) => {
+                        // Reference-counted binaries are shared with the sender, only their
+                        // headers were copied, so link them to this process's virtual binary
+                        // heap to release them when they become garbage
+                        destination_heap.virtual_alloc_from(copy_start);
+
+                        self.send_message(Message::Process(message::Process {
+                            data: destination_data,
+                        }));
+                    }
+                    Err(_) => {
+                        let (heap_fragment_data, heap_fragment) =
+                            data.clone_to_fragment().unwrap();
 
-                    self.send_heap_message(heap_fragment, heap_fragment_data);
+                        self.send_heap_message(heap_fragment, heap_fragment_data);
+                    }
                 }
-            },
+            }
             None => {
+                drop(status);
+
                 let (heap_fragment_data, heap_fragment) = data.clone_to_fragment().unwrap();
 
                 self.send_heap_message(heap_fragment, heap_fragment_data);
@@ -567,7 +614,20 @@ impl Process {
     }
 
     fn send_message(&self, message: Message) {
-        self.mailbox.lock().borrow_mut().push(message)
+        self.inbox.push(message)
+    }
+
+    /// Locks the mailbox, after moving any messages sent since it was last locked into it
+    ///
+    /// Senders never take this lock, so it is only contended when another process
+    /// inspects the mailbox, e.g. with `process_info/2`.
+    pub fn mailbox(&self) -> MutexGuard<RefCell<Mailbox>> {
+        let mailbox = self.mailbox.lock();
+        unsafe {
+            mailbox.borrow_mut().drain(&self.inbox);
+        }
+
+        mailbox
     }
 
     // Terms
@@ -579,6 +639,43 @@ impl Process {
         }
     }
 
+    /// Like `binary_from_bytes`, but `init` writes the `len` bytes of the binary in place, so
+    /// that callers which know the size up front don't need to build the bytes separately
+    pub fn binary_from_fn<F>(&self, len: usize, init: F) -> Term
+    where
+        F: FnOnce(&mut [u8]),
+    {
+        if len <= HeapBin::MAX_SIZE {
+            let mut bytes = [0; HeapBin::MAX_SIZE];
+            init(&mut bytes[..len]);
+
+            return self.binary_from_bytes(&bytes[..len]);
+        }
+
+        let proc_bin = match ProcBin::from_fn(len, Encoding::Raw, init) {
+            Ok(proc_bin) => proc_bin,
+            Err(alloc) => panic!(alloc),
+        };
+        let mut heap = self.acquire_heap();
+
+        match unsafe { heap.alloc_layout(Layout::new::<ProcBin>()) } {
+            Ok(non_null) => unsafe {
+                let ptr = non_null.as_ptr() as *mut ProcBin;
+                ptr.write(proc_bin);
+                let boxed_proc_bin = Boxed::new_unchecked(ptr);
+                // Add the binary to the process's virtual binary heap
+                heap.virtual_alloc(boxed_proc_bin);
+
+                boxed_proc_bin.into()
+            },
+            Err(_) => {
+                drop(heap);
+
+                self.attach_fragment_or_panic(HeapFragment::new_procbin(proc_bin))
+            }
+        }
+    }
+
     pub fn binary_from_str(&self, s: &str) -> Term {
         match self.acquire_heap().binary_from_str(s) {
             Ok(term) => term,
@@ -781,6 +878,40 @@ impl Process {
             .into()
     }
 
+    /// Returns `map` with `key` associated with `value`
+    pub fn map_put(&self, map: &Map, key: Term, value: Term) -> Term {
+        let result = map.put(self.acquire_heap().deref_mut(), key, value);
+
+        result
+            .unwrap_or_else(|_| {
+                self.attach_fragment_or_panic(HeapFragment::new_map_put(map, key, value))
+            })
+            .into()
+    }
+
+    /// Returns `map` without `key`
+    pub fn map_remove(&self, map: &Map, key: Term) -> Term {
+        let result = map.remove(self.acquire_heap().deref_mut(), key);
+
+        result
+            .unwrap_or_else(|_| {
+                self.attach_fragment_or_panic(HeapFragment::new_map_remove(map, key))
+            })
+            .into()
+    }
+
+    /// Returns a map with the entries of `map` and `other`, where keys present in both are
+    /// associated with their value in `other`
+    pub fn map_merge(&self, map: &Map, other: &Map) -> Term {
+        let result = map.merge(self.acquire_heap().deref_mut(), other);
+
+        result
+            .unwrap_or_else(|_| {
+                self.attach_fragment_or_panic(HeapFragment::new_map_merge(map, other))
+            })
+            .into()
+    }
+
     pub fn reference(&self, number: ReferenceNumber) -> Term {
         self.reference_from_scheduler(self.scheduler_id.lock().unwrap(), number)
     }
@@ -952,7 +1083,7 @@ impl Process {
         }
         // Check if young generation requires collection
         let heap = self.heap.lock();
-        heap.should_collect(self.gc_threshold)
+        heap.should_collect(self.gc_policy.gc_threshold)
     }
 
     #[inline(always)]
@@ -1124,6 +1255,26 @@ impl Process {
         self.run_reductions.fetch_add(1, Ordering::AcqRel);
     }
 
+    /// Puts the process in the waiting status, unless a message has been sent to it since
+    /// its mailbox was last locked.
+    ///
+    /// Senders don't take the mailbox lock, and only wake up the process if they see it
+    /// waiting, so a receive must use this rather than `wait` to not miss a message sent
+    /// after it last checked the mailbox.
+    pub fn wait_for_message(&self) {
+        {
+            let mut writable_status = self.status.write();
+            if self.inbox.is_empty() {
+                *writable_status = Status::Waiting;
+
+                if self.gc_policy.shrink_on_idle {
+                    self.flags.set(ProcessFlags::ShrinkHeap);
+                }
+            }
+        }
+        self.run_reductions.fetch_add(1, Ordering::AcqRel);
+    }
+
     /// Puts the process in the runnable status if it was waiting
     pub fn stop_waiting(&self) -> bool {
         let mut writable_status = self.status.write();
@@ -1438,6 +1589,14 @@ impl PartialEq for Process {
     }
 }
 
+impl Drop for Process {
+    fn drop(&mut self) {
+        // Heap fragments hold references to the reference-counted binaries in them, which are
+        // released when the fragments are dropped
+        self.sweep_off_heap();
+    }
+}
+
 unsafe impl Send for Process {}
 unsafe impl Sync for Process {}
 
@@ -3,6 +3,7 @@ mod iter;
 mod process_heap_alloc;
 mod semispace;
 mod stack_alloc;
+mod stack_pool;
 mod stack_primitives;
 mod term_alloc;
 mod virtual_alloc;
@@ -13,12 +14,16 @@ pub use self::iter::HeapIter;
 pub use self::process_heap_alloc::ProcessHeapAlloc;
 pub use self::semispace::{GenerationalHeap, SemispaceHeap};
 pub use self::stack_alloc::StackAlloc;
+pub use self::stack_pool::{
+    set_stack_pages, set_stack_pool_capacity, stack_pages, DEFAULT_STACK_PAGES,
+    DEFAULT_STACK_POOL_CAPACITY,
+};
 pub use self::stack_primitives::StackPrimitives;
 pub use self::term_alloc::TermAlloc;
 pub use self::virtual_alloc::{VirtualAlloc, VirtualAllocator, VirtualHeap};
 pub use self::virtual_binary_heap::VirtualBinaryHeap;
 
-use core::alloc::{AllocError, Layout};
+use core::alloc::AllocError;
 use core::ffi::c_void;
 use core::mem::transmute;
 use core::ptr::{self, NonNull};
@@ -112,23 +117,19 @@ impl Default for Stack {
 unsafe impl Sync for Stack {}
 impl Drop for Stack {
     fn drop(&mut self) {
-        use liblumen_core::alloc::mmap;
         use liblumen_core::sys::sysconf;
 
-        if self.base.is_null() {
-            return;
-        }
+        let base = match NonNull::new(self.base) {
+            Some(base) => base,
+            None => return,
+        };
 
         let page_size = sysconf::pagesize();
         let pages = (self.size / page_size) - 1;
 
-        let (layout, _offset) = Layout::from_size_align(page_size, page_size)
-            .unwrap()
-            .repeat(pages)
-            .unwrap();
-
+        // The stack is recycled for the next process spawned by this scheduler
         unsafe {
-            mmap::unmap(self.base, layout);
+            stack_pool::release(base, pages);
         }
     }
 }
@@ -151,14 +152,13 @@ pub fn heap(size: usize) -> AllocResult<*mut Term> {
     PROC_ALLOC.alloc(size)
 }
 
-/// Allocate a new process stack of the given size (in pages)
+/// Allocate a new process stack of the given size (in pages), reusing an unused stack
+/// of the same size if one is available
 #[inline]
 pub fn stack(num_pages: usize) -> AllocResult<Stack> {
-    use liblumen_core::alloc::mmap;
-
     debug_assert!(num_pages > 0, "stack size in pages must be greater than 0");
 
-    let ptr = unsafe { mmap::map_stack(num_pages)? };
+    let ptr = stack_pool::acquire(num_pages)?;
     Ok(Stack::new(ptr.as_ptr(), num_pages))
 }
 
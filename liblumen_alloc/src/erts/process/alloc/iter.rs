@@ -22,6 +22,11 @@ pub trait HeapIter: Sized + Heap {
     ///   }
     /// }
     fn iter_mut<'a>(&mut self) -> IterMut<'a, Self>;
+
+    /// Like `iter_mut`, but starts at `start` rather than the beginning of the heap
+    ///
+    /// `start` must be the position of a term on this heap, such as a previous `heap_top`
+    fn iter_mut_from<'a>(&mut self, start: *mut Term) -> IterMut<'a, Self>;
 }
 
 /// This implementation relies on the fact that access to the heap is exclusive,
@@ -43,6 +48,16 @@ where
             _marker: PhantomData,
         }
     }
+
+    fn iter_mut_from<'a>(&mut self, start: *mut Term) -> IterMut<'a, Self> {
+        debug_assert!(self.heap_start() <= start && start <= self.heap_top());
+
+        IterMut {
+            heap: self as *const _ as *mut Self,
+            pos: start,
+            _marker: PhantomData,
+        }
+    }
 }
 
 pub struct IterMut<'a, T: Heap> {
@@ -80,8 +95,9 @@ where
                     return Some(term);
                 } else if term.is_header() {
                     // For certain terms, we need to walk their elements
-                    if term.is_tuple() {
-                        // Tuple header is word-sized, followed by elements
+                    if term.is_tuple() || term.is_map() {
+                        // Tuple header is word-sized, followed by elements, and maps are
+                        // laid out the same way, followed by their size and root node
                         self.pos = unsafe { pos.add(1) };
                         // Shift to first element
                         return Some(term);
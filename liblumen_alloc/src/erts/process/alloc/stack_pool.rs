@@ -0,0 +1,244 @@
+use core::alloc::Layout;
+use core::cell::RefCell;
+use core::ptr::NonNull;
+use core::sync::atomic::{AtomicUsize, Ordering};
+
+use liblumen_core::alloc::mmap;
+use liblumen_core::sys::sysconf;
+
+use crate::erts::exception::AllocResult;
+
+/// The default size of a process stack, in pages, not including its guard page.
+///
+/// Stacks are reserved at this size up front, but only the pages a process actually
+/// touches are committed, so a process can grow its stack up to this size while most
+/// processes only use a few pages.
+pub const DEFAULT_STACK_PAGES: usize = 256;
+
+/// The default number of unused stacks kept by each scheduler
+pub const DEFAULT_STACK_POOL_CAPACITY: usize = 64;
+
+/// The number of pages at the top of a recycled stack which are left committed, as they
+/// are almost certainly used by the next process to get the stack
+const RESIDENT_PAGES: usize = 4;
+
+static STACK_PAGES: AtomicUsize = AtomicUsize::new(DEFAULT_STACK_PAGES);
+static STACK_POOL_CAPACITY: AtomicUsize = AtomicUsize::new(DEFAULT_STACK_POOL_CAPACITY);
+
+thread_local! {
+    // Each scheduler runs on its own thread, so this is a pool per scheduler, which needs
+    // no synchronization. Stacks are returned to the pool of the thread which drops the
+    // process, which is usually the scheduler it exited on.
+    static STACK_POOL: RefCell<StackPool> = RefCell::new(StackPool(Vec::new()));
+}
+
+/// Returns the size of process stacks, in pages
+#[inline]
+pub fn stack_pages() -> usize {
+    STACK_PAGES.load(Ordering::Relaxed)
+}
+
+/// Sets the size of process stacks spawned from now on, in pages
+pub fn set_stack_pages(pages: usize) {
+    assert!(pages > 0, "stack size in pages must be greater than 0");
+    STACK_PAGES.store(pages, Ordering::Relaxed);
+}
+
+/// Sets the maximum number of unused stacks kept by each scheduler
+pub fn set_stack_pool_capacity(capacity: usize) {
+    STACK_POOL_CAPACITY.store(capacity, Ordering::Relaxed);
+}
+
+/// Takes a stack mapping of `pages` pages, plus its guard page, from the pool of the
+/// current thread, or maps a new one if the pool is empty.
+pub(super) fn acquire(pages: usize) -> AllocResult<NonNull<u8>> {
+    let pooled = STACK_POOL
+        .try_with(|pool| pool.borrow_mut().take(pages))
+        .ok()
+        .flatten();
+
+    match pooled {
+        Some(base) => Ok(base),
+        None => unsafe { mmap::map_stack(pages).map_err(From::from) },
+    }
+}
+
+/// Returns a stack mapping of `pages` pages, plus its guard page, to the pool of the
+/// current thread, or unmaps it if the pool is full.
+pub(super) unsafe fn release(base: NonNull<u8>, pages: usize) {
+    let page_size = sysconf::pagesize();
+
+    if pages == stack_pages() {
+        // Give back the memory of all but the top of the stack, as the pool may hold on
+        // to the stack for a long time, and most processes don't use that much of it
+        if pages > RESIDENT_PAGES {
+            let bottom = base.as_ptr().add(page_size);
+            mmap::decommit(bottom, (pages - RESIDENT_PAGES) * page_size);
+        }
+
+        let pooled = STACK_POOL
+            .try_with(|pool| pool.borrow_mut().put(base, pages))
+            .unwrap_or(false);
+        if pooled {
+            return;
+        }
+    }
+
+    unmap(base, pages);
+}
+
+unsafe fn unmap(base: NonNull<u8>, pages: usize) {
+    let page_size = sysconf::pagesize();
+    let layout = Layout::from_size_align_unchecked((pages + 1) * page_size, page_size);
+
+    mmap::unmap(base.as_ptr(), layout);
+}
+
+/// Unused stack mappings, and their size in pages
+struct StackPool(Vec<(NonNull<u8>, usize)>);
+impl StackPool {
+    fn take(&mut self, pages: usize) -> Option<NonNull<u8>> {
+        while let Some((base, base_pages)) = self.0.pop() {
+            if base_pages == pages {
+                return Some(base);
+            }
+            // The stack size was changed since this stack was pooled
+            unsafe { unmap(base, base_pages) }
+        }
+
+        None
+    }
+
+    fn put(&mut self, base: NonNull<u8>, pages: usize) -> bool {
+        if self.0.len() < STACK_POOL_CAPACITY.load(Ordering::Relaxed) {
+            self.0.push((base, pages));
+            true
+        } else {
+            false
+        }
+    }
+
+    fn clear(&mut self) {
+        for (base, pages) in self.0.drain(..) {
+            unsafe { unmap(base, pages) }
+        }
+    }
+}
+impl Drop for StackPool {
+    fn drop(&mut self) {
+        self.clear();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    extern crate test;
+
+    use super::*;
+
+    use test::Bencher;
+
+    use crate::erts::process::{alloc, Priority, Process};
+    use crate::erts::ModuleFunctionArity;
+
+    /// The number of processes spawned per iteration of the spawn and park benchmarks
+    const PROCESSES: usize = 1_000;
+
+    #[bench]
+    fn acquire_and_release_pooled(b: &mut Bencher) {
+        let pages = stack_pages();
+
+        b.iter(|| unsafe {
+            let base = acquire(pages).unwrap();
+            touch_top(base, pages);
+            release(base, pages);
+        });
+    }
+
+    #[bench]
+    fn map_and_unmap_unpooled(b: &mut Bencher) {
+        let pages = stack_pages();
+
+        b.iter(|| unsafe {
+            let base = mmap::map_stack(pages).unwrap();
+            touch_top(base, pages);
+            unmap(base, pages);
+        });
+    }
+
+    // `bytes` counts processes, so the reported MB/s is millions of processes spawned per second
+    #[bench]
+    fn spawn_rate(b: &mut Bencher) {
+        b.bytes = PROCESSES as u64;
+
+        b.iter(|| {
+            for _ in 0..PROCESSES {
+                let process = spawn();
+                drop(process);
+            }
+        });
+    }
+
+    // Spawns processes which stay alive until the end of the iteration, so the stacks come
+    // from the pool only until it runs dry. The resident memory of the parked processes is
+    // printed once, as the benchmark harness has no way to report it.
+    #[cfg(target_os = "linux")]
+    #[bench]
+    fn park_processes(b: &mut Bencher) {
+        let before = resident_bytes();
+        let parked: Vec<Process> = (0..PROCESSES).map(|_| spawn()).collect();
+        let after = resident_bytes();
+        drop(parked);
+
+        eprintln!(
+            "resident memory of {} parked processes: {} KiB ({} bytes per process)",
+            PROCESSES,
+            after.saturating_sub(before) / 1024,
+            after.saturating_sub(before) / PROCESSES
+        );
+
+        b.iter(|| {
+            let parked: Vec<Process> = (0..PROCESSES).map(|_| spawn()).collect();
+            parked
+        });
+    }
+
+    fn spawn() -> Process {
+        let init = atom_from_str!("init");
+        let initial_module_function_arity = ModuleFunctionArity {
+            module: init,
+            function: init,
+            arity: 0,
+        };
+        let (heap, heap_size) = alloc::default_heap().unwrap();
+        let process = Process::new_with_stack(
+            Priority::Normal,
+            None,
+            initial_module_function_arity,
+            heap,
+            heap_size,
+        )
+        .unwrap();
+
+        let stack = process.stack().lock();
+        let pages = (stack.size / sysconf::pagesize()) - 1;
+        unsafe { touch_top(NonNull::new(stack.base).unwrap(), pages) };
+        drop(stack);
+
+        process
+    }
+
+    #[cfg(target_os = "linux")]
+    fn resident_bytes() -> usize {
+        let statm = std::fs::read_to_string("/proc/self/statm").unwrap();
+        let resident_pages: usize = statm.split_whitespace().nth(1).unwrap().parse().unwrap();
+
+        resident_pages * sysconf::pagesize()
+    }
+
+    // Like a newly spawned process, which only uses the top of its stack
+    unsafe fn touch_top(base: NonNull<u8>, pages: usize) {
+        let top = base.as_ptr().add((pages + 1) * sysconf::pagesize());
+        top.sub(1).write_volatile(1);
+    }
+}
@@ -46,7 +46,7 @@ pub trait TermAlloc: Heap {
         let len = bytes.len();
 
         // Allocate ProcBins for sizes greater than 64 bytes
-        if len > 64 {
+        if len > HeapBin::MAX_SIZE {
             match self.procbin_from_bytes(bytes) {
                 Err(error) => Err(error),
                 Ok(bin_ptr) => {
@@ -264,9 +264,7 @@ pub trait TermAlloc: Heap {
     where
         Self: Sized,
     {
-        let boxed = Map::from_hash_map(hash_map).clone_to_heap(self)?;
-        let ptr: Boxed<Map> = boxed.dyn_cast();
-        Ok(ptr)
+        Map::from_hash_map(self, &hash_map)
     }
 
     /// Constructs a map and associated with the given process.
@@ -274,9 +272,7 @@ pub trait TermAlloc: Heap {
     where
         Self: Sized,
     {
-        let boxed = Map::from_slice(slice).clone_to_heap(self)?;
-        let ptr: Boxed<Map> = boxed.dyn_cast();
-        Ok(ptr)
+        Map::from_slice(self, slice)
     }
 
     #[inline]
@@ -1,4 +1,5 @@
 use crate::erts::exception::{ErlangException, RuntimeException};
+use crate::erts::term::prelude::Term;
 
 use liblumen_core::util::thread_local::ThreadLocalCell;
 
@@ -28,6 +29,12 @@ extern "C" {
     #[thread_local]
     static mut PROCESS_SIGNAL: ProcessSignal;
 
+    // Points to the `[top, limit)` pair of the young heap belonging to the
+    // currently running process, generated code bump allocates against it
+    #[link_name = "__lumen_process_heap"]
+    #[thread_local]
+    static mut PROCESS_HEAP: *mut *mut Term;
+
     #[allow(improper_ctypes)]
     #[unwind(allowed)]
     #[link_name = "__lumen_panic"]
@@ -59,6 +66,17 @@ pub fn clear_process_signal() {
     }
 }
 
+/// Sets the heap bounds used by generated code for inline allocation
+///
+/// This must be called by the scheduler whenever a process is swapped in,
+/// with the value returned by `Process::heap_bump_region`
+#[inline(always)]
+pub fn set_process_heap(bounds: *mut *mut Term) {
+    unsafe {
+        PROCESS_HEAP = bounds;
+    }
+}
+
 #[unwind(allowed)]
 pub fn process_raise(err: RuntimeException) -> ! {
     let erlang_exception = err.as_erlang_exception();
@@ -26,6 +26,9 @@ impl ProcessFlags {
     /// This flag indicates the processes linked to this process should send exit messages instead
     /// of causing this process to exit when they exit
     pub const TrapExit: Self = Self(1 << 6);
+    /// This flag indicates that the process went idle, and the next GC should be a full sweep
+    /// so that the heap is shrunk to fit its live data
+    pub const ShrinkHeap: Self = Self(1 << 7);
 
     pub fn are_set(&self, flags: ProcessFlags) -> bool {
         (*self & flags) == flags
@@ -1,7 +1,9 @@
 mod collection_type;
 pub mod collector;
 mod old_heap;
+mod policy;
 mod rootset;
+mod statistics;
 mod sweep;
 mod young_heap;
 
@@ -13,7 +15,10 @@ pub use self::collection_type::{
 };
 pub use self::collector::{GarbageCollector, ProcessCollector, SimpleCollector};
 pub use self::old_heap::OldHeap;
+pub use self::policy::{GcPolicy, HeapGrowth, DEFAULT_FULLSWEEP_AFTER, DEFAULT_GC_THRESHOLD};
 pub use self::rootset::RootSet;
+pub use self::statistics::{global_statistics, GcStatistics};
+pub(crate) use self::statistics::{CollectionKind, Pause};
 pub use self::sweep::{Sweep, Sweepable, Sweeper};
 pub use self::young_heap::YoungHeap;
 
@@ -0,0 +1,89 @@
+use crate::erts::process::alloc;
+
+/// The default number of minor collections before a full sweep is forced, same as BEAM
+pub const DEFAULT_FULLSWEEP_AFTER: usize = 65535;
+
+/// The default percentage of used to unused space at which a collection is triggered
+pub const DEFAULT_GC_THRESHOLD: f64 = 0.75;
+
+/// Controls when a process is garbage collected, and how its heap is sized
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct GcPolicy {
+    /// The number of minor collections after which the next collection is a full sweep
+    pub fullsweep_after: usize,
+    /// The size (in words) below which the heap is never shrunk
+    pub min_heap_size: usize,
+    /// The size (in words) the heap may not grow beyond, or `0` if unlimited
+    pub max_heap_size: usize,
+    /// The percentage of used to unused space at which a collection is triggered
+    pub gc_threshold: f64,
+    /// How the heap grows when a collection doesn't free enough space
+    pub heap_growth: HeapGrowth,
+    /// Whether the first collection after the process waits for a message should be a
+    /// full sweep, which compacts all live data into a heap sized to fit it, releasing
+    /// the memory held by idle processes
+    pub shrink_on_idle: bool,
+}
+impl GcPolicy {
+    /// Returns the policy for a process with the given minimum heap size (in words)
+    pub fn with_min_heap_size(min_heap_size: usize) -> Self {
+        Self {
+            min_heap_size,
+            ..Default::default()
+        }
+    }
+
+    /// Calculates the next largest heap size equal to or greater than `size`, according
+    /// to the growth curve of this policy
+    #[inline]
+    pub fn next_heap_size(&self, size: usize) -> usize {
+        self.heap_growth.next_heap_size(self.min_heap_size, size)
+    }
+}
+impl Default for GcPolicy {
+    fn default() -> Self {
+        Self {
+            fullsweep_after: DEFAULT_FULLSWEEP_AFTER,
+            min_heap_size: alloc::default_heap_size(),
+            max_heap_size: 0,
+            gc_threshold: DEFAULT_GC_THRESHOLD,
+            heap_growth: HeapGrowth::default(),
+            shrink_on_idle: false,
+        }
+    }
+}
+
+/// The curve along which process heaps grow
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum HeapGrowth {
+    /// The same growth pattern as BEAM, Fibonacci growth from 233 words until 1M words,
+    /// at which point the heap grows 20% at a time.
+    ///
+    /// These sizes match the size classes of the process heap allocator, so heaps are
+    /// reused rather than mapped for every collection.
+    Fibonacci,
+    /// Grows by the given percentage at each step, starting from the minimum heap size of
+    /// the process, trading more frequent collections for less unused space on large heaps
+    Geometric(u8),
+}
+impl HeapGrowth {
+    /// Calculates the next heap size greater than `size` for a process whose heap starts at
+    /// `min_heap_size` words
+    pub fn next_heap_size(&self, min_heap_size: usize, size: usize) -> usize {
+        match self {
+            Self::Fibonacci => alloc::next_heap_size(size),
+            Self::Geometric(percent) => {
+                let mut next_size = min_heap_size.max(1);
+                while next_size <= size {
+                    next_size += (next_size * (*percent as usize) / 100).max(1);
+                }
+                next_size
+            }
+        }
+    }
+}
+impl Default for HeapGrowth {
+    fn default() -> Self {
+        Self::Fibonacci
+    }
+}
@@ -0,0 +1,92 @@
+use core::sync::atomic::{AtomicU64, Ordering};
+
+/// The number of collections performed by all processes
+static COLLECTIONS: AtomicU64 = AtomicU64::new(0);
+/// The number of words reclaimed by all collections
+static WORDS_RECLAIMED: AtomicU64 = AtomicU64::new(0);
+
+/// Garbage collection counters for a single process
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct GcStatistics {
+    /// The number of minor collections
+    pub minor_collections: u64,
+    /// The number of minor collections since the last full sweep, as reported by
+    /// `process_info/2` for `minor_gcs`
+    pub minor_collections_since_fullsweep: u64,
+    /// The number of full sweep collections
+    pub full_collections: u64,
+    /// The number of words freed across all collections
+    pub words_reclaimed: u64,
+    /// The total time spent collecting, in nanoseconds
+    pub pause_ns: u64,
+    /// The longest time spent in a single collection, in nanoseconds
+    pub max_pause_ns: u64,
+}
+impl GcStatistics {
+    /// Returns the total number of collections
+    #[inline]
+    pub fn collections(&self) -> u64 {
+        self.minor_collections + self.full_collections
+    }
+
+    pub(crate) fn record(&mut self, kind: CollectionKind, words_reclaimed: usize, pause: Pause) {
+        let pause_ns = pause.elapsed_ns();
+        match kind {
+            CollectionKind::Minor => self.minor_collections += 1,
+            CollectionKind::Full => self.full_collections += 1,
+        }
+        self.words_reclaimed += words_reclaimed as u64;
+        self.pause_ns += pause_ns;
+        self.max_pause_ns = self.max_pause_ns.max(pause_ns);
+
+        COLLECTIONS.fetch_add(1, Ordering::Relaxed);
+        WORDS_RECLAIMED.fetch_add(words_reclaimed as u64, Ordering::Relaxed);
+    }
+}
+
+/// Returns the number of collections and words reclaimed by all processes since the
+/// system started, as returned by `erlang:statistics(garbage_collection)`
+pub fn global_statistics() -> (u64, u64) {
+    (
+        COLLECTIONS.load(Ordering::Relaxed),
+        WORDS_RECLAIMED.load(Ordering::Relaxed),
+    )
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub(crate) enum CollectionKind {
+    Minor,
+    Full,
+}
+
+/// Measures the time the process is paused for a collection
+#[cfg(not(target_arch = "wasm32"))]
+pub(crate) struct Pause(std::time::Instant);
+#[cfg(not(target_arch = "wasm32"))]
+impl Pause {
+    #[inline]
+    pub(crate) fn start() -> Self {
+        Self(std::time::Instant::now())
+    }
+
+    #[inline]
+    fn elapsed_ns(&self) -> u64 {
+        self.0.elapsed().as_nanos() as u64
+    }
+}
+
+// There is no monotonic clock available to this crate on wasm32, so pauses aren't timed
+#[cfg(target_arch = "wasm32")]
+pub(crate) struct Pause;
+#[cfg(target_arch = "wasm32")]
+impl Pause {
+    #[inline]
+    pub(crate) fn start() -> Self {
+        Self
+    }
+
+    #[inline]
+    fn elapsed_ns(&self) -> u64 {
+        0
+    }
+}
@@ -293,6 +293,11 @@ where
         // Move to new location
         src.copy_to_nonoverlapping(dst, 1);
 
+        // Write move marker to previous location, so that the reference now held by the moved
+        // header is not also released with the previous location, such as a heap fragment
+        let marker: Term = dst.into();
+        (src as *mut Term).write(marker);
+
         // Link to destination virtual heap
         let boxed = Boxed::new_unchecked(dst);
         sweeper.target_mut().virtual_alloc(boxed);
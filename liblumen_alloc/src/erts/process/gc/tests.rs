@@ -8,6 +8,7 @@ use crate::erts::process::alloc::*;
 use crate::erts::testing::DEFAULT_HEAP_SIZE;
 
 mod collector;
+mod policy;
 mod simple_collector;
 mod sweep;
 
@@ -147,6 +147,7 @@ fn simple_gc_test(process: Process) {
     // Run garbage collection
     let mut roots = [tuple_term, list_term, closure_term];
     process.garbage_collect(0, &mut roots[..]).unwrap();
+    assert_eq!(process.gc_statistics().collections(), 1);
     process.set_flags(ProcessFlags::NeedFullSweep);
     // Grab post-collection size
     let collected_size_first = process.young_heap_used();
@@ -0,0 +1,38 @@
+use crate::erts::process::alloc;
+use crate::erts::process::gc::{GcPolicy, HeapGrowth};
+
+#[test]
+fn fibonacci_heap_growth_follows_heap_sizes() {
+    let policy = GcPolicy::default();
+
+    for size in [0, 233, 1000, 100_000, 10_000_000].iter() {
+        assert_eq!(policy.next_heap_size(*size), alloc::next_heap_size(*size));
+    }
+}
+
+#[test]
+fn geometric_heap_growth_fits_requested_size() {
+    let growth = HeapGrowth::Geometric(25);
+    let mut previous = 0;
+
+    for size in [0, 233, 1000, 100_000, 10_000_000].iter() {
+        let next = growth.next_heap_size(alloc::default_heap_size(), *size);
+        assert!(*size < next);
+        // The next size is less than one step larger than the requested size
+        assert!(next <= (*size).max(alloc::default_heap_size()) * 5 / 4 + 1);
+        assert!(previous <= next);
+        previous = next;
+    }
+}
+
+#[test]
+fn geometric_heap_growth_starts_from_min_heap_size() {
+    let min_heap_size = 16_000;
+    let policy = GcPolicy {
+        heap_growth: HeapGrowth::Geometric(25),
+        ..GcPolicy::with_min_heap_size(min_heap_size)
+    };
+
+    assert_eq!(policy.next_heap_size(0), min_heap_size);
+    assert_eq!(policy.next_heap_size(min_heap_size), min_heap_size * 5 / 4);
+}
@@ -31,11 +31,15 @@ use crate::mem::bit_size_of;
 /// in the old heap; while terms above the high-water mark have not survived a
 /// collection yet, and are either garbage to be collected, or values which need to
 /// be copied to the new young heap.
+///
+/// NOTE: Generated code bump allocates directly against `top` and `stack_start`
+/// (see `bump_region`), so those two fields must remain first, in that order.
+#[repr(C)]
 pub struct YoungHeap {
-    start: *mut Term,
     top: *mut Term,
-    end: *mut Term,
     stack_start: *mut Term,
+    start: *mut Term,
+    end: *mut Term,
     stack_end: *mut Term,
     stack_size: usize,
     high_water_mark: *mut Term,
@@ -120,6 +124,17 @@ impl YoungHeap {
         distance_absolute(self.high_water_mark, self.start)
     }
 
+    /// Returns a pointer to the `[top, stack_start)` pair which bounds the free
+    /// region of this heap. Generated code allocates by bumping `top` through this
+    /// pointer, and only calls into the runtime when the region is exhausted.
+    ///
+    /// The pointer remains valid for as long as this heap is owned by its process,
+    /// as collections replace the young heap in place.
+    #[inline]
+    pub fn bump_region(&mut self) -> *mut *mut Term {
+        &mut self.top
+    }
+
     /// Sets the high water mark to the current top of the heap
     #[inline]
     pub fn set_high_water_mark(&mut self) {
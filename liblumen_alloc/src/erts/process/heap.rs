@@ -6,7 +6,7 @@ use log::trace;
 use liblumen_core::util::pointer::distance_absolute;
 
 use crate::erts::exception::AllocResult;
-use crate::erts::term::prelude::{Boxed, ProcBin, Term};
+use crate::erts::term::prelude::{Boxed, Encoded, ProcBin, Term};
 
 use super::alloc::{self, *};
 use super::gc::{self, *};
@@ -20,6 +20,8 @@ use super::{Process, ProcessFlags};
 pub struct ProcessHeap {
     // the number of minor collections
     pub(super) gen_gc_count: usize,
+    // counters for all collections of this heap
+    statistics: GcStatistics,
     // The semi-space generational heap
     heap: SemispaceProcessHeap,
 }
@@ -30,6 +32,7 @@ impl ProcessHeap {
         let heap = SemispaceHeap::new(young, old);
         Self {
             gen_gc_count: 0,
+            statistics: Default::default(),
             heap,
         }
     }
@@ -40,6 +43,37 @@ impl ProcessHeap {
         self.heap.should_collect(gc_threshold)
     }
 
+    /// Returns the garbage collection counters of this heap
+    #[inline]
+    pub fn gc_statistics(&self) -> GcStatistics {
+        GcStatistics {
+            minor_collections_since_fullsweep: self.gen_gc_count as u64,
+            ..self.statistics
+        }
+    }
+
+    /// Links the reference-counted binaries allocated at or after `start` into the virtual
+    /// binary heap
+    ///
+    /// This is used after copying a term on to this heap from elsewhere, e.g. a message, as
+    /// only the headers of the binaries in the term are copied, and the references they hold
+    /// must be released when they become garbage.
+    pub fn virtual_alloc_from(&mut self, start: *mut Term) {
+        for term in self.iter_mut_from(start) {
+            if term.is_procbin() {
+                let bin = unsafe { Boxed::new_unchecked(term as *mut Term as *mut ProcBin) };
+                self.heap.virtual_alloc(bin);
+            }
+        }
+    }
+
+    /// Returns the bump-allocation bounds of the young generation,
+    /// see `YoungHeap::bump_region`
+    #[inline]
+    pub(super) fn young_bump_region(&mut self) -> *mut *mut Term {
+        self.heap.young_generation_mut().bump_region()
+    }
+
     #[cfg(test)]
     pub(super) fn heap(&self) -> &SemispaceProcessHeap {
         &self.heap
@@ -76,23 +110,43 @@ impl ProcessHeap {
         let stack_size = young.stack_size();
         roots.push_range(sp, stack_size);
 
+        let policy = process.gc_policy();
+        let pause = Pause::start();
+
         // Initialize the collector
         // Determine if the current collection requires a full sweep or not
-        if process.needs_fullsweep() || self.gen_gc_count >= process.max_gen_gcs {
-            self.collect_full(process, needed, roots)
+        let (kind, result) = if process.needs_fullsweep()
+            || process.flags.are_set(ProcessFlags::ShrinkHeap)
+            || self.gen_gc_count >= policy.fullsweep_after
+        {
+            (
+                CollectionKind::Full,
+                self.collect_full(process, &policy, needed, roots),
+            )
         } else {
-            self.collect_minor(process, needed, roots)
-        }
+            (
+                CollectionKind::Minor,
+                self.collect_minor(process, &policy, needed, roots),
+            )
+        };
+
+        result.map(|(reductions, words_reclaimed)| {
+            self.statistics.record(kind, words_reclaimed, pause);
+            reductions
+        })
     }
 
     /// Handles the specific details required to initialize and execute a full sweep garbage
     /// collection
+    ///
+    /// Returns the estimated cost in reductions, and the number of words reclaimed
     fn collect_full(
         &mut self,
         process: &Process,
+        policy: &GcPolicy,
         needed: usize,
         roots: RootSet,
-    ) -> Result<usize, GcError> {
+    ) -> Result<(usize, usize), GcError> {
         trace!("Performing a full sweep garbage collection");
 
         // Determine the estimated size for the new heap which will receive all live data
@@ -108,24 +162,25 @@ impl ProcessHeap {
         // If we already have a large enough heap, we don't need to grow it, but if the GROW flag is
         // set, then we should do it anyway, since it will prevent us from doing another full
         // collection for awhile (assuming one is not forced)
-        let baseline_size = alloc::next_heap_size(padded_estimate);
+        let baseline_size = policy.next_heap_size(padded_estimate);
         let new_heap_size =
             if baseline_size == young.heap_size() && process.should_force_heap_growth() {
-                alloc::next_heap_size(baseline_size)
+                policy.next_heap_size(baseline_size)
             } else {
                 baseline_size
             };
 
         // Verify that our projected heap size is not going to blow the max heap size, if set
         // NOTE: When this happens, we will be left with no choice but to kill the process
-        if process.max_heap_size > 0 && process.max_heap_size < new_heap_size {
+        if policy.max_heap_size > 0 && policy.max_heap_size < new_heap_size {
             return Err(GcError::MaxHeapSizeExceeded);
         }
 
-        // Unset heap_grow and need_fullsweep flags, because we are doing both
+        // Unset heap_grow, need_fullsweep and shrink_heap flags, because we are doing all
+        // of them
         process
             .flags
-            .clear(ProcessFlags::GrowHeap | ProcessFlags::NeedFullSweep);
+            .clear(ProcessFlags::GrowHeap | ProcessFlags::NeedFullSweep | ProcessFlags::ShrinkHeap);
 
         // Allocate target heap (new young generation)
         let ptr = alloc::heap(new_heap_size).map_err(|alloc| GcError::Alloc(alloc))?;
@@ -153,6 +208,7 @@ impl ProcessHeap {
         let stack_used = young.stack_used();
         let heap_used = young.heap_used();
         let size_after = stack_used + heap_used + process.off_heap_size();
+        let words_reclaimed = size_before.saturating_sub(size_after);
         if size_before >= size_after {
             trace!(
                 "Full sweep reclaimed {} words of garbage",
@@ -193,20 +249,20 @@ impl ProcessHeap {
         // failing due to lack of space
         if total_size * 3 < needed_after * 4 {
             process.flags.set(ProcessFlags::GrowHeap);
-            return Ok(gc::estimate_cost(size_after, 0));
+            return Ok((gc::estimate_cost(size_after, 0), words_reclaimed));
         }
 
         // Check if the needed space consumes less than 25% of the new heap,
         // and if so, shrink the new heap immediately to free the unused space
-        if total_size > needed_after * 4 && process.min_heap_size < total_size {
+        let reductions = if total_size > needed_after * 4 && policy.min_heap_size < total_size {
             // Shrink to double our estimated need
             let mut estimate = needed_after * 2;
             // If our estimated need is too low, round up to the min heap size;
             // otherwise, calculate the next heap size bucket our need falls in
-            if estimate < process.min_heap_size {
-                estimate = process.min_heap_size;
+            if estimate < policy.min_heap_size {
+                estimate = policy.min_heap_size;
             } else {
-                estimate = alloc::next_heap_size(estimate);
+                estimate = policy.next_heap_size(estimate);
             }
 
             // As a sanity check, only shrink the heap if the estimate is
@@ -214,25 +270,30 @@ impl ProcessHeap {
             if estimate < total_size {
                 self.shrink_young_heap(estimate);
                 // The final cost of this GC needs to account for the moved heap
-                Ok(gc::estimate_cost(size_after, size_after))
+                gc::estimate_cost(size_after, size_after)
             } else {
                 // We're not actually going to shrink, so our
                 // cost is based purely on the size of the new heap
-                Ok(gc::estimate_cost(size_after, 0))
+                gc::estimate_cost(size_after, 0)
             }
         } else {
             // No shrink required, so our cost is based purely on the size of the new heap
-            Ok(gc::estimate_cost(size_after, 0))
-        }
+            gc::estimate_cost(size_after, 0)
+        };
+
+        Ok((reductions, words_reclaimed))
     }
 
     /// Handles the specific details required to initialize and execute a minor garbage collection
+    ///
+    /// Returns the estimated cost in reductions, and the number of words reclaimed
     fn collect_minor(
         &mut self,
         process: &Process,
+        policy: &GcPolicy,
         needed: usize,
         roots: RootSet,
-    ) -> Result<usize, GcError> {
+    ) -> Result<(usize, usize), GcError> {
         trace!("Performing a minor garbage collection");
 
         // Determine the estimated size for the new heap which will receive immature live data
@@ -248,7 +309,7 @@ impl ProcessHeap {
         // the max heap size, if one was configured.
         //
         // If a max heap size is set, make sure we're not going to exceed it
-        if process.max_heap_size > 0 {
+        if policy.max_heap_size > 0 {
             // First, check if we have exceeded the max heap size
             let mut heap_size = size_before;
             // In this estimate, our stack size includes unused area between stack and heap
@@ -256,7 +317,7 @@ impl ProcessHeap {
             let old = self.heap.old_generation();
             // Add potential old heap size
             if !old.active() && mature_size > 0 {
-                heap_size += alloc::next_heap_size(size_before);
+                heap_size += policy.next_heap_size(size_before);
             } else if old.active() {
                 heap_size += old.heap_used();
             }
@@ -266,17 +327,17 @@ impl ProcessHeap {
             // reclaim `needed` words. We grow the projected size until there
             // is at least enough memory for the current heap + `needed`
             let baseline_size = stack_size + size_before + needed;
-            heap_size += alloc::next_heap_size(baseline_size);
+            heap_size += policy.next_heap_size(baseline_size);
 
             // When this error type is returned, a full sweep will be triggered
-            if heap_size > process.max_heap_size {
+            if heap_size > policy.max_heap_size {
                 return Err(GcError::MaxHeapSizeExceeded);
             }
         }
 
         // Allocate an old heap if we don't have one and one is needed
         if !self.heap.old_generation().active() && mature_size > 0 {
-            let size = alloc::next_heap_size(size_before);
+            let size = policy.next_heap_size(size_before);
             let ptr = alloc::heap(size).map_err(|alloc| GcError::Alloc(alloc))?;
             let _ = self.heap.swap_old(OldHeap::new(ptr, size));
         }
@@ -295,7 +356,7 @@ impl ProcessHeap {
         // the new heap is too small to meet the need that triggered the
         // collection in the first place. Better to shrink it post-collection
         // than to require growing it and re-updating all the roots again
-        let new_size = alloc::next_heap_size(baseline_size);
+        let new_size = policy.next_heap_size(baseline_size);
 
         // Allocate new young generation heap
         let ptr = alloc::heap(new_size).map_err(|alloc| GcError::Alloc(alloc))?;
@@ -327,6 +388,7 @@ impl ProcessHeap {
         let new_mature_size = distance_absolute(old.heap_top(), prev_old_top);
         let heap_used = young.heap_used();
         let size_after = new_mature_size + heap_used; // TODO: add process.mbuf_size
+        let words_reclaimed = size_before.saturating_sub(size_after);
         let needed_after = heap_used + needed + stack_size;
 
         // Excessively large heaps should be shrunk, but don't even bother on reasonable small heaps
@@ -337,7 +399,7 @@ impl ProcessHeap {
         let is_oversized = heap_size > needed_after * 4;
         let old_heap_size = old.heap_size();
         let should_shrink = is_oversized && (heap_size > 8000 || heap_size > old_heap_size);
-        if should_shrink {
+        let reductions = if should_shrink {
             // We are going to shrink the heap to 3x the size of our current need,
             // at this point we already know that the heap is more than 4x our current need,
             // so this provides a reasonable baseline heap usage of 33%
@@ -356,10 +418,10 @@ impl ProcessHeap {
 
             // If the new estimate is less than the min heap size, then round up;
             // otherwise, round the estimate up to the nearest heap size bucket
-            if estimate < process.min_heap_size {
-                estimate = process.min_heap_size;
+            if estimate < policy.min_heap_size {
+                estimate = policy.min_heap_size;
             } else {
-                estimate = alloc::next_heap_size(estimate);
+                estimate = policy.next_heap_size(estimate);
             }
 
             // As a sanity check, only shrink if our revised estimate is
@@ -367,17 +429,19 @@ impl ProcessHeap {
             if estimate < heap_size {
                 self.shrink_young_heap(estimate);
                 // Our final cost should account for the moved heap
-                Ok(gc::estimate_cost(size_after, heap_used))
+                gc::estimate_cost(size_after, heap_used)
             } else {
                 // We're not actually going to shrink, so our cost
                 // is entirely based on the size of the new heap
-                Ok(gc::estimate_cost(size_after, 0))
+                gc::estimate_cost(size_after, 0)
             }
         } else {
             // No shrink required, so our cost is based
             // on the size of the new heap only
-            Ok(gc::estimate_cost(size_after, 0))
-        }
+            gc::estimate_cost(size_after, 0)
+        };
+
+        Ok((reductions, words_reclaimed))
     }
 
     /// In some cases, after a minor collection we may find that we have over-allocated for the
@@ -1,11 +1,19 @@
+use core::cell::UnsafeCell;
 use core::default::Default;
+use core::fmt::{self, Debug};
+use core::ptr;
+use core::sync::atomic::{AtomicPtr, AtomicUsize, Ordering};
 
+use alloc::boxed::Box;
 use alloc::collections::vec_deque::Iter;
 use alloc::collections::VecDeque;
 
+use intrusive_collections::UnsafeRef;
+
 use crate::borrow::CloneToProcess;
 use crate::erts::exception::AllocResult;
 use crate::erts::message::{self, Message};
+use crate::erts::process::alloc::Heap;
 use crate::erts::process::ffi::{set_process_signal, ProcessSignal};
 use crate::erts::process::Process;
 use crate::erts::term::prelude::Term;
@@ -59,6 +67,18 @@ impl Mailbox {
 
     // End receive implementation for the eir interpreter / minimal interpreter
 
+    /// Moves the messages sent to the process since the last call into the receive queue
+    ///
+    /// # Safety
+    ///
+    /// Only one thread may drain `inbox` at a time, which holding the lock on the
+    /// mailbox guarantees
+    pub unsafe fn drain(&mut self, inbox: &Inbox) {
+        while let Some(message) = inbox.pop() {
+            self.messages.push_back(message);
+        }
+    }
+
     pub fn flush<F>(&mut self, predicate: F, process: &Process) -> bool
     where
         F: Fn(&Message) -> bool,
@@ -114,28 +134,47 @@ impl Mailbox {
             Message::HeapFragment(message::HeapFragment {
                 ref unsafe_ref_heap_fragment,
                 data,
-            }) => match data.clone_to_heap(&mut process.acquire_heap()) {
-                Ok(heap_data) => {
-                    let mut off_heap = process.off_heap.lock();
-
-                    unsafe {
-                        let mut cursor =
-                            off_heap.cursor_mut_from_ptr(unsafe_ref_heap_fragment.as_ref());
-                        cursor
-                            .remove()
-                            .expect("HeapFragment was not in process's off_heap");
+            }) => {
+                let mut heap = process.acquire_heap();
+                let copy_start = heap.heap_top();
+
+                match data.clone_to_heap(&mut heap) {
+                    Ok(heap_data) => {
+                        // Only the headers of reference-counted binaries were copied, so link
+                        // them to the virtual binary heap to release them when they become
+                        // garbage
+                        heap.virtual_alloc_from(copy_start);
+                        drop(heap);
+
+                        let mut off_heap = process.off_heap.lock();
+
+                        unsafe {
+                            let mut cursor =
+                                off_heap.cursor_mut_from_ptr(unsafe_ref_heap_fragment.as_ref());
+                            let heap_fragment_ref = cursor
+                                .remove()
+                                .expect("HeapFragment was not in process's off_heap");
+                            // Nothing refers to the fragment now that the data is copied, and
+                            // dropping it releases the binaries the data held
+                            let heap_fragment_ptr = UnsafeRef::into_raw(heap_fragment_ref);
+                            process
+                                .off_heap_size
+                                .fetch_sub((*heap_fragment_ptr).heap_size(), Ordering::AcqRel);
+                            ptr::drop_in_place(heap_fragment_ptr);
+                        }
+
+                        self.decrement_seen();
+
+                        Ok(heap_data)
                     }
+                    err @ Err(_) => {
+                        drop(heap);
+                        self.messages.push_front(message);
 
-                    self.decrement_seen();
-
-                    Ok(heap_data)
-                }
-                err @ Err(_) => {
-                    self.messages.push_front(message);
-
-                    err
+                        err
+                    }
                 }
-            },
+            }
         })
     }
 
@@ -188,3 +227,118 @@ impl Default for Mailbox {
         }
     }
 }
+
+/// The messages sent to a process which have not been moved into its `Mailbox` yet
+///
+/// Senders push onto this queue without taking any lock, so that sending to a process
+/// many others are sending to doesn't serialize the senders behind the mailbox lock.
+/// It is a multi-producer, single-consumer linked queue (Vyukov): a push is a single
+/// atomic swap of the head, followed by linking the previous head to the new node.
+///
+/// The receiving end is drained into the `Mailbox` by whoever holds its lock, usually
+/// the process itself at receive time, so selective receive only ever scans the
+/// `Mailbox`, and the order of messages from each sender is preserved.
+pub struct Inbox {
+    /// The most recently pushed node, which producers swap in
+    head: AtomicPtr<InboxNode>,
+    /// The most recently popped node, whose `next` is the next message, only
+    /// accessed by the consumer
+    tail: UnsafeCell<*mut InboxNode>,
+    /// The number of messages pushed but not yet popped
+    ///
+    /// This is incremented before a message is linked in, so it may be briefly
+    /// non-zero when `pop` still returns `None`, but never the other way around.
+    len: AtomicUsize,
+}
+
+struct InboxNode {
+    next: AtomicPtr<InboxNode>,
+    message: Option<Message>,
+}
+impl InboxNode {
+    fn new(message: Option<Message>) -> *mut Self {
+        Box::into_raw(Box::new(Self {
+            next: AtomicPtr::new(ptr::null_mut()),
+            message,
+        }))
+    }
+}
+
+impl Inbox {
+    pub fn new() -> Self {
+        let stub = InboxNode::new(None);
+
+        Self {
+            head: AtomicPtr::new(stub),
+            tail: UnsafeCell::new(stub),
+            len: AtomicUsize::new(0),
+        }
+    }
+
+    /// Returns `true` if no messages are waiting to be drained into the mailbox
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.len.load(Ordering::Acquire)
+    }
+
+    /// Pushes `message` at the end of the queue, this may be called from any thread
+    pub fn push(&self, message: Message) {
+        self.len.fetch_add(1, Ordering::AcqRel);
+
+        let node = InboxNode::new(Some(message));
+        let prev = self.head.swap(node, Ordering::AcqRel);
+        // Until this store, the consumer sees the queue end at `prev`
+        unsafe {
+            (*prev).next.store(node, Ordering::Release);
+        }
+    }
+
+    /// Pops the message at the front of the queue
+    ///
+    /// # Safety
+    ///
+    /// Must only be called by one thread at a time
+    unsafe fn pop(&self) -> Option<Message> {
+        let tail = *self.tail.get();
+        let next = (*tail).next.load(Ordering::Acquire);
+        if next.is_null() {
+            return None;
+        }
+
+        *self.tail.get() = next;
+        // `next` becomes the new stub, so its message is moved out
+        let message = (*next).message.take();
+        drop(Box::from_raw(tail));
+        self.len.fetch_sub(1, Ordering::AcqRel);
+
+        message
+    }
+}
+impl Debug for Inbox {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("Inbox").field("len", &self.len()).finish()
+    }
+}
+impl Default for Inbox {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+impl Drop for Inbox {
+    fn drop(&mut self) {
+        unsafe {
+            while self.pop().is_some() {}
+            drop(Box::from_raw(*self.tail.get()));
+        }
+    }
+}
+
+// The consumer end is only accessed while holding the lock on the mailbox, and
+// everything else is atomic
+unsafe impl Send for Inbox {}
+unsafe impl Sync for Inbox {}
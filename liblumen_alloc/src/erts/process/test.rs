@@ -66,6 +66,267 @@ mod integer {
     }
 }
 
+mod inbox {
+    extern crate test;
+
+    use super::*;
+
+    use std::sync::atomic::{AtomicBool, Ordering};
+    use std::sync::{Arc, Barrier};
+    use std::thread;
+
+    use test::Bencher;
+
+    use crate::erts::term::prelude::*;
+
+    const MESSAGES: usize = 1_000;
+
+    #[bench]
+    fn send_then_receive(b: &mut Bencher) {
+        let process = process();
+
+        b.iter(|| {
+            for _ in 0..MESSAGES {
+                process.send_from_self(Term::NIL);
+            }
+
+            drain(&process);
+        });
+    }
+
+    #[bench]
+    fn fan_in_1(b: &mut Bencher) {
+        fan_in(b, 1);
+    }
+
+    #[bench]
+    fn fan_in_2(b: &mut Bencher) {
+        fan_in(b, 2);
+    }
+
+    #[bench]
+    fn fan_in_4(b: &mut Bencher) {
+        fan_in(b, 4);
+    }
+
+    #[bench]
+    fn fan_in_8(b: &mut Bencher) {
+        fan_in(b, 8);
+    }
+
+    #[bench]
+    fn fan_in_16(b: &mut Bencher) {
+        fan_in(b, 16);
+    }
+
+    #[bench]
+    fn fan_in_32(b: &mut Bencher) {
+        fan_in(b, 32);
+    }
+
+    #[bench]
+    fn fan_in_64(b: &mut Bencher) {
+        fan_in(b, 64);
+    }
+
+    /// Each of `senders` threads sends `MESSAGES` to the same process per iteration.
+    ///
+    /// The threads are spawned once and released together by a barrier each iteration, so
+    /// thread start up isn't measured. Immediates need no copying, so this only measures the
+    /// senders contending on the inbox.
+    fn fan_in(b: &mut Bencher, senders: usize) {
+        let receiver = Arc::new(process());
+        let start = Arc::new(Barrier::new(senders + 1));
+        let finish = Arc::new(Barrier::new(senders + 1));
+        let stop = Arc::new(AtomicBool::new(false));
+
+        let threads: Vec<_> = (0..senders)
+            .map(|_| {
+                let receiver = receiver.clone();
+                let start = start.clone();
+                let finish = finish.clone();
+                let stop = stop.clone();
+
+                thread::spawn(move || loop {
+                    start.wait();
+
+                    if stop.load(Ordering::Acquire) {
+                        break;
+                    }
+
+                    for _ in 0..MESSAGES {
+                        receiver.send_from_self(Term::NIL);
+                    }
+
+                    finish.wait();
+                })
+            })
+            .collect();
+
+        b.iter(|| {
+            start.wait();
+            finish.wait();
+
+            drain(&receiver);
+        });
+
+        stop.store(true, Ordering::Release);
+        start.wait();
+
+        for thread in threads {
+            thread.join().unwrap();
+        }
+    }
+
+    fn drain(process: &Process) {
+        let mailbox_guard = process.mailbox();
+        let mut mailbox = mailbox_guard.borrow_mut();
+
+        while mailbox.pop().is_some() {}
+    }
+}
+
+mod send_from_other {
+    extern crate test;
+
+    use super::*;
+
+    use core::convert::TryInto;
+
+    use test::Bencher;
+
+    use crate::erts::process::alloc::VirtualAllocator;
+    use crate::erts::term::prelude::*;
+
+    const PIPELINE_LEN: usize = 10;
+
+    #[test]
+    fn with_procbin_shares_binary_data_with_receiver() {
+        let sender = process();
+        let receiver = process();
+        let sent = sender.binary_from_bytes(&[0; HeapBin::MAX_SIZE + 1]);
+
+        receiver.send_from_other(sent);
+
+        let mailbox_guard = receiver.mailbox();
+        let mailbox = mailbox_guard.borrow();
+        let received = *mailbox.iter().next().unwrap().data();
+
+        assert_ne!(received, sent);
+
+        let sent_bin: Boxed<ProcBin> = sent.decode().unwrap().try_into().unwrap();
+        let received_bin: Boxed<ProcBin> = received.decode().unwrap().try_into().unwrap();
+
+        assert_eq!(unsafe { received_bin.as_byte_ptr() }, unsafe {
+            sent_bin.as_byte_ptr()
+        });
+        assert!(receiver
+            .acquire_heap()
+            .virtual_contains(received_bin.as_ptr()));
+    }
+
+    #[test]
+    fn with_procbin_received_from_heap_fragment_holds_reference_until_process_drops() {
+        let sender = process();
+        let sent = sender.binary_from_bytes(&[0; HeapBin::MAX_SIZE + 1]);
+        let sent_bin: Boxed<ProcBin> = sent.decode().unwrap().try_into().unwrap();
+
+        let receiver = process();
+        let received = receive_through_heap_fragment(&receiver, sent);
+
+        // The copy on the receiver's heap holds a reference, and the dropped fragment doesn't
+        assert_eq!(sent_bin.refc(), 2);
+
+        let mut roots = [received];
+        receiver.garbage_collect(0, &mut roots[..]).unwrap();
+
+        assert_eq!(sent_bin.refc(), 2);
+
+        drop(receiver);
+
+        assert_eq!(sent_bin.refc(), 1);
+    }
+
+    #[test]
+    fn with_procbin_received_from_heap_fragment_releases_reference_when_garbage() {
+        let sender = process();
+        let sent = sender.binary_from_bytes(&[0; HeapBin::MAX_SIZE + 1]);
+        let sent_bin: Boxed<ProcBin> = sent.decode().unwrap().try_into().unwrap();
+
+        let receiver = process();
+        receive_through_heap_fragment(&receiver, sent);
+
+        assert_eq!(sent_bin.refc(), 2);
+
+        receiver.garbage_collect(0, &mut [][..]).unwrap();
+
+        assert_eq!(sent_bin.refc(), 1);
+    }
+
+    #[test]
+    fn with_procbin_in_heap_fragment_releases_reference_when_process_drops() {
+        let sender = process();
+        let sent = sender.binary_from_bytes(&[0; HeapBin::MAX_SIZE + 1]);
+        let sent_bin: Boxed<ProcBin> = sent.decode().unwrap().try_into().unwrap();
+
+        let receiver = process();
+        *receiver.status.write() = Status::Running;
+        receiver.send_from_other(sent);
+
+        assert_eq!(sent_bin.refc(), 2);
+
+        drop(receiver);
+
+        assert_eq!(sent_bin.refc(), 1);
+    }
+
+    #[bench]
+    fn pipeline_with_procbin(b: &mut Bencher) {
+        pipeline(b, 1024 * 1024);
+    }
+
+    #[bench]
+    fn pipeline_with_heapbin(b: &mut Bencher) {
+        pipeline(b, HeapBin::MAX_SIZE);
+    }
+
+    // Relays a binary of `len` bytes down a chain of processes, each one receiving it from
+    // the one before, then collects every heap so the relayed copies don't accumulate
+    fn pipeline(b: &mut Bencher, len: usize) {
+        let processes: Vec<Process> = (0..PIPELINE_LEN).map(|_| process()).collect();
+        let bytes = vec![0; len];
+
+        b.iter(|| {
+            let mut message = processes[0].binary_from_bytes(&bytes);
+
+            for receiver in &processes[1..] {
+                receiver.send_from_other(message);
+
+                let mailbox_guard = receiver.mailbox();
+                let mut mailbox = mailbox_guard.borrow_mut();
+                message = mailbox.receive(receiver).unwrap().unwrap();
+            }
+
+            for process in &processes {
+                process.garbage_collect(0, &mut [][..]).unwrap();
+            }
+        });
+    }
+
+    // A running process can't be copied into, so the message is sent in a heap fragment,
+    // which `receive` copies onto the heap once the process has stopped running
+    fn receive_through_heap_fragment(receiver: &Process, data: Term) -> Term {
+        *receiver.status.write() = Status::Running;
+        receiver.send_from_other(data);
+        *receiver.status.write() = Status::Runnable;
+
+        let mailbox_guard = receiver.mailbox();
+        let mut mailbox = mailbox_guard.borrow_mut();
+
+        mailbox.receive(receiver).unwrap().unwrap()
+    }
+}
+
 pub(super) fn process() -> Process {
     let init = atom_from_str!("init");
     let initial_module_function_arity = ModuleFunctionArity {
@@ -1,9 +1,12 @@
+use std::ffi::c_void;
 use std::fmt;
 use std::iter::FusedIterator;
 use std::mem;
 use std::ptr::NonNull;
 use std::sync::Arc;
 
+use once_cell::sync::OnceCell;
+
 use liblumen_core::util::thread_local::ThreadLocalCell;
 
 use crate::borrow::CloneToProcess;
@@ -13,51 +16,66 @@ use crate::erts::process::{AllocResult, ModuleFunctionArity, Process};
 use crate::erts::term::prelude::*;
 use crate::erts::HeapFragment;
 
-pub type Frame = backtrace::Frame;
-
 use super::{format, utils, Symbolication, TraceFrame};
 
+/// The maximum number of native frames recorded when a trace is captured
+const MAX_FRAMES: usize = 10;
+
+/// A raw return address captured from the native stack
+///
+/// Nothing else about the frame is recorded at capture time, the symbol it
+/// belongs to is only resolved if the trace is inspected.
+#[derive(Clone, Copy)]
+pub struct Frame {
+    ip: usize,
+}
+impl Frame {
+    #[inline]
+    pub fn ip(&self) -> *mut c_void {
+        self.ip as *mut c_void
+    }
+}
+
 pub struct Trace {
-    frames: ThreadLocalCell<Vec<TraceFrame>>,
+    // Raw return addresses, most recent first
+    addresses: [usize; MAX_FRAMES],
+    depth: usize,
+    // Built from `addresses` the first time the frames are requested
+    frames: OnceCell<Vec<TraceFrame>>,
     fragment: ThreadLocalCell<Option<NonNull<HeapFragment>>>,
     term: ThreadLocalCell<Option<Term>>,
     top: ThreadLocalCell<Option<Term>>,
 }
 impl Trace {
-    const MAX_FRAMES: usize = 10;
-
     #[inline]
     fn new() -> Arc<Self> {
         Arc::new(Self {
-            frames: ThreadLocalCell::new(Vec::with_capacity(Self::MAX_FRAMES)),
+            addresses: [0; MAX_FRAMES],
+            depth: 0,
+            frames: OnceCell::new(),
             fragment: ThreadLocalCell::new(None),
             term: ThreadLocalCell::new(None),
             top: ThreadLocalCell::new(None),
         })
     }
 
+    /// Captures the return addresses of the current native stack
+    ///
+    /// This is done on every raise, and most exceptions are caught without
+    /// their stacktrace ever being looked at, so only the return addresses are
+    /// recorded here. Symbols are resolved, and the Erlang form of the trace
+    /// constructed, when the trace is first inspected.
     pub fn capture() -> Arc<Self> {
         // Allocates a new trace on the heap
         let trace_arc = Self::new();
         let ptr = Arc::as_ptr(&trace_arc) as *mut Trace;
         let trace = unsafe { &mut *ptr };
-        //let stackmap = StackMap::get();
 
-        // Capture the raw metadata for each frame in the trace
-        let mut depth = 0;
         backtrace::trace(|frame| {
-            // Look up the symbol in our stack map, if we have an
-            // entry, then this frame is an Erlang frame, so push
-            // it on the trace
-            //
-            // All other frames can be ignored for now
-            //let symbol_address = frame.symbol_address();
-            //if stackmap.find_function(symbol_address).is_some() {
-            depth += 1;
-            trace.push_frame(frame);
-            //}
-
-            depth < Self::MAX_FRAMES
+            trace.addresses[trace.depth] = frame.ip() as usize;
+            trace.depth += 1;
+
+            trace.depth < MAX_FRAMES
         });
 
         trace_arc
@@ -69,6 +87,8 @@ impl Trace {
         let (fragment_term, fragment) = term.clone_to_fragment().unwrap();
 
         Arc::new(Self {
+            addresses: [0; MAX_FRAMES],
+            depth: 0,
             frames: Default::default(),
             fragment: ThreadLocalCell::new(Some(fragment)),
             term: ThreadLocalCell::new(Some(fragment_term)),
@@ -79,12 +99,19 @@ impl Trace {
     /// Returns the set of native frames in the stack trace
     #[inline]
     pub fn frames(&self) -> &[TraceFrame] {
-        self.frames.as_slice()
+        self.frames
+            .get_or_init(|| {
+                self.addresses[..self.depth]
+                    .iter()
+                    .map(|ip| TraceFrame::from(Frame { ip: *ip }))
+                    .collect()
+            })
+            .as_slice()
     }
 
     #[inline]
     pub fn iter_symbols(&self) -> SymbolIter<'_> {
-        SymbolIter::new(self.frames.as_slice(), self.top.as_ref().clone())
+        SymbolIter::new(self.frames(), self.top.as_ref().clone())
     }
 
     #[inline]
@@ -136,9 +163,9 @@ impl Trace {
 
     #[inline]
     pub fn push_frame(&mut self, frame: &Frame) {
-        unsafe {
-            self.frames.as_mut().push(TraceFrame::from(frame));
-        }
+        // Materialize the captured frames first, so the pushed frame stays last
+        self.frames();
+        self.frames.get_mut().unwrap().push(TraceFrame::from(frame));
     }
 
     pub fn as_term(&self) -> AllocResult<Term> {
@@ -266,7 +293,9 @@ impl Trace {
         if let Some(fragment) = self.fragment.as_ref() {
             Ok(Some(fragment.clone()))
         } else {
-            if let Some(layout) = utils::calculate_fragment_layout(self.frames.len(), extra) {
+            // Frames are only materialized when inspected, but will be part of the term
+            let num_frames = self.depth.max(self.frames.len());
+            if let Some(layout) = utils::calculate_fragment_layout(num_frames, extra) {
                 let heap_ptr = HeapFragment::new(layout)?;
                 unsafe {
                     self.fragment.set(Some(heap_ptr.clone()));
@@ -294,10 +323,11 @@ impl Trace {
         let heap = unsafe { heap_ptr.as_mut() };
 
         // If top was set, we have an extra frame to append
+        let frames = self.frames();
         let mut erlang_frames = if self.top.is_some() {
-            Vec::with_capacity(1 + self.frames.len())
+            Vec::with_capacity(1 + frames.len())
         } else {
-            Vec::with_capacity(self.frames.len())
+            Vec::with_capacity(frames.len())
         };
 
         // If top was set, add it as the most recent frame on the stack
@@ -306,7 +336,7 @@ impl Trace {
         }
 
         // Add all of the "real" stack frames
-        for frame in &self.frames[..] {
+        for frame in frames {
             if let Some(symbol) = frame.symbolicate() {
                 if let Some(ref mfa) = symbol.module_function_arity() {
                     let erlang_frame =
@@ -329,8 +359,8 @@ impl Trace {
 
 pub(super) fn resolve_frame(frame: &Frame) -> Option<Symbolication> {
     let mut result = None;
-    // Otherwise resolve symbols for this frame
-    backtrace::resolve_frame(frame, |symbol| {
+    // Return addresses are adjusted to point into the call instruction by `resolve`
+    backtrace::resolve(frame.ip(), |symbol| {
         let name = symbol.name();
         let mfa = if let Some(name) = name {
             let string = String::from_utf8_lossy(name.as_bytes());
@@ -352,3 +382,34 @@ pub(super) fn resolve_frame(frame: &Frame) -> Option<Symbolication> {
     });
     result
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn frames_of_captured_trace_are_built_once() {
+        let trace = Trace::capture();
+
+        let frames = trace.frames();
+        assert!(0 < frames.len());
+        assert_eq!(frames.len(), trace.depth);
+
+        // Later calls return the same frames, rather than appending them again
+        let again = trace.frames();
+        assert_eq!(again.len(), frames.len());
+        assert_eq!(again.as_ptr(), frames.as_ptr());
+    }
+
+    #[test]
+    fn pushed_frame_follows_captured_frames() {
+        let mut trace = Trace::capture();
+        let depth = trace.depth;
+
+        Arc::get_mut(&mut trace)
+            .unwrap()
+            .push_frame(&Frame { ip: 1 });
+
+        assert_eq!(trace.frames().len(), depth + 1);
+    }
+}
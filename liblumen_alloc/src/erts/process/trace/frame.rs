@@ -15,10 +15,6 @@ impl TraceFrame {
         }
 
         // Otherwise resolve symbols for this frame
-        if let Some(symbol) = super::resolve_frame(&self.frame) {
-            unsafe { self.symbol.set(Some(symbol)) }
-        }
-
         let symbol = super::resolve_frame(&self.frame);
         if symbol.is_some() {
             unsafe {
@@ -80,7 +80,7 @@ impl RawTerm {
     }
 
     #[inline]
-    fn encode_literal<T: ?Sized>(value: *const T) -> Self {
+    pub fn encode_literal<T: ?Sized>(value: *const T) -> Self {
         Self(Encoding::encode_literal(value))
     }
 
@@ -745,8 +745,8 @@ mod tests {
         let mut heap = RegionHeap::default();
 
         let pairs = vec![(atom!("foo"), fixnum!(1)), (atom!("bar"), fixnum!(2))];
-        let map = Map::from_slice(pairs.as_slice());
-        let map_term = map.clone_to_heap(&mut heap).unwrap();
+        let map = Map::from_slice(&mut heap, pairs.as_slice()).unwrap();
+        let map_term: RawTerm = map.into();
         assert!(map_term.is_boxed());
         assert_eq!(map_term.type_of(), Tag::Box);
         assert!(!map_term.is_map());
@@ -760,7 +760,7 @@ mod tests {
         let map_decoded: Result<Boxed<Map>, _> = map_term.decode().unwrap().try_into();
         assert!(map_decoded.is_ok());
         let map_box = map_decoded.unwrap();
-        assert_eq!(&map, map_box.as_ref());
+        assert_eq!(map.as_ref(), map_box.as_ref());
         assert_eq!(map.len(), 2);
         assert_eq!(map.get(atom!("bar")), Some(fixnum!(2)));
     }
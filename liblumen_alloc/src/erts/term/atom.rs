@@ -7,16 +7,15 @@ use core::ptr;
 use core::slice;
 use core::str::{self, Utf8Error};
 
-use std::os::raw::c_uint;
-
 use hashbrown::HashMap;
 use lazy_static::lazy_static;
+use once_cell::sync::OnceCell;
 use thiserror::Error;
 
 use liblumen_arena::DroplessArena;
 
 use liblumen_core::alloc::prelude::*;
-use liblumen_core::atoms::ConstantAtom;
+use liblumen_core::atoms::AtomIndex;
 use liblumen_core::locks::RwLock;
 
 use super::prelude::{Term, TypeError, TypedTerm};
@@ -28,38 +27,64 @@ pub const MAX_ATOMS: usize = super::arch::MAX_ATOM_ID - 1;
 pub const MAX_ATOM_LENGTH: usize = u16::max_value() as usize;
 
 lazy_static! {
-    /// The atom table used by the runtime system
+    /// The table of atoms created dynamically by the runtime system
     static ref ATOMS: RwLock<AtomTable> = Default::default();
 }
 
+/// The read-only image of the constant atoms present in the compiled program
+static ATOM_INDEX: OnceCell<&'static AtomIndex> = OnceCell::new();
+
 /// Performs one-time initialization of the atom table at program start, using the
-/// array of constant atom values present in the compiled program.
+/// atom table image generated by the compiler for the constant atoms in the program.
+///
+/// The image is used in place, lookups of constant atoms never take a lock, and only
+/// atoms created dynamically are stored in the `ATOMS` table, with ids following on
+/// from those in the image.
 ///
 /// It is expected that this will be called by code generated by the compiler, during the
 /// earliest phase of startup, to ensure that nothing has tried to use the atom table yet.
 #[no_mangle]
-pub unsafe extern "C" fn InitializeLumenAtomTable(table: *const ConstantAtom, len: c_uint) -> bool {
-    let len = len as usize;
-    if len == 0 {
-        return true;
-    }
-    if table.is_null() {
+pub unsafe extern "C" fn InitializeLumenAtomIndex(index: *const AtomIndex) -> bool {
+    if index.is_null() {
         return false;
     }
-    let raw_table = slice::from_raw_parts::<'static>(table, len);
-    let mut default_table = ATOMS.write();
-    if let Err(err) = default_table.from_raw(raw_table) {
-        panic!("{}", err);
-    } else {
-        true
+    let index = &*index;
+    let mut dynamic_table = ATOMS.write();
+    if let Err(_) = ATOM_INDEX.set(index) {
+        eprintln!("tried to initialize atom table more than once!");
+        return false;
     }
+    dynamic_table.reset(index.names_len);
+
+    true
 }
 
 pub fn dump_atoms() {
+    if let Some(index) = ATOM_INDEX.get() {
+        for (id, name) in index.iter() {
+            println!("atom(id = {}, value = '{}')", id, name);
+        }
+    }
     let table = ATOMS.read();
     table.dump();
 }
 
+#[inline]
+fn get_id(name: &str) -> Option<usize> {
+    if let Some(id) = ATOM_INDEX.get().and_then(|index| index.get_id(name)) {
+        return Some(id);
+    }
+    ATOMS.read().get_id(name)
+}
+
+#[inline]
+fn get_name(id: usize) -> Option<&'static str> {
+    if let Some(name) = ATOM_INDEX.get().and_then(|index| index.get_name(id)) {
+        return Some(name);
+    }
+    ATOMS.read().get_name(id)
+}
+
 /// An interned string, represented in memory as a integer ID.
 ///
 /// This struct is simply a transparent wrapper around the ID.
@@ -84,7 +109,7 @@ impl Atom {
     /// Returns the string representation of this atom
     #[inline]
     pub fn name(&self) -> &'static str {
-        ATOMS.read().get_name(self.0).unwrap()
+        get_name(self.0).unwrap()
     }
 
     /// Returns true if this atom is a boolean value
@@ -145,7 +170,7 @@ impl Atom {
     pub fn try_from_str<S: AsRef<str>>(s: S) -> Result<Self, AtomError> {
         let name = s.as_ref();
         Self::validate(name)?;
-        if let Some(id) = ATOMS.read().get_id(name) {
+        if let Some(id) = get_id(name) {
             return Ok(Atom(id));
         }
         let id = ATOMS.write().get_id_or_insert(name)?;
@@ -159,7 +184,7 @@ impl Atom {
     pub fn try_from_str_existing<S: AsRef<str>>(s: S) -> Result<Self, AtomError> {
         let name = s.as_ref();
         Self::validate(name)?;
-        if let Some(id) = ATOMS.read().get_id(name) {
+        if let Some(id) = get_id(name) {
             return Ok(Atom(id));
         }
         Err(AtomError::NonExistent.into())
@@ -275,7 +300,7 @@ impl Display for Atom {
 
 impl Debug for Atom {
     fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
-        if let Some(name) = ATOMS.read().get_name(self.0) {
+        if let Some(name) = get_name(self.0) {
             f.write_str(":\"")?;
             name.chars()
                 .flat_map(char::escape_default)
@@ -365,44 +390,16 @@ impl AtomTable {
         table
     }
 
-    /// Used to initialize the atom table from an array of null-terminated strings with static
-    /// lifetime, such as generated by codegen in order to initialize the atom table with
-    /// constant atom values in the compiled program. It is expected that this will be called
-    /// via `InitializeLumenAtomTable`
-    unsafe fn from_raw(&mut self, raw_table: &'static [ConstantAtom]) -> anyhow::Result<()> {
-        use std::ffi::CStr;
-
-        let len = raw_table.len();
+    /// Discards all atoms in this table, so that it only holds atoms created from here on,
+    /// which will be assigned ids starting at `next_id`. It is expected that this will be
+    /// called via `InitializeLumenAtomIndex`, with the ids before `next_id` reserved for the
+    /// atoms in the atom table image.
+    fn reset(&mut self, next_id: usize) {
+        assert!(next_id < MAX_ATOMS);
 
-        self.next_id = 0;
+        self.next_id = next_id;
         self.ids.clear();
         self.names.clear();
-
-        self.ids.reserve(len);
-        self.names.reserve(len);
-
-        for ConstantAtom { id, value } in raw_table.iter() {
-            let id = *id;
-            // Ensure the 'next_id' is always one higher than the highest id we've seen
-            if id >= self.next_id {
-                self.next_id = id + 1;
-            }
-            // This is safe because the underlying data is static
-            let cs = CStr::from_ptr::<'static>(*value);
-            let name = cs.to_str().unwrap_or_else(|error| {
-                panic!(
-                    "invalid utf-8 ({:?}) in entry ({}) in atom table!",
-                    error,
-                    cs.to_string_lossy()
-                )
-            });
-            assert_eq!(None, self.names.insert(id, name));
-            assert_eq!(None, self.ids.insert(name, id));
-        }
-
-        assert!(self.next_id < MAX_ATOMS);
-
-        Ok(())
     }
 
     fn get_id(&self, name: &str) -> Option<usize> {
@@ -84,9 +84,14 @@ display!(SubBinary);
 macro_rules! hash {
     ($t:ty) => {
         impl Hash for $t {
+            /// Full bytes are hashed as a slice, the same as `AlignedBinary::as_bytes`, so that a
+            /// binary hashes the same whether it is aligned or not.
             fn hash<H: Hasher>(&self, state: &mut H) {
-                for byte in self.full_byte_iter() {
-                    byte.hash(state);
+                if self.is_aligned() {
+                    unsafe { self.as_bytes_unchecked() }.hash(state);
+                } else {
+                    let full_bytes: Vec<u8> = self.full_byte_iter().collect();
+                    full_bytes.hash(state);
                 }
 
                 for bit in self.partial_byte_bit_iter() {
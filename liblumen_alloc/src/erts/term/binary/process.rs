@@ -127,10 +127,25 @@ impl ProcBin {
 
     /// Creates a new procbin from a raw byte slice, by copying it to the heap
     pub fn from_slice(s: &[u8], encoding: Encoding) -> AllocResult<Self> {
+        Self::from_fn(s.len(), encoding, |data| data.copy_from_slice(s))
+    }
+
+    /// Creates a new procbin of `len` bytes on the heap, whose bytes are written by `init`
+    ///
+    /// This allows callers that know the size of a binary up front to produce its bytes in
+    /// place, rather than in a temporary buffer that is then copied by `from_slice`.
+    ///
+    /// NOTE: The bytes are not initialized before `init` is called, so it must write all of them
+    pub fn from_fn<F>(len: usize, encoding: Encoding, init: F) -> AllocResult<Self>
+    where
+        F: FnOnce(&mut [u8]),
+    {
         use liblumen_core::sys::alloc as sys_alloc;
 
         let (base_layout, flags_offset) = ProcBinInner::base_layout();
-        let (unpadded_layout, data_offset) = base_layout.extend(Layout::for_value(s)).unwrap();
+        let (unpadded_layout, data_offset) = base_layout
+            .extend(Layout::array::<u8>(len).unwrap())
+            .unwrap();
         // We pad to alignment so that the Layout produced here
         // matches that returned by `Layout::for_value` on the
         // final `ProcBinInner`
@@ -138,7 +153,6 @@ impl ProcBin {
 
         unsafe {
             let non_null_byte_slice = sys_alloc::allocate(layout)?;
-            let len = s.len();
 
             let ptr: *mut u8 = non_null_byte_slice.as_mut_ptr();
             ptr::write(ptr as *mut AtomicUsize, AtomicUsize::new(1));
@@ -146,7 +160,7 @@ impl ProcBin {
             let flags = BinaryFlags::new(encoding).set_size(len);
             ptr::write(flags_ptr, flags);
             let data_ptr = ptr.offset(data_offset as isize);
-            ptr::copy_nonoverlapping(s.as_ptr(), data_ptr, len);
+            init(slice::from_raw_parts_mut(data_ptr, len));
 
             let inner = ProcBinInner::from_raw_parts(ptr, len);
             Ok(Self {
@@ -162,6 +176,12 @@ impl ProcBin {
         unsafe { self.inner.as_ref() }
     }
 
+    /// The number of headers holding a reference to the binary data
+    #[cfg(test)]
+    pub(crate) fn refc(&self) -> usize {
+        self.inner().refc.load(atomic::Ordering::Acquire)
+    }
+
     // Non-inlined part of `drop`.
     #[inline(never)]
     unsafe fn drop_slow(&self) {
@@ -222,7 +242,6 @@ impl CloneToProcess for ProcBin {
         let mut heap = process.acquire_heap();
         let boxed = self.clone_to_heap(&mut heap).unwrap();
         let ptr: *mut Self = boxed.dyn_cast();
-        self.inner().refc.fetch_add(1, atomic::Ordering::AcqRel);
         // Reify a reference to the newly written clone, and push it
         // on to the process virtual heap
         let clone = unsafe { &*ptr };
@@ -230,6 +249,12 @@ impl CloneToProcess for ProcBin {
         boxed
     }
 
+    /// Only the header is copied, the binary data is shared with `self`
+    ///
+    /// Every header holds a reference, so the reference count is incremented here. It is
+    /// decremented when the header is dropped, either by the virtual binary heap it must be
+    /// linked to when `heap` is a process heap (see `ProcessHeap::virtual_alloc_from`), or by
+    /// `HeapFragment::drop` when `heap` is a heap fragment.
     fn clone_to_heap<A>(&self, heap: &mut A) -> AllocResult<Term>
     where
         A: ?Sized + TermAlloc,
@@ -238,6 +263,7 @@ impl CloneToProcess for ProcBin {
             // Allocate space for the header
             let layout = Layout::new::<Self>();
             let ptr = heap.alloc_layout(layout)?.as_ptr() as *mut Self;
+            self.inner().refc.fetch_add(1, atomic::Ordering::AcqRel);
             // Write the binary header with an empty link
             ptr::write(
                 ptr,
@@ -247,10 +247,22 @@ impl CloneToProcess for SubBinary {
     {
         let layout = Layout::new::<Self>();
         let size = layout.size();
-        match self.original.follow_moved().decode().unwrap() {
-            // For ref-counted binaries and those that are already on the process heap,
-            // we just need to copy the sub binary header, not the binary as well
-            TypedTerm::ProcBin(_bin) => {
+        let new_original = match self.original.follow_moved().decode().unwrap() {
+            // For binaries that are already on the heap, we just need to copy the sub binary
+            // header, not the binary as well
+            TypedTerm::ProcBin(bin) if heap.is_owner(bin.as_ptr()) => None,
+            TypedTerm::HeapBinary(bin) if heap.is_owner(bin.as_ptr()) => None,
+            // For ref-counted binaries on another heap, only the procbin header is cloned, which
+            // shares the binary data with the original, so that sending a sub-binary of a large
+            // binary never copies the data
+            TypedTerm::ProcBin(bin) => Some(bin.clone_to_heap(heap)?),
+            // Heap binaries are small enough to be cloned along with the sub binary header
+            TypedTerm::HeapBinary(bin) => Some(bin.clone_to_heap(heap)?),
+            t => panic!("expected ProcBin or HeapBin, but got {:?}", t),
+        };
+
+        match new_original {
+            None => {
                 // Allocate space for header and copy it
                 unsafe {
                     let ptr = heap.alloc_layout(layout)?.as_ptr() as *mut Self;
@@ -258,40 +270,25 @@ impl CloneToProcess for SubBinary {
                     Ok(ptr.into())
                 }
             }
-            TypedTerm::HeapBinary(bin) => {
-                if heap.is_owner(bin.as_ptr()) {
-                    // Allocate space for header and copy it
-                    unsafe {
-                        let ptr = heap.alloc_layout(layout)?.as_ptr() as *mut Self;
-                        ptr::copy_nonoverlapping(self as *const Self, ptr, size);
-                        Ok(ptr.into())
-                    }
-                } else {
-                    // Need to make sure that the heapbin is cloned as well, and that the header is
-                    // suitably updated
-                    let new_bin = bin.clone_to_heap(heap)?;
-                    unsafe {
-                        // Allocate space for header
-                        let ptr = heap.alloc_layout(layout)?.as_ptr() as *mut Self;
-                        // Write header, with modifications
-                        ptr::write(
-                            ptr,
-                            Self {
-                                header: self.header,
-                                original: new_bin,
-                                byte_offset: self.byte_offset,
-                                bit_offset: self.bit_offset,
-                                full_byte_len: self.full_byte_len,
-                                partial_byte_bit_len: self.partial_byte_bit_len,
-                                writable: self.writable,
-                            },
-                        );
-
-                        Ok(ptr.into())
-                    }
-                }
-            }
-            t => panic!("expected ProcBin or HeapBin, but got {:?}", t),
+            Some(new_original) => unsafe {
+                // Allocate space for header
+                let ptr = heap.alloc_layout(layout)?.as_ptr() as *mut Self;
+                // Write header, referring to the cloned binary
+                ptr::write(
+                    ptr,
+                    Self {
+                        header: self.header,
+                        original: new_original,
+                        byte_offset: self.byte_offset,
+                        bit_offset: self.bit_offset,
+                        full_byte_len: self.full_byte_len,
+                        partial_byte_bit_len: self.partial_byte_bit_len,
+                        writable: self.writable,
+                    },
+                );
+
+                Ok(ptr.into())
+            },
         }
     }
 
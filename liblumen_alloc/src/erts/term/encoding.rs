@@ -1,4 +1,3 @@
-use core::alloc::Layout;
 use core::convert::TryInto;
 use core::fmt::{self, Debug};
 use core::marker::PhantomData;
@@ -9,7 +8,6 @@ use alloc::sync::Arc;
 
 use std::backtrace::Backtrace;
 
-use hashbrown::HashMap;
 use thiserror::Error;
 
 use liblumen_term::{Encoding as TermEncoding, Tag};
@@ -243,22 +241,6 @@ impl<T: ?Sized> Debug for Header<T> {
     }
 }
 const_assert_eq!(mem::size_of::<Header<usize>>(), mem::size_of::<usize>());
-impl Header<Map> {
-    pub fn from_map(map: &HashMap<Term, Term>) -> Self {
-        let header_layout = Layout::new::<Self>();
-        let value_layout = Layout::for_value(map);
-        let (layout, _value_offset) = header_layout.extend(value_layout).unwrap();
-        // subtract the header layout size in words instead of just not including it as `extend`
-        // adds padding for field alignment.
-        let arity = Self::to_word_size(layout.size()) - Self::to_word_size(header_layout.size());
-        let value = Term::encode_header(arity.try_into().unwrap(), Term::HEADER_MAP);
-        Self {
-            value,
-            _phantom: PhantomData,
-        }
-    }
-}
-
 /// This is a marker trait for dynamically-sized types which have headers
 pub trait DynamicHeader {
     /// The header tag associated with this type
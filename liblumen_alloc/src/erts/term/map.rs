@@ -1,44 +1,101 @@
-use core::alloc::Layout;
+mod hamt;
+
 use core::cmp;
 use core::convert::{TryFrom, TryInto};
 use core::fmt::{self, Debug, Display, Write};
 use core::hash::{Hash, Hasher};
+use core::iter::FusedIterator;
 use core::mem;
-use core::ptr;
+use core::slice;
 
 use alloc::vec::Vec;
 
 use anyhow::*;
 use hashbrown::HashMap;
 
+use crate::borrow::CloneToProcess;
+use crate::erts;
 use crate::erts::exception::{AllocResult, InternalResult};
-use crate::erts::process::alloc::TermAlloc;
+use crate::erts::process::alloc::{HeapAlloc, TermAlloc};
 
 use super::prelude::*;
 
-#[derive(Clone)]
+/// Maps with at most this many entries are stored as a flatmap, larger maps are stored as a
+/// hash array mapped trie
+pub const MAX_FLATMAP_SIZE: usize = 32;
+
+/// Represents a map term in memory.
+///
+/// Like any other term, a map is allocated on the process heap, and is persistent: updating a
+/// map produces a new map, which shares as much of its structure with the original as it can.
+///
+/// Maps of up to `MAX_FLATMAP_SIZE` entries are stored as a flatmap, a tuple of alternating keys
+/// and values, sorted by key. Larger maps are stored as a hash array mapped trie, whose nodes are
+/// also tuples, see the `hamt` module. Since a map is made only of tuples and small integers, the
+/// garbage collector walks and moves it like any other term.
+///
+/// NOTE: The compiler generates inline lookups of atom keys in flatmaps, so the layout of this
+/// struct, `MAX_FLATMAP_SIZE`, and the layout of flatmaps must be kept in sync with
+/// `MapOpConversions.cpp`
 #[repr(C)]
 pub struct Map {
     header: Header<Map>,
-    value: HashMap<Term, Term>,
+    // The number of entries, as a small integer
+    size: Term,
+    // The flatmap tuple, or the root node of the trie
+    root: Term,
 }
+impl_static_header!(Map, Term::HEADER_MAP);
 
 impl Map {
-    pub(in crate::erts) fn from_hash_map(value: HashMap<Term, Term>) -> Self {
-        Self {
-            header: Header::from_map(&value),
-            value,
-        }
+    /// Constructs an empty map on `heap`
+    pub fn new<A>(heap: &mut A) -> AllocResult<Boxed<Map>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        let root = Tuple::new(heap, 0)?;
+
+        Self::alloc(heap, 0, root.into())
+    }
+
+    /// Constructs a map from the given key/value pairs on `heap`
+    ///
+    /// If a key occurs more than once, the last value given for it is used. Keys and values are
+    /// not copied, so must already be on `heap`, or be immediates or literals.
+    pub fn from_slice<A>(heap: &mut A, slice: &[(Term, Term)]) -> AllocResult<Boxed<Map>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        Entries::from_iter(slice.iter().copied()).build(heap)
+    }
+
+    /// Like `from_slice`, but takes the entries from a `HashMap`
+    pub fn from_hash_map<A>(heap: &mut A, hash_map: &HashMap<Term, Term>) -> AllocResult<Boxed<Map>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        Entries::from_iter(hash_map.iter().map(|(key, value)| (*key, *value))).build(heap)
     }
 
-    pub(in crate::erts) fn from_slice(slice: &[(Term, Term)]) -> Self {
-        let mut value: HashMap<Term, Term> = HashMap::with_capacity(slice.len());
+    /// The number of words needed to construct a map from `slice` with `from_slice`
+    pub fn need_in_words_from_slice(slice: &[(Term, Term)]) -> usize {
+        Entries::from_iter(slice.iter().copied()).need_in_words()
+    }
 
-        for (entry_key, entry_value) in slice {
-            value.insert(*entry_key, *entry_value);
-        }
+    /// The number of words needed to construct a map of `len` distinct keys with `from_slice`,
+    /// for when the keys are not known yet
+    ///
+    /// This is exact for flatmaps, but only an estimate for larger maps, as the shape of their
+    /// trie depends on the hashes of their keys. Well distributed hashes need fewer than 4 words
+    /// per entry, so 5 are counted.
+    pub fn need_in_words_from_len(len: usize) -> usize {
+        let map_words = erts::to_word_size(mem::size_of::<Map>());
 
-        Self::from_hash_map(value)
+        if len <= MAX_FLATMAP_SIZE {
+            map_words + 1 + len * 2
+        } else {
+            map_words + len * 5
+        }
     }
 
     pub fn from_list(list: Term) -> InternalResult<HashMap<Term, Term>> {
@@ -83,132 +140,601 @@ impl Map {
     }
 
     pub fn get(&self, key: Term) -> Option<Term> {
-        self.value.get(&key).copied()
-    }
-
-    pub fn take(&self, key: Term) -> Option<(Term, HashMap<Term, Term>)> {
-        if self.is_key(key) {
-            let mut map = self.value.clone();
-            let value = map.remove(&key).unwrap();
-
-            Some((value, map))
+        if self.is_flatmap() {
+            let entries = self.flat_entries();
+            flat_position(entries, key).map(|index| entries[index * 2 + 1])
         } else {
-            None
+            hamt::get(self.root, hash_key(key), key)
         }
     }
 
     pub fn is_key(&self, key: Term) -> bool {
-        self.value.contains_key(&key)
+        self.get(key).is_some()
     }
 
     pub fn keys(&self) -> Vec<Term> {
-        self.value.keys().into_iter().copied().collect()
+        self.iter().map(|(key, _)| *key).collect()
     }
 
     pub fn values(&self) -> Vec<Term> {
-        self.value.values().into_iter().copied().collect()
+        self.iter().map(|(_, value)| *value).collect()
     }
 
     pub fn len(&self) -> usize {
-        self.value.len()
+        decode_usize(self.size)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Returns a map with `key` associated with `value`, whether or not `key` is present
+    ///
+    /// If `key` is already associated with `value`, this map is returned as is.
+    pub fn put<A>(&self, heap: &mut A, key: Term, value: Term) -> AllocResult<Boxed<Map>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        Ok(self
+            .insert(heap, key, value, Insert::Put)?
+            .unwrap_or_else(|| self.as_boxed()))
     }
 
-    pub fn remove(&self, key: Term) -> Option<HashMap<Term, Term>> {
+    /// Returns a map with the value of `key` replaced with `value`, or `None` if `key` is not
+    /// present
+    pub fn update<A>(&self, heap: &mut A, key: Term, value: Term) -> AllocResult<Option<Boxed<Map>>>
+    where
+        A: ?Sized + TermAlloc,
+    {
         if self.is_key(key) {
-            let mut map = self.value.clone();
-            map.remove(&key);
-            Some(map)
+            self.put(heap, key, value).map(Some)
         } else {
-            None
+            Ok(None)
         }
     }
 
-    pub fn update(&self, key: Term, value: Term) -> Option<HashMap<Term, Term>> {
-        if self.is_key(key) {
-            let mut map = self.value.clone();
-            map.insert(key, value);
-            Some(map)
+    /// Returns a map without `key`
+    ///
+    /// If `key` is not present, this map is returned as is.
+    pub fn remove<A>(&self, heap: &mut A, key: Term) -> AllocResult<Boxed<Map>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        Ok(self
+            .take(heap, key)?
+            .map(|(_, map)| map)
+            .unwrap_or_else(|| self.as_boxed()))
+    }
+
+    /// Returns the value of `key`, and a map without `key`, or `None` if `key` is not present
+    pub fn take<A>(&self, heap: &mut A, key: Term) -> AllocResult<Option<(Term, Boxed<Map>)>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        if self.is_flatmap() {
+            let entries = self.flat_entries();
+            let index = match flat_position(entries, key) {
+                Some(index) => index,
+                None => return Ok(None),
+            };
+            let value = entries[index * 2 + 1];
+
+            let mut root = Tuple::new(heap, entries.len() - 2)?;
+            let elements = root.elements_mut();
+            elements[..index * 2].copy_from_slice(&entries[..index * 2]);
+            elements[index * 2..].copy_from_slice(&entries[index * 2 + 2..]);
+
+            let map = Self::alloc(heap, self.len() - 1, root.into())?;
+
+            return Ok(Some((value, map)));
+        }
+
+        let value = match self.get(key) {
+            Some(value) => value,
+            None => return Ok(None),
+        };
+        let len = self.len() - 1;
+
+        // Once small enough, the remaining entries are moved back into a flatmap
+        let map = if len <= MAX_FLATMAP_SIZE {
+            let remaining = self
+                .iter()
+                .filter(|(entry_key, _)| !exact_eq(**entry_key, key))
+                .map(|(entry_key, entry_value)| (*entry_key, *entry_value));
+
+            Entries::from_iter(remaining).build(heap)?
+        } else {
+            let root = hamt::remove(heap, self.root, hash_key(key), key, 0)?;
+
+            Self::alloc(heap, len, root)?
+        };
+
+        Ok(Some((value, map)))
+    }
+
+    /// Returns a map with the entries of both maps, where keys present in both are associated
+    /// with their value in `other`
+    pub fn merge<A>(&self, heap: &mut A, other: &Map) -> AllocResult<Boxed<Map>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        if other.is_empty() {
+            return Ok(self.as_boxed());
+        }
+        if self.is_empty() {
+            return Ok(other.as_boxed());
+        }
+
+        // Small maps are rebuilt from scratch, which allocates the result exactly once
+        if self.is_flatmap() && other.is_flatmap() {
+            let entries = self
+                .iter()
+                .chain(other.iter())
+                .map(|(key, value)| (*key, *value));
+
+            return Entries::from_iter(entries).build(heap);
+        }
+
+        // Otherwise the entries of the smaller map are inserted into the larger one
+        let (mut merged, smaller, insert) = if self.len() < other.len() {
+            (other.as_boxed(), self, Insert::PutNew)
         } else {
-            None
+            (self.as_boxed(), other, Insert::Put)
+        };
+        for (key, value) in smaller.iter() {
+            if let Some(map) = merged.insert(heap, *key, *value, insert)? {
+                merged = map;
+            }
         }
+
+        Ok(merged)
     }
 
-    pub fn put(&self, key: Term, value: Term) -> Option<HashMap<Term, Term>> {
-        if self.get(key).map_or(false, |val| val == value) {
-            None
+    /// Iterates over the entries of this map, in key order for flatmaps, or in hash order
+    /// otherwise
+    pub fn iter(&self) -> Iter<'_> {
+        if self.is_flatmap() {
+            Iter::flat(self.flat_entries())
         } else {
-            let mut map = self.value.clone();
-            map.insert(key, value);
-            Some(map)
+            Iter::hamt(node_elements(self.root))
         }
     }
 
-    pub fn iter(&self) -> hashbrown::hash_map::Iter<Term, Term> {
-        self.value.iter()
+    /// The number of words that may be allocated by `put` or `update` of `key` on this map
+    pub fn need_in_words_to_put(&self, key: Term) -> usize {
+        let map_words = erts::to_word_size(mem::size_of::<Self>());
+
+        if self.is_flatmap() {
+            if self.len() < MAX_FLATMAP_SIZE {
+                // Tuple header and one more entry than there is now
+                map_words + 1 + (self.len() + 1) * 2
+            } else {
+                // Converting to a trie, the value doesn't matter for sizing
+                let entries = self
+                    .iter()
+                    .map(|(key, value)| (*key, *value))
+                    .chain(core::iter::once((key, Term::NIL)));
+
+                Entries::from_iter(entries).need_in_words()
+            }
+        } else {
+            map_words + hamt::need_in_words_to_insert(self.root, hash_key(key), key, 0)
+        }
     }
 
-    pub fn iter_mut(&mut self) -> hashbrown::hash_map::IterMut<Term, Term> {
-        self.value.iter_mut()
+    /// The number of words that may be allocated by `remove` or `take` of `key` from this map
+    pub fn need_in_words_to_remove(&self, key: Term) -> usize {
+        let map_words = erts::to_word_size(mem::size_of::<Self>());
+        let len = self.len();
+
+        if len <= MAX_FLATMAP_SIZE + 1 {
+            // Tuple header and one less entry than there is now
+            map_words + 1 + len.saturating_sub(1) * 2
+        } else {
+            map_words + hamt::need_in_words_to_remove(self.root, hash_key(key))
+        }
+    }
+
+    /// Marks this map and all of its internal structure as literals, and returns the literal term
+    ///
+    /// # Safety
+    ///
+    /// The map must be in memory which is never freed, and is not part of any process heap, e.g.
+    /// a leaked heap fragment, and must only contain immediates or literals.
+    pub unsafe fn into_literal(map: Boxed<Map>) -> Term {
+        let ptr = map.as_ptr();
+        let root = (*ptr).root;
+        (*ptr).root = if (*ptr).is_flatmap() {
+            let root_ptr: *mut Term = root.dyn_cast();
+            Term::encode_literal(root_ptr)
+        } else {
+            hamt::into_literal(root)
+        };
+
+        Term::encode_literal(ptr)
     }
 
     // Private
 
+    fn alloc<A>(heap: &mut A, len: usize, root: Term) -> AllocResult<Boxed<Map>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        let layout = core::alloc::Layout::new::<Self>();
+        let map = Self {
+            header: Default::default(),
+            size: encode_usize(len),
+            root,
+        };
+
+        unsafe {
+            let ptr = heap.alloc_layout(layout)?.as_ptr() as *mut Self;
+            ptr.write(map);
+
+            Ok(Boxed::new_unchecked(ptr))
+        }
+    }
+
+    #[inline]
+    fn as_boxed(&self) -> Boxed<Map> {
+        // Maps are only ever constructed on a heap, so `self` is always a boxed map
+        unsafe { Boxed::new_unchecked(self as *const Self as *mut Self) }
+    }
+
+    #[inline]
+    fn is_flatmap(&self) -> bool {
+        self.len() <= MAX_FLATMAP_SIZE
+    }
+
+    #[inline]
+    fn flat_entries(&self) -> &[Term] {
+        node_elements(self.root)
+    }
+
+    /// Inserts `key` into this map, returning `None` if the map is unchanged
+    fn insert<A>(
+        &self,
+        heap: &mut A,
+        key: Term,
+        value: Term,
+        insert: Insert,
+    ) -> AllocResult<Option<Boxed<Map>>>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        let len = self.len();
+
+        if !self.is_flatmap() {
+            return match hamt::insert(heap, self.root, hash_key(key), key, value, insert, 0)? {
+                Some((root, added)) => {
+                    let len = if added { len + 1 } else { len };
+                    Self::alloc(heap, len, root).map(Some)
+                }
+                None => Ok(None),
+            };
+        }
+
+        let entries = self.flat_entries();
+        match flat_position(entries, key) {
+            Some(index) => {
+                let old_value = entries[index * 2 + 1];
+                if insert == Insert::PutNew || exact_eq(old_value, value) {
+                    return Ok(None);
+                }
+
+                let mut root = Tuple::new(heap, entries.len())?;
+                let elements = root.elements_mut();
+                elements.copy_from_slice(entries);
+                elements[index * 2 + 1] = value;
+
+                Self::alloc(heap, len, root.into()).map(Some)
+            }
+            None if len < MAX_FLATMAP_SIZE => {
+                let index = flat_insertion_point(entries, key);
+
+                let mut root = Tuple::new(heap, entries.len() + 2)?;
+                let elements = root.elements_mut();
+                elements[..index * 2].copy_from_slice(&entries[..index * 2]);
+                elements[index * 2] = key;
+                elements[index * 2 + 1] = value;
+                elements[index * 2 + 2..].copy_from_slice(&entries[index * 2..]);
+
+                Self::alloc(heap, len + 1, root.into()).map(Some)
+            }
+            None => {
+                // This map outgrows a flatmap, so the trie is built from all of the entries
+                let entries = self
+                    .iter()
+                    .map(|(key, value)| (*key, *value))
+                    .chain(core::iter::once((key, value)));
+
+                Entries::from_iter(entries).build(heap).map(Some)
+            }
+        }
+    }
+
     fn sorted_keys(&self) -> Vec<Term> {
-        let mut key_vec: Vec<Term> = Vec::new();
-        key_vec.extend(self.value.keys());
+        let mut key_vec: Vec<Term> = self.keys();
         key_vec.sort_unstable_by(|key1, key2| key1.cmp(&key2));
 
         key_vec
     }
 }
 
-impl AsRef<HashMap<Term, Term>> for Boxed<Map> {
-    fn as_ref(&self) -> &HashMap<Term, Term> {
-        &self.as_ref().value
-    }
+/// How an insertion treats a key which is already present
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum Insert {
+    /// Replace the value of the key
+    Put,
+    /// Keep the value of the key
+    PutNew,
 }
 
-impl AsRef<HashMap<Term, Term>> for Map {
-    fn as_ref(&self) -> &HashMap<Term, Term> {
-        &self.value
-    }
+/// The entries of a map under construction, deduplicated and ordered as they will be stored
+enum Entries {
+    /// Sorted by key
+    Flat(Vec<(Term, Term)>),
+    /// Sorted by hash
+    Hamt(Vec<hamt::Entry>),
 }
+impl Entries {
+    fn from_iter<I>(iter: I) -> Self
+    where
+        I: Iterator<Item = (Term, Term)>,
+    {
+        let mut entries: Vec<hamt::Entry> = iter
+            .map(|(key, value)| hamt::Entry::new(key, value))
+            .collect();
 
-impl crate::borrow::CloneToProcess for Map {
-    fn clone_to_heap<A>(&self, heap: &mut A) -> AllocResult<Term>
+        // Sort by hash, keeping the order in which duplicate keys were given, then keep only
+        // the last value given for each key
+        entries.sort_by_key(|entry| entry.hash);
+        let mut deduped: Vec<hamt::Entry> = Vec::with_capacity(entries.len());
+        let mut run_start = 0;
+        for entry in entries {
+            if deduped
+                .last()
+                .map_or(true, |last: &hamt::Entry| last.hash != entry.hash)
+            {
+                run_start = deduped.len();
+            }
+
+            match deduped[run_start..]
+                .iter_mut()
+                .find(|existing| exact_eq(existing.key, entry.key))
+            {
+                Some(existing) => existing.value = entry.value,
+                None => deduped.push(entry),
+            }
+        }
+
+        if deduped.len() <= MAX_FLATMAP_SIZE {
+            let mut flat: Vec<(Term, Term)> = deduped
+                .into_iter()
+                .map(|entry| (entry.key, entry.value))
+                .collect();
+            flat.sort_by(|(key1, _), (key2, _)| key1.cmp(key2));
+
+            Self::Flat(flat)
+        } else {
+            Self::Hamt(deduped)
+        }
+    }
+
+    fn len(&self) -> usize {
+        match self {
+            Self::Flat(entries) => entries.len(),
+            Self::Hamt(entries) => entries.len(),
+        }
+    }
+
+    fn need_in_words(&self) -> usize {
+        let map_words = erts::to_word_size(mem::size_of::<Map>());
+
+        match self {
+            Self::Flat(entries) => map_words + 1 + entries.len() * 2,
+            Self::Hamt(entries) => map_words + hamt::need_in_words_to_build(entries, 0),
+        }
+    }
+
+    fn build<A>(&self, heap: &mut A) -> AllocResult<Boxed<Map>>
     where
         A: ?Sized + TermAlloc,
     {
-        let layout = Layout::for_value(self);
-        let ptr = unsafe { heap.alloc_layout(layout)?.as_ptr() };
+        let root = match self {
+            Self::Flat(entries) => {
+                let mut root = Tuple::new(heap, entries.len() * 2)?;
+                for (pair, (key, value)) in root.elements_mut().chunks_mut(2).zip(entries) {
+                    pair[0] = *key;
+                    pair[1] = *value;
+                }
 
-        let self_value = &self.value;
-        let mut heap_value = HashMap::with_capacity(self_value.len());
+                root.into()
+            }
+            Self::Hamt(entries) => hamt::build(heap, entries, 0)?,
+        };
 
-        for (entry_key, entry_value) in self_value {
-            let heap_entry_key = entry_key.clone_to_heap(heap)?;
-            let heap_entry_value = entry_value.clone_to_heap(heap)?;
-            heap_value.insert(heap_entry_key, heap_entry_value);
+        Map::alloc(heap, self.len(), root)
+    }
+}
+
+/// Iterates over the entries of a `Map`
+pub struct Iter<'a> {
+    // The entries of the flatmap, or of the current node of the trie, as alternating keys and
+    // values
+    entries: slice::ChunksExact<'a, Term>,
+    // The children of the nodes of the trie left to visit
+    nodes: Vec<slice::Iter<'a, Term>>,
+}
+impl<'a> Iter<'a> {
+    fn flat(entries: &'a [Term]) -> Self {
+        Self {
+            entries: entries.chunks_exact(2),
+            nodes: Vec::new(),
         }
+    }
 
-        // Clone to ensure `value` remains valid if caller is dropped
-        let heap_self = Self {
-            header: self.header.clone(),
-            value: heap_value,
-        };
+    fn hamt(root: &'a [Term]) -> Self {
+        let (entries, children) = hamt::split(root);
 
-        let size = mem::size_of_val(self);
-        unsafe {
-            ptr::copy_nonoverlapping(&heap_self as *const _ as *const u8, ptr as *mut u8, size);
+        Self {
+            entries: entries.chunks_exact(2),
+            nodes: vec![children.iter()],
+        }
+    }
+}
+impl<'a> Iterator for Iter<'a> {
+    type Item = (&'a Term, &'a Term);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        loop {
+            if let Some(pair) = self.entries.next() {
+                return Some((&pair[0], &pair[1]));
+            }
+
+            // Descend into the next child of the deepest node with children left
+            let child = loop {
+                match self.nodes.last_mut()?.next() {
+                    Some(child) => break *child,
+                    None => {
+                        self.nodes.pop();
+                    }
+                }
+            };
+            let (entries, children) = hamt::split(node_elements(child));
+            self.entries = entries.chunks_exact(2);
+            self.nodes.push(children.iter());
+        }
+    }
+}
+impl FusedIterator for Iter<'_> {}
+
+/// Map keys are the same if they are exactly equal, i.e. `=:=`
+#[inline]
+fn exact_eq(lhs: Term, rhs: Term) -> bool {
+    // Atoms and small integers, by far the most common keys, are only equal if identical
+    if lhs.as_usize() == rhs.as_usize() {
+        return true;
+    }
+    if lhs.is_immediate() || rhs.is_immediate() {
+        return false;
+    }
+
+    match (lhs.decode(), rhs.decode()) {
+        (Ok(lhs), Ok(rhs)) => lhs.exact_eq(&rhs),
+        _ => false,
+    }
+}
+
+/// Maps are copied between processes without being rebuilt, so a key must hash the same way
+/// in every process, which rules out randomly seeded hashers
+#[inline]
+fn hash_key(key: Term) -> u64 {
+    let mut hasher = KeyHasher::default();
+    key.hash(&mut hasher);
+    hasher.finish()
+}
+
+#[derive(Default)]
+struct KeyHasher(u64);
+impl Hasher for KeyHasher {
+    #[inline]
+    fn write(&mut self, bytes: &[u8]) {
+        let mut chunks = bytes.chunks_exact(8);
+        for chunk in &mut chunks {
+            self.write_u64(u64::from_ne_bytes(chunk.try_into().unwrap()));
+        }
+        for byte in chunks.remainder() {
+            self.write_u64(*byte as u64);
         }
+    }
+
+    #[inline]
+    fn write_u64(&mut self, i: u64) {
+        self.0 = (self.0.rotate_left(5) ^ i).wrapping_mul(0x51_7c_c1_b7_27_22_0a_95);
+    }
+
+    #[inline]
+    fn write_usize(&mut self, i: usize) {
+        self.write_u64(i as u64);
+    }
+
+    /// The trie is indexed by the high bits of the hash, so they are mixed with the low bits
+    #[inline]
+    fn finish(&self) -> u64 {
+        let mut hash = self.0;
+        hash ^= hash >> 33;
+        hash = hash.wrapping_mul(0xff51_afd7_ed55_8ccd);
+        hash ^= hash >> 33;
+        hash = hash.wrapping_mul(0xc4ce_b9fe_1a85_ec53);
+        hash ^ (hash >> 33)
+    }
+}
+
+/// Returns the index of the pair holding `key` in a flatmap
+///
+/// Flatmaps are small enough that a linear scan, which mostly compares words, is faster than a
+/// binary search comparing terms.
+#[inline]
+fn flat_position(entries: &[Term], key: Term) -> Option<usize> {
+    entries
+        .chunks_exact(2)
+        .position(|pair| exact_eq(pair[0], key))
+}
+
+/// Returns the index of the pair at which `key` should be inserted to keep a flatmap sorted
+#[inline]
+fn flat_insertion_point(entries: &[Term], key: Term) -> usize {
+    let len = entries.len() / 2;
+    let (mut low, mut high) = (0, len);
+    while low < high {
+        let mid = (low + high) / 2;
+        if entries[mid * 2] <= key {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    low
+}
+
+/// Returns the elements of the tuple `term` points to
+///
+/// The lifetime is that of the map the tuple belongs to, as its structure is never modified.
+#[inline]
+fn node_elements<'a>(term: Term) -> &'a [Term] {
+    unsafe {
+        let ptr: *mut Term = term.dyn_cast();
+        let tuple = Tuple::from_raw_term(ptr);
+        &*(tuple.as_ref().elements() as *const [Term])
+    }
+}
+
+#[inline]
+fn encode_usize(n: usize) -> Term {
+    let small: SmallInteger = n.try_into().unwrap();
+    small.encode().unwrap()
+}
+
+#[inline]
+fn decode_usize(term: Term) -> usize {
+    let small: SmallInteger = term.decode().unwrap().try_into().unwrap();
+    TryInto::<usize>::try_into(small).unwrap()
+}
 
-        mem::forget(heap_self);
+impl crate::borrow::CloneToProcess for Map {
+    fn clone_to_heap<A>(&self, heap: &mut A) -> AllocResult<Term>
+    where
+        A: ?Sized + TermAlloc,
+    {
+        let root = self.root.clone_to_heap(heap)?;
 
-        Ok((ptr as *mut Self).into())
+        Self::alloc(heap, self.len(), root).map(|map| map.into())
     }
 
     fn size_in_words(&self) -> usize {
-        crate::erts::to_word_size(Layout::for_value(self).size())
+        erts::to_word_size(mem::size_of_val(self)) + self.root.size_in_words()
     }
 }
 
@@ -216,7 +742,8 @@ impl Debug for Map {
     fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
         f.debug_struct("Map")
             .field("header", &self.header)
-            .field("value", &self.value)
+            .field("size", &self.len())
+            .field("root", &self.root)
             .finish()
     }
 }
@@ -244,7 +771,7 @@ impl Eq for Map {}
 impl Hash for Map {
     fn hash<H: Hasher>(&self, state: &mut H) {
         for key in self.sorted_keys() {
-            let value = self.value[&key];
+            let value = self.get(key).unwrap();
 
             key.hash(state);
             value.hash(state);
@@ -254,7 +781,10 @@ impl Hash for Map {
 
 impl PartialEq for Map {
     fn eq(&self, other: &Map) -> bool {
-        self.value.eq(&other.value)
+        self.len() == other.len()
+            && self
+                .iter()
+                .all(|(key, value)| other.get(*key).map_or(false, |other| other == *value))
     }
 }
 impl<T> PartialEq<Boxed<T>> for Map
@@ -294,16 +824,10 @@ impl Ord for Map {
 
                 match self_key_vec.cmp(&other_key_vec) {
                     cmp::Ordering::Equal => {
-                        let self_value = &self.value;
-                        let other_value = &other.value;
                         let mut final_ordering = cmp::Ordering::Equal;
 
                         for key in self_key_vec {
-                            match self_value
-                                .get(&key)
-                                .unwrap()
-                                .cmp(other_value.get(&key).unwrap())
-                            {
+                            match self.get(key).unwrap().cmp(&other.get(key).unwrap()) {
                                 cmp::Ordering::Equal => continue,
                                 ordering => {
                                     final_ordering = ordering;
@@ -333,3 +857,292 @@ impl TryFrom<TypedTerm> for Boxed<Map> {
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    extern crate test;
+
+    use super::*;
+
+    use core::ops::Range;
+
+    use liblumen_core::alloc::Layout;
+    use liblumen_core::sys::sysconf::MIN_ALIGN;
+
+    use test::Bencher;
+
+    use crate::erts::testing::RegionHeap;
+
+    const LEN: usize = 1_000;
+
+    mod put {
+        use super::*;
+
+        #[test]
+        fn with_more_than_max_flatmap_size_entries_gets_every_key() {
+            let mut heap = heap();
+            let map = put_all(&mut heap, 0..LEN);
+
+            assert!(!map.is_flatmap());
+            assert_eq!(map.len(), LEN);
+            for i in 0..LEN {
+                assert_eq!(map.get(fixnum!(i)), Some(value(i)));
+            }
+            assert_eq!(map.get(fixnum!(LEN)), None);
+        }
+
+        #[test]
+        fn past_max_flatmap_size_converts_to_a_trie() {
+            let mut heap = heap();
+            let flatmap = put_all(&mut heap, 0..MAX_FLATMAP_SIZE);
+
+            assert!(flatmap.is_flatmap());
+
+            let map = flatmap
+                .put(
+                    &mut heap,
+                    fixnum!(MAX_FLATMAP_SIZE),
+                    value(MAX_FLATMAP_SIZE),
+                )
+                .unwrap();
+
+            assert!(!map.is_flatmap());
+            assert_eq!(map.len(), MAX_FLATMAP_SIZE + 1);
+            assert_eq!(*map, *from_slice(&mut heap, 0..MAX_FLATMAP_SIZE + 1));
+        }
+
+        #[test]
+        fn with_present_key_and_value_returns_the_same_map() {
+            let mut heap = heap();
+            let map = put_all(&mut heap, 0..LEN);
+
+            let put = map.put(&mut heap, fixnum!(0), value(0)).unwrap();
+
+            assert_eq!(put.as_ptr(), map.as_ptr());
+        }
+    }
+
+    mod remove {
+        use super::*;
+
+        #[test]
+        fn to_max_flatmap_size_converts_back_to_a_flatmap() {
+            let mut heap = heap();
+            let map = from_slice(&mut heap, 0..MAX_FLATMAP_SIZE + 1);
+
+            assert!(!map.is_flatmap());
+
+            let removed = map.remove(&mut heap, fixnum!(0)).unwrap();
+
+            assert!(removed.is_flatmap());
+            assert_eq!(*removed, *from_slice(&mut heap, 1..MAX_FLATMAP_SIZE + 1));
+        }
+
+        #[test]
+        fn from_trie_keeps_every_other_key() {
+            let mut heap = heap();
+            let mut map = from_slice(&mut heap, 0..LEN);
+
+            for i in (0..LEN).step_by(2) {
+                map = map.remove(&mut heap, fixnum!(i)).unwrap();
+            }
+
+            assert_eq!(map.len(), LEN / 2);
+            for i in 0..LEN {
+                let expected = if i % 2 == 0 { None } else { Some(value(i)) };
+                assert_eq!(map.get(fixnum!(i)), expected);
+            }
+        }
+    }
+
+    mod merge {
+        use super::*;
+
+        #[test]
+        fn with_tries_takes_values_from_other() {
+            let mut heap = heap();
+            let map = from_slice(&mut heap, 0..LEN);
+            let other = from_slice_with(&mut heap, LEN / 2..LEN * 2, |i| fixnum!(i));
+
+            for (map, other) in &[(map, other), (map, from_slice(&mut heap, 0..10))] {
+                let merged = map.merge(&mut heap, other).unwrap();
+
+                for (key, value) in map.iter() {
+                    assert_eq!(merged.get(*key), other.get(*key).or(Some(*value)));
+                }
+                for (key, value) in other.iter() {
+                    assert_eq!(merged.get(*key), Some(*value));
+                }
+            }
+        }
+
+        #[test]
+        fn with_flatmap_and_larger_trie_takes_values_from_other() {
+            let mut heap = heap();
+            let map = from_slice_with(&mut heap, 0..10, |i| fixnum!(i));
+            let other = from_slice(&mut heap, 0..LEN);
+
+            let merged = map.merge(&mut heap, &other).unwrap();
+
+            assert_eq!(*merged, *other);
+        }
+
+        #[test]
+        fn with_flatmaps_converts_to_a_trie_if_needed() {
+            let mut heap = heap();
+            let map = from_slice(&mut heap, 0..MAX_FLATMAP_SIZE);
+            let other = from_slice(&mut heap, MAX_FLATMAP_SIZE / 2..MAX_FLATMAP_SIZE * 3 / 2);
+
+            let merged = map.merge(&mut heap, &other).unwrap();
+
+            assert!(!merged.is_flatmap());
+            assert_eq!(*merged, *from_slice(&mut heap, 0..MAX_FLATMAP_SIZE * 3 / 2));
+        }
+    }
+
+    mod iter {
+        use super::*;
+
+        #[test]
+        fn with_trie_visits_every_entry_once() {
+            let mut heap = heap();
+            let map = from_slice(&mut heap, 0..LEN);
+
+            let mut keys: Vec<Term> = map.iter().map(|(key, _)| *key).collect();
+            keys.sort();
+
+            assert_eq!(keys, (0..LEN).map(|i| fixnum!(i)).collect::<Vec<_>>());
+            assert!(map.iter().all(|(key, value)| map.get(*key) == Some(*value)));
+        }
+    }
+
+    mod get {
+        use super::*;
+
+        const BYTES: &[u8] = b"a binary key";
+
+        #[test]
+        fn with_aligned_subbinary_key_finds_equal_heap_binary_key() {
+            with_subbinary_key_finds_equal_heap_binary_key(0);
+        }
+
+        #[test]
+        fn with_unaligned_subbinary_key_finds_equal_heap_binary_key() {
+            with_subbinary_key_finds_equal_heap_binary_key(3);
+        }
+
+        fn with_subbinary_key_finds_equal_heap_binary_key(bit_offset: u8) {
+            let mut heap = heap();
+            let key = heap.binary_from_bytes(BYTES).unwrap();
+            let subbinary_key = subbinary_key(&mut heap, bit_offset);
+
+            for &len in &[MAX_FLATMAP_SIZE, LEN] {
+                let mut entries: Vec<(Term, Term)> =
+                    (1..len).map(|i| (fixnum!(i), value(i))).collect();
+                entries.push((key, value(0)));
+                let map = Map::from_slice(&mut heap, &entries).unwrap();
+
+                assert_eq!(map.get(subbinary_key), Some(value(0)));
+            }
+        }
+
+        /// A subbinary with the same bytes as `BYTES`, starting `bit_offset` bits into its
+        /// original
+        fn subbinary_key(heap: &mut RegionHeap, bit_offset: u8) -> Term {
+            let mut shifted = vec![0; BYTES.len() + 1];
+            for (i, byte) in BYTES.iter().enumerate() {
+                shifted[i] |= byte >> bit_offset;
+                if bit_offset > 0 {
+                    shifted[i + 1] |= byte << (8 - bit_offset);
+                }
+            }
+            let original = heap.binary_from_bytes(&shifted).unwrap();
+
+            heap.subbinary_from_original(original, 0, bit_offset, BYTES.len(), 0)
+                .unwrap()
+                .into()
+        }
+    }
+
+    #[bench]
+    fn put_into_trie(b: &mut Bencher) {
+        b.iter(|| put_all(&mut heap(), 0..LEN).len());
+    }
+
+    #[bench]
+    fn get_from_trie(b: &mut Bencher) {
+        let mut heap = heap();
+        let map = from_slice(&mut heap, 0..LEN);
+
+        b.iter(|| {
+            for i in 0..LEN {
+                test::black_box(map.get(fixnum!(i)));
+            }
+        });
+    }
+
+    #[bench]
+    fn get_from_flatmap(b: &mut Bencher) {
+        let mut heap = heap();
+        let map = from_slice(&mut heap, 0..MAX_FLATMAP_SIZE);
+
+        b.iter(|| {
+            for i in 0..MAX_FLATMAP_SIZE {
+                test::black_box(map.get(fixnum!(i)));
+            }
+        });
+    }
+
+    #[bench]
+    fn merge_tries(b: &mut Bencher) {
+        let mut heap = heap();
+        let map = from_slice(&mut heap, 0..LEN);
+        let other = from_slice(&mut heap, LEN / 2..LEN);
+
+        b.iter(|| map.merge(&mut self::heap(), &other).unwrap().len());
+    }
+
+    #[bench]
+    fn iterate_trie(b: &mut Bencher) {
+        let mut heap = heap();
+        let map = from_slice(&mut heap, 0..LEN);
+
+        b.iter(|| map.iter().count());
+    }
+
+    /// Builds a map by putting one key at a time, going through both representations
+    fn put_all(heap: &mut RegionHeap, keys: Range<usize>) -> Boxed<Map> {
+        let mut map = Map::new(heap).unwrap();
+        for i in keys {
+            map = map.put(heap, fixnum!(i), value(i)).unwrap();
+        }
+
+        map
+    }
+
+    fn from_slice(heap: &mut RegionHeap, keys: Range<usize>) -> Boxed<Map> {
+        from_slice_with(heap, keys, value)
+    }
+
+    fn from_slice_with<F>(heap: &mut RegionHeap, keys: Range<usize>, value: F) -> Boxed<Map>
+    where
+        F: Fn(usize) -> Term,
+    {
+        let entries: Vec<(Term, Term)> = keys.map(|i| (fixnum!(i), value(i))).collect();
+
+        Map::from_slice(heap, &entries).unwrap()
+    }
+
+    fn value(i: usize) -> Term {
+        fixnum!(i + LEN * 10)
+    }
+
+    // Large enough for a map of a few thousand entries, along with the nodes replaced putting
+    // them one at a time
+    fn heap() -> RegionHeap {
+        let layout =
+            Layout::from_size_align(512 * 1024 * mem::size_of::<Term>(), MIN_ALIGN).unwrap();
+
+        RegionHeap::new(layout)
+    }
+}
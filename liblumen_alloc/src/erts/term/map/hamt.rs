@@ -0,0 +1,880 @@
+//! The hash array mapped trie used by maps with more than `MAX_FLATMAP_SIZE` entries.
+//!
+//! The trie is a compressed hash array mapped prefix tree (CHAMP): every node is a tuple of
+//!
+//! ```text
+//! {datamap, nodemap, key1, value1, ..., keyN, valueN, child1, ..., childM}
+//! ```
+//!
+//! where each node indexes 4 bits of the key hash, starting from the most significant bits, and
+//! the bitmaps, which are small integers, record which of the 16 slots of the node hold an
+//! entry, and which hold a child node. Entries and children are stored in slot order, so the
+//! position of a slot is the number of bits set below it in its bitmap.
+//!
+//! Once the whole hash is used up, keys whose hashes collide share a collision node, whose
+//! bitmaps are both zero, and whose entries are searched linearly.
+//!
+//! Updates copy the nodes on the path to the changed slot, and share every other node with the
+//! trie they were made from.
+use core::convert::TryInto;
+
+use crate::erts::exception::AllocResult;
+use crate::erts::process::alloc::TermAlloc;
+use crate::erts::term::prelude::*;
+
+use super::{decode_usize, encode_usize, exact_eq, hash_key, node_elements, Insert};
+
+/// The number of hash bits indexed by each node
+const BITS: u32 = 4;
+/// The depth of collision nodes, at which all of the hash has been used
+const MAX_DEPTH: u32 = 64 / BITS;
+
+/// An entry of a map being built, along with the hash of its key
+pub(super) struct Entry {
+    pub(super) hash: u64,
+    pub(super) key: Term,
+    pub(super) value: Term,
+}
+impl Entry {
+    #[inline]
+    pub(super) fn new(key: Term, value: Term) -> Self {
+        Self {
+            hash: hash_key(key),
+            key,
+            value,
+        }
+    }
+}
+
+/// The result of removing a key from a node
+enum Removed {
+    /// The node was replaced by this node
+    Node(Term),
+    /// The node was left with this single entry, which is moved into its parent
+    Single(Term, Term),
+}
+
+pub(super) fn get(root: Term, hash: u64, key: Term) -> Option<Term> {
+    let mut node = node_elements(root);
+
+    for depth in 0..MAX_DEPTH {
+        let (datamap, nodemap) = bitmaps(node);
+        let bit = bit(hash, depth);
+
+        if datamap & bit != 0 {
+            let at = entry_index(datamap, bit);
+
+            return if exact_eq(node[at], key) {
+                Some(node[at + 1])
+            } else {
+                None
+            };
+        } else if nodemap & bit != 0 {
+            node = node_elements(node[child_index(node, nodemap, bit)]);
+        } else {
+            return None;
+        }
+    }
+
+    collision_position(node, key).map(|at| node[at + 1])
+}
+
+/// Inserts `key` into the trie rooted at `root`, returning the new root and whether the key
+/// was added, or `None` if the trie is unchanged
+pub(super) fn insert<A>(
+    heap: &mut A,
+    root: Term,
+    hash: u64,
+    key: Term,
+    value: Term,
+    insert: Insert,
+    depth: u32,
+) -> AllocResult<Option<(Term, bool)>>
+where
+    A: ?Sized + TermAlloc,
+{
+    let node = node_elements(root);
+
+    if depth == MAX_DEPTH {
+        return match collision_position(node, key) {
+            Some(at) => replace_value(heap, node, at, value, insert),
+            None => {
+                let mut new_node = Tuple::new(heap, node.len() + 2)?;
+                let elements = new_node.elements_mut();
+                elements[..node.len()].copy_from_slice(node);
+                elements[node.len()] = key;
+                elements[node.len() + 1] = value;
+
+                Ok(Some((new_node.into(), true)))
+            }
+        };
+    }
+
+    let (datamap, nodemap) = bitmaps(node);
+    let bit = bit(hash, depth);
+
+    if datamap & bit != 0 {
+        let at = entry_index(datamap, bit);
+        let (existing_key, existing_value) = (node[at], node[at + 1]);
+
+        if exact_eq(existing_key, key) {
+            return replace_value(heap, node, at, value, insert);
+        }
+
+        // The slot is taken by another key, so both move down into a new child
+        let child = pair_node(
+            heap,
+            Entry {
+                hash: hash_key(existing_key),
+                key: existing_key,
+                value: existing_value,
+            },
+            Entry { hash, key, value },
+            depth + 1,
+        )?;
+
+        let datamap = datamap & !bit;
+        let nodemap = nodemap | bit;
+        let mut new_node = Tuple::new(heap, node.len() - 1)?;
+        let elements = new_node.elements_mut();
+        let child_at = child_index(elements, nodemap, bit);
+        elements[0] = encode_usize(datamap as usize);
+        elements[1] = encode_usize(nodemap as usize);
+        elements[2..at].copy_from_slice(&node[2..at]);
+        elements[at..child_at].copy_from_slice(&node[at + 2..child_at + 2]);
+        elements[child_at] = child;
+        elements[child_at + 1..].copy_from_slice(&node[child_at + 2..]);
+
+        Ok(Some((new_node.into(), true)))
+    } else if nodemap & bit != 0 {
+        let child_at = child_index(node, nodemap, bit);
+
+        match self::insert(heap, node[child_at], hash, key, value, insert, depth + 1)? {
+            Some((child, added)) => {
+                let mut new_node = Tuple::new(heap, node.len())?;
+                let elements = new_node.elements_mut();
+                elements.copy_from_slice(node);
+                elements[child_at] = child;
+
+                Ok(Some((new_node.into(), added)))
+            }
+            None => Ok(None),
+        }
+    } else {
+        let at = entry_index(datamap, bit);
+        let mut new_node = Tuple::new(heap, node.len() + 2)?;
+        let elements = new_node.elements_mut();
+        elements[0] = encode_usize((datamap | bit) as usize);
+        elements[1] = node[1];
+        elements[2..at].copy_from_slice(&node[2..at]);
+        elements[at] = key;
+        elements[at + 1] = value;
+        elements[at + 2..].copy_from_slice(&node[at..]);
+
+        Ok(Some((new_node.into(), true)))
+    }
+}
+
+/// The number of words that may be allocated by `insert`
+pub(super) fn need_in_words_to_insert(root: Term, hash: u64, key: Term, depth: u32) -> usize {
+    let node = node_elements(root);
+
+    if depth == MAX_DEPTH {
+        return tuple_words(node.len() + 2);
+    }
+
+    let (datamap, nodemap) = bitmaps(node);
+    let bit = bit(hash, depth);
+
+    if datamap & bit != 0 {
+        let at = entry_index(datamap, bit);
+
+        if exact_eq(node[at], key) {
+            tuple_words(node.len())
+        } else {
+            tuple_words(node.len() - 1) + need_in_words_to_pair(hash_key(node[at]), hash, depth + 1)
+        }
+    } else if nodemap & bit != 0 {
+        let child = node[child_index(node, nodemap, bit)];
+
+        tuple_words(node.len()) + need_in_words_to_insert(child, hash, key, depth + 1)
+    } else {
+        tuple_words(node.len() + 2)
+    }
+}
+
+/// Removes `key`, which must be present, from the trie rooted at `root`, returning the new root
+pub(super) fn remove<A>(
+    heap: &mut A,
+    root: Term,
+    hash: u64,
+    key: Term,
+    depth: u32,
+) -> AllocResult<Term>
+where
+    A: ?Sized + TermAlloc,
+{
+    match remove_from(heap, root, hash, key, depth)? {
+        Removed::Node(node) => Ok(node),
+        Removed::Single(..) => unreachable!("the root node of a trie is never collapsed"),
+    }
+}
+
+/// The number of words that may be allocated by `remove`
+pub(super) fn need_in_words_to_remove(root: Term, hash: u64) -> usize {
+    let mut node = node_elements(root);
+    // Every node on the path is copied, and may grow by a word when a child is inlined
+    let mut words = tuple_words(node.len() + 1);
+
+    for depth in 0..MAX_DEPTH {
+        let (_, nodemap) = bitmaps(node);
+        let bit = bit(hash, depth);
+        if nodemap & bit == 0 {
+            break;
+        }
+
+        node = node_elements(node[child_index(node, nodemap, bit)]);
+        words += tuple_words(node.len() + 1);
+    }
+
+    words
+}
+
+/// Builds a trie from `entries`, which must be sorted by hash, and have no duplicate keys
+pub(super) fn build<A>(heap: &mut A, entries: &[Entry], depth: u32) -> AllocResult<Term>
+where
+    A: ?Sized + TermAlloc,
+{
+    if depth == MAX_DEPTH {
+        let mut node = Tuple::new(heap, 2 + entries.len() * 2)?;
+        let elements = node.elements_mut();
+        elements[0] = encode_usize(0);
+        elements[1] = encode_usize(0);
+        for (pair, entry) in elements[2..].chunks_mut(2).zip(entries) {
+            pair[0] = entry.key;
+            pair[1] = entry.value;
+        }
+
+        return Ok(node.into());
+    }
+
+    // Slots with one entry hold it directly, and slots with more hold a child node
+    let mut datamap: u32 = 0;
+    let mut nodemap: u32 = 0;
+    for (fragment, group) in groups(entries, depth) {
+        if group.len() == 1 {
+            datamap |= 1 << fragment;
+        } else {
+            nodemap |= 1 << fragment;
+        }
+    }
+
+    let num_entries = datamap.count_ones() as usize;
+    let mut node = Tuple::new(heap, 2 + num_entries * 2 + nodemap.count_ones() as usize)?;
+    let elements = node.elements_mut();
+    elements[0] = encode_usize(datamap as usize);
+    elements[1] = encode_usize(nodemap as usize);
+
+    let mut entry_at = 2;
+    let mut child_at = 2 + num_entries * 2;
+    for (_, group) in groups(entries, depth) {
+        if let [entry] = group {
+            elements[entry_at] = entry.key;
+            elements[entry_at + 1] = entry.value;
+            entry_at += 2;
+        } else {
+            elements[child_at] = build(heap, group, depth + 1)?;
+            child_at += 1;
+        }
+    }
+
+    Ok(node.into())
+}
+
+/// The number of words allocated by `build`
+pub(super) fn need_in_words_to_build(entries: &[Entry], depth: u32) -> usize {
+    if depth == MAX_DEPTH {
+        return tuple_words(2 + entries.len() * 2);
+    }
+
+    let mut len = 2;
+    let mut children_words = 0;
+    for (_, group) in groups(entries, depth) {
+        if group.len() == 1 {
+            len += 2;
+        } else {
+            len += 1;
+            children_words += need_in_words_to_build(group, depth + 1);
+        }
+    }
+
+    tuple_words(len) + children_words
+}
+
+/// Returns the entries and child nodes of a node
+#[inline]
+pub(super) fn split(node: &[Term]) -> (&[Term], &[Term]) {
+    let (_, nodemap) = bitmaps(node);
+    let children_at = node.len() - nodemap.count_ones() as usize;
+
+    (&node[2..children_at], &node[children_at..])
+}
+
+/// Marks every node of the trie rooted at `root` as a literal, and returns the literal root
+///
+/// # Safety
+///
+/// See `Map::into_literal`
+pub(super) unsafe fn into_literal(root: Term) -> Term {
+    let ptr: *mut Term = root.dyn_cast();
+    let mut node = Tuple::from_raw_term(ptr);
+    let (_, nodemap) = bitmaps(node.elements());
+    let children_at = node.len() - nodemap.count_ones() as usize;
+
+    for child in &mut node.elements_mut()[children_at..] {
+        *child = into_literal(*child);
+    }
+
+    Term::encode_literal(ptr)
+}
+
+// Private
+
+fn remove_from<A>(
+    heap: &mut A,
+    root: Term,
+    hash: u64,
+    key: Term,
+    depth: u32,
+) -> AllocResult<Removed>
+where
+    A: ?Sized + TermAlloc,
+{
+    let node = node_elements(root);
+
+    if depth == MAX_DEPTH {
+        let at = collision_position(node, key).unwrap();
+
+        if node.len() == 6 {
+            let other = if at == 2 { 4 } else { 2 };
+
+            return Ok(Removed::Single(node[other], node[other + 1]));
+        }
+
+        return without_entry(heap, node, at, 0, 0).map(Removed::Node);
+    }
+
+    let (datamap, nodemap) = bitmaps(node);
+    let bit = bit(hash, depth);
+
+    if datamap & bit != 0 {
+        let at = entry_index(datamap, bit);
+        debug_assert!(exact_eq(node[at], key));
+
+        // Below the root, a node left with a single entry is collapsed into its parent
+        if depth > 0 && nodemap == 0 && datamap.count_ones() == 2 {
+            let other = if at == 2 { 4 } else { 2 };
+
+            return Ok(Removed::Single(node[other], node[other + 1]));
+        }
+
+        without_entry(heap, node, at, datamap & !bit, nodemap).map(Removed::Node)
+    } else {
+        debug_assert!(nodemap & bit != 0);
+        let child_at = child_index(node, nodemap, bit);
+
+        match remove_from(heap, node[child_at], hash, key, depth + 1)? {
+            Removed::Node(child) => {
+                let mut new_node = Tuple::new(heap, node.len())?;
+                let elements = new_node.elements_mut();
+                elements.copy_from_slice(node);
+                elements[child_at] = child;
+
+                Ok(Removed::Node(new_node.into()))
+            }
+            Removed::Single(key, value) if depth > 0 && node.len() == 3 => {
+                Ok(Removed::Single(key, value))
+            }
+            Removed::Single(key, value) => {
+                // The remaining entry of the child moves into the slot the child occupied
+                let datamap = datamap | bit;
+                let at = entry_index(datamap, bit);
+                let mut new_node = Tuple::new(heap, node.len() + 1)?;
+                let elements = new_node.elements_mut();
+                elements[0] = encode_usize(datamap as usize);
+                elements[1] = encode_usize((nodemap & !bit) as usize);
+                elements[2..at].copy_from_slice(&node[2..at]);
+                elements[at] = key;
+                elements[at + 1] = value;
+                elements[at + 2..child_at + 2].copy_from_slice(&node[at..child_at]);
+                elements[child_at + 2..].copy_from_slice(&node[child_at + 1..]);
+
+                Ok(Removed::Node(new_node.into()))
+            }
+        }
+    }
+}
+
+/// Copies `node` without the entry at `at`, with the given bitmaps
+fn without_entry<A>(
+    heap: &mut A,
+    node: &[Term],
+    at: usize,
+    datamap: u32,
+    nodemap: u32,
+) -> AllocResult<Term>
+where
+    A: ?Sized + TermAlloc,
+{
+    let mut new_node = Tuple::new(heap, node.len() - 2)?;
+    let elements = new_node.elements_mut();
+    elements[0] = encode_usize(datamap as usize);
+    elements[1] = encode_usize(nodemap as usize);
+    elements[2..at].copy_from_slice(&node[2..at]);
+    elements[at..].copy_from_slice(&node[at + 2..]);
+
+    Ok(new_node.into())
+}
+
+/// Copies `node` with the value at `at` replaced, or returns `None` if it needn't change
+fn replace_value<A>(
+    heap: &mut A,
+    node: &[Term],
+    at: usize,
+    value: Term,
+    insert: Insert,
+) -> AllocResult<Option<(Term, bool)>>
+where
+    A: ?Sized + TermAlloc,
+{
+    if insert == Insert::PutNew || exact_eq(node[at + 1], value) {
+        return Ok(None);
+    }
+
+    let mut new_node = Tuple::new(heap, node.len())?;
+    let elements = new_node.elements_mut();
+    elements.copy_from_slice(node);
+    elements[at + 1] = value;
+
+    Ok(Some((new_node.into(), false)))
+}
+
+/// Builds the node holding two entries which occupied the same slot of its parent
+fn pair_node<A>(heap: &mut A, first: Entry, second: Entry, depth: u32) -> AllocResult<Term>
+where
+    A: ?Sized + TermAlloc,
+{
+    if depth == MAX_DEPTH {
+        return build(heap, &[first, second], depth);
+    }
+
+    let first_fragment = fragment(first.hash, depth);
+    let second_fragment = fragment(second.hash, depth);
+
+    if first_fragment == second_fragment {
+        let child = pair_node(heap, first, second, depth + 1)?;
+        let mut node = Tuple::new(heap, 3)?;
+        let elements = node.elements_mut();
+        elements[0] = encode_usize(0);
+        elements[1] = encode_usize(1 << first_fragment);
+        elements[2] = child;
+
+        Ok(node.into())
+    } else if first_fragment < second_fragment {
+        build(heap, &[first, second], depth)
+    } else {
+        build(heap, &[second, first], depth)
+    }
+}
+
+/// The number of words allocated by `pair_node`
+fn need_in_words_to_pair(first_hash: u64, second_hash: u64, depth: u32) -> usize {
+    if depth < MAX_DEPTH && fragment(first_hash, depth) == fragment(second_hash, depth) {
+        tuple_words(3) + need_in_words_to_pair(first_hash, second_hash, depth + 1)
+    } else {
+        tuple_words(6)
+    }
+}
+
+/// Iterates over runs of entries, sorted by hash, which occupy the same slot at `depth`
+fn groups(entries: &[Entry], depth: u32) -> impl Iterator<Item = (u32, &[Entry])> {
+    let mut rest = entries;
+
+    core::iter::from_fn(move || {
+        let first = rest.first()?;
+        let fragment = fragment(first.hash, depth);
+        let len = rest
+            .iter()
+            .position(|entry| self::fragment(entry.hash, depth) != fragment)
+            .unwrap_or(rest.len());
+        let (group, remaining) = rest.split_at(len);
+        rest = remaining;
+
+        Some((fragment, group))
+    })
+}
+
+/// Returns the index of the key of `key` in a collision node
+#[inline]
+fn collision_position(node: &[Term], key: Term) -> Option<usize> {
+    node[2..]
+        .chunks_exact(2)
+        .position(|pair| exact_eq(pair[0], key))
+        .map(|index| 2 + index * 2)
+}
+
+#[inline]
+fn bitmaps(node: &[Term]) -> (u32, u32) {
+    (
+        decode_usize(node[0]).try_into().unwrap(),
+        decode_usize(node[1]).try_into().unwrap(),
+    )
+}
+
+#[inline]
+fn fragment(hash: u64, depth: u32) -> u32 {
+    ((hash >> (64 - BITS * (depth + 1))) & ((1 << BITS) - 1)) as u32
+}
+
+#[inline]
+fn bit(hash: u64, depth: u32) -> u32 {
+    1 << fragment(hash, depth)
+}
+
+/// The index of the key of the entry in the slot of `bit`
+#[inline]
+fn entry_index(datamap: u32, bit: u32) -> usize {
+    2 + (datamap & (bit - 1)).count_ones() as usize * 2
+}
+
+/// The index of the child node in the slot of `bit`
+#[inline]
+fn child_index(node: &[Term], nodemap: u32, bit: u32) -> usize {
+    let children_at = node.len() - nodemap.count_ones() as usize;
+
+    children_at + (nodemap & (bit - 1)).count_ones() as usize
+}
+
+#[inline]
+fn tuple_words(len: usize) -> usize {
+    1 + len
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use core::mem;
+
+    use liblumen_core::alloc::Layout;
+    use liblumen_core::sys::sysconf::MIN_ALIGN;
+
+    use crate::erts::testing::RegionHeap;
+
+    // Keys given these hashes, rather than their own, are placed where the tests need them. As
+    // nodes rehash keys they push down a level, tries built from them must only be changed in
+    // ways that don't push a key down.
+    const COLLIDING: u64 = 0xdead_beef_0123_4567;
+    const OTHER: u64 = 0x5000_0000_0000_0000;
+
+    mod insert {
+        use super::*;
+
+        #[test]
+        fn with_colliding_hash_adds_to_the_collision_node_at_max_depth() {
+            let mut heap = heap();
+            let root = trie(&mut heap, &[(0, COLLIDING), (1, COLLIDING), (2, OTHER)]);
+
+            let (inserted, added) = insert(
+                &mut heap,
+                root,
+                COLLIDING,
+                fixnum!(3),
+                value(3),
+                Insert::Put,
+                0,
+            )
+            .unwrap()
+            .unwrap();
+
+            assert!(added);
+
+            let node = collision_node(inserted, COLLIDING);
+            assert_eq!(bitmaps(node), (0, 0));
+            assert_eq!(node.len(), 2 + 3 * 2);
+
+            for i in 0..4 {
+                assert_eq!(get(inserted, COLLIDING, fixnum!(i)), Some(value(i)));
+            }
+            assert_eq!(get(inserted, COLLIDING, fixnum!(4)), None);
+            assert_eq!(get(root, COLLIDING, fixnum!(3)), None);
+        }
+
+        #[test]
+        fn with_hash_sharing_a_slot_builds_a_path_to_both_keys() {
+            let mut heap = heap();
+            // Find two keys whose hashes share their first two fragments, but not the third
+            let mut seen: Vec<Option<(usize, u64)>> = vec![None; 1 << (BITS * 2)];
+            let (first, second) = (0..)
+                .find_map(|i| {
+                    let hash = hash_key(fixnum!(i));
+                    let prefix = (hash >> (64 - BITS * 2)) as usize;
+
+                    match seen[prefix] {
+                        Some((j, other)) if fragment(other, 2) != fragment(hash, 2) => {
+                            Some(((j, other), (i, hash)))
+                        }
+                        Some(_) => None,
+                        None => {
+                            seen[prefix] = Some((i, hash));
+                            None
+                        }
+                    }
+                })
+                .unwrap();
+            let root = trie(&mut heap, &[first]);
+
+            let (inserted, added) = insert(
+                &mut heap,
+                root,
+                second.1,
+                fixnum!(second.0),
+                value(second.0),
+                Insert::Put,
+                0,
+            )
+            .unwrap()
+            .unwrap();
+
+            assert!(added);
+
+            let root_node = node_elements(inserted);
+            assert_eq!(bitmaps(root_node), (0, bit(first.1, 0)));
+
+            let path = node_elements(root_node[2]);
+            assert_eq!(bitmaps(path), (0, bit(first.1, 1)));
+
+            let pair = node_elements(path[2]);
+            assert_eq!(bitmaps(pair), (bit(first.1, 2) | bit(second.1, 2), 0));
+
+            for (i, hash) in &[first, second] {
+                assert_eq!(get(inserted, *hash, fixnum!(*i)), Some(value(*i)));
+            }
+        }
+
+        #[test]
+        fn with_present_key_replaces_the_value_only_with_put() {
+            let mut heap = heap();
+            let root = trie(&mut heap, &[(0, OTHER)]);
+            let key = fixnum!(0);
+
+            assert!(
+                insert(&mut heap, root, OTHER, key, value(0), Insert::Put, 0)
+                    .unwrap()
+                    .is_none()
+            );
+            assert!(
+                insert(&mut heap, root, OTHER, key, value(1), Insert::PutNew, 0)
+                    .unwrap()
+                    .is_none()
+            );
+
+            let (replaced, added) = insert(&mut heap, root, OTHER, key, value(1), Insert::Put, 0)
+                .unwrap()
+                .unwrap();
+
+            assert!(!added);
+            assert_eq!(get(replaced, OTHER, key), Some(value(1)));
+            assert_eq!(get(root, OTHER, key), Some(value(0)));
+        }
+
+        #[test]
+        fn allocates_at_most_need_in_words_to_insert() {
+            let mut heap = heap();
+            let mut root = trie(&mut heap, &[]);
+
+            for i in 0..200 {
+                let hash = hash_key(fixnum!(i));
+                let need = need_in_words_to_insert(root, hash, fixnum!(i), 0);
+                let (inserted, _) =
+                    insert(&mut heap, root, hash, fixnum!(i), value(i), Insert::Put, 0)
+                        .unwrap()
+                        .unwrap();
+
+                assert!(words_not_shared(inserted, root) <= need);
+
+                root = inserted;
+            }
+        }
+    }
+
+    mod remove {
+        use super::*;
+
+        #[test]
+        fn with_collision_node_of_two_moves_the_other_key_into_the_root() {
+            let mut heap = heap();
+            let root = trie(&mut heap, &[(0, COLLIDING), (1, COLLIDING), (2, OTHER)]);
+
+            let removed = remove(&mut heap, root, COLLIDING, fixnum!(0), 0).unwrap();
+
+            let node = node_elements(removed);
+            assert_eq!(bitmaps(node), (bit(COLLIDING, 0) | bit(OTHER, 0), 0));
+            assert_eq!(get(removed, COLLIDING, fixnum!(0)), None);
+            assert_eq!(get(removed, COLLIDING, fixnum!(1)), Some(value(1)));
+            assert_eq!(get(removed, OTHER, fixnum!(2)), Some(value(2)));
+        }
+
+        #[test]
+        fn with_larger_collision_node_keeps_it() {
+            let mut heap = heap();
+            let root = trie(&mut heap, &[(0, COLLIDING), (1, COLLIDING), (2, COLLIDING)]);
+
+            let removed = remove(&mut heap, root, COLLIDING, fixnum!(1), 0).unwrap();
+
+            assert_eq!(
+                &collision_node(removed, COLLIDING)[2..],
+                &[fixnum!(0), value(0), fixnum!(2), value(2)]
+            );
+        }
+
+        #[test]
+        fn with_pair_below_a_path_collapses_the_path() {
+            let mut heap = heap();
+            let first = hash(&[1, 2, 3]);
+            let second = hash(&[1, 2, 4]);
+            let root = trie(&mut heap, &[(0, first), (1, second), (2, OTHER)]);
+
+            let path = node_elements(node_elements(root)[4]);
+            assert_eq!(bitmaps(path), (0, 1 << 2));
+
+            let removed = remove(&mut heap, root, second, fixnum!(1), 0).unwrap();
+
+            let node = node_elements(removed);
+            assert_eq!(bitmaps(node), (1 << 1 | bit(OTHER, 0), 0));
+            assert_eq!(&node[2..], &[fixnum!(0), value(0), fixnum!(2), value(2)]);
+        }
+
+        #[test]
+        fn allocates_at_most_need_in_words_to_remove() {
+            let mut heap = heap();
+            let first = hash(&[1, 2, 3]);
+            let root = trie(
+                &mut heap,
+                &[
+                    (0, first),
+                    (1, hash(&[1, 2, 4])),
+                    (2, COLLIDING),
+                    (3, COLLIDING),
+                    (4, OTHER),
+                ],
+            );
+
+            for (i, hash) in &[(0, first), (2, COLLIDING), (4, OTHER)] {
+                let need = need_in_words_to_remove(root, *hash);
+                let removed = remove(&mut heap, root, *hash, fixnum!(*i), 0).unwrap();
+
+                assert!(words_not_shared(removed, root) <= need);
+            }
+        }
+    }
+
+    mod build {
+        use super::*;
+
+        #[test]
+        fn allocates_need_in_words_to_build() {
+            let mut heap = heap();
+            let mut entries: Vec<Entry> = (0..100)
+                .map(|i| Entry::new(fixnum!(i), value(i)))
+                .chain((100..103).map(|i| entry(i, COLLIDING)))
+                .collect();
+            entries.sort_by_key(|entry| entry.hash);
+
+            let root = build(&mut heap, &entries, 0).unwrap();
+
+            assert_eq!(
+                words_not_shared(root, trie(&mut heap, &[])),
+                need_in_words_to_build(&entries, 0)
+            );
+            for entry in &entries {
+                assert_eq!(get(root, entry.hash, entry.key), Some(entry.value));
+            }
+        }
+    }
+
+    /// Builds a trie of the keys given along with the hashes to place them by
+    fn trie(heap: &mut RegionHeap, keys: &[(usize, u64)]) -> Term {
+        let mut entries: Vec<Entry> = keys.iter().map(|(i, hash)| entry(*i, *hash)).collect();
+        entries.sort_by_key(|entry| entry.hash);
+
+        build(heap, &entries, 0).unwrap()
+    }
+
+    fn entry(i: usize, hash: u64) -> Entry {
+        Entry {
+            hash,
+            key: fixnum!(i),
+            value: value(i),
+        }
+    }
+
+    fn value(i: usize) -> Term {
+        fixnum!(i + 1000)
+    }
+
+    /// Returns the hash starting with `fragments`, followed by zeros
+    fn hash(fragments: &[u64]) -> u64 {
+        fragments
+            .iter()
+            .enumerate()
+            .fold(0, |hash, (depth, fragment)| {
+                hash | fragment << (64 - BITS as usize * (depth + 1))
+            })
+    }
+
+    /// Follows the children from `root` along `hash` down to its collision node
+    fn collision_node(root: Term, hash: u64) -> &'static [Term] {
+        let mut node = node_elements(root);
+
+        for depth in 0..MAX_DEPTH {
+            let (datamap, nodemap) = bitmaps(node);
+            let bit = bit(hash, depth);
+            assert_eq!(datamap & bit, 0);
+            assert_ne!(nodemap & bit, 0);
+
+            node = node_elements(node[child_index(node, nodemap, bit)]);
+        }
+
+        node
+    }
+
+    /// The number of words taken by the nodes of the trie rooted at `root` which aren't
+    /// shared with the trie rooted at `other`, i.e. those allocated to make it from `other`
+    fn words_not_shared(root: Term, other: Term) -> usize {
+        let shared = nodes(other);
+
+        nodes(root)
+            .into_iter()
+            .filter(|node| !shared.contains(node))
+            .map(|node| tuple_words(node_elements(node).len()))
+            .sum()
+    }
+
+    fn nodes(root: Term) -> Vec<Term> {
+        let (_, children) = split(node_elements(root));
+        let mut nodes = vec![root];
+        for child in children {
+            nodes.extend(self::nodes(*child));
+        }
+
+        nodes
+    }
+
+    fn heap() -> RegionHeap {
+        let layout =
+            Layout::from_size_align(64 * 1024 * mem::size_of::<Term>(), MIN_ALIGN).unwrap();
+
+        RegionHeap::new(layout)
+    }
+}
@@ -26,6 +26,8 @@
 #![feature(unwind_attributes)]
 #![feature(slice_ptr_len)]
 #![feature(nonnull_slice_from_raw_parts)]
+// Support benchmarks
+#![feature(test)]
 
 #[cfg_attr(not(test), macro_use)]
 extern crate alloc;
@@ -65,7 +67,7 @@ pub use self::segmented_alloc::SegmentedAlloc;
 
 // An allocator that manages buckets of slab allocators as a highly efficient
 // means of managing allocations with fixed sizes
-pub use self::size_class_alloc::{SizeClassAlloc, SizeClassAllocRef};
+pub use self::size_class_alloc::{MagazineStats, SizeClassAlloc, SizeClassAllocRef};
 
 // Runtime system support, e.g. process heaps, etc.
 pub use erts::*;
@@ -1,3 +1,5 @@
+mod magazine;
+
 use core::cmp;
 use core::intrinsics::unlikely;
 use core::ptr::{self, NonNull};
@@ -13,10 +15,17 @@ use liblumen_core::alloc::mmap;
 use liblumen_core::alloc::prelude::*;
 use liblumen_core::alloc::size_classes::{SizeClass, SizeClassIndex};
 use liblumen_core::locks::RwLock;
+#[cfg(not(target_arch = "wasm32"))]
+use log::{debug, log_enabled, Level};
 
 use crate::blocks::ThreadSafeBlockBitSubset;
 use crate::carriers::{superalign_down, SUPERALIGNED_CARRIER_SIZE};
 use crate::carriers::{SlabCarrier, SlabCarrierList};
+#[cfg(target_arch = "wasm32")]
+use crate::stats::hooks;
+
+pub use self::magazine::MagazineStats;
+use self::magazine::Magazines;
 
 #[derive(Clone)]
 pub struct SizeClassAllocRef(Arc<SizeClassAlloc>);
@@ -46,6 +55,7 @@ pub struct SizeClassAlloc {
     max_size_class: SizeClass,
     size_classes: Box<[SizeClass]>,
     carriers: Box<[RwLock<SlabCarrierList>]>,
+    magazines: Magazines,
 }
 impl SizeClassAlloc {
     pub fn can_fit_multiple_blocks(size_class: &SizeClass) -> bool {
@@ -75,11 +85,16 @@ impl SizeClassAlloc {
             list.push_front(unsafe { UnsafeRef::from_raw(slab) });
             carriers.push(RwLock::new(list));
         }
+        let block_sizes = size_classes
+            .iter()
+            .map(|size_class| size_class.to_bytes())
+            .collect::<Vec<_>>();
         let size_classes = size_classes.to_vec();
         Self {
             max_size_class,
             size_classes: size_classes.into_boxed_slice(),
             carriers: carriers.into_boxed_slice(),
+            magazines: Magazines::new(&block_sizes),
         }
     }
 
@@ -89,6 +104,12 @@ impl SizeClassAlloc {
         self.max_size_class.to_bytes()
     }
 
+    /// Returns a snapshot of how often allocations are satisfied by the per-thread
+    /// magazines, rather than the shared carriers
+    pub fn magazine_stats(&self) -> MagazineStats {
+        self.magazines.stats()
+    }
+
     pub unsafe fn allocate(&self, layout: Layout) -> Result<NonNull<[u8]>, AllocError> {
         // Ensure allocated region has enough space for carrier header and aligned block
         let size = layout.size();
@@ -97,6 +118,40 @@ impl SizeClassAlloc {
         }
         let (index, size_class) =
             binary_search_next_largest(&self.size_classes, |sc| sc.to_bytes().cmp(&size)).unwrap();
+        let block_size = size_class.to_bytes();
+
+        // Try the magazine of this thread first, refilling it in a batch under a single
+        // acquisition of the carrier list lock when it is empty
+        if let Some(mut magazines) = self.magazines.acquire() {
+            let block = magazines.pop(index).or_else(|| {
+                let carriers = self.carriers[index].read();
+                let mut carriers = carriers.iter().peekable();
+                let refilled = magazines.refill(index, || {
+                    while let Some(carrier) = carriers.peek() {
+                        if let Ok(data) = carrier.alloc_block() {
+                            return Some(data);
+                        }
+                        carriers.next();
+                    }
+                    None
+                });
+                refilled
+            });
+            if let Some(data) = block {
+                return Ok(NonNull::slice_from_raw_parts(data, block_size));
+            }
+        }
+
+        self.allocate_from_carriers(index, size_class)
+    }
+
+    /// Allocates a block of the size class at `index` directly from the carriers,
+    /// creating a new carrier if they are all full
+    unsafe fn allocate_from_carriers(
+        &self,
+        index: usize,
+        size_class: &SizeClass,
+    ) -> Result<NonNull<[u8]>, AllocError> {
         let carriers = self.carriers[index].read();
         for carrier in carriers.iter() {
             if let Ok(data) = carrier.alloc_block() {
@@ -149,14 +204,82 @@ impl SizeClassAlloc {
     }
 
     pub unsafe fn deallocate(&self, ptr: NonNull<u8>, _layout: Layout) {
-        // Locate the owning carrier and deallocate with it
-        let raw = ptr.as_ptr();
+        // Keep the block in the magazine of this thread for its next allocation. The
+        // size class is taken from the owning carrier, rather than the layout, as a
+        // block may have been resized within its size class
+        if let Some(mut magazines) = self.magazines.acquire() {
+            let block_size = Self::carrier_for(ptr).block_size();
+            let index = self.index_for_block_size(block_size);
+            let mut flushed = false;
+            magazines.push(index, ptr, |block| {
+                Self::free_block(block);
+                flushed = true;
+            });
+            if unlikely(flushed) {
+                drop(magazines);
+                self.report_flush(block_size);
+            }
+            return;
+        }
+
+        Self::free_block(ptr);
+    }
+
+    /// Reports the magazine hit rate to the stats hooks after a magazine was flushed
+    #[cfg(target_arch = "wasm32")]
+    #[cold]
+    fn report_flush(&self, block_size: usize) {
+        let stats = self.magazines.stats();
+        hooks::on_magazine_flush(
+            "SizeClassAlloc".to_owned(),
+            block_size,
+            stats.hits,
+            stats.misses,
+        );
+    }
+
+    /// Logs the magazine hit rate after a magazine was flushed
+    ///
+    /// Scanning the stats of every slot isn't free, so it is only done when the
+    /// message would actually be logged
+    #[cfg(not(target_arch = "wasm32"))]
+    #[cold]
+    fn report_flush(&self, block_size: usize) {
+        if log_enabled!(Level::Debug) {
+            let stats = self.magazines.stats();
+            debug!(
+                "SizeClassAlloc flushed magazine of {} byte blocks, hit rate = {:.2}% ({} hits, {} misses)",
+                block_size,
+                stats.hit_rate() * 100.0,
+                stats.hits,
+                stats.misses
+            );
+        }
+    }
+
+    /// Returns a block to its owning carrier, regardless of which thread allocated it
+    #[inline]
+    unsafe fn free_block(ptr: NonNull<u8>) {
+        Self::carrier_for(ptr).free_block(ptr.as_ptr());
+    }
+
+    /// Locates the carrier which owns the given block
+    #[inline]
+    unsafe fn carrier_for<'a>(
+        ptr: NonNull<u8>,
+    ) -> &'a SlabCarrier<LinkedListLink, ThreadSafeBlockBitSubset> {
         // Since the slabs are super-aligned, we can mask off the low
         // bits of the given pointer to find our carrier
-        let carrier_ptr = superalign_down(raw as usize)
-            as *mut SlabCarrier<LinkedListLink, ThreadSafeBlockBitSubset>;
-        let carrier = &mut *carrier_ptr;
-        carrier.free_block(raw);
+        let carrier_ptr = superalign_down(ptr.as_ptr() as usize)
+            as *const SlabCarrier<LinkedListLink, ThreadSafeBlockBitSubset>;
+        &*carrier_ptr
+    }
+
+    #[inline]
+    fn index_for_block_size(&self, block_size: usize) -> usize {
+        binary_search_next_largest(&self.size_classes, |sc| sc.to_bytes().cmp(&block_size))
+            .map(|(index, _)| index)
+            .unwrap()
     }
 
     /// Creates a new, empty slab carrier, unlinked to the allocator
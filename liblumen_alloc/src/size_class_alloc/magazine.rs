@@ -0,0 +1,384 @@
+use core::fmt;
+use core::ptr::NonNull;
+use core::sync::atomic::{AtomicUsize, Ordering};
+
+#[cfg(not(test))]
+use alloc::boxed::Box;
+#[cfg(not(test))]
+use alloc::vec::Vec;
+
+use liblumen_core::locks::{SpinLock, SpinLockGuard};
+use liblumen_core::util::cache_padded::CachePadded;
+
+/// The number of magazine slots in each allocator
+///
+/// Each thread is assigned a slot the first time it allocates, if there are more threads
+/// than slots, threads will share a slot, and bypass the magazines when the slot is in
+/// use by another thread.
+const NUM_SLOTS: usize = 64;
+
+/// The maximum number of free blocks kept in a magazine
+const MAX_MAGAZINE_BLOCKS: usize = 32;
+
+/// The maximum number of bytes of free blocks kept in a magazine, so that fewer blocks
+/// of the larger size classes are held back from other threads
+const MAX_MAGAZINE_BYTES: usize = 256 * 1024;
+
+#[thread_local]
+static mut THREAD_SLOT: usize = usize::max_value();
+
+static NEXT_THREAD_SLOT: AtomicUsize = AtomicUsize::new(0);
+
+/// Per-thread caches of free blocks for each size class of a `SizeClassAlloc`
+///
+/// Allocating and freeing through a magazine takes no shared lock, and touches no
+/// memory shared with other threads. Magazines are refilled from, and flushed to,
+/// the shared slab carriers in batches of half their capacity, so that a thread
+/// alternating between allocating and freeing doesn't go to the carriers every time.
+pub struct Magazines {
+    slots: Box<[CachePadded<Slot>]>,
+}
+impl Magazines {
+    /// Creates empty magazines for size classes of the given sizes, in bytes
+    pub fn new(block_sizes: &[usize]) -> Self {
+        let slots = (0..NUM_SLOTS)
+            .map(|_| CachePadded::new(Slot::new(block_sizes)))
+            .collect::<Vec<_>>();
+
+        Self {
+            slots: slots.into_boxed_slice(),
+        }
+    }
+
+    /// Acquires the magazines of the current thread, unless another thread sharing
+    /// its slot is using them
+    #[inline]
+    pub fn acquire(&self) -> Option<MagazinesGuard<'_>> {
+        let slot = &self.slots[thread_slot()];
+        let magazines = slot.magazines.try_lock()?;
+
+        Some(MagazinesGuard { slot, magazines })
+    }
+
+    /// Returns a snapshot of how well the magazines are working across all threads
+    pub fn stats(&self) -> MagazineStats {
+        self.slots
+            .iter()
+            .fold(MagazineStats::default(), |stats, slot| MagazineStats {
+                hits: stats.hits + slot.hits.load(Ordering::Relaxed),
+                misses: stats.misses + slot.misses.load(Ordering::Relaxed),
+                flushes: stats.flushes + slot.flushes.load(Ordering::Relaxed),
+            })
+    }
+}
+
+struct Slot {
+    magazines: SpinLock<Box<[Magazine]>>,
+    // These are only written by the thread holding the lock, but may be read at any time
+    hits: AtomicUsize,
+    misses: AtomicUsize,
+    flushes: AtomicUsize,
+}
+impl Slot {
+    fn new(block_sizes: &[usize]) -> Self {
+        let magazines = block_sizes
+            .iter()
+            .map(|block_size| Magazine::new(*block_size))
+            .collect::<Vec<_>>();
+
+        Self {
+            magazines: SpinLock::new(magazines.into_boxed_slice()),
+            hits: AtomicUsize::new(0),
+            misses: AtomicUsize::new(0),
+            flushes: AtomicUsize::new(0),
+        }
+    }
+
+    #[inline]
+    fn count(counter: &AtomicUsize) {
+        // Only the lock holder writes, so this doesn't need to be an atomic increment
+        counter.store(counter.load(Ordering::Relaxed) + 1, Ordering::Relaxed);
+    }
+}
+
+/// Exclusive access to the magazines of the current thread
+pub struct MagazinesGuard<'a> {
+    slot: &'a Slot,
+    magazines: SpinLockGuard<'a, Box<[Magazine]>>,
+}
+impl<'a> MagazinesGuard<'a> {
+    /// Takes a free block from the magazine of the size class at `index`, if it has one
+    #[inline]
+    pub fn pop(&mut self, index: usize) -> Option<NonNull<u8>> {
+        let block = self.magazines[index].blocks.pop();
+        match block {
+            Some(_) => Slot::count(&self.slot.hits),
+            None => Slot::count(&self.slot.misses),
+        }
+
+        block
+    }
+
+    /// Refills the empty magazine of the size class at `index` with a batch of blocks
+    /// from `alloc_block`, and takes one of them
+    ///
+    /// Returns `None` if `alloc_block` couldn't provide any blocks
+    pub fn refill<F>(&mut self, index: usize, mut alloc_block: F) -> Option<NonNull<u8>>
+    where
+        F: FnMut() -> Option<NonNull<u8>>,
+    {
+        let magazine = &mut self.magazines[index];
+        debug_assert!(magazine.blocks.is_empty());
+
+        for _ in 0..magazine.batch_size() {
+            match alloc_block() {
+                Some(block) => magazine.blocks.push(block),
+                None => break,
+            }
+        }
+
+        magazine.blocks.pop()
+    }
+
+    /// Puts a freed block in the magazine of the size class at `index`, first flushing
+    /// a batch of blocks to `free_block` if the magazine is full
+    pub fn push<F>(&mut self, index: usize, block: NonNull<u8>, mut free_block: F)
+    where
+        F: FnMut(NonNull<u8>),
+    {
+        let magazine = &mut self.magazines[index];
+
+        if magazine.blocks.len() == magazine.capacity {
+            let keep = magazine.capacity - magazine.batch_size();
+            for flushed in magazine.blocks.drain(keep..) {
+                free_block(flushed);
+            }
+            Slot::count(&self.slot.flushes);
+        }
+
+        magazine.blocks.push(block);
+    }
+}
+
+/// The free blocks of a single size class
+struct Magazine {
+    capacity: usize,
+    blocks: Vec<NonNull<u8>>,
+}
+impl Magazine {
+    fn new(block_size: usize) -> Self {
+        let capacity = (MAX_MAGAZINE_BYTES / block_size)
+            .max(1)
+            .min(MAX_MAGAZINE_BLOCKS);
+
+        Self {
+            capacity,
+            // The storage is allocated on first use, as most threads only ever use a few
+            // of the size classes
+            blocks: Vec::new(),
+        }
+    }
+
+    /// The number of blocks moved at once between the magazine and the carriers
+    #[inline]
+    fn batch_size(&self) -> usize {
+        (self.capacity / 2).max(1)
+    }
+}
+
+// The blocks are owned by the allocator, and only accessed under the slot lock
+unsafe impl Send for Magazine {}
+
+#[inline]
+fn thread_slot() -> usize {
+    unsafe {
+        if THREAD_SLOT == usize::max_value() {
+            THREAD_SLOT = NEXT_THREAD_SLOT.fetch_add(1, Ordering::Relaxed) % NUM_SLOTS;
+        }
+
+        THREAD_SLOT
+    }
+}
+
+/// A snapshot of magazine usage in a `SizeClassAlloc`
+#[derive(Debug, Default, Clone, Copy)]
+pub struct MagazineStats {
+    /// The number of allocations satisfied from a magazine
+    pub hits: usize,
+    /// The number of allocations which had to refill their magazine
+    pub misses: usize,
+    /// The number of times a full magazine was flushed back to the carriers
+    pub flushes: usize,
+}
+impl MagazineStats {
+    /// The fraction of allocations satisfied from a magazine
+    pub fn hit_rate(&self) -> f64 {
+        let total = self.hits + self.misses;
+        if total == 0 {
+            0.0
+        } else {
+            self.hits as f64 / total as f64
+        }
+    }
+}
+impl fmt::Display for MagazineStats {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        writeln!(f, "# Magazine Hits = {}", self.hits)?;
+        writeln!(f, "# Magazine Misses = {}", self.misses)?;
+        writeln!(f, "# Magazine Hit Rate = {:.2}%", self.hit_rate() * 100.0)?;
+        writeln!(f, "# Magazine Flushes = {}", self.flushes)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use std::collections::HashSet;
+    use std::sync::Arc;
+    use std::thread;
+
+    /// Magazines of this block size hold 32 blocks, and move 16 at a time
+    const BLOCK_SIZE: usize = 8;
+    const CAPACITY: usize = MAX_MAGAZINE_BLOCKS;
+    const BATCH_SIZE: usize = CAPACITY / 2;
+
+    #[test]
+    fn magazine_capacity_is_bounded_by_bytes() {
+        assert_eq!(Magazine::new(BLOCK_SIZE).capacity, CAPACITY);
+        assert_eq!(Magazine::new(MAX_MAGAZINE_BYTES / 4).capacity, 4);
+        assert_eq!(Magazine::new(MAX_MAGAZINE_BYTES * 2).capacity, 1);
+        assert_eq!(Magazine::new(MAX_MAGAZINE_BYTES * 2).batch_size(), 1);
+    }
+
+    #[test]
+    fn refill_takes_a_batch() {
+        let magazines = Magazines::new(&[BLOCK_SIZE]);
+        let mut carrier = fake_blocks(CAPACITY * 2);
+        let mut guard = magazines.acquire().unwrap();
+
+        assert_eq!(guard.pop(0), None);
+        assert!(guard.refill(0, || carrier.pop()).is_some());
+        assert_eq!(carrier.len(), CAPACITY * 2 - BATCH_SIZE);
+
+        for _ in 1..BATCH_SIZE {
+            assert!(guard.pop(0).is_some());
+        }
+        assert_eq!(guard.pop(0), None);
+        drop(guard);
+
+        let stats = magazines.stats();
+        assert_eq!(stats.hits, BATCH_SIZE - 1);
+        assert_eq!(stats.misses, 2);
+        assert_eq!(stats.flushes, 0);
+    }
+
+    #[test]
+    fn refill_takes_what_is_left() {
+        let magazines = Magazines::new(&[BLOCK_SIZE]);
+        let mut carrier = fake_blocks(3);
+        let mut guard = magazines.acquire().unwrap();
+
+        assert!(guard.refill(0, || carrier.pop()).is_some());
+        assert!(carrier.is_empty());
+        assert!(guard.pop(0).is_some());
+        assert!(guard.pop(0).is_some());
+        assert_eq!(guard.pop(0), None);
+
+        assert_eq!(guard.refill(0, || carrier.pop()), None);
+    }
+
+    #[test]
+    fn push_flushes_a_batch_when_full() {
+        let magazines = Magazines::new(&[BLOCK_SIZE]);
+        let blocks = fake_blocks(CAPACITY + 1);
+        let mut flushed = Vec::new();
+        let mut guard = magazines.acquire().unwrap();
+
+        for block in blocks.iter().copied() {
+            guard.push(0, block, |block| flushed.push(block));
+        }
+
+        // The top half of the full magazine is flushed before the new block is pushed
+        assert_eq!(&flushed[..], &blocks[CAPACITY - BATCH_SIZE..CAPACITY]);
+        assert_eq!(guard.pop(0), Some(blocks[CAPACITY]));
+        for _ in 1..(CAPACITY - BATCH_SIZE + 1) {
+            assert!(guard.pop(0).is_some());
+        }
+        assert_eq!(guard.pop(0), None);
+        drop(guard);
+
+        assert_eq!(magazines.stats().flushes, 1);
+    }
+
+    #[test]
+    fn blocks_freed_on_another_thread_are_kept_there() {
+        let magazines = Arc::new(Magazines::new(&[BLOCK_SIZE]));
+        let carrier = fake_blocks(CAPACITY + BATCH_SIZE);
+        // Blocks cross threads as addresses, as `NonNull` isn't `Send`
+        let addresses = carrier
+            .iter()
+            .map(|block| block.as_ptr() as usize)
+            .collect::<Vec<_>>();
+
+        // Takes every block, three full batches, leaving the magazine empty
+        let allocated = {
+            let magazines = magazines.clone();
+            let mut carrier = carrier.clone();
+            thread::spawn(move || {
+                let mut guard = magazines.acquire().unwrap();
+                let mut allocated = Vec::new();
+                while let Some(block) = guard.pop(0).or_else(|| guard.refill(0, || carrier.pop())) {
+                    allocated.push(block.as_ptr() as usize);
+                }
+                allocated
+            })
+            .join()
+            .unwrap()
+        };
+        assert_eq!(allocated.len(), addresses.len());
+
+        // Frees every block, flushing the batch which doesn't fit, then allocates
+        // from what was kept
+        let (flushed, reused) = {
+            let magazines = magazines.clone();
+            thread::spawn(move || {
+                let mut guard = magazines.acquire().unwrap();
+                let mut flushed = Vec::new();
+                for address in allocated {
+                    let block = NonNull::new(address as *mut u8).unwrap();
+                    guard.push(0, block, |block| flushed.push(block.as_ptr() as usize));
+                }
+                let mut reused = Vec::new();
+                while let Some(block) = guard.pop(0) {
+                    reused.push(block.as_ptr() as usize);
+                }
+                (flushed, reused)
+            })
+            .join()
+            .unwrap()
+        };
+        assert_eq!(flushed.len(), BATCH_SIZE);
+        assert_eq!(reused.len(), CAPACITY);
+
+        // Every block ends up either back in the carriers, or reused, exactly once
+        let mut seen = HashSet::new();
+        for address in flushed.iter().chain(reused.iter()) {
+            assert!(addresses.contains(address));
+            assert!(seen.insert(*address));
+        }
+
+        let stats = magazines.stats();
+        assert_eq!(stats.flushes, 1);
+        assert_eq!(stats.hits, addresses.len() - 3 + CAPACITY);
+    }
+
+    /// Returns distinct, suitably aligned addresses to stand in for blocks
+    ///
+    /// The magazines never dereference the blocks, so these are never backed by memory
+    fn fake_blocks(count: usize) -> Vec<NonNull<u8>> {
+        (1..=count)
+            .map(|i| NonNull::new((i * BLOCK_SIZE) as *mut u8).unwrap())
+            .collect()
+    }
+}
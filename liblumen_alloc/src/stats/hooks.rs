@@ -20,6 +20,9 @@ mod internal {
 
         #[wasm_bindgen(js_namespace = LumenStatsAlloc)]
         pub fn on_dealloc(tag: String, size: usize, align: usize, ptr: *mut u8);
+
+        #[wasm_bindgen(js_namespace = LumenStatsAlloc)]
+        pub fn on_magazine_flush(tag: String, size: usize, hits: usize, misses: usize);
     }
 }
 
@@ -41,6 +44,8 @@ mod internal {
     }
 
     pub fn on_dealloc(_tag: String, _size: usize, _align: usize, _ptr: *mut u8) {}
+
+    pub fn on_magazine_flush(_tag: String, _size: usize, _hits: usize, _misses: usize) {}
 }
 
 pub use internal::*;
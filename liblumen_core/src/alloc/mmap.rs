@@ -80,6 +80,22 @@ pub unsafe fn remap(
     .map(|ptr| ptr.cast())
 }
 
+/// Releases the physical memory backing part of a mapping, which is committed again
+/// when next accessed
+#[cfg(has_mmap)]
+#[inline]
+pub unsafe fn decommit(ptr: *mut u8, size: usize) {
+    mmap::decommit(ptr, size);
+}
+
+/// Releases the physical memory backing part of a mapping, which is committed again
+/// when next accessed
+///
+/// NOTE: This is a fallback implementation, the memory is not released
+#[cfg(not(has_mmap))]
+#[inline]
+pub unsafe fn decommit(_ptr: *mut u8, _size: usize) {}
+
 /// Destroys a mapping given a pointer to the mapping and the layout which created it
 #[cfg(has_mmap)]
 #[inline]
@@ -1,18 +1,292 @@
-/// This struct represents the serialized form of an atom table entry
+use core_alloc::vec::Vec;
+
+use core::slice;
+use core::str;
+
+/// This struct represents the serialized form of the atom table
 ///
 /// Constant atoms found during compilation are serialized into a static
-/// atom table which seeds the runtime atom table during initialization,
-/// in order to connect the values of those constant atoms to the runtime
-/// table entries, we serialize both the string value and the id, so that
-/// constant usages can be replaced with a constant term value, and the
-/// atom table will reflect the same data (i.e. the id matches the string)
+/// atom table image, which the runtime uses in place. Constant usages of
+/// atoms are replaced with a constant term value, so the image maps both
+/// ways between the id used in term form and the string value of each atom:
+///
+/// - `names` is indexed by id, so getting the name of an atom is a single load.
+/// Ids are assigned by the compiler's interner, so the array may contain holes,
+/// which are represented by an entry with a null pointer.
+/// - `displacements` and `slots` form a minimal perfect hash from name to id, see
+/// `AtomIndex::get_id` for how a lookup is performed.
+#[repr(C)]
+pub struct AtomIndex {
+    /// The seed used when hashing atom names
+    pub seed: u64,
+    /// The number of entries in `names`, this is one greater than the largest id
+    pub names_len: usize,
+    /// The name of each atom, indexed by id
+    pub names: *const AtomName,
+    /// The number of entries in `displacements`
+    pub displacements_len: usize,
+    /// The displacement for each hash bucket
+    pub displacements: *const AtomDisplacement,
+    /// The number of entries in `slots`, this is the number of atoms in the image
+    pub slots_len: usize,
+    /// The id of the atom stored in each slot of the perfect hash
+    pub slots: *const u32,
+}
+impl AtomIndex {
+    /// Returns the name of the atom with the given id, if it is part of this image
+    #[inline]
+    pub fn get_name(&self, id: usize) -> Option<&'static str> {
+        if id >= self.names_len {
+            return None;
+        }
+        let name = unsafe { &*self.names.add(id) };
+        if name.value.is_null() {
+            return None;
+        }
+        // This is safe because the names were valid strings in the compiler
+        // and the underlying data is static
+        unsafe {
+            let bytes = slice::from_raw_parts(name.value as *const u8, name.len);
+            Some(str::from_utf8_unchecked(bytes))
+        }
+    }
+
+    /// Returns the id of the atom with the given name, if it is part of this image
+    ///
+    /// This hashes the name once, uses the hash to select the displacement of its
+    /// bucket, and combines the two to obtain the only slot the name can occupy.
+    /// The name of the atom in that slot is then compared against the one given.
+    #[inline]
+    pub fn get_id(&self, name: &str) -> Option<usize> {
+        if self.slots_len == 0 {
+            return None;
+        }
+        let hashes = AtomHashes::new(self.seed, name);
+        let bucket = (hashes.g as usize) % self.displacements_len;
+        let displacement = unsafe { &*self.displacements.add(bucket) };
+        let slot = (hashes.displace(displacement) as usize) % self.slots_len;
+        let id = unsafe { *self.slots.add(slot) } as usize;
+        match self.get_name(id) {
+            Some(existing) if existing == name => Some(id),
+            _ => None,
+        }
+    }
+
+    /// Returns an iterator over the ids and names of the atoms in this image
+    pub fn iter(&self) -> impl Iterator<Item = (usize, &'static str)> + '_ {
+        (0..self.names_len).filter_map(move |id| self.get_name(id).map(|name| (id, name)))
+    }
+}
+
+// These are safe to implement because the image is immutable and static
+unsafe impl Sync for AtomIndex {}
+unsafe impl Send for AtomIndex {}
+
+/// This struct represents the serialized form of an atom name in the atom table image
 #[repr(C)]
-pub struct ConstantAtom {
-    // The id of the atom, which will be used as the id in term form
-    pub id: usize,
-    // The string value of the atom.
+pub struct AtomName {
+    // The string value of the atom, or null if no atom has this id.
     //
     // We use i8 here, which is equivalent to libc::c_char, but libc
     // is not universally available in this crate, so we use the former
     pub value: *const i8,
+    // The length of the string value in bytes
+    pub len: usize,
+}
+
+/// The displacement applied to the hashes of all names that fall in a given bucket
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct AtomDisplacement {
+    pub d1: u32,
+    pub d2: u32,
+}
+
+/// The hashes of an atom name used by the perfect hash
+///
+/// `g` selects the bucket, while `f1` and `f2` are combined with the displacement
+/// of that bucket to select a slot, this is the "hash and displace" scheme, which
+/// lets each bucket be placed by searching for a displacement rather than rehashing.
+#[derive(Debug, Clone, Copy)]
+pub struct AtomHashes {
+    pub g: u32,
+    pub f1: u32,
+    pub f2: u32,
+}
+impl AtomHashes {
+    #[inline]
+    pub fn new(seed: u64, name: &str) -> Self {
+        // FNV-1a, followed by a finalizer to spread the bits of short names
+        let mut h = 0xcbf2_9ce4_8422_2325u64 ^ seed;
+        for byte in name.as_bytes() {
+            h ^= *byte as u64;
+            h = h.wrapping_mul(0x0000_0100_0000_01b3);
+        }
+        let h1 = mix(h);
+        let h2 = mix(h1);
+        Self {
+            g: (h1 >> 32) as u32,
+            f1: h1 as u32,
+            f2: h2 as u32,
+        }
+    }
+
+    #[inline]
+    pub fn displace(&self, displacement: &AtomDisplacement) -> u32 {
+        displacement
+            .d2
+            .wrapping_add(self.f1.wrapping_mul(displacement.d1))
+            .wrapping_add(self.f2)
+    }
+}
+
+#[inline]
+fn mix(mut h: u64) -> u64 {
+    h = (h ^ (h >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+    h = (h ^ (h >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+    h ^ (h >> 31)
+}
+
+/// The perfect hash portion of an atom table image, as constructed by the compiler
+pub struct AtomIndexBuilder {
+    pub seed: u64,
+    pub displacements: Vec<AtomDisplacement>,
+    /// The id of the atom stored in each slot
+    pub slots: Vec<u32>,
+}
+impl AtomIndexBuilder {
+    /// The average number of names per bucket
+    const LAMBDA: usize = 5;
+
+    /// Constructs a minimal perfect hash over the given (id, name) pairs
+    ///
+    /// The names must be unique
+    pub fn new(atoms: &[(usize, &str)]) -> Self {
+        let mut seed = 0;
+        loop {
+            if let Some(index) = Self::try_new(seed, atoms) {
+                return index;
+            }
+            seed += 1;
+        }
+    }
+
+    fn try_new(seed: u64, atoms: &[(usize, &str)]) -> Option<Self> {
+        let len = atoms.len();
+        if len == 0 {
+            return Some(Self {
+                seed,
+                displacements: Vec::new(),
+                slots: Vec::new(),
+            });
+        }
+
+        let hashes = atoms
+            .iter()
+            .map(|(_, name)| AtomHashes::new(seed, name))
+            .collect::<Vec<_>>();
+
+        let buckets_len = (len + Self::LAMBDA - 1) / Self::LAMBDA;
+        let mut buckets: Vec<(usize, Vec<usize>)> =
+            (0..buckets_len).map(|i| (i, Vec::new())).collect();
+        for (i, hash) in hashes.iter().enumerate() {
+            buckets[(hash.g as usize) % buckets_len].1.push(i);
+        }
+        // Place the largest buckets first, while there are the most free slots
+        buckets.sort_by(|a, b| b.1.len().cmp(&a.1.len()));
+
+        let mut displacements = vec![AtomDisplacement::default(); buckets_len];
+        let mut slots: Vec<Option<usize>> = vec![None; len];
+        // Tracks which slots have been claimed by the current attempt
+        let mut claimed: Vec<u64> = vec![0; len];
+        let mut generation = 0u64;
+        let mut placed = Vec::with_capacity(Self::LAMBDA);
+
+        'buckets: for (bucket, keys) in buckets.iter() {
+            for d1 in 0..(len as u32) {
+                'displacements: for d2 in 0..(len as u32) {
+                    let displacement = AtomDisplacement { d1, d2 };
+                    generation += 1;
+                    placed.clear();
+                    for key in keys.iter().copied() {
+                        let slot = (hashes[key].displace(&displacement) as usize) % len;
+                        if slots[slot].is_some() || claimed[slot] == generation {
+                            continue 'displacements;
+                        }
+                        claimed[slot] = generation;
+                        placed.push((slot, key));
+                    }
+                    for (slot, key) in placed.iter().copied() {
+                        slots[slot] = Some(key);
+                    }
+                    displacements[*bucket] = displacement;
+                    continue 'buckets;
+                }
+            }
+            return None;
+        }
+
+        let slots = slots
+            .into_iter()
+            .map(|key| atoms[key.unwrap()].0 as u32)
+            .collect();
+
+        Some(Self {
+            seed,
+            displacements,
+            slots,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn perfect_hash_finds_every_atom() {
+        let names = (0..1000)
+            .map(|i| format!("atom{}", i))
+            .collect::<Vec<String>>();
+        // Leave holes in the ids, as the compiler does
+        let atoms = names
+            .iter()
+            .enumerate()
+            .map(|(i, name)| (i * 2, name.as_str()))
+            .collect::<Vec<_>>();
+        let builder = AtomIndexBuilder::new(atoms.as_slice());
+
+        let names_len = atoms.last().unwrap().0 + 1;
+        let mut table = (0..names_len)
+            .map(|_| AtomName {
+                value: core::ptr::null(),
+                len: 0,
+            })
+            .collect::<Vec<_>>();
+        for (id, name) in atoms.iter() {
+            table[*id] = AtomName {
+                value: name.as_ptr() as *const i8,
+                len: name.len(),
+            };
+        }
+
+        let index = AtomIndex {
+            seed: builder.seed,
+            names_len,
+            names: table.as_ptr(),
+            displacements_len: builder.displacements.len(),
+            displacements: builder.displacements.as_ptr(),
+            slots_len: builder.slots.len(),
+            slots: builder.slots.as_ptr(),
+        };
+
+        for (id, name) in atoms.iter() {
+            assert_eq!(index.get_id(name), Some(*id));
+            assert_eq!(index.get_name(*id), Some(*name));
+        }
+        assert_eq!(index.get_id("not_an_atom"), None);
+        assert_eq!(index.get_name(1), None);
+        assert_eq!(index.get_name(names_len), None);
+        assert_eq!(index.iter().count(), atoms.len());
+    }
 }
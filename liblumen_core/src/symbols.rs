@@ -83,3 +83,23 @@ impl FunctionSymbol {
 // It is safe to do so, since the data is static and lives for the life of the program
 unsafe impl Sync for FunctionSymbol {}
 unsafe impl Send for FunctionSymbol {}
+
+/// This struct represents the serialized form of an entry in the module index
+/// of the symbol table
+///
+/// The symbol table is emitted by the compiler sorted by module, function and
+/// arity, so all of the symbols belonging to a module are contiguous. Each entry
+/// of the module index records where that range of symbols starts and how many
+/// there are, and the index itself is sorted by module, so that dispatch can
+/// find a function with two binary searches over static data, and nothing has to
+/// be built at startup.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct ModuleSymbols {
+    /// Module name atom
+    pub module: usize,
+    /// The index of the first symbol belonging to this module
+    pub offset: usize,
+    /// The number of symbols belonging to this module
+    pub len: usize,
+}
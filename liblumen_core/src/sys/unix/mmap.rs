@@ -153,9 +153,12 @@ unsafe fn commit(ptr: *mut u8, size: usize) {
     libc::madvise(ptr as *mut _, size, MADV_WILLNEED);
 }
 
-#[allow(unused)]
+/// Releases the physical memory backing a region of a mapping, without unmapping it
+///
+/// The contents of the region are undefined if it is accessed again, at which point it is
+/// committed again.
 #[inline(always)]
-unsafe fn decommit(ptr: *mut u8, size: usize) {
+pub unsafe fn decommit(ptr: *mut u8, size: usize) {
     // If unsupported, we may have to add conditional compilation to use MADV_DONTNEED instead
     libc::madvise(ptr as *mut _, size, MADV_FREE);
 }
@@ -0,0 +1,14 @@
+-module(init).
+-export([start/0]).
+-import(erlang, [display/1]).
+
+%% Small integer arithmetic which never overflows, so every operation stays on
+%% the inline fast path, including negative results.
+start() ->
+  display({sum, sum(0, 1000000), difference, difference(0, 1000000)}).
+
+sum(Acc, 0) -> Acc;
+sum(Acc, N) -> sum(Acc + N * 3 - N, N - 1).
+
+difference(Acc, 0) -> Acc;
+difference(Acc, N) -> difference(Acc - N, N - 1).
@@ -0,0 +1,63 @@
+#![feature(test)]
+
+//! Measures cross-scheduler wakeups by passing a token around a ring of processes.
+
+extern crate test;
+
+use std::process::{Command, Stdio};
+use std::sync::Once;
+
+use test::Bencher;
+
+#[bench]
+fn token_ring(b: &mut Bencher) {
+    ensure_compiled();
+
+    b.iter(|| {
+        let output = Command::new("benches/_build/run_queue_contention")
+            .stdin(Stdio::null())
+            .output()
+            .unwrap();
+
+        assert_eq!(
+            String::from_utf8_lossy(&output.stdout),
+            "done\n",
+            "\nstderr = {}",
+            String::from_utf8_lossy(&output.stderr)
+        );
+    });
+}
+
+static COMPILED: Once = Once::new();
+
+fn ensure_compiled() {
+    COMPILED.call_once(|| {
+        compile();
+    })
+}
+
+fn compile() {
+    std::fs::create_dir_all("benches/_build").unwrap();
+
+    let mut command = Command::new("../bin/lumen");
+
+    command
+        .arg("compile")
+        .arg("--output")
+        .arg("benches/_build/run_queue_contention")
+        // Turn off optimizations as work-around for debug info bug in EIR
+        .arg("-O0");
+
+    let compile_output = command
+        .arg("benches/run_queue_contention/init.erl")
+        .stdin(Stdio::null())
+        .output()
+        .unwrap();
+
+    assert!(
+        compile_output.status.success(),
+        "stdout = {}\nstderr = {}",
+        String::from_utf8_lossy(&compile_output.stdout),
+        String::from_utf8_lossy(&compile_output.stderr)
+    );
+}
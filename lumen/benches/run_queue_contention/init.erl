@@ -0,0 +1,34 @@
+-module(init).
+-export([start/0]).
+-import(erlang, [display/1]).
+
+%% Passes a token around a ring of processes, so each hop wakes a process which
+%% is usually owned by another scheduler, pushing it through that scheduler's
+%% injector queue, while idle schedulers try to steal.
+start() ->
+  First = ring(self(), 1000),
+  lap(First, 100),
+  display(done).
+
+ring(Next, 0) -> Next;
+ring(Next, N) -> ring(spawn(fun () -> forward(Next) end), N - 1).
+
+forward(Next) ->
+  receive
+    token ->
+      Next ! token,
+      forward(Next);
+    stop ->
+      Next ! stop
+  end.
+
+lap(First, 0) ->
+  First ! stop,
+  receive
+    stop -> ok
+  end;
+lap(First, N) ->
+  First ! token,
+  receive
+    token -> lap(First, N - 1)
+  end.
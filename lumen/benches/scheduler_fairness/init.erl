@@ -0,0 +1,48 @@
+-module(init).
+-export([start/0]).
+-import(erlang, [display/1]).
+
+%% Times message round trips while every scheduler is kept busy by processes
+%% which never wait, so the round trips only complete promptly if the busy
+%% processes are preempted when their reduction budget runs out.
+start() ->
+  Busy = spawn_busy(16, []),
+  Echo = spawn(fun echo/0),
+  ping(Echo, 1000),
+  stop([Echo | Busy]),
+  display(done).
+
+spawn_busy(0, Pids) -> Pids;
+spawn_busy(N, Pids) -> spawn_busy(N - 1, [spawn(fun busy/0) | Pids]).
+
+busy() ->
+  receive
+    stop -> ok
+  after 0 ->
+    spin(1000),
+    busy()
+  end.
+
+spin(0) -> ok;
+spin(N) -> spin(N - 1).
+
+echo() ->
+  receive
+    {ping, From} ->
+      From ! pong,
+      echo();
+    stop ->
+      ok
+  end.
+
+ping(_, 0) -> ok;
+ping(Echo, N) ->
+  Echo ! {ping, self()},
+  receive
+    pong -> ping(Echo, N - 1)
+  end.
+
+stop([]) -> ok;
+stop([Pid | Pids]) ->
+  Pid ! stop,
+  stop(Pids).
@@ -0,0 +1,63 @@
+#![feature(test)]
+
+//! Measures unwinding through the FDE cache from many scheduler threads at once.
+
+extern crate test;
+
+use std::process::{Command, Stdio};
+use std::sync::Once;
+
+use test::Bencher;
+
+#[bench]
+fn concurrent_throw_catch(b: &mut Bencher) {
+    ensure_compiled();
+
+    b.iter(|| {
+        let output = Command::new("benches/_build/throw_catch")
+            .stdin(Stdio::null())
+            .output()
+            .unwrap();
+
+        assert_eq!(
+            String::from_utf8_lossy(&output.stdout),
+            "done\n",
+            "\nstderr = {}",
+            String::from_utf8_lossy(&output.stderr)
+        );
+    });
+}
+
+static COMPILED: Once = Once::new();
+
+fn ensure_compiled() {
+    COMPILED.call_once(|| {
+        compile();
+    })
+}
+
+fn compile() {
+    std::fs::create_dir_all("benches/_build").unwrap();
+
+    let mut command = Command::new("../bin/lumen");
+
+    command
+        .arg("compile")
+        .arg("--output")
+        .arg("benches/_build/throw_catch")
+        // Turn off optimizations as work-around for debug info bug in EIR
+        .arg("-O0");
+
+    let compile_output = command
+        .arg("benches/throw_catch/init.erl")
+        .stdin(Stdio::null())
+        .output()
+        .unwrap();
+
+    assert!(
+        compile_output.status.success(),
+        "stdout = {}\nstderr = {}",
+        String::from_utf8_lossy(&compile_output.stdout),
+        String::from_utf8_lossy(&compile_output.stderr)
+    );
+}
@@ -0,0 +1,32 @@
+-module(init).
+-export([start/0]).
+-import(erlang, [display/1]).
+
+%% Throws through several frames to a catch in another function, on many
+%% processes at once, so the unwinder looks up the same FDEs from every
+%% scheduler thread.
+start() ->
+  spawn_catchers(self(), 16),
+  wait(16),
+  display(done).
+
+spawn_catchers(_, 0) -> ok;
+spawn_catchers(Parent, N) ->
+  spawn(fun () -> Parent ! catch_loop(1000) end),
+  spawn_catchers(Parent, N - 1).
+
+catch_loop(0) -> done;
+catch_loop(N) ->
+  try deep(10)
+  catch throw:bottom -> ok
+  end,
+  catch_loop(N - 1).
+
+deep(0) -> throw(bottom);
+deep(Depth) -> [deep(Depth - 1)].
+
+wait(0) -> ok;
+wait(N) ->
+  receive
+    done -> wait(N - 1)
+  end.
@@ -0,0 +1,32 @@
+-module(init).
+-export([start/0]).
+-import(erlang, [display/1]).
+
+start() ->
+  display(catch_throw()),
+  display(catch_error()),
+  display(catch_raise()),
+  display(catch_reraise()).
+
+catch_throw() ->
+  try throw(thrown)
+  catch throw:Reason -> {caught, throw, Reason}
+  end.
+
+catch_error() ->
+  try error(failed)
+  catch error:Reason -> {caught, error, Reason}
+  end.
+
+catch_raise() ->
+  try erlang:raise(exit, raised, [])
+  catch exit:Reason -> {caught, exit, Reason}
+  end.
+
+catch_reraise() ->
+  try
+    try error(inner)
+    catch error:Inner:Stacktrace -> erlang:raise(error, {reraised, Inner}, Stacktrace)
+    end
+  catch error:Reason -> {caught, error, Reason}
+  end.
@@ -0,0 +1,57 @@
+use std::process::{Command, Stdio};
+use std::sync::Once;
+
+#[test]
+fn without_arguments_matches_atom_keys_in_flatmaps_and_hamts() {
+    ensure_compiled();
+
+    let cli_output = Command::new("tests/_build/map_patterns")
+        .stdin(Stdio::null())
+        .output()
+        .unwrap();
+
+    let stdout = String::from_utf8_lossy(&cli_output.stdout);
+    let stderr = String::from_utf8_lossy(&cli_output.stderr);
+
+    assert_eq!(
+        String::from_utf8_lossy(&cli_output.stdout),
+        "{found, 1, 3}\n{found, 1, 3}\n{found, 1, 3}\n{101, 131}\n{101, 131}\nnot_found\nmissing\nmissing\n{one, two}\n",
+        "\nstdout = {}\nstderr = {}",
+        stdout,
+        stderr
+    );
+}
+
+static COMPILED: Once = Once::new();
+
+fn ensure_compiled() {
+    COMPILED.call_once(|| {
+        compile();
+    })
+}
+
+fn compile() {
+    std::fs::create_dir_all("tests/_build").unwrap();
+
+    let mut command = Command::new("../bin/lumen");
+
+    command
+        .arg("compile")
+        .arg("--output")
+        .arg("tests/_build/map_patterns")
+        // Turn off optimizations as work-around for debug info bug in EIR
+        .arg("-O0");
+
+    let compile_output = command
+        .arg("tests/map_patterns/init.erl")
+        .stdin(Stdio::null())
+        .output()
+        .unwrap();
+
+    assert!(
+        compile_output.status.success(),
+        "stdout = {}\nstderr = {}",
+        String::from_utf8_lossy(&compile_output.stdout),
+        String::from_utf8_lossy(&compile_output.stderr)
+    );
+}
@@ -0,0 +1,99 @@
+-module(init).
+-export([start/0]).
+-import(erlang, [display/1]).
+
+start() ->
+  Small = #{a => 1, b => 2, c => 3},
+  display(lookup(Small)),
+  display(lookup(large_literal())),
+  display(lookup(large(1, 3))),
+  display(first_and_last(large_literal())),
+  display(first_and_last(large(1, 3))),
+  display(lookup(#{b => 2})),
+  display(missing(large_literal())),
+  display(missing(large(1, 3))),
+  display(integer_key(#{1 => one, 2 => two})).
+
+% Constant atom keys are searched for inline in flatmaps, which hold at most
+% 32 entries, larger maps are HAMTs which are searched by the runtime
+lookup(#{a := A, c := C}) -> {found, A, C};
+lookup(_) -> not_found.
+
+first_and_last(#{k01 := First, k31 := Last}) -> {First, Last}.
+
+missing(#{missing := _}) -> found;
+missing(_) -> missing.
+
+integer_key(#{1 := One, 2 := Two}) -> {One, Two}.
+
+% 33 entries, built once by the runtime as a literal
+large_literal() ->
+  #{a => 1,
+    c => 3,
+    k01 => 101,
+    k02 => 102,
+    k03 => 103,
+    k04 => 104,
+    k05 => 105,
+    k06 => 106,
+    k07 => 107,
+    k08 => 108,
+    k09 => 109,
+    k10 => 110,
+    k11 => 111,
+    k12 => 112,
+    k13 => 113,
+    k14 => 114,
+    k15 => 115,
+    k16 => 116,
+    k17 => 117,
+    k18 => 118,
+    k19 => 119,
+    k20 => 120,
+    k21 => 121,
+    k22 => 122,
+    k23 => 123,
+    k24 => 124,
+    k25 => 125,
+    k26 => 126,
+    k27 => 127,
+    k28 => 128,
+    k29 => 129,
+    k30 => 130,
+    k31 => 131}.
+
+% 33 entries, built by inserting each entry
+large(A, C) ->
+  #{a => A,
+    c => C,
+    k01 => 101,
+    k02 => 102,
+    k03 => 103,
+    k04 => 104,
+    k05 => 105,
+    k06 => 106,
+    k07 => 107,
+    k08 => 108,
+    k09 => 109,
+    k10 => 110,
+    k11 => 111,
+    k12 => 112,
+    k13 => 113,
+    k14 => 114,
+    k15 => 115,
+    k16 => 116,
+    k17 => 117,
+    k18 => 118,
+    k19 => 119,
+    k20 => 120,
+    k21 => 121,
+    k22 => 122,
+    k23 => 123,
+    k24 => 124,
+    k25 => 125,
+    k26 => 126,
+    k27 => 127,
+    k28 => 128,
+    k29 => 129,
+    k30 => 130,
+    k31 => 131}.
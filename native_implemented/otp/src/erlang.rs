@@ -171,6 +171,7 @@ pub mod spawn_opt_4;
 pub mod split_binary_2;
 pub mod start_timer_3;
 pub mod start_timer_4;
+pub mod statistics_1;
 mod string_to_float;
 mod string_to_integer;
 pub mod subtract_2;
@@ -181,6 +182,7 @@ pub mod system_time_0;
 pub mod system_time_1;
 mod term_to_binary;
 pub mod term_to_binary_1;
+pub mod term_to_binary_2;
 pub mod throw_1;
 pub mod time_0;
 pub mod time_offset_0;
@@ -11,18 +11,29 @@ use liblumen_alloc::erts::process::Process;
 use liblumen_alloc::erts::term::prelude::*;
 
 use crate::binary::to_term::Options;
-use crate::runtime::distribution::external_term_format::{term, version};
+use crate::runtime::distribution::external_term_format::{term, version, Original};
 
 macro_rules! maybe_aligned_maybe_binary_try_into_term {
     ($process:expr, $options:expr, $binary:expr, $ident:expr) => {
         if $ident.is_binary() {
             if $ident.is_aligned() {
-                versioned_tagged_bytes_try_into_term($process, $options, unsafe {
-                    $ident.as_bytes_unchecked()
-                })
+                versioned_tagged_bytes_try_into_term(
+                    $process,
+                    $options,
+                    &Original::new($binary),
+                    unsafe { $ident.as_bytes_unchecked() },
+                )
             } else {
+                // Copied to a binary of its own, so that binaries in it can be subbinaries of it
                 let byte_vec: Vec<u8> = $ident.full_byte_iter().collect();
-                versioned_tagged_bytes_try_into_term($process, $options, &byte_vec)
+                let copy = $process.binary_from_bytes(&byte_vec);
+
+                versioned_tagged_bytes_try_into_term(
+                    $process,
+                    $options,
+                    &Original::new(copy),
+                    $process.bytes_from_binary(copy).unwrap(),
+                )
             }
         } else {
             Err(NotABinary)
@@ -40,15 +51,27 @@ pub fn result(process: &Process, binary: Term, options: Term) -> exception::Resu
     let options: Options = options.try_into()?;
 
     match binary.decode()? {
-        TypedTerm::HeapBinary(heap_binary) => {
-            versioned_tagged_bytes_try_into_term(process, &options, heap_binary.as_bytes())
-        }
+        TypedTerm::HeapBinary(heap_binary) => versioned_tagged_bytes_try_into_term(
+            process,
+            &options,
+            &Original::new(binary),
+            heap_binary.as_bytes(),
+        ),
+        TypedTerm::BinaryLiteral(binary_literal) => versioned_tagged_bytes_try_into_term(
+            process,
+            &options,
+            &Original::new(binary),
+            binary_literal.as_bytes(),
+        ),
         TypedTerm::MatchContext(match_context) => {
             maybe_aligned_maybe_binary_try_into_term!(process, &options, binary, match_context)
         }
-        TypedTerm::ProcBin(process_binary) => {
-            versioned_tagged_bytes_try_into_term(process, &options, process_binary.as_bytes())
-        }
+        TypedTerm::ProcBin(process_binary) => versioned_tagged_bytes_try_into_term(
+            process,
+            &options,
+            &Original::new(binary),
+            process_binary.as_bytes(),
+        ),
         TypedTerm::SubBinary(subbinary) => {
             maybe_aligned_maybe_binary_try_into_term!(process, &options, binary, subbinary)
         }
@@ -61,11 +84,12 @@ pub fn result(process: &Process, binary: Term, options: Term) -> exception::Resu
 fn versioned_tagged_bytes_try_into_term(
     process: &Process,
     options: &Options,
+    original: &Original,
     bytes: &[u8],
 ) -> exception::Result<Term> {
     let after_version_bytes = version::check(bytes)?;
     let (term, after_term_bytes) =
-        term::decode_tagged(process, options.existing, after_version_bytes)?;
+        term::decode(process, original, options.existing, after_version_bytes)?;
 
     let final_term = if options.used {
         let used_byte_len = bytes.len() - after_term_bytes.len();
@@ -2,10 +2,118 @@ mod with_safe;
 
 use proptest::strategy::Just;
 
+use liblumen_alloc::erts::process::alloc::Heap;
 use liblumen_alloc::erts::process::Process;
-use liblumen_alloc::erts::term::prelude::{Atom, Term};
+use liblumen_alloc::erts::term::prelude::{Atom, BinaryLiteral, Boxed, Encoded, Term, TypedTerm};
 
 use crate::erlang::binary_to_term_2::result;
-use crate::test::strategy;
+use crate::runtime::distribution::external_term_format::{term, Original};
+use crate::test::{strategy, with_process};
 
 // `with_used_with_binary_returns_how_many_bytes_were_consumed_along_with_term` in integration tests
+
+#[test]
+fn with_binary_larger_than_heap_binary_decodes_subbinary_of_binary() {
+    with_process(|process| {
+        let bytes = large_bytes();
+        let binary = process.binary_from_bytes(&binary_ext(&bytes));
+
+        let decoded = result(process, binary, Term::NIL).unwrap();
+
+        match decoded.decode().unwrap() {
+            TypedTerm::SubBinary(subbinary) => assert_eq!(subbinary.original(), binary),
+            typed_term => panic!("{:?} is not a subbinary", typed_term),
+        }
+        assert_eq!(decoded, process.binary_from_bytes(&bytes));
+    });
+}
+
+#[test]
+fn with_subbinary_of_binary_literal_decodes_subbinary_of_binary_literal() {
+    with_process(|process| {
+        let bytes = large_bytes();
+        let literal_bytes = Box::leak(binary_ext(&bytes).into_boxed_slice());
+        let literal_len = literal_bytes.len();
+        let literal: Term = unsafe {
+            Boxed::new_unchecked(Box::into_raw(Box::new(BinaryLiteral::from_raw_bytes(
+                literal_bytes.as_mut_ptr(),
+                literal_len,
+                None,
+            ))))
+        }
+        .into();
+        let subbinary = process.subbinary_from_original(literal, 0, 0, literal_len, 0);
+
+        let decoded = result(process, subbinary, Term::NIL).unwrap();
+
+        match decoded.decode().unwrap() {
+            TypedTerm::SubBinary(subbinary) => assert_eq!(subbinary.original(), literal),
+            typed_term => panic!("{:?} is not a subbinary", typed_term),
+        }
+        assert_eq!(decoded, process.binary_from_bytes(&bytes));
+    });
+}
+
+#[test]
+fn with_term_larger_than_heap_available_decodes_into_heap_fragment() {
+    with_process(|process| {
+        let len = 2 * process.acquire_heap().heap_size();
+        let binary = process.binary_from_bytes(&list_ext(len));
+        let heap_available = process.acquire_heap().heap_available();
+
+        let decoded = result(process, binary, Term::NIL).unwrap();
+
+        assert_eq!(process.acquire_heap().heap_available(), heap_available);
+        assert_eq!(decoded, list(process, len));
+    });
+}
+
+#[test]
+fn with_too_few_words_counted_retries_with_more_room() {
+    with_process(|process| {
+        let len = 2 * process.acquire_heap().heap_size();
+        let binary = process.binary_from_bytes(&list_ext(len));
+        let bytes = process.bytes_from_binary(binary).unwrap();
+
+        // Skip the version, which `result` checks before decoding
+        let (decoded, after_term_bytes) =
+            term::decode_in_words(process, &Original::new(binary), false, &bytes[1..], 1).unwrap();
+
+        assert!(after_term_bytes.is_empty());
+        assert_eq!(decoded, list(process, len));
+    });
+}
+
+const VERSION: u8 = 131;
+
+/// Too many bytes to be a heap binary
+fn large_bytes() -> Vec<u8> {
+    (0..=u8::MAX).collect()
+}
+
+/// `bytes` as a `BINARY_EXT`
+fn binary_ext(bytes: &[u8]) -> Vec<u8> {
+    let mut byte_vec = vec![VERSION, 109];
+    byte_vec.extend_from_slice(&(bytes.len() as u32).to_be_bytes());
+    byte_vec.extend_from_slice(bytes);
+
+    byte_vec
+}
+
+/// `list(process, len)` as a `LIST_EXT` of `SMALL_INTEGER_EXT`s
+fn list_ext(len: usize) -> Vec<u8> {
+    let mut byte_vec = vec![VERSION, 108];
+    byte_vec.extend_from_slice(&(len as u32).to_be_bytes());
+    for i in 0..len {
+        byte_vec.extend_from_slice(&[97, i as u8]);
+    }
+    byte_vec.push(106);
+
+    byte_vec
+}
+
+fn list(process: &Process, len: usize) -> Term {
+    let elements: Vec<Term> = (0..len).map(|i| process.integer(i as u8)).collect();
+
+    process.list_from_slice(&elements)
+}
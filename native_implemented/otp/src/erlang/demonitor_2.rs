@@ -60,8 +60,7 @@ pub(in crate::erlang) fn demonitor(
 
 fn flush(monitoring_process: &Process, reference: &Reference) -> bool {
     monitoring_process
-        .mailbox
-        .lock()
+        .mailbox()
         .borrow_mut()
         .flush(|message| is_down(message, reference), monitoring_process)
 }
@@ -40,8 +40,8 @@ fn process_info(process: &Process, item: Atom) -> InternalResult<Term> {
         "current_stacktrace" => unimplemented!(),
         "dictionary" => unimplemented!(),
         "error_handler" => unimplemented!(),
-        "garbage_collection" => unimplemented!(),
-        "garbage_collection_info" => unimplemented!(),
+        "garbage_collection" => Ok(garbage_collection(process)),
+        "garbage_collection_info" => Ok(garbage_collection_info(process)),
         "group_leader" => unimplemented!(),
         "heap_size" => unimplemented!(),
         "initial_call" => unimplemented!(),
@@ -50,7 +50,7 @@ fn process_info(process: &Process, item: Atom) -> InternalResult<Term> {
         "memory" => unimplemented!(),
         "message_queue_len" => unimplemented!(),
         "messages" => Ok(messages(process)),
-        "min_heap_size" => unimplemented!(),
+        "min_heap_size" => Ok(min_heap_size(process)),
         "min_bin_vheap_size" => unimplemented!(),
         "monitored_by" => Ok(monitored_by(process)),
         "monitors" => Ok(monitors(process)),
@@ -80,6 +80,67 @@ fn process_info(process: &Process, item: Atom) -> InternalResult<Term> {
     }
 }
 
+fn garbage_collection(process: &Process) -> Term {
+    let gc_policy = process.gc_policy();
+    let gc_statistics = process.gc_statistics();
+
+    let vec = vec![
+        process.tuple_from_slice(&[
+            atom!("max_heap_size"),
+            process.integer(gc_policy.max_heap_size),
+        ]),
+        process.tuple_from_slice(&[
+            atom!("min_heap_size"),
+            process.integer(gc_policy.min_heap_size),
+        ]),
+        process.tuple_from_slice(&[
+            atom!("fullsweep_after"),
+            process.integer(gc_policy.fullsweep_after),
+        ]),
+        process.tuple_from_slice(&[
+            atom!("minor_gcs"),
+            process.integer(gc_statistics.minor_collections_since_fullsweep),
+        ]),
+    ];
+
+    let tag = atom!("garbage_collection");
+    let value = process.list_from_slice(&vec);
+
+    process.tuple_from_slice(&[tag, value])
+}
+
+fn garbage_collection_info(process: &Process) -> Term {
+    let gc_statistics = process.gc_statistics();
+
+    let vec = vec![
+        process.tuple_from_slice(&[
+            atom!("minor_gcs"),
+            process.integer(gc_statistics.minor_collections_since_fullsweep),
+        ]),
+        process.tuple_from_slice(&[
+            atom!("full_gcs"),
+            process.integer(gc_statistics.full_collections),
+        ]),
+        process.tuple_from_slice(&[
+            atom!("words_reclaimed"),
+            process.integer(gc_statistics.words_reclaimed),
+        ]),
+        process.tuple_from_slice(&[
+            atom!("gc_pause_ns"),
+            process.integer(gc_statistics.pause_ns),
+        ]),
+        process.tuple_from_slice(&[
+            atom!("max_gc_pause_ns"),
+            process.integer(gc_statistics.max_pause_ns),
+        ]),
+    ];
+
+    let tag = atom!("garbage_collection_info");
+    let value = process.list_from_slice(&vec);
+
+    process.tuple_from_slice(&[tag, value])
+}
+
 fn links(process: &Process) -> Term {
     let tag = atom!("links");
 
@@ -97,8 +158,7 @@ fn messages(process: &Process) -> Term {
     let tag = atom!("messages");
 
     let vec: Vec<Term> = process
-        .mailbox
-        .lock()
+        .mailbox()
         .borrow()
         .iter()
         .map(|message| match message {
@@ -114,6 +174,13 @@ fn messages(process: &Process) -> Term {
     process.tuple_from_slice(&[tag, value])
 }
 
+fn min_heap_size(process: &Process) -> Term {
+    let tag = atom!("min_heap_size");
+    let value = process.integer(process.gc_policy().min_heap_size);
+
+    process.tuple_from_slice(&[tag, value])
+}
+
 fn monitored_by(process: &Process) -> Term {
     let tag = atom!("monitored_by");
 
@@ -1,3 +1,5 @@
+mod with_garbage_collection;
+mod with_garbage_collection_info;
 mod with_registered_name;
 
 use super::*;
@@ -29,7 +31,7 @@ fn without_supported_item_errors_badarg() {
 fn unsupported_item_atom() -> BoxedStrategy<Term> {
     strategy::atom()
         .prop_filter("Item cannot be supported", |atom| match atom.name() {
-            "registered_name" => false,
+            "garbage_collection" | "garbage_collection_info" | "registered_name" => false,
             _ => true,
         })
         .prop_map(|atom| atom.encode().unwrap())
@@ -0,0 +1,64 @@
+use super::*;
+
+use liblumen_alloc::erts::process::{Process, ProcessFlags};
+
+#[test]
+fn returns_gc_policy() {
+    with_process_arc(|arc_process| {
+        let gc_policy = arc_process.gc_policy();
+
+        assert_eq!(
+            value(&arc_process, "fullsweep_after"),
+            arc_process.integer(gc_policy.fullsweep_after)
+        );
+        assert_eq!(
+            value(&arc_process, "min_heap_size"),
+            arc_process.integer(gc_policy.min_heap_size)
+        );
+        assert_eq!(
+            value(&arc_process, "max_heap_size"),
+            arc_process.integer(gc_policy.max_heap_size)
+        );
+    });
+}
+
+#[test]
+fn minor_gcs_counts_minor_collections_since_last_fullsweep() {
+    with_process_arc(|arc_process| {
+        assert_eq!(value(&arc_process, "minor_gcs"), arc_process.integer(0));
+
+        arc_process.garbage_collect(0, &mut [][..]).unwrap();
+        arc_process.garbage_collect(0, &mut [][..]).unwrap();
+
+        assert_eq!(value(&arc_process, "minor_gcs"), arc_process.integer(2));
+
+        arc_process.set_flags(ProcessFlags::NeedFullSweep);
+        arc_process.garbage_collect(0, &mut [][..]).unwrap();
+
+        assert_eq!(value(&arc_process, "minor_gcs"), arc_process.integer(0));
+    });
+}
+
+fn item() -> Term {
+    Atom::str_to_term("garbage_collection")
+}
+
+fn value(arc_process: &Process, key: &str) -> Term {
+    let pid = arc_process.pid_term();
+    let tuple: Boxed<Tuple> = result(arc_process, pid, item())
+        .unwrap()
+        .try_into()
+        .unwrap();
+
+    assert_eq!(tuple[0], item());
+
+    let list: Boxed<Cons> = tuple[1].try_into().unwrap();
+    let entry: Boxed<Tuple> = list
+        .keyfind(OneBasedIndex::default(), Atom::str_to_term(key))
+        .unwrap()
+        .unwrap()
+        .try_into()
+        .unwrap();
+
+    entry[1]
+}
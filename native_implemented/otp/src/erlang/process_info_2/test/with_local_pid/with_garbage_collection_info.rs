@@ -0,0 +1,63 @@
+use super::*;
+
+use liblumen_alloc::erts::process::{Process, ProcessFlags};
+
+#[test]
+fn without_collections_returns_zeroed_counters() {
+    with_process_arc(|arc_process| {
+        for key in &["minor_gcs", "full_gcs", "words_reclaimed"] {
+            assert_eq!(value(&arc_process, key), arc_process.integer(0));
+        }
+    });
+}
+
+#[test]
+fn counts_minor_and_full_collections() {
+    with_process_arc(|arc_process| {
+        arc_process.garbage_collect(0, &mut [][..]).unwrap();
+
+        assert_eq!(value(&arc_process, "minor_gcs"), arc_process.integer(1));
+        assert_eq!(value(&arc_process, "full_gcs"), arc_process.integer(0));
+
+        arc_process.set_flags(ProcessFlags::NeedFullSweep);
+        arc_process.garbage_collect(0, &mut [][..]).unwrap();
+
+        assert_eq!(value(&arc_process, "minor_gcs"), arc_process.integer(0));
+        assert_eq!(value(&arc_process, "full_gcs"), arc_process.integer(1));
+
+        let gc_statistics = arc_process.gc_statistics();
+
+        assert_eq!(
+            value(&arc_process, "max_gc_pause_ns"),
+            arc_process.integer(gc_statistics.max_pause_ns)
+        );
+        assert_eq!(
+            value(&arc_process, "gc_pause_ns"),
+            arc_process.integer(gc_statistics.pause_ns)
+        );
+    });
+}
+
+fn item() -> Term {
+    Atom::str_to_term("garbage_collection_info")
+}
+
+fn value(arc_process: &Process, key: &str) -> Term {
+    let pid = arc_process.pid_term();
+    let tuple: Boxed<Tuple> = result(arc_process, pid, item())
+        .unwrap()
+        .try_into()
+        .unwrap();
+
+    assert_eq!(tuple[0], item());
+
+    let list: Boxed<Cons> = tuple[1].try_into().unwrap();
+    let entry: Boxed<Tuple> = list
+        .keyfind(OneBasedIndex::default(), Atom::str_to_term(key))
+        .unwrap()
+        .unwrap()
+        .try_into()
+        .unwrap();
+
+    entry[1]
+}
@@ -0,0 +1,33 @@
+#[cfg(all(not(target_arch = "wasm32"), test))]
+mod test;
+
+use anyhow::*;
+
+use liblumen_alloc::erts::exception;
+use liblumen_alloc::erts::process::gc;
+use liblumen_alloc::erts::process::Process;
+use liblumen_alloc::erts::term::prelude::*;
+
+#[native_implemented::function(erlang:statistics/1)]
+pub fn result(process: &Process, item: Term) -> exception::Result<Term> {
+    let item_atom: Atom = term_try_into_atom!(item)?;
+
+    match item_atom.name() {
+        "garbage_collection" => Ok(garbage_collection(process)),
+        // The other items OTP supports (`reductions`, `run_queue`, `runtime`, `wall_clock`, etc)
+        // aren't tracked, so they are rejected like unknown items rather than panicking
+        name => Err(TryAtomFromTermError(name))
+            .context("supported item is garbage_collection")
+            .map_err(From::from),
+    }
+}
+
+fn garbage_collection(process: &Process) -> Term {
+    let (collections, words_reclaimed) = gc::global_statistics();
+
+    process.tuple_from_slice(&[
+        process.integer(collections),
+        process.integer(words_reclaimed),
+        process.integer(0),
+    ])
+}
@@ -0,0 +1,65 @@
+use std::convert::TryInto;
+
+use liblumen_alloc::erts::process::Process;
+use liblumen_alloc::erts::term::prelude::*;
+
+use crate::erlang::statistics_1::result;
+use crate::test::with_process;
+
+#[test]
+fn with_garbage_collection_returns_collections_words_reclaimed_and_zero() {
+    with_process(|process| {
+        let tuple = garbage_collection(process);
+
+        assert_eq!(tuple.len(), 3);
+        assert!(tuple[0].is_integer());
+        assert!(tuple[1].is_integer());
+        assert_eq!(tuple[2], process.integer(0));
+    });
+}
+
+#[test]
+fn with_garbage_collection_counts_collections_of_all_processes() {
+    with_process(|process| {
+        let before = garbage_collection(process);
+
+        process.garbage_collect(0, &mut [][..]).unwrap();
+
+        let after = garbage_collection(process);
+
+        // Other tests collect concurrently, so only a lower bound holds
+        assert!(before[0] < after[0]);
+        assert!(before[1] <= after[1]);
+    });
+}
+
+#[test]
+fn with_unsupported_item_errors_badarg() {
+    with_process(|process| {
+        for item in &[
+            "active_tasks",
+            "context_switches",
+            "exact_reductions",
+            "io",
+            "reductions",
+            "run_queue",
+            "runtime",
+            "scheduler_wall_time",
+            "total_run_queue_lengths",
+            "wall_clock",
+            "not_an_item",
+        ] {
+            assert_badarg!(
+                result(process, Atom::str_to_term(item)),
+                "supported item is garbage_collection"
+            );
+        }
+    });
+}
+
+fn garbage_collection(process: &Process) -> Boxed<Tuple> {
+    result(process, Atom::str_to_term("garbage_collection"))
+        .unwrap()
+        .try_into()
+        .unwrap()
+}
@@ -5,6 +5,7 @@ use std::convert::TryInto;
 use std::mem;
 use std::sync::Arc;
 
+use miniz_oxide::deflate;
 use num_bigint::{BigInt, Sign};
 
 use liblumen_alloc::erts::process::Process;
@@ -18,10 +19,45 @@ use crate::runtime::distribution::external_term_format::{version, Tag};
 
 use options::*;
 
+pub use options::Options;
+
 pub fn term_to_binary(process: &Process, term: Term, options: Options) -> Term {
-    let byte_vec = term_to_byte_vec(process, &options, term);
+    // The term is encoded twice: first only counting the bytes, so that the binary can be
+    // allocated at its final size, then writing the bytes directly into that binary
+    let mut byte_counter = ByteCounter::default();
+    append_version_and_term(&mut byte_counter, &options, term);
+
+    let level = options.compression.0;
+
+    if level == 0 {
+        return process.binary_from_fn(byte_counter.len, |bytes| {
+            append_version_and_term_to_bytes(bytes, &options, term);
+        });
+    }
 
-    process.binary_from_bytes(&byte_vec)
+    let mut uncompressed = vec![0; byte_counter.len];
+    append_version_and_term_to_bytes(&mut uncompressed, &options, term);
+
+    // The version isn't part of the compressed data
+    let uncompressed_term = &uncompressed[VERSION_BYTE_LEN..];
+    let compressed_term = deflate::compress_to_vec_zlib(uncompressed_term, level);
+    let compressed_len =
+        VERSION_BYTE_LEN + TAG_BYTE_LEN + UNCOMPRESSED_SIZE_BYTE_LEN + compressed_term.len();
+
+    // Like OTP, the uncompressed encoding is returned when compressing doesn't make it smaller
+    if compressed_len < uncompressed.len() {
+        process.binary_from_fn(compressed_len, |bytes| {
+            let mut byte_writer = ByteWriter::new(bytes);
+            byte_writer.push(version::NUMBER);
+            push_tag(&mut byte_writer, Tag::Compressed);
+            append_usize_as_u32(&mut byte_writer, uncompressed_term.len());
+            byte_writer.extend_from_slice(&compressed_term);
+
+            debug_assert_eq!(byte_writer.len, byte_writer.bytes.len());
+        })
+    } else {
+        process.binary_from_bytes(&uncompressed)
+    }
 }
 
 // Private
@@ -33,6 +69,11 @@ pub fn term_to_binary(process: &Process, term: Term, options: Options) -> Term {
 // > as it is used as a wild card for debug purpose (like a pid returned by erlang:list_to_pid/1).
 const CREATION: u8 = 0;
 
+const VERSION_BYTE_LEN: usize = mem::size_of::<u8>();
+const TAG_BYTE_LEN: usize = mem::size_of::<u8>();
+const UNCOMPRESSED_SIZE_BYTE_LEN: usize = mem::size_of::<u32>();
+const NEW_FUNCTION_EXT_SIZE_BYTE_LEN: usize = mem::size_of::<u32>();
+
 const NEWER_REFERENCE_EXT_MAX_U32_LEN: usize = 3;
 
 const SMALL_INTEGER_EXT_MIN: isize = std::u8::MIN as isize;
@@ -46,8 +87,87 @@ const STRING_EXT_MAX_LEN: usize = std::u16::MAX as usize;
 const SMALL_BIG_EXT_MAX_LEN: usize = std::u8::MAX as usize;
 const SMALL_ATOM_UTF8_EXT_MAX_LEN: usize = std::u8::MAX as usize;
 
-fn append_big_int(byte_vec: &mut Vec<u8>, big_int: &BigInt) {
-    let (sign, mut little_endian_bytes) = big_int.to_bytes_le();
+/// Where encoded bytes are appended.
+///
+/// `ByteCounter` only sizes the encoding and `ByteWriter` writes it, so every `append_*`
+/// function must append the same bytes to either.
+trait Buffer {
+    fn push(&mut self, byte: u8);
+
+    fn extend_from_slice(&mut self, bytes: &[u8]);
+
+    fn extend<I: IntoIterator<Item = u8>>(&mut self, iter: I) {
+        for byte in iter {
+            self.push(byte);
+        }
+    }
+
+    /// Appends the 32-bit size of what `append` appends, which counts the size itself, followed
+    /// by what `append` appends
+    fn append_sized<F: FnOnce(&mut Self)>(&mut self, append: F);
+}
+
+#[derive(Default)]
+struct ByteCounter {
+    len: usize,
+}
+
+impl Buffer for ByteCounter {
+    fn push(&mut self, _byte: u8) {
+        self.len += 1;
+    }
+
+    fn extend_from_slice(&mut self, bytes: &[u8]) {
+        self.len += bytes.len();
+    }
+
+    fn extend<I: IntoIterator<Item = u8>>(&mut self, iter: I) {
+        self.len += iter.into_iter().count();
+    }
+
+    fn append_sized<F: FnOnce(&mut Self)>(&mut self, append: F) {
+        self.len += NEW_FUNCTION_EXT_SIZE_BYTE_LEN;
+        append(self);
+    }
+}
+
+struct ByteWriter<'a> {
+    bytes: &'a mut [u8],
+    len: usize,
+}
+
+impl<'a> ByteWriter<'a> {
+    fn new(bytes: &'a mut [u8]) -> Self {
+        Self { bytes, len: 0 }
+    }
+}
+
+impl Buffer for ByteWriter<'_> {
+    fn push(&mut self, byte: u8) {
+        self.bytes[self.len] = byte;
+        self.len += 1;
+    }
+
+    fn extend_from_slice(&mut self, bytes: &[u8]) {
+        let end = self.len + bytes.len();
+        self.bytes[self.len..end].copy_from_slice(bytes);
+        self.len = end;
+    }
+
+    // The size is filled in once known, so that nested funs are each only encoded once
+    fn append_sized<F: FnOnce(&mut Self)>(&mut self, append: F) {
+        let start = self.len;
+        let end = start + NEW_FUNCTION_EXT_SIZE_BYTE_LEN;
+        self.len = end;
+        append(self);
+
+        let size = (self.len - start) as u32;
+        self.bytes[start..end].copy_from_slice(&size.to_be_bytes());
+    }
+}
+
+fn append_big_int<B: Buffer>(buffer: &mut B, big_int: &BigInt) {
+    let (sign, little_endian_bytes) = big_int.to_bytes_le();
 
     let sign_byte: u8 = match sign {
         Sign::Minus => 1,
@@ -57,31 +177,51 @@ fn append_big_int(byte_vec: &mut Vec<u8>, big_int: &BigInt) {
     let len_usize = little_endian_bytes.len();
 
     if len_usize <= SMALL_BIG_EXT_MAX_LEN {
-        push_tag(byte_vec, Tag::SmallBig);
-        byte_vec.push(len_usize as u8);
+        push_tag(buffer, Tag::SmallBig);
+        buffer.push(len_usize as u8);
     } else {
-        push_tag(byte_vec, Tag::LargeBig);
-        append_usize_as_u32(byte_vec, len_usize);
+        push_tag(buffer, Tag::LargeBig);
+        append_usize_as_u32(buffer, len_usize);
     }
 
-    byte_vec.push(sign_byte);
-    byte_vec.append(&mut little_endian_bytes);
+    buffer.push(sign_byte);
+    buffer.extend_from_slice(&little_endian_bytes);
 }
 
-fn append_binary_bytes(byte_vec: &mut Vec<u8>, binary_bytes: &[u8]) {
-    byte_vec.extend_from_slice(binary_bytes)
+fn append_binary_bytes<B: Buffer>(buffer: &mut B, binary_bytes: &[u8]) {
+    buffer.extend_from_slice(binary_bytes)
 }
 
-fn append_creator(byte_vec: &mut Vec<u8>, creator: &Creator) {
+fn append_atom<B: Buffer>(buffer: &mut B, atom: Atom) {
+    let bytes = atom.name().as_bytes();
+    let len_usize = bytes.len();
+
+    if bytes.iter().all(|byte| byte.is_ascii()) {
+        push_tag(buffer, Tag::Atom);
+        append_usize_as_u16(buffer, len_usize);
+    } else if len_usize <= SMALL_ATOM_UTF8_EXT_MAX_LEN {
+        push_tag(buffer, Tag::SmallAtomUTF8);
+
+        let len_u8 = len_usize as u8;
+        buffer.push(len_u8);
+    } else {
+        push_tag(buffer, Tag::AtomUTF8);
+        append_usize_as_u16(buffer, len_usize);
+    }
+
+    buffer.extend_from_slice(bytes);
+}
+
+fn append_creator<B: Buffer>(buffer: &mut B, creator: &Creator) {
     match creator {
         Creator::Local(pid) => append_pid(
-            byte_vec,
+            buffer,
             node::arc_node(),
             pid.number() as u32,
             pid.serial() as u32,
         ),
         Creator::External(external_pid) => append_pid(
-            byte_vec,
+            buffer,
             external_pid.arc_node(),
             external_pid.number() as u32,
             external_pid.serial() as u32,
@@ -89,7 +229,48 @@ fn append_creator(byte_vec: &mut Vec<u8>, creator: &Creator) {
     }
 }
 
-fn append_pid(byte_vec: &mut Vec<u8>, arc_node: Arc<Node>, id: u32, serial: u32) {
+// Everything in NEW_FUN_EXT after its Size
+fn append_new_function_sized<B: Buffer>(buffer: &mut B, options: &Options, closure: &Closure) {
+    if let Definition::Anonymous {
+        index,
+        old_unique,
+        unique,
+        //creator,
+    } = closure.definition()
+    {
+        let default_creator = Creator::Local(Pid::default());
+
+        let module_function_arity = closure.module_function_arity();
+        buffer.push(module_function_arity.arity);
+
+        buffer.extend_from_slice(unique);
+        buffer.extend_from_slice(&index.to_be_bytes());
+
+        let env_len_u32: u32 = closure.env_len().try_into().unwrap();
+        buffer.extend_from_slice(&env_len_u32.to_be_bytes());
+
+        append_atom(buffer, module_function_arity.module);
+
+        // > [index] encoded using SMALL_INTEGER_EXT or INTEGER_EXT.
+        try_append_isize_as_small_integer_or_integer(buffer, (*index).try_into().unwrap()).unwrap();
+
+        // > An integer encoded using SMALL_INTEGER_EXT or INTEGER_EXT
+        // But this means OldUniq can't be the same a Uniq with a different
+        // encoding,
+        try_append_isize_as_small_integer_or_integer(buffer, (*old_unique).try_into().unwrap())
+            .unwrap();
+
+        append_creator(buffer, &default_creator);
+
+        for term in closure.env_slice() {
+            append_term(buffer, options, *term);
+        }
+    } else {
+        unreachable!()
+    }
+}
+
+fn append_pid<B: Buffer>(buffer: &mut B, arc_node: Arc<Node>, id: u32, serial: u32) {
     let creation = arc_node.creation();
 
     let tag = if creation <= (std::u8::MAX as u32) {
@@ -98,52 +279,42 @@ fn append_pid(byte_vec: &mut Vec<u8>, arc_node: Arc<Node>, id: u32, serial: u32)
         Tag::NewPID
     };
 
-    push_tag(byte_vec, tag);
+    push_tag(buffer, tag);
 
-    byte_vec.extend_from_slice(&atom_to_byte_vec(arc_node.name()));
-    byte_vec.extend_from_slice(&id.to_be_bytes());
-    byte_vec.extend_from_slice(&serial.to_be_bytes());
+    append_atom(buffer, arc_node.name());
+    buffer.extend_from_slice(&id.to_be_bytes());
+    buffer.extend_from_slice(&serial.to_be_bytes());
 
     if creation <= (std::u8::MAX as u32) {
-        byte_vec.push(creation as u8);
+        buffer.push(creation as u8);
     } else {
-        byte_vec.extend_from_slice(&creation.to_be_bytes());
+        buffer.extend_from_slice(&creation.to_be_bytes());
     };
 }
 
-fn append_usize_as_u16(byte_vec: &mut Vec<u8>, len_usize: usize) {
+fn append_usize_as_u16<B: Buffer>(buffer: &mut B, len_usize: usize) {
     assert!(len_usize <= (std::u16::MAX as usize));
     let len_u16 = len_usize as u16;
-    byte_vec.extend_from_slice(&len_u16.to_be_bytes());
+    buffer.extend_from_slice(&len_u16.to_be_bytes());
 }
 
-fn append_usize_as_u32(byte_vec: &mut Vec<u8>, len_usize: usize) {
+fn append_usize_as_u32<B: Buffer>(buffer: &mut B, len_usize: usize) {
     assert!(len_usize <= (std::u32::MAX as usize));
     let len_u32 = len_usize as u32;
-    byte_vec.extend_from_slice(&len_u32.to_be_bytes());
+    buffer.extend_from_slice(&len_u32.to_be_bytes());
 }
 
-fn atom_to_byte_vec(atom: Atom) -> Vec<u8> {
-    let bytes = atom.name().as_bytes();
-    let len_usize = bytes.len();
-    let mut byte_vec: Vec<u8> = Vec::new();
-
-    if bytes.iter().all(|byte| byte.is_ascii()) {
-        push_tag(&mut byte_vec, Tag::Atom);
-        append_usize_as_u16(&mut byte_vec, len_usize);
-    } else if len_usize <= SMALL_ATOM_UTF8_EXT_MAX_LEN {
-        push_tag(&mut byte_vec, Tag::SmallAtomUTF8);
-
-        let len_u8 = len_usize as u8;
-        byte_vec.push(len_u8);
-    } else {
-        push_tag(&mut byte_vec, Tag::AtomUTF8);
-        append_usize_as_u16(&mut byte_vec, len_usize);
-    }
+fn append_version_and_term<B: Buffer>(buffer: &mut B, options: &Options, term: Term) {
+    buffer.push(version::NUMBER);
+    append_term(buffer, options, term);
+}
 
-    byte_vec.extend_from_slice(bytes);
+/// Writes the encoding of `term` into `bytes`, which must be exactly as long as counted
+fn append_version_and_term_to_bytes(bytes: &mut [u8], options: &Options, term: Term) {
+    let mut byte_writer = ByteWriter::new(bytes);
+    append_version_and_term(&mut byte_writer, options, term);
 
-    byte_vec
+    debug_assert_eq!(byte_writer.len, byte_writer.bytes.len());
 }
 
 // Tail is the final tail  of the list; it is NIL_EXT for a proper list, but can be any type if the
@@ -165,31 +336,29 @@ fn cons_to_element_vec_tail(cons: &Cons) -> (Vec<Term>, Term) {
     (element_vec, tail)
 }
 
-fn push_tag(byte_vec: &mut Vec<u8>, tag: Tag) {
-    byte_vec.push(tag.into());
+fn push_tag<B: Buffer>(buffer: &mut B, tag: Tag) {
+    buffer.push(tag.into());
 }
 
-fn term_to_byte_vec(process: &Process, options: &Options, term: Term) -> Vec<u8> {
+fn append_term<B: Buffer>(buffer: &mut B, options: &Options, term: Term) {
     let mut stack = VecDeque::new();
     stack.push_front(term);
 
-    let mut byte_vec: Vec<u8> = vec![version::NUMBER];
-
     while let Some(front_term) = stack.pop_front() {
         match front_term.decode().unwrap() {
             TypedTerm::Atom(atom) => {
-                byte_vec.extend_from_slice(&atom_to_byte_vec(atom));
+                append_atom(buffer, atom);
             }
             TypedTerm::List(cons) => {
-                match try_cons_to_string_ext_byte_vec(&cons) {
-                    Ok(mut string_ext_byte_vec) => byte_vec.append(&mut string_ext_byte_vec),
+                match try_append_cons_as_string_ext(buffer, &cons) {
+                    Ok(()) => (),
                     Err(_) => {
-                        push_tag(&mut byte_vec, Tag::List);
+                        push_tag(buffer, Tag::List);
 
                         let (element_vec, tail) = cons_to_element_vec_tail(&cons);
 
                         let len_usize = element_vec.len();
-                        append_usize_as_u32(&mut byte_vec, len_usize);
+                        append_usize_as_u32(buffer, len_usize);
 
                         stack.push_front(tail);
 
@@ -200,23 +369,15 @@ fn term_to_byte_vec(process: &Process, options: &Options, term: Term) -> Vec<u8>
                 };
             }
             TypedTerm::Nil => {
-                push_tag(&mut byte_vec, Tag::Nil);
+                push_tag(buffer, Tag::Nil);
             }
             TypedTerm::Pid(pid) => {
-                append_pid(
-                    &mut byte_vec,
-                    arc_node(),
-                    pid.number() as u32,
-                    pid.serial() as u32,
-                );
+                append_pid(buffer, arc_node(), pid.number() as u32, pid.serial() as u32);
             }
             TypedTerm::SmallInteger(small_integer) => {
                 let small_integer_isize: isize = small_integer.into();
 
-                match try_append_isize_as_small_integer_or_integer(
-                    &mut byte_vec,
-                    small_integer_isize,
-                ) {
+                match try_append_isize_as_small_integer_or_integer(buffer, small_integer_isize) {
                     Ok(()) => (),
                     Err(_) => {
                         let small_integer_i64 = small_integer_isize as i64;
@@ -224,97 +385,49 @@ fn term_to_byte_vec(process: &Process, options: &Options, term: Term) -> Vec<u8>
                         // jumping to 8 to hold i64.
                         let small_integer_big_int: BigInt = small_integer_i64.into();
 
-                        append_big_int(&mut byte_vec, &small_integer_big_int);
+                        append_big_int(buffer, &small_integer_big_int);
                     }
                 }
             }
             TypedTerm::BigInteger(big_integer) => {
                 let big_int: &BigInt = big_integer.as_ref().into();
 
-                append_big_int(&mut byte_vec, big_int);
+                append_big_int(buffer, big_int);
             }
             TypedTerm::Float(float) => {
                 let float_f64: f64 = float.into();
 
-                push_tag(&mut byte_vec, Tag::NewFloat);
-                byte_vec.extend_from_slice(&float_f64.to_be_bytes());
+                push_tag(buffer, Tag::NewFloat);
+                buffer.extend_from_slice(&float_f64.to_be_bytes());
             }
-            TypedTerm::Closure(closure) => {
-                match closure.definition() {
-                    Definition::Export { function } => {
-                        push_tag(&mut byte_vec, Tag::Export);
-                        byte_vec.append(&mut atom_to_byte_vec(closure.module()));
-                        byte_vec.append(&mut atom_to_byte_vec(*function));
-                        try_append_isize_as_small_integer_or_integer(
-                            &mut byte_vec,
-                            closure.arity() as isize,
-                        )
-                        .unwrap();
-                    }
-                    Definition::Anonymous {
-                        index,
-                        old_unique,
-                        unique,
-                        //creator,
-                    } => {
-                        let default_creator = Creator::Local(Pid::default());
-                        let mut sized_byte_vec: Vec<u8> = Vec::new();
-
-                        let module_function_arity = closure.module_function_arity();
-                        sized_byte_vec.push(module_function_arity.arity);
-
-                        sized_byte_vec.extend_from_slice(unique);
-                        sized_byte_vec.extend_from_slice(&index.to_be_bytes());
-
-                        let env_len_u32: u32 = closure.env_len().try_into().unwrap();
-                        sized_byte_vec.extend_from_slice(&env_len_u32.to_be_bytes());
-
-                        sized_byte_vec.append(&mut atom_to_byte_vec(module_function_arity.module));
-
-                        // > [index] encoded using SMALL_INTEGER_EXT or INTEGER_EXT.
-                        try_append_isize_as_small_integer_or_integer(
-                            &mut sized_byte_vec,
-                            (*index).try_into().unwrap(),
-                        )
+            TypedTerm::Closure(closure) => match closure.definition() {
+                Definition::Export { function } => {
+                    push_tag(buffer, Tag::Export);
+                    append_atom(buffer, closure.module());
+                    append_atom(buffer, *function);
+                    try_append_isize_as_small_integer_or_integer(buffer, closure.arity() as isize)
                         .unwrap();
-
-                        // > An integer encoded using SMALL_INTEGER_EXT or INTEGER_EXT
-                        // But this means OldUniq can't be the same a Uniq with a different
-                        // encoding,
-                        try_append_isize_as_small_integer_or_integer(
-                            &mut sized_byte_vec,
-                            (*old_unique).try_into().unwrap(),
-                        )
-                        .unwrap();
-
-                        append_creator(&mut sized_byte_vec, &default_creator);
-
-                        for term in closure.env_slice() {
-                            sized_byte_vec.append(&mut term_to_byte_vec(process, options, *term));
-                        }
-
-                        const SIZE_BYTE_LEN: usize = mem::size_of::<u32>();
-                        let size = (SIZE_BYTE_LEN + sized_byte_vec.len()) as u32;
-
-                        push_tag(&mut byte_vec, Tag::NewFunction);
-                        byte_vec.extend_from_slice(&size.to_be_bytes());
-                        byte_vec.append(&mut sized_byte_vec);
-                    }
                 }
-            }
+                Definition::Anonymous { .. } => {
+                    push_tag(buffer, Tag::NewFunction);
+                    buffer.append_sized(|buffer| {
+                        append_new_function_sized(buffer, options, &closure)
+                    });
+                }
+            },
             TypedTerm::ExternalPid(external_pid) => {
                 append_pid(
-                    &mut byte_vec,
+                    buffer,
                     external_pid.arc_node(),
                     external_pid.number() as u32,
                     external_pid.serial() as u32,
                 );
             }
             TypedTerm::Map(map) => {
-                push_tag(&mut byte_vec, Tag::Map);
+                push_tag(buffer, Tag::Map);
 
                 let len_usize = map.len();
-                append_usize_as_u32(&mut byte_vec, len_usize);
+                append_usize_as_u32(buffer, len_usize);
 
                 for (key, value) in map.iter() {
                     stack.push_front(*value);
@@ -322,19 +435,17 @@ fn term_to_byte_vec(process: &Process, options: &Options, term: Term) -> Vec<u8>
                 }
             }
             TypedTerm::HeapBinary(heap_bin) => {
-                push_tag(&mut byte_vec, Tag::Binary);
+                push_tag(buffer, Tag::Binary);
 
                 let len_usize = heap_bin.full_byte_len();
-                append_usize_as_u32(&mut byte_vec, len_usize);
+                append_usize_as_u32(buffer, len_usize);
 
-                byte_vec.extend_from_slice(heap_bin.as_bytes());
+                buffer.extend_from_slice(heap_bin.as_bytes());
             }
             TypedTerm::MatchContext(match_context) => {
                 if match_context.is_binary() {
                     if match_context.is_aligned() {
-                        append_binary_bytes(&mut byte_vec, unsafe {
-                            match_context.as_bytes_unchecked()
-                        });
+                        append_binary_bytes(buffer, unsafe { match_context.as_bytes_unchecked() });
                     } else {
                         unimplemented!()
                     }
@@ -343,58 +454,58 @@ fn term_to_byte_vec(process: &Process, options: &Options, term: Term) -> Vec<u8>
                 }
             }
             TypedTerm::ProcBin(proc_bin) => {
-                push_tag(&mut byte_vec, Tag::Binary);
+                push_tag(buffer, Tag::Binary);
 
                 let len_usize = proc_bin.full_byte_len();
-                append_usize_as_u32(&mut byte_vec, len_usize);
+                append_usize_as_u32(buffer, len_usize);
 
-                byte_vec.extend_from_slice(proc_bin.as_bytes());
+                buffer.extend_from_slice(proc_bin.as_bytes());
             }
             TypedTerm::Reference(reference) => {
                 let scheduler_id_u32: u32 = reference.scheduler_id().into();
                 let number: u64 = reference.number().into();
 
-                push_tag(&mut byte_vec, Tag::NewerReference);
+                push_tag(buffer, Tag::NewerReference);
 
                 let u32_byte_len = mem::size_of::<u32>();
                 let len_usize = (mem::size_of::<u32>() + mem::size_of::<u64>()) / u32_byte_len;
                 // > Len - A 16-bit big endian unsigned integer not larger than 3.
                 assert!(len_usize <= NEWER_REFERENCE_EXT_MAX_U32_LEN);
-                append_usize_as_u16(&mut byte_vec, len_usize);
+                append_usize_as_u16(buffer, len_usize);
 
-                byte_vec.extend_from_slice(&atom_to_byte_vec(node::atom()));
+                append_atom(buffer, node::atom());
 
                 let creation_u32 = CREATION as u32;
-                byte_vec.extend_from_slice(&creation_u32.to_be_bytes());
+                buffer.extend_from_slice(&creation_u32.to_be_bytes());
 
-                byte_vec.extend_from_slice(&scheduler_id_u32.to_be_bytes());
-                byte_vec.extend_from_slice(&number.to_be_bytes());
+                buffer.extend_from_slice(&scheduler_id_u32.to_be_bytes());
+                buffer.extend_from_slice(&number.to_be_bytes());
             }
             TypedTerm::SubBinary(subbinary) => {
                 if subbinary.is_binary() {
-                    push_tag(&mut byte_vec, Tag::Binary);
+                    push_tag(buffer, Tag::Binary);
 
                     let len_usize = subbinary.full_byte_len();
-                    append_usize_as_u32(&mut byte_vec, len_usize);
+                    append_usize_as_u32(buffer, len_usize);
 
                     if subbinary.is_aligned() {
-                        byte_vec.extend_from_slice(unsafe { subbinary.as_bytes_unchecked() });
+                        buffer.extend_from_slice(unsafe { subbinary.as_bytes_unchecked() });
                     } else {
-                        byte_vec.extend(subbinary.full_byte_iter());
+                        buffer.extend(subbinary.full_byte_iter());
                     }
                 } else {
-                    push_tag(&mut byte_vec, Tag::BitBinary);
+                    push_tag(buffer, Tag::BitBinary);
 
                     let len_usize = subbinary.total_byte_len();
-                    append_usize_as_u32(&mut byte_vec, len_usize);
+                    append_usize_as_u32(buffer, len_usize);
 
                     let bits_u8 = subbinary.partial_byte_bit_len();
-                    byte_vec.push(bits_u8);
+                    buffer.push(bits_u8);
 
                     if subbinary.is_aligned() {
-                        byte_vec.extend_from_slice(unsafe { subbinary.as_bytes_unchecked() });
+                        buffer.extend_from_slice(unsafe { subbinary.as_bytes_unchecked() });
                     } else {
-                        byte_vec.extend(subbinary.full_byte_iter());
+                        buffer.extend(subbinary.full_byte_iter());
                     }
 
                     let mut last_byte: u8 = 0;
@@ -403,18 +514,18 @@ fn term_to_byte_vec(process: &Process, options: &Options, term: Term) -> Vec<u8>
                         last_byte |= bit << (7 - index);
                     }
 
-                    byte_vec.push(last_byte);
+                    buffer.push(last_byte);
                 }
             }
             TypedTerm::Tuple(tuple) => {
                 let len_usize = tuple.len();
 
                 if len_usize <= SMALL_TUPLE_EXT_MAX_LEN {
-                    push_tag(&mut byte_vec, Tag::SmallTuple);
-                    byte_vec.push(len_usize as u8);
+                    push_tag(buffer, Tag::SmallTuple);
+                    buffer.push(len_usize as u8);
                 } else {
-                    push_tag(&mut byte_vec, Tag::LargeTuple);
-                    append_usize_as_u32(&mut byte_vec, len_usize);
+                    push_tag(buffer, Tag::LargeTuple);
+                    append_usize_as_u32(buffer, len_usize);
                 }
 
                 for element in tuple.iter().rev() {
@@ -424,26 +535,24 @@ fn term_to_byte_vec(process: &Process, options: &Options, term: Term) -> Vec<u8>
             _ => unimplemented!("term_to_binary({:?})", front_term),
         };
     }
-
-    byte_vec
 }
 
-fn try_append_isize_as_small_integer_or_integer(
-    mut byte_vec: &mut Vec<u8>,
+fn try_append_isize_as_small_integer_or_integer<B: Buffer>(
+    buffer: &mut B,
     integer: isize,
 ) -> Result<(), TypeError> {
     if SMALL_INTEGER_EXT_MIN <= integer && integer <= SMALL_INTEGER_EXT_MAX {
         let integer_u8: u8 = integer as u8;
 
-        push_tag(&mut byte_vec, Tag::SmallInteger);
-        byte_vec.extend_from_slice(&integer_u8.to_be_bytes());
+        push_tag(buffer, Tag::SmallInteger);
+        buffer.extend_from_slice(&integer_u8.to_be_bytes());
 
         Ok(())
     } else if INTEGER_EXT_MIN <= integer && integer <= INTEGER_EXT_MAX {
         let small_integer_i32: i32 = integer as i32;
 
-        push_tag(&mut byte_vec, Tag::Integer);
-        byte_vec.extend_from_slice(&small_integer_i32.to_be_bytes());
+        push_tag(buffer, Tag::Integer);
+        buffer.extend_from_slice(&small_integer_i32.to_be_bytes());
 
         Ok(())
     } else {
@@ -451,19 +560,22 @@ fn try_append_isize_as_small_integer_or_integer(
     }
 }
 
-fn try_cons_to_string_ext_byte_vec(cons: &Cons) -> Result<Vec<u8>, TypeError> {
-    let mut character_byte_vec: Vec<u8> = Vec::new();
-
+fn try_append_cons_as_string_ext<B: Buffer>(buffer: &mut B, cons: &Cons) -> Result<(), TypeError> {
     // STRING_EXT is used (https://github.com/erlang/otp/blob/e6a69b021bc2aee6aca42bd72583a96d06f4ba9d/erts/emulator/beam/external.c#L2893)
     // only after checking `is_external_string` (https://github.com/erlang/otp/blob/e6a69b021bc2aee6aca42bd72583a96d06f4ba9d/erts/emulator/beam/external.c#L2892).
     // `is_external_string` only checks if the element is an integer between 0 and 255.  It does not
     // care about printability. (https://github.com/erlang/otp/blob/e6a69b021bc2aee6aca42bd72583a96d06f4ba9d/erts/emulator/beam/external.c#L3164-L3191)
-    for (index, result) in cons.into_iter().enumerate() {
-        if index < STRING_EXT_MAX_LEN {
+    //
+    // The whole list is checked before anything is appended, as nothing can be taken back out of
+    // the buffer if a later element turns out not to be a byte.
+    let mut len_usize = 0;
+
+    for result in cons.into_iter() {
+        if len_usize < STRING_EXT_MAX_LEN {
             match result {
                 Ok(element) => {
-                    let character_byte: u8 = element.try_into().map_err(|_| TypeError)?;
-                    character_byte_vec.push(character_byte);
+                    let _: u8 = element.try_into().map_err(|_| TypeError)?;
+                    len_usize += 1;
                 }
                 Err(_) => return Err(TypeError),
             }
@@ -472,12 +584,74 @@ fn try_cons_to_string_ext_byte_vec(cons: &Cons) -> Result<Vec<u8>, TypeError> {
         }
     }
 
-    let mut byte_vec = vec![Tag::String.into()];
+    push_tag(buffer, Tag::String);
+    append_usize_as_u16(buffer, len_usize);
 
-    let len_usize = character_byte_vec.len();
-    append_usize_as_u16(&mut byte_vec, len_usize);
+    for element in cons.into_iter().flatten() {
+        let character_byte: u8 = element.try_into().unwrap();
+        buffer.push(character_byte);
+    }
+
+    Ok(())
+}
 
-    byte_vec.extend_from_slice(&character_byte_vec);
+#[cfg(all(not(target_arch = "wasm32"), test))]
+mod bench {
+    extern crate test;
 
-    Ok(byte_vec)
+    use super::*;
+
+    use test::Bencher;
+
+    use crate::test::process;
+
+    #[bench]
+    fn list_of_tuples(b: &mut Bencher) {
+        let process = process::default();
+        let element = process.tuple_from_slice(&[
+            Atom::str_to_term("element"),
+            process.integer(std::u32::MAX),
+            process.binary_from_bytes(&[0; 100]),
+        ]);
+        let term = process.list_from_slice(&vec![element; 1_000]);
+
+        encode(b, term);
+    }
+
+    // Every fun captures the one before it, so this is exponential in the depth if a fun's size
+    // is counted separately from encoding it
+    #[bench]
+    fn nested_anonymous_closures(b: &mut Bencher) {
+        let process = process::default();
+        let mut term = Term::NIL;
+        for index in 0..20 {
+            term = process.anonymous_closure_with_env_from_slice(
+                Atom::from_str("module"),
+                index,
+                0,
+                [0; 16],
+                0,
+                None,
+                process.pid().into(),
+                &[term],
+            );
+        }
+
+        encode(b, term);
+    }
+
+    // Encodes like `term_to_binary`, but into a reused buffer instead of a binary, as the
+    // binaries would fill the process heap
+    fn encode(b: &mut Bencher, term: Term) {
+        let options = Options::default();
+        let mut bytes = Vec::new();
+
+        b.iter(|| {
+            let mut byte_counter = ByteCounter::default();
+            append_version_and_term(&mut byte_counter, &options, term);
+
+            bytes.resize(byte_counter.len, 0);
+            append_version_and_term_to_bytes(&mut bytes, &options, term);
+        });
+    }
 }
@@ -5,11 +5,11 @@ use std::convert::{TryFrom, TryInto};
 
 use liblumen_alloc::erts::term::prelude::*;
 
-use compression::*;
+pub use compression::Compression;
 use minor_version::*;
 
 pub struct Options {
-    compression: Compression,
+    pub compression: Compression,
     minor_version: MinorVersion,
 }
 
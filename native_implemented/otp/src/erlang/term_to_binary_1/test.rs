@@ -1,3 +1,5 @@
+use std::convert::TryInto;
+
 use proptest::strategy::Just;
 use proptest::{prop_assert, prop_assert_eq};
 
@@ -573,6 +575,29 @@ fn with_small_utf8_atom_returns_small_atom_utf8_ext() {
     });
 }
 
+// NEW_FUN_EXT (112)
+#[test]
+fn with_anonymous_closure_returns_new_fun_ext_with_environment_inline() {
+    with_process(|process| {
+        let inner = anonymous_closure(process, &[Atom::str_to_term("env")]);
+        let inner_bytes = process
+            .bytes_from_binary(result(process, inner))
+            .unwrap()
+            .to_vec();
+
+        assert_eq!(&inner_bytes[..2], &[VERSION_NUMBER, NEW_FUN_EXT]);
+        assert_eq!(new_fun_ext_size(&inner_bytes), inner_bytes.len() - 2);
+        // The environment directly follows the creation of the creator's pid
+        assert!(inner_bytes.ends_with(&[0, ATOM_EXT, 0, 3, b'e', b'n', b'v']));
+
+        let outer = anonymous_closure(process, &[inner]);
+        let outer_bytes = process.bytes_from_binary(result(process, outer)).unwrap();
+
+        assert_eq!(new_fun_ext_size(outer_bytes), outer_bytes.len() - 2);
+        assert!(outer_bytes.ends_with(&inner_bytes[1..]));
+    });
+}
+
 const VERSION_NUMBER: u8 = 131;
 
 const NEW_FLOAT_EXT: u8 = 70;
@@ -584,6 +609,7 @@ const SMALL_TUPLE_EXT: u8 = 104;
 const NIL_EXT: u8 = 106;
 const STRING_EXT: u8 = 107;
 const BINARY_EXT: u8 = 109;
+const NEW_FUN_EXT: u8 = 112;
 
 fn non_empty_atom_term() -> Term {
     Atom::str_to_term("atom")
@@ -605,3 +631,20 @@ fn non_empty_tuple_byte_vec() -> Vec<u8> {
 
     byte_vec
 }
+
+fn anonymous_closure(process: &Process, env: &[Term]) -> Term {
+    process.anonymous_closure_with_env_from_slice(
+        Atom::from_str("module"),
+        1,
+        2,
+        [3; 16],
+        0,
+        None,
+        process.pid().into(),
+        env,
+    )
+}
+
+fn new_fun_ext_size(bytes: &[u8]) -> usize {
+    u32::from_be_bytes(bytes[2..6].try_into().unwrap()) as usize
+}
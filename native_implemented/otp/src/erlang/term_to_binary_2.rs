@@ -0,0 +1,28 @@
+#[cfg(all(not(target_arch = "wasm32"), test))]
+mod test;
+
+use std::convert::TryInto;
+
+use anyhow::*;
+
+use liblumen_alloc::erts::exception;
+use liblumen_alloc::erts::process::Process;
+use liblumen_alloc::erts::term::prelude::Term;
+
+use crate::erlang::term_to_binary::{term_to_binary, Options};
+
+#[native_implemented::function(erlang:term_to_binary/2)]
+pub fn result(process: &Process, term: Term, options: Term) -> exception::Result<Term> {
+    let options: Options = options.try_into().map_err(|_| {
+        anyhow!(
+            "options ({}) is not a proper list of supported options ({})",
+            options,
+            SUPPORTED_OPTIONS
+        )
+    })?;
+
+    Ok(term_to_binary(process, term, options))
+}
+
+const SUPPORTED_OPTIONS: &str = "`compressed`, `{compressed, Level}` with Level in 0..9, or \
+                                 `{minor_version, Version}` with Version in 0..2";
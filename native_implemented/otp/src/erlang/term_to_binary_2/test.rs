@@ -0,0 +1,138 @@
+use std::convert::TryInto;
+
+use miniz_oxide::inflate;
+use proptest::strategy::Just;
+
+use liblumen_alloc::erts::process::Process;
+use liblumen_alloc::erts::term::prelude::*;
+
+use crate::erlang::term_to_binary_2::result;
+use crate::erlang::{binary_to_term_1, term_to_binary_1};
+use crate::test::strategy;
+use crate::test::with_process;
+
+#[test]
+fn without_proper_list_options_errors_badarg() {
+    run!(
+        |arc_process| {
+            (
+                Just(arc_process.clone()),
+                strategy::term::is_not_list(arc_process),
+            )
+        },
+        |(arc_process, options)| {
+            prop_assert_badarg!(
+                result(&arc_process, Term::NIL, options),
+                format!(
+                    "options ({}) is not a proper list of supported options ({})",
+                    options,
+                    "`compressed`, `{compressed, Level}` with Level in 0..9, or \
+                     `{minor_version, Version}` with Version in 0..2"
+                )
+            );
+
+            Ok(())
+        },
+    );
+}
+
+#[test]
+fn without_options_returns_the_same_binary_as_term_to_binary_1() {
+    with_process(|process| {
+        let term = compressible_term(process);
+
+        assert_eq!(
+            result(process, term, Term::NIL),
+            Ok(term_to_binary_1::result(process, term))
+        );
+    });
+}
+
+// COMPRESSED (80)
+#[test]
+fn with_compressed_with_compressible_term_returns_compressed_ext() {
+    with_process(|process| {
+        let term = compressible_term(process);
+        let uncompressed = term_to_binary_1::result(process, term);
+        let uncompressed_bytes = process.bytes_from_binary(uncompressed).unwrap();
+
+        let binary = result(process, term, compressed(process)).unwrap();
+        let bytes = process.bytes_from_binary(binary).unwrap();
+
+        assert!(bytes.len() < uncompressed_bytes.len());
+        assert_eq!(&bytes[..2], &[VERSION_NUMBER, COMPRESSED]);
+
+        let (size_bytes, zlib_bytes) = bytes[2..].split_at(4);
+        let size = u32::from_be_bytes(size_bytes.try_into().unwrap()) as usize;
+
+        assert_eq!(size, uncompressed_bytes.len() - 1);
+        assert_eq!(
+            inflate::decompress_to_vec_zlib(zlib_bytes).unwrap(),
+            &uncompressed_bytes[1..]
+        );
+    });
+}
+
+#[test]
+fn with_compressed_binary_to_term_returns_term() {
+    with_process(|process| {
+        let term = compressible_term(process);
+        let binary = result(process, term, compressed(process)).unwrap();
+
+        assert_eq!(binary_to_term_1::result(process, binary), Ok(term));
+    });
+}
+
+#[test]
+fn with_compressed_with_large_binary_binary_to_term_returns_term() {
+    with_process(|process| {
+        let large_binary = process.binary_from_bytes(&[7; 1_000]);
+        let term = process.tuple_from_slice(&[large_binary, compressible_term(process)]);
+        let binary = result(process, term, compressed(process)).unwrap();
+
+        assert!(process.bytes_from_binary(binary).unwrap().len() < 1_000);
+        assert_eq!(binary_to_term_1::result(process, binary), Ok(term));
+    });
+}
+
+#[test]
+fn with_compressed_with_incompressible_term_returns_uncompressed() {
+    with_process(|process| {
+        let term = Atom::str_to_term("a");
+
+        assert_eq!(
+            result(process, term, compressed(process)),
+            Ok(term_to_binary_1::result(process, term))
+        );
+    });
+}
+
+#[test]
+fn with_compressed_level_zero_returns_uncompressed() {
+    with_process(|process| {
+        let term = compressible_term(process);
+        let option =
+            process.tuple_from_slice(&[Atom::str_to_term("compressed"), process.integer(0)]);
+        let options = process.list_from_slice(&[option]);
+
+        assert_eq!(
+            result(process, term, options),
+            Ok(term_to_binary_1::result(process, term))
+        );
+    });
+}
+
+const VERSION_NUMBER: u8 = 131;
+
+const COMPRESSED: u8 = 80;
+
+fn compressed(process: &Process) -> Term {
+    process.list_from_slice(&[Atom::str_to_term("compressed")])
+}
+
+fn compressible_term(process: &Process) -> Term {
+    let element = process.tuple_from_slice(&[Atom::str_to_term("element"), process.integer(0)]);
+    let elements = vec![element; 100];
+
+    process.list_from_slice(&elements)
+}
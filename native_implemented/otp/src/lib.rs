@@ -3,6 +3,8 @@
 #![feature(backtrace)]
 #![feature(thread_local)]
 #![feature(unwind_attributes)]
+// Support benchmarks
+#![feature(test)]
 
 #[macro_use]
 mod macros;
@@ -81,7 +81,7 @@ macro_rules! assert_has_message {
             has_message(process, $message),
             "Mailbox does not contain {:?} and instead contains {:?}",
             $message,
-            process.mailbox.lock().borrow()
+            process.mailbox().borrow()
         );
     }};
 }
@@ -9,8 +9,5 @@ use liblumen_alloc::erts::term::prelude::*;
 pub fn result(process: &Process, key: Term, map: Term) -> exception::Result<Term> {
     let boxed_map = term_try_into_map_or_badmap!(process, map)?;
 
-    match boxed_map.remove(key) {
-        Some(hash_map) => Ok(process.map_from_hash_map(hash_map)),
-        None => Ok(map),
-    }
+    Ok(process.map_remove(&boxed_map, key))
 }
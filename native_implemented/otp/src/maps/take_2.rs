@@ -10,9 +10,9 @@ use liblumen_alloc::erts::term::prelude::*;
 pub fn result(process: &Process, key: Term, map: Term) -> exception::Result<Term> {
     let boxed_map = term_try_into_map_or_badmap!(process, map)?;
 
-    let result = match boxed_map.take(key) {
-        Some((value, hash_map)) => {
-            let map = process.map_from_hash_map(hash_map);
+    let result = match boxed_map.get(key) {
+        Some(value) => {
+            let map = process.map_remove(&boxed_map, key);
             process.tuple_from_slice(&[value, map])
         }
         None => atom!("error"),
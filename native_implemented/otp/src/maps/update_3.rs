@@ -12,13 +12,14 @@ use liblumen_alloc::erts::term::prelude::*;
 pub fn result(process: &Process, key: Term, value: Term, map: Term) -> exception::Result<Term> {
     let boxed_map = term_try_into_map_or_badmap!(process, map)?;
 
-    match boxed_map.update(key, value) {
-        Some(hash_map) => Ok(process.map_from_hash_map(hash_map)),
-        None => Err(badkey(
+    if boxed_map.is_key(key) {
+        Ok(process.map_put(&boxed_map, key, value))
+    } else {
+        Err(badkey(
             process,
             key,
             Trace::capture(),
             anyhow!("key ({}) does not exist in map ({})", key, map).into(),
-        )),
+        ))
     }
 }
@@ -76,7 +76,7 @@ pub fn external_arc_node() -> Arc<Node> {
 }
 
 pub fn has_message(process: &Process, data: Term) -> bool {
-    process.mailbox.lock().borrow().iter().any(|message| {
+    process.mailbox().borrow().iter().any(|message| {
         &data
             == match message {
                 Message::Process(message::Process { data }) => data,
@@ -87,8 +87,7 @@ pub fn has_message(process: &Process, data: Term) -> bool {
 
 pub fn has_heap_message(process: &Process, data: Term) -> bool {
     process
-        .mailbox
-        .lock()
+        .mailbox()
         .borrow()
         .iter()
         .any(|message| match message {
@@ -101,8 +100,7 @@ pub fn has_heap_message(process: &Process, data: Term) -> bool {
 
 pub fn has_process_message(process: &Process, data: Term) -> bool {
     process
-        .mailbox
-        .lock()
+        .mailbox()
         .borrow()
         .iter()
         .any(|message| match message {
@@ -164,8 +162,7 @@ pub fn number_to_integer_with_float(
 
 pub fn receive_message(process: &Process) -> Option<Term> {
     process
-        .mailbox
-        .lock()
+        .mailbox()
         .borrow_mut()
         .receive(process)
         .map(|result| result.unwrap())
@@ -1,9 +1,8 @@
 use std::convert::TryInto;
 use std::panic;
 
-use hashbrown::HashMap;
-
 use liblumen_alloc::erts::term::{binary, prelude::*};
+use liblumen_alloc::HeapFragment;
 use liblumen_core::sys::Endianness;
 
 use crate::process::current_process;
@@ -34,20 +33,49 @@ pub extern "C" fn builtin_bigint_from_cstr(ptr: *const u8, size: usize) -> Term
     current_process().integer(value)
 }
 
+/// Literals must be at least word-aligned on all targets so that the pointer
+/// can carry the literal tag
+#[repr(C, align(8))]
+struct AlignedLiteral<T>(T);
+
+/// Moves the given term out of any process heap and returns a literal-tagged
+/// pointer to it. The value is never freed, and is ignored by the garbage
+/// collector, so this is only suitable for compile-time constants, which are
+/// materialized once and cached by the generated code.
+fn leak_literal<T>(value: T) -> Term {
+    let literal: &'static AlignedLiteral<T> = Box::leak(Box::new(AlignedLiteral(value)));
+    Term::encode_literal(&literal.0 as *const T)
+}
+
+#[export_name = "__lumen_builtin_bigint_literal"]
+pub extern "C" fn builtin_bigint_literal(ptr: *const u8, size: usize) -> Term {
+    let bytes = unsafe { core::slice::from_raw_parts(ptr, size) };
+    let value = BigInteger::from_bytes(bytes).unwrap();
+    leak_literal(value)
+}
+
+/// Constructs a literal map from `len` key/value pairs, stored as a flat array
+/// of alternating keys and values, all of which must themselves be literals
+/// or immediates
+#[export_name = "__lumen_builtin_map_literal"]
+pub extern "C" fn builtin_map_literal(entries: *const Term, len: usize) -> Term {
+    let entries = unsafe { core::slice::from_raw_parts(entries, len * 2) };
+    let pairs: Vec<(Term, Term)> = entries.chunks(2).map(|kv| (kv[0], kv[1])).collect();
+    // The fragment is never attached to a process, so it is leaked along with the map
+    let (map, _) = HeapFragment::new_map_from_slice(pairs.as_slice()).unwrap();
+    unsafe { Map::into_literal(map) }
+}
+
 #[export_name = "__lumen_builtin_map.new"]
 pub extern "C" fn builtin_map_new() -> Term {
-    current_process().map_from_hash_map(HashMap::default())
+    current_process().map_from_slice(&[])
 }
 
 #[export_name = "__lumen_builtin_map.insert"]
 pub extern "C" fn builtin_map_insert(map: Term, key: Term, value: Term) -> Term {
     let decoded_map: Result<Boxed<Map>, _> = map.decode().unwrap().try_into();
     if let Ok(m) = decoded_map {
-        if let Some(new_map) = m.put(key, value) {
-            current_process().map_from_hash_map(new_map)
-        } else {
-            map
-        }
+        current_process().map_put(&m, key, value)
     } else {
         Term::NONE
     }
@@ -57,8 +85,8 @@ pub extern "C" fn builtin_map_insert(map: Term, key: Term, value: Term) -> Term
 pub extern "C" fn builtin_map_update(map: Term, key: Term, value: Term) -> Term {
     let decoded_map: Result<Boxed<Map>, _> = map.decode().unwrap().try_into();
     if let Ok(m) = decoded_map {
-        if let Some(new_map) = m.update(key, value) {
-            current_process().map_from_hash_map(new_map)
+        if m.is_key(key) {
+            current_process().map_put(&m, key, value)
         } else {
             // TODO: Trigger badkey error
             Term::NONE
@@ -4,6 +4,7 @@ mod atom_utf8;
 mod big;
 mod binary;
 mod bit_binary;
+mod compressed;
 mod export;
 mod f64;
 mod i32;
@@ -13,6 +14,7 @@ mod list;
 mod map;
 mod new_float;
 mod new_function;
+mod need_in_words;
 mod new_pid;
 mod newer_reference;
 mod pid;
@@ -38,10 +40,11 @@ use anyhow::*;
 use num_enum::{IntoPrimitive, TryFromPrimitive};
 use thiserror::Error;
 
-use liblumen_alloc::erts::exception::{ArcError, InternalException, InternalResult};
+use liblumen_alloc::erts::exception::{AllocResult, ArcError, InternalException, InternalResult};
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::closure::Creator;
 use liblumen_alloc::erts::term::prelude::{Pid as LocalPid, *};
-use liblumen_alloc::erts::{Node, Process};
+use liblumen_alloc::erts::Node;
 use liblumen_alloc::CloneToProcess;
 
 use crate::distribution::nodes::node;
@@ -75,6 +78,17 @@ pub enum DecodeError {
     UnexpectedVersion { version: u8, backtrace: Backtrace },
     #[error("unexpected tag ({tag})")]
     UnexpectedTag { tag: Tag, backtrace: Backtrace },
+    #[error("compressed term could not be inflated ({status})")]
+    Inflate {
+        status: String,
+        backtrace: Backtrace,
+    },
+    #[error("compressed term inflated to {actual} bytes, but its uncompressed size is {expected}")]
+    UncompressedSize {
+        expected: usize,
+        actual: usize,
+        backtrace: Backtrace,
+    },
 }
 
 impl From<DecodeError> for InternalException {
@@ -88,6 +102,7 @@ impl From<DecodeError> for InternalException {
 pub enum Tag {
     NewFloat = 70,
     BitBinary = 77,
+    Compressed = 80,
     AtomCacheReference = 82,
     NewPID = 88,
     NewPort = 89,
@@ -169,10 +184,10 @@ impl Pid {
         Ok(pid)
     }
 
-    fn clone_to_process(&self, process: &Process) -> Term {
+    fn clone_to_heap<H: TermAlloc>(&self, heap: &mut H) -> AllocResult<Term> {
         match self {
-            Pid::Local(local_pid) => local_pid.clone().into(),
-            Pid::External(external_pid) => external_pid.clone_to_process(process),
+            Pid::Local(local_pid) => Ok(local_pid.clone().into()),
+            Pid::External(external_pid) => external_pid.clone_to_heap(heap),
         }
     }
 }
@@ -186,10 +201,64 @@ impl Into<Creator> for Pid {
     }
 }
 
+/// The binary that terms are decoded from
+///
+/// Binaries in it that are too large to be heap binaries are decoded as subbinaries of it, rather
+/// than being copied.
+pub struct Original {
+    binary: Term,
+    bytes: *const u8,
+}
+
+impl Original {
+    /// `binary` may be any binary, but subbinaries are taken of the heap binary, process binary or
+    /// binary literal that its bytes are part of
+    pub fn new(binary: Term) -> Self {
+        match binary.decode().unwrap() {
+            TypedTerm::HeapBinary(heap_bin) => Self {
+                binary,
+                bytes: heap_bin.as_bytes().as_ptr(),
+            },
+            TypedTerm::ProcBin(proc_bin) => Self {
+                binary,
+                bytes: proc_bin.as_bytes().as_ptr(),
+            },
+            TypedTerm::BinaryLiteral(binary_literal) => Self {
+                binary,
+                bytes: binary_literal.as_bytes().as_ptr(),
+            },
+            TypedTerm::SubBinary(subbinary) => Self::new(subbinary.original()),
+            TypedTerm::MatchContext(match_context) => Self::new(match_context.original()),
+            _ => panic!("original ({}) is not a binary", binary),
+        }
+    }
+
+    /// Returns a subbinary of `bytes`, which must be part of the original binary
+    fn subbinary_from_bytes<H: TermAlloc>(
+        &self,
+        heap: &mut H,
+        bytes: &[u8],
+        full_byte_len: usize,
+        partial_byte_bit_len: u8,
+    ) -> AllocResult<Term> {
+        let byte_offset = bytes.as_ptr() as usize - self.bytes as usize;
+
+        heap.subbinary_from_original(
+            self.binary,
+            byte_offset,
+            0,
+            full_byte_len,
+            partial_byte_bit_len,
+        )
+        .map(|subbinary| subbinary.into())
+    }
+}
+
 // Private
 
-fn decode_vec_term<'a>(
-    process: &Process,
+fn decode_vec_term<'a, H: TermAlloc>(
+    heap: &mut H,
+    original: &Original,
     safe: bool,
     bytes: &'a [u8],
     len: usize,
@@ -198,7 +267,8 @@ fn decode_vec_term<'a>(
     let mut remaining_bytes = bytes;
 
     for _ in 0..len {
-        let (element, after_element_bytes) = term::decode_tagged(process, safe, remaining_bytes)?;
+        let (element, after_element_bytes) =
+            term::decode_tagged(heap, original, safe, remaining_bytes)?;
         element_vec.push(element);
         remaining_bytes = after_element_bytes;
     }
@@ -0,0 +1,50 @@
+//! `COMPRESSED` terms are the uncompressed size, followed by the zlib deflated encoding of the
+//! term, which runs to the end of the bytes.
+use std::backtrace::Backtrace;
+
+use miniz_oxide::inflate;
+
+use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
+use liblumen_alloc::erts::term::prelude::*;
+
+use super::{term, u32, DecodeError, Original};
+
+/// The inflated bytes are copied to a heap binary, so that binaries in the term can be subbinaries
+/// of it, the same as they are of an uncompressed original
+pub fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
+    safe: bool,
+    bytes: &'a [u8],
+) -> InternalResult<(Term, &'a [u8])> {
+    let (inflated, after_compressed_bytes) = inflate(bytes)?;
+    let inflated_binary = heap.heapbin_from_bytes(&inflated)?;
+    let original = Original::new(inflated_binary.into());
+    let (term, _) = term::decode_tagged(heap, &original, safe, inflated_binary.as_bytes())?;
+
+    Ok((term, after_compressed_bytes))
+}
+
+/// Returns the inflated encoding of the term, and the bytes after the compressed data, which are
+/// always empty
+pub fn inflate(bytes: &[u8]) -> InternalResult<(Vec<u8>, &[u8])> {
+    let (uncompressed_size_u32, after_size_bytes) = u32::decode(bytes)?;
+    let uncompressed_size = uncompressed_size_u32 as usize;
+
+    match inflate::decompress_to_vec_zlib(after_size_bytes) {
+        Ok(inflated) if inflated.len() == uncompressed_size => {
+            Ok((inflated, &after_size_bytes[after_size_bytes.len()..]))
+        }
+        Ok(inflated) => Err(DecodeError::UncompressedSize {
+            expected: uncompressed_size,
+            actual: inflated.len(),
+            backtrace: Backtrace::capture(),
+        }
+        .into()),
+        Err(status) => Err(DecodeError::Inflate {
+            status: format!("{:?}", status),
+            backtrace: Backtrace::capture(),
+        }
+        .into()),
+    }
+}
@@ -3,15 +3,15 @@ use std::mem;
 use std::ptr::NonNull;
 
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
 use super::{atom, small_integer};
 use liblumen_alloc::erts::apply::find_symbol;
 use liblumen_alloc::ModuleFunctionArity;
 
-pub fn decode<'a>(
-    process: &Process,
+pub fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
@@ -30,7 +30,9 @@ pub fn decode<'a>(
         NonNull::new_unchecked(ptr)
     });
 
-    let closure = process.export_closure(module, function, arity, option_native);
+    let closure = heap
+        .export_closure(module, function, arity, option_native)?
+        .into();
 
     Ok((closure, after_arity_bytes))
 }
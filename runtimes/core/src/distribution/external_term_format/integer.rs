@@ -1,12 +1,12 @@
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
 use super::i32;
 
-pub fn decode<'a>(process: &Process, bytes: &'a [u8]) -> InternalResult<(Term, &'a [u8])> {
+pub fn decode<'a, H: TermAlloc>(heap: &mut H, bytes: &'a [u8]) -> InternalResult<(Term, &'a [u8])> {
     let (integer_i32, after_integer_bytes) = i32::decode(bytes)?;
-    let integer = process.integer(integer_i32);
+    let integer = heap.integer(integer_i32)?;
 
     Ok((integer, after_integer_bytes))
 }
@@ -1,20 +1,21 @@
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
-use super::{decode_vec_term, term, u32};
+use super::{decode_vec_term, term, u32, Original};
 
-pub fn decode<'a>(
-    process: &Process,
+pub fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
+    original: &Original,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
     let (len_32, after_len_bytes) = u32::decode(bytes)?;
     let (element_vec, after_elements_bytes) =
-        decode_vec_term(process, safe, after_len_bytes, len_32 as usize)?;
-    let (tail, after_tail_bytes) = term::decode_tagged(process, safe, after_elements_bytes)?;
+        decode_vec_term(heap, original, safe, after_len_bytes, len_32 as usize)?;
+    let (tail, after_tail_bytes) = term::decode_tagged(heap, original, safe, after_elements_bytes)?;
 
-    let list = process.improper_list_from_slice(&element_vec, tail);
+    let list = heap.improper_list_from_slice(&element_vec, tail)?.into();
 
     Ok((list, after_tail_bytes))
 }
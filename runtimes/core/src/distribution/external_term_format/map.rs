@@ -1,29 +1,29 @@
-use hashbrown::HashMap;
-
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
-use super::{term, u32};
+use super::{term, u32, Original};
 
-pub fn decode<'a>(
-    process: &Process,
+pub fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
+    original: &Original,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
     let (pair_len_u32, after_len_bytes) = u32::decode(bytes)?;
     let pair_len_usize = pair_len_u32 as usize;
-    let mut hash_map: HashMap<Term, Term> = HashMap::with_capacity(pair_len_usize);
+    let mut pair_vec: Vec<(Term, Term)> = Vec::with_capacity(pair_len_usize);
     let mut remaining_bytes = after_len_bytes;
 
     for _ in 0..pair_len_usize {
-        let (key, after_key_bytes) = term::decode_tagged(process, safe, remaining_bytes)?;
-        let (value, after_value_bytes) = term::decode_tagged(process, safe, after_key_bytes)?;
-        hash_map.insert(key, value);
+        let (key, after_key_bytes) = term::decode_tagged(heap, original, safe, remaining_bytes)?;
+        let (value, after_value_bytes) =
+            term::decode_tagged(heap, original, safe, after_key_bytes)?;
+        pair_vec.push((key, value));
         remaining_bytes = after_value_bytes;
     }
 
-    let map = process.map_from_hash_map(hash_map);
+    let map = heap.map_from_slice(&pair_vec)?.into();
 
     Ok((map, remaining_bytes))
 }
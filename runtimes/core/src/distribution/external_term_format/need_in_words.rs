@@ -0,0 +1,297 @@
+//! Counts the words needed on the heap to decode a term, without decoding it, so that all of the
+//! term can be allocated at once.
+//!
+//! Counts are exact or over-estimates, except for maps too large to be flatmaps, whose size is
+//! estimated by `Map::need_in_words_from_len`.
+use std::backtrace::Backtrace;
+use std::mem;
+
+use liblumen_alloc::erts::exception::{InternalException, InternalResult};
+use liblumen_alloc::erts::term::closure::ClosureLayout;
+use liblumen_alloc::erts::term::prelude::*;
+use liblumen_alloc::erts::to_word_size;
+
+use super::{i32, isize, try_split_at, u16, u32, u8, DecodeError, Tag};
+
+pub fn tagged(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (tag, after_tag_bytes) = Tag::decode(bytes)?;
+
+    match tag {
+        Tag::Atom | Tag::AtomUTF8 | Tag::SmallAtom | Tag::SmallAtomUTF8 => {
+            let after_atom_bytes = skip_atom(tag, after_tag_bytes)?;
+
+            Ok((0, after_atom_bytes))
+        }
+        Tag::AtomCacheReference => unimplemented!("{:?}", tag),
+        Tag::Binary => binary(after_tag_bytes),
+        Tag::BitBinary => bit_binary(after_tag_bytes),
+        Tag::Compressed => compressed(after_tag_bytes),
+        Tag::Export => export(after_tag_bytes),
+        Tag::Float => unimplemented!("{:?}", tag),
+        Tag::Function => unimplemented!("{:?}", tag),
+        Tag::Integer => {
+            let (integer_i32, after_integer_bytes) = i32::decode(after_tag_bytes)?;
+            let integer: Integer = integer_i32.into();
+            let words = match integer {
+                Integer::Small(_) => 0,
+                Integer::Big(_) => words_of::<BigInteger>(),
+            };
+
+            Ok((words, after_integer_bytes))
+        }
+        Tag::LargeBig => {
+            let (len_u32, after_len_bytes) = u32::decode(after_tag_bytes)?;
+
+            big(after_len_bytes, len_u32 as usize)
+        }
+        Tag::LargeTuple => {
+            let (len_u32, after_len_bytes) = u32::decode(after_tag_bytes)?;
+
+            tuple(after_len_bytes, len_u32 as usize)
+        }
+        Tag::List => list(after_tag_bytes),
+        Tag::Map => map(after_tag_bytes),
+        Tag::NewFloat => {
+            let (_, after_float_bytes) = try_split_at(after_tag_bytes, mem::size_of::<f64>())?;
+            let words = if cfg!(target_arch = "x86_64") {
+                0
+            } else {
+                words_of::<Float>()
+            };
+
+            Ok((words, after_float_bytes))
+        }
+        Tag::NewFunction => new_function(after_tag_bytes),
+        Tag::NewPID | Tag::PID => {
+            let after_pid_bytes = skip_pid(tag, after_tag_bytes)?;
+
+            // Local pids are immediates, but the node has not been looked up yet
+            Ok((words_of::<ExternalPid>(), after_pid_bytes))
+        }
+        Tag::NewPort => unimplemented!("{:?}", tag),
+        Tag::NewReference => unimplemented!("{:?}", tag),
+        Tag::NewerReference => newer_reference(after_tag_bytes),
+        Tag::Nil => Ok((0, after_tag_bytes)),
+        Tag::Port => unimplemented!("{:?}", tag),
+        Tag::Reference => unimplemented!("{:?}", tag),
+        Tag::SmallBig => {
+            let (len_u8, after_len_bytes) = u8::decode(after_tag_bytes)?;
+
+            big(after_len_bytes, len_u8 as usize)
+        }
+        Tag::SmallInteger => {
+            let (_, after_small_integer_bytes) = u8::decode(after_tag_bytes)?;
+
+            Ok((0, after_small_integer_bytes))
+        }
+        Tag::SmallTuple => {
+            let (len_u8, after_len_bytes) = u8::decode(after_tag_bytes)?;
+
+            tuple(after_len_bytes, len_u8 as usize)
+        }
+        Tag::String => {
+            let (len_u16, after_len_bytes) = u16::decode(after_tag_bytes)?;
+            let len_usize = len_u16 as usize;
+            let (_, after_characters_bytes) = try_split_at(after_len_bytes, len_usize)?;
+
+            Ok((
+                Cons::need_in_words_from_len(len_usize),
+                after_characters_bytes,
+            ))
+        }
+    }
+}
+
+// Private
+
+fn big(bytes: &[u8], len: usize) -> InternalResult<(usize, &[u8])> {
+    // Sign byte, then digits
+    let (_, after_big_bytes) = try_split_at(bytes, 1 + len)?;
+
+    // Small enough values are decoded as small integers instead
+    Ok((words_of::<BigInteger>(), after_big_bytes))
+}
+
+fn binary(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (len_u32, after_len_bytes) = u32::decode(bytes)?;
+    let len_usize = len_u32 as usize;
+    let (data_bytes, after_data_bytes) = try_split_at(after_len_bytes, len_usize)?;
+
+    Ok((binary_words(data_bytes), after_data_bytes))
+}
+
+fn binary_words(data_bytes: &[u8]) -> usize {
+    if data_bytes.len() <= HeapBin::MAX_SIZE {
+        let (layout, _, _) = HeapBin::layout_for(data_bytes);
+
+        to_word_size(layout.size())
+    } else {
+        words_of::<SubBinary>()
+    }
+}
+
+fn compressed(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (inflated, after_compressed_bytes) = super::compressed::inflate(bytes)?;
+    // The inflated bytes are decoded from a heap binary of them
+    let (layout, _, _) = HeapBin::layout_for(&inflated);
+    let (term_words, _) = tagged(&inflated)?;
+
+    Ok((
+        to_word_size(layout.size()) + term_words,
+        after_compressed_bytes,
+    ))
+}
+
+fn bit_binary(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (len_u32, after_len_bytes) = u32::decode(bytes)?;
+    let len_usize = len_u32 as usize;
+    let (_, after_partial_byte_bit_len_bytes) = u8::decode(after_len_bytes)?;
+    let (data_bytes, after_data_bytes) = try_split_at(after_partial_byte_bit_len_bytes, len_usize)?;
+
+    let words = if len_usize <= HeapBin::MAX_SIZE {
+        binary_words(data_bytes) + words_of::<SubBinary>()
+    } else {
+        words_of::<SubBinary>()
+    };
+
+    Ok((words, after_data_bytes))
+}
+
+fn export(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let after_module_bytes = skip_tagged_atom(bytes)?;
+    let after_function_bytes = skip_tagged_atom(after_module_bytes)?;
+    let (_, after_arity_bytes) = isize::decode(after_function_bytes)?;
+
+    Ok((closure_words(0), after_arity_bytes))
+}
+
+fn list(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (len_u32, after_len_bytes) = u32::decode(bytes)?;
+    let len_usize = len_u32 as usize;
+    let (elements_words, after_elements_bytes) = vec_term(after_len_bytes, len_usize)?;
+    let (tail_words, after_tail_bytes) = tagged(after_elements_bytes)?;
+
+    // A list without elements, but with a tail, is still given a cell
+    let cons_words = Cons::need_in_words_from_len(len_usize.max(1));
+
+    Ok((cons_words + elements_words + tail_words, after_tail_bytes))
+}
+
+fn map(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (pair_len_u32, after_len_bytes) = u32::decode(bytes)?;
+    let pair_len_usize = pair_len_u32 as usize;
+    let (pairs_words, after_pairs_bytes) = vec_term(after_len_bytes, 2 * pair_len_usize)?;
+
+    Ok((
+        Map::need_in_words_from_len(pair_len_usize) + pairs_words,
+        after_pairs_bytes,
+    ))
+}
+
+fn new_function(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (_total_byte_len, after_size_bytes) = u32::decode(bytes)?;
+    // Arity, Uniq and Index
+    let (_, after_index_bytes) = try_split_at(after_size_bytes, 1 + 16 + 4)?;
+    let (num_free, after_num_free_bytes) = u32::decode(after_index_bytes)?;
+    let after_module_bytes = skip_tagged_atom(after_num_free_bytes)?;
+    let (_, after_old_index_bytes) = isize::decode(after_module_bytes)?;
+    let (_, after_old_uniq_bytes) = isize::decode(after_old_index_bytes)?;
+    let (pid_tag, after_pid_tag_bytes) = Tag::decode(after_old_uniq_bytes)?;
+    let after_creator_bytes = skip_pid(pid_tag, after_pid_tag_bytes)?;
+
+    let env_len = num_free as usize;
+    let (env_words, after_env_bytes) = vec_term(after_creator_bytes, env_len)?;
+
+    Ok((closure_words(env_len) + env_words, after_env_bytes))
+}
+
+fn newer_reference(bytes: &[u8]) -> InternalResult<(usize, &[u8])> {
+    let (u32_len_u16, after_len_bytes) = u16::decode(bytes)?;
+    let after_node_bytes = skip_tagged_atom(after_len_bytes)?;
+    let (_creation, after_creation_bytes) = u32::decode(after_node_bytes)?;
+    let len_usize = (u32_len_u16 as usize) * mem::size_of::<u32>();
+    let (_, after_id_bytes) = try_split_at(after_creation_bytes, len_usize)?;
+
+    Ok((to_word_size(Reference::layout().size()), after_id_bytes))
+}
+
+fn tuple(bytes: &[u8], len: usize) -> InternalResult<(usize, &[u8])> {
+    let (elements_words, after_elements_bytes) = vec_term(bytes, len)?;
+
+    Ok((
+        to_word_size(Tuple::layout_for_len(len).size()) + elements_words,
+        after_elements_bytes,
+    ))
+}
+
+fn vec_term(bytes: &[u8], len: usize) -> InternalResult<(usize, &[u8])> {
+    let mut words = 0;
+    let mut remaining_bytes = bytes;
+
+    for _ in 0..len {
+        let (element_words, after_element_bytes) = tagged(remaining_bytes)?;
+        words += element_words;
+        remaining_bytes = after_element_bytes;
+    }
+
+    Ok((words, remaining_bytes))
+}
+
+fn closure_words(env_len: usize) -> usize {
+    to_word_size(ClosureLayout::for_env_len(env_len).layout().size())
+}
+
+fn skip_atom(tag: Tag, bytes: &[u8]) -> InternalResult<&[u8]> {
+    let (len_usize, after_len_bytes) = match tag {
+        Tag::Atom | Tag::AtomUTF8 => {
+            let (len_u16, after_len_bytes) = u16::decode(bytes)?;
+
+            (len_u16 as usize, after_len_bytes)
+        }
+        Tag::SmallAtom | Tag::SmallAtomUTF8 => {
+            let (len_u8, after_len_bytes) = u8::decode(bytes)?;
+
+            (len_u8 as usize, after_len_bytes)
+        }
+        _ => unreachable!(),
+    };
+    let (_, after_atom_name_bytes) = try_split_at(after_len_bytes, len_usize)?;
+
+    Ok(after_atom_name_bytes)
+}
+
+fn skip_tagged_atom(bytes: &[u8]) -> InternalResult<&[u8]> {
+    let (tag, after_tag_bytes) = Tag::decode(bytes)?;
+
+    match tag {
+        Tag::Atom | Tag::AtomUTF8 | Tag::SmallAtom | Tag::SmallAtomUTF8 => {
+            skip_atom(tag, after_tag_bytes)
+        }
+        _ => Err(unexpected_tag(tag)),
+    }
+}
+
+fn skip_pid(tag: Tag, bytes: &[u8]) -> InternalResult<&[u8]> {
+    let creation_len = match tag {
+        Tag::PID => mem::size_of::<u8>(),
+        Tag::NewPID => mem::size_of::<u32>(),
+        _ => return Err(unexpected_tag(tag)),
+    };
+    let after_node_bytes = skip_tagged_atom(bytes)?;
+    // ID, Serial, then Creation
+    let (_, after_pid_bytes) = try_split_at(after_node_bytes, 4 + 4 + creation_len)?;
+
+    Ok(after_pid_bytes)
+}
+
+fn unexpected_tag(tag: Tag) -> InternalException {
+    DecodeError::UnexpectedTag {
+        tag,
+        backtrace: Backtrace::capture(),
+    }
+    .into()
+}
+
+fn words_of<T>() -> usize {
+    to_word_size(mem::size_of::<T>())
+}
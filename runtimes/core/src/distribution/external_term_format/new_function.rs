@@ -5,16 +5,17 @@ use std::ptr::NonNull;
 
 use liblumen_alloc::erts::apply::find_symbol;
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::closure::{Definition, OldUnique};
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 use liblumen_alloc::ModuleFunctionArity;
 
-use super::{atom, decode_vec_term, isize, u32, u8, Pid};
+use super::{atom, decode_vec_term, isize, u32, u8, Original, Pid};
 use crate::distribution::external_term_format::try_split_at;
 
-pub fn decode<'a>(
-    process: &Process,
+pub fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
+    original: &Original,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
@@ -35,7 +36,7 @@ pub fn decode<'a>(
 
     let env_len: usize = num_free as usize;
     let (env_vec, after_vec_term_bytes) =
-        decode_vec_term(process, safe, after_creator_bytes, env_len)?;
+        decode_vec_term(heap, original, safe, after_creator_bytes, env_len)?;
 
     assert_eq!(
         bytes.len() - after_vec_term_bytes.len(),
@@ -59,7 +60,7 @@ pub fn decode<'a>(
         NonNull::new_unchecked(ptr)
     });
 
-    let closure = process.anonymous_closure_with_env_from_slice(
+    let closure = heap.anonymous_closure_with_env_from_slice(
         module,
         index,
         old_unique,
@@ -68,9 +69,9 @@ pub fn decode<'a>(
         option_native,
         creator.into(),
         &env_vec,
-    );
+    )?;
 
-    Ok((closure, after_vec_term_bytes))
+    Ok((closure.into(), after_vec_term_bytes))
 }
 
 const UNIQ_LEN: usize = 16;
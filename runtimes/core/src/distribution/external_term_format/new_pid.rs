@@ -1,6 +1,6 @@
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
 use super::{arc_node, u32, Pid};
 
@@ -16,11 +16,12 @@ pub fn decode_pid<'a>(safe: bool, bytes: &'a [u8]) -> InternalResult<(Pid, &'a [
     Ok((pid, after_creation_bytes))
 }
 
-pub fn decode_term<'a>(
-    process: &Process,
+pub fn decode_term<'a, H: TermAlloc>(
+    heap: &mut H,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
-    decode_pid(safe, bytes)
-        .map(|(pid, after_pid_bytes)| (pid.clone_to_process(process), after_pid_bytes))
+    let (pid, after_pid_bytes) = decode_pid(safe, bytes)?;
+
+    Ok((pid.clone_to_heap(heap)?, after_pid_bytes))
 }
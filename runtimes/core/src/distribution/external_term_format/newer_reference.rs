@@ -1,16 +1,16 @@
 use std::mem;
 
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
 use crate::distribution::external_term_format::try_split_at;
 use crate::distribution::nodes::node;
 
 use super::{arc_node, u16, u32, u64};
 
-pub fn decode<'a>(
-    process: &Process,
+pub fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
@@ -26,7 +26,7 @@ pub fn decode<'a>(
             let (scheduler_id_u32, after_scheduler_id_bytes) = u32::decode(id_bytes)?;
             let (number_u64, _) = u64::decode(after_scheduler_id_bytes)?;
 
-            let reference = process.reference_from_scheduler(scheduler_id_u32.into(), number_u64);
+            let reference = heap.reference(scheduler_id_u32.into(), number_u64)?.into();
 
             Ok((reference, after_id_bytes))
         } else {
@@ -3,14 +3,14 @@ use std::backtrace::Backtrace;
 use anyhow::*;
 
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
 use super::{u8, DecodeError, Tag};
 
-pub fn decode<'a>(process: &Process, bytes: &'a [u8]) -> InternalResult<(Term, &'a [u8])> {
+pub fn decode<'a, H: TermAlloc>(heap: &mut H, bytes: &'a [u8]) -> InternalResult<(Term, &'a [u8])> {
     let (small_integer_u8, after_small_integer_bytes) = u8::decode(bytes)?;
-    let integer = process.integer(small_integer_u8);
+    let integer = heap.integer(small_integer_u8)?;
 
     Ok((integer, after_small_integer_bytes))
 }
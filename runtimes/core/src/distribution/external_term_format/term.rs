@@ -1,7 +1,63 @@
+use liblumen_alloc::erts::exception::SystemException;
+use liblumen_alloc::erts::process::alloc::Heap;
+use liblumen_alloc::erts::{HeapFragment, Process};
+
 use super::*;
 
-pub fn decode_tagged<'a>(
+/// Decodes the term at the start of `bytes`, which must be part of `original`
+///
+/// The words needed by the whole term are counted before anything is decoded, so that it can all
+/// be allocated on the process heap, or in a single heap fragment when the heap does not have
+/// room, instead of each term being allocated separately.
+pub fn decode<'a>(
     process: &Process,
+    original: &Original,
+    safe: bool,
+    bytes: &'a [u8],
+) -> InternalResult<(Term, &'a [u8])> {
+    let (need_in_words, _) = need_in_words::tagged(bytes)?;
+
+    decode_in_words(process, original, safe, bytes, need_in_words)
+}
+
+/// Decodes the term at the start of `bytes` into room for `need_in_words` words, retrying with
+/// twice the room until it fits
+pub fn decode_in_words<'a>(
+    process: &Process,
+    original: &Original,
+    safe: bool,
+    bytes: &'a [u8],
+    mut need_in_words: usize,
+) -> InternalResult<(Term, &'a [u8])> {
+    loop {
+        let mut heap = process.acquire_heap();
+
+        let result = if need_in_words <= heap.heap_available() {
+            decode_tagged(&mut *heap, original, safe, bytes)
+        } else {
+            // The fragment is attached before it is used, so that it is not leaked, whether or
+            // not decoding succeeds
+            let mut non_null_heap_fragment = process
+                .attach_fragment_or_panic(HeapFragment::new_from_word_size(need_in_words).map(
+                    |non_null_heap_fragment| (non_null_heap_fragment, non_null_heap_fragment),
+                ));
+            let heap_fragment = unsafe { non_null_heap_fragment.as_mut() };
+
+            decode_tagged(heap_fragment, original, safe, bytes)
+        };
+
+        match result {
+            // The count for large maps is only an estimate, so on the rare occasion that it is
+            // too low, try again with more room
+            Err(InternalException::System(SystemException::Alloc(_))) => need_in_words *= 2,
+            result => return result,
+        }
+    }
+}
+
+pub fn decode_tagged<'a, H: TermAlloc>(
+    heap: &mut H,
+    original: &Original,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
@@ -11,31 +67,32 @@ pub fn decode_tagged<'a>(
         Tag::Atom => atom::decode_term(safe, after_tag_bytes),
         Tag::AtomCacheReference => unimplemented!("{:?}", tag),
         Tag::AtomUTF8 => atom_utf8::decode_term(safe, after_tag_bytes),
-        Tag::Binary => binary::decode(process, after_tag_bytes),
-        Tag::BitBinary => bit_binary::decode(process, after_tag_bytes),
-        Tag::Export => export::decode(process, safe, after_tag_bytes),
+        Tag::Binary => binary::decode(heap, original, after_tag_bytes),
+        Tag::BitBinary => bit_binary::decode(heap, original, after_tag_bytes),
+        Tag::Compressed => compressed::decode(heap, safe, after_tag_bytes),
+        Tag::Export => export::decode(heap, safe, after_tag_bytes),
         Tag::Float => unimplemented!("{:?}", tag),
         Tag::Function => unimplemented!("{:?}", tag),
-        Tag::Integer => integer::decode(process, after_tag_bytes),
-        Tag::LargeBig => big::large::decode(process, after_tag_bytes),
-        Tag::LargeTuple => tuple::large::decode(process, safe, after_tag_bytes),
-        Tag::List => list::decode(process, safe, after_tag_bytes),
-        Tag::Map => map::decode(process, safe, after_tag_bytes),
-        Tag::NewFloat => new_float::decode(process, after_tag_bytes),
-        Tag::NewFunction => new_function::decode(process, safe, after_tag_bytes),
-        Tag::NewPID => new_pid::decode_term(process, safe, after_tag_bytes),
+        Tag::Integer => integer::decode(heap, after_tag_bytes),
+        Tag::LargeBig => big::large::decode(heap, after_tag_bytes),
+        Tag::LargeTuple => tuple::large::decode(heap, original, safe, after_tag_bytes),
+        Tag::List => list::decode(heap, original, safe, after_tag_bytes),
+        Tag::Map => map::decode(heap, original, safe, after_tag_bytes),
+        Tag::NewFloat => new_float::decode(heap, after_tag_bytes),
+        Tag::NewFunction => new_function::decode(heap, original, safe, after_tag_bytes),
+        Tag::NewPID => new_pid::decode_term(heap, safe, after_tag_bytes),
         Tag::NewPort => unimplemented!("{:?}", tag),
         Tag::NewReference => unimplemented!("{:?}", tag),
-        Tag::NewerReference => newer_reference::decode(process, safe, after_tag_bytes),
+        Tag::NewerReference => newer_reference::decode(heap, safe, after_tag_bytes),
         Tag::Nil => Ok((Term::NIL, after_tag_bytes)),
-        Tag::PID => pid::decode_term(process, safe, after_tag_bytes),
+        Tag::PID => pid::decode_term(heap, safe, after_tag_bytes),
         Tag::Port => unimplemented!("{:?}", tag),
         Tag::Reference => unimplemented!("{:?}", tag),
         Tag::SmallAtom => small_atom::decode(safe, after_tag_bytes),
         Tag::SmallAtomUTF8 => small_atom_utf8::decode_term(safe, after_tag_bytes),
-        Tag::SmallBig => big::small::decode(process, after_tag_bytes),
-        Tag::SmallInteger => small_integer::decode(process, after_tag_bytes),
-        Tag::SmallTuple => tuple::small::decode(process, safe, after_tag_bytes),
-        Tag::String => string::decode(process, after_tag_bytes),
+        Tag::SmallBig => big::small::decode(heap, after_tag_bytes),
+        Tag::SmallInteger => small_integer::decode(heap, after_tag_bytes),
+        Tag::SmallTuple => tuple::small::decode(heap, original, safe, after_tag_bytes),
+        Tag::String => string::decode(heap, after_tag_bytes),
     }
 }
@@ -2,19 +2,20 @@ pub mod large;
 pub mod small;
 
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
-use super::decode_vec_term;
+use super::{decode_vec_term, Original};
 
-fn decode<'a>(
-    process: &Process,
+fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
+    original: &Original,
     safe: bool,
     bytes: &'a [u8],
     len: usize,
 ) -> InternalResult<(Term, &'a [u8])> {
-    let (element_vec, after_elements_vec) = decode_vec_term(process, safe, bytes, len)?;
-    let tuple = process.tuple_from_slice(&element_vec);
+    let (element_vec, after_elements_vec) = decode_vec_term(heap, original, safe, bytes, len)?;
+    let tuple = heap.tuple_from_slice(&element_vec)?.into();
 
     Ok((tuple, after_elements_vec))
 }
@@ -1,15 +1,16 @@
 use liblumen_alloc::erts::exception::InternalResult;
+use liblumen_alloc::erts::process::alloc::TermAlloc;
 use liblumen_alloc::erts::term::prelude::*;
-use liblumen_alloc::erts::Process;
 
-use super::super::u8;
+use super::super::{u8, Original};
 
-pub fn decode<'a>(
-    process: &Process,
+pub fn decode<'a, H: TermAlloc>(
+    heap: &mut H,
+    original: &Original,
     safe: bool,
     bytes: &'a [u8],
 ) -> InternalResult<(Term, &'a [u8])> {
     let (len_u8, after_len_bytes) = u8::decode(bytes)?;
 
-    super::decode(process, safe, after_len_bytes, len_u8 as usize)
+    super::decode(heap, original, safe, after_len_bytes, len_u8 as usize)
 }
@@ -1,3 +1,4 @@
+mod heap_growth;
 mod message_queue_data;
 
 use std::convert::{TryFrom, TryInto};
@@ -6,6 +7,7 @@ use anyhow::*;
 
 use liblumen_alloc::erts::exception::Alloc;
 use liblumen_alloc::erts::process::alloc::{default_heap_size, heap, next_heap_size};
+use liblumen_alloc::erts::process::gc::{GcPolicy, HeapGrowth};
 use liblumen_alloc::erts::process::priority::Priority;
 use liblumen_alloc::erts::process::Process;
 use liblumen_alloc::erts::term::prelude::*;
@@ -42,6 +44,11 @@ pub struct Options {
     pub min_bin_vheap_size: Option<usize>,
     pub max_heap_size: Option<MaxHeapSize>,
     pub message_queue_data: MessageQueueData,
+    /// Lumen-specific: the curve along which the heap grows between collections
+    pub heap_growth: Option<HeapGrowth>,
+    /// Lumen-specific: whether the heap is compacted by the first collection after the
+    /// process waits for a message
+    pub shrink_on_idle: Option<bool>,
 }
 
 impl Options {
@@ -104,19 +111,44 @@ impl Options {
         };
         let (heap, heap_size) = self.sized_heap()?;
 
-        let process = Process::new(
+        let mut process = Process::new(
             priority,
             parent_process,
             module_function_arity,
             heap,
             heap_size,
         );
+        process.set_gc_policy(self.gc_policy(process.gc_policy()));
 
         Ok(process)
     }
 
     // Private
 
+    /// Applies the garbage collection options to `gc_policy`
+    fn gc_policy(&self, mut gc_policy: GcPolicy) -> GcPolicy {
+        if let Some(fullsweep_after) = self.fullsweep_after {
+            gc_policy.fullsweep_after = fullsweep_after;
+        }
+
+        if let Some(MaxHeapSize {
+            size: Some(size), ..
+        }) = self.max_heap_size
+        {
+            gc_policy.max_heap_size = size;
+        }
+
+        if let Some(heap_growth) = self.heap_growth {
+            gc_policy.heap_growth = heap_growth;
+        }
+
+        if let Some(shrink_on_idle) = self.shrink_on_idle {
+            gc_policy.shrink_on_idle = shrink_on_idle;
+        }
+
+        gc_policy
+    }
+
     /// `heap` size in words.
     fn heap_size(&self) -> usize {
         match self.min_heap_size {
@@ -162,6 +194,13 @@ impl Options {
 
                     Ok(self)
                 }
+                "heap_growth" => {
+                    let heap_growth =
+                        heap_growth::try_from_term(tuple[1]).context("heap_growth")?;
+                    self.heap_growth = Some(heap_growth);
+
+                    Ok(self)
+                }
                 "max_heap_size" => unimplemented!(),
                 "message_queue_data" => {
                     let message_queue_data = tuple[1].try_into().context("message_queue_data")?;
@@ -187,6 +226,12 @@ impl Options {
 
                     Ok(self)
                 }
+                "shrink_on_idle" => {
+                    let shrink_on_idle = tuple[1].try_into().context("shrink_on_idle")?;
+                    self.shrink_on_idle = Some(shrink_on_idle);
+
+                    Ok(self)
+                }
                 name => Err(TryPropListFromTermError::KeywordKeyName(name).into()),
             }
         } else {
@@ -206,17 +251,21 @@ impl Default for Options {
             min_bin_vheap_size: None,
             max_heap_size: None,
             message_queue_data: Default::default(),
+            heap_growth: None,
+            shrink_on_idle: None,
         }
     }
 }
 
 const SUPPORTED_OPTIONS_CONTEXT: &str = "supported options are :link, :monitor, \
      {:fullsweep_after, generational_collections :: pos_integer()}, \
+     {:heap_growth, :fibonacci | {:geometric, percent :: 1..255}}, \
      {:max_heap_size, words :: pos_integer()}, \
      {:message_queue_data, :off_heap | :on_heap}, \
      {:min_bin_vheap_size, words :: pos_integer()}, \
-     {:min_heap_size, words :: pos_integer()}, and \
-     {:priority, level :: :low | :normal | :high | :max}";
+     {:min_heap_size, words :: pos_integer()}, \
+     {:priority, level :: :low | :normal | :high | :max}, and \
+     {:shrink_on_idle, boolean()}";
 
 impl TryFrom<Term> for Options {
     type Error = anyhow::Error;
@@ -0,0 +1,38 @@
+use std::convert::TryInto;
+
+use anyhow::*;
+
+use liblumen_alloc::erts::process::gc::HeapGrowth;
+use liblumen_alloc::erts::term::prelude::*;
+
+/// Converts `fibonacci` or `{geometric, percent}` to the `HeapGrowth` it names
+pub fn try_from_term(term: Term) -> anyhow::Result<HeapGrowth> {
+    match term.decode().unwrap() {
+        TypedTerm::Atom(atom) => match atom.name() {
+            "fibonacci" => Ok(HeapGrowth::Fibonacci),
+            name => Err(TryAtomFromTermError(name)).context(SUPPORTED_HEAP_GROWTH_CONTEXT),
+        },
+        TypedTerm::Tuple(tuple) if tuple.len() == 2 => {
+            let atom: Atom = tuple[0].try_into().context(SUPPORTED_HEAP_GROWTH_CONTEXT)?;
+
+            match atom.name() {
+                "geometric" => {
+                    let percent: u8 = tuple[1]
+                        .try_into()
+                        .context("geometric percent is not between 1 and 255")?;
+
+                    if 0 < percent {
+                        Ok(HeapGrowth::Geometric(percent))
+                    } else {
+                        Err(anyhow!("geometric percent is not between 1 and 255"))
+                    }
+                }
+                name => Err(TryAtomFromTermError(name)).context(SUPPORTED_HEAP_GROWTH_CONTEXT),
+            }
+        }
+        _ => Err(anyhow!(SUPPORTED_HEAP_GROWTH_CONTEXT)),
+    }
+}
+
+const SUPPORTED_HEAP_GROWTH_CONTEXT: &str =
+    "supported heap_growth are fibonacci or {geometric, percent :: 1..255}";
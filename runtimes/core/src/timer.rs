@@ -127,6 +127,19 @@ impl Hierarchy {
         }
     }
 
+    /// Returns the time at which the next timer is due, or `None` if there are no timers
+    pub fn next_timeout(&self) -> Option<Monotonic> {
+        if !self.at_once.is_empty() {
+            return Some(self.soon.slot_monotonic);
+        }
+
+        // Timers in each wheel are due before those in the next
+        self.soon
+            .first_monotonic()
+            .or_else(|| self.later.first_monotonic())
+            .or_else(|| self.long_term.first_monotonic())
+    }
+
     pub fn read(&self, timer_reference_number: ReferenceNumber) -> Option<Milliseconds> {
         self.timer_by_reference_number
             .get(&timer_reference_number)
@@ -205,6 +218,18 @@ impl Hierarchy {
         self.timeout_at_once();
 
         let monotonic = monotonic::time();
+
+        // Without any timers, skip straight to the current time, instead of stepping through
+        // every slot since the last call, which may have been a long time ago if idle
+        if self.is_empty() {
+            if self.soon.slot_monotonic < monotonic {
+                self.soon.slot_monotonic = monotonic;
+                self.later.slot_monotonic = monotonic + Self::SOON_TOTAL_MILLISECONDS;
+            }
+
+            return;
+        }
+
         let milliseconds = monotonic - self.soon.slot_monotonic;
 
         for _ in 0..milliseconds.into() {
@@ -232,6 +257,13 @@ impl Hierarchy {
         }
     }
 
+    fn is_empty(&self) -> bool {
+        self.at_once.is_empty()
+            && self.soon.len == 0
+            && self.later.len == 0
+            && self.long_term.is_empty()
+    }
+
     fn timeout_at_once(&mut self) {
         for arc_timer in self.at_once.drain(..) {
             self.timer_by_reference_number
@@ -609,6 +641,10 @@ impl Slot {
         self.0.drain(0..exclusive_end_bound)
     }
 
+    fn first_monotonic(&self) -> Option<Monotonic> {
+        self.0.first().map(|arc_timer| arc_timer.monotonic)
+    }
+
     fn is_empty(&self) -> bool {
         self.0.is_empty()
     }
@@ -692,6 +728,8 @@ struct Wheel {
     slots: Vec<Slot>,
     slot_index: SlotIndex,
     slot_monotonic: Monotonic,
+    /// The number of timers in all slots
+    len: usize,
 }
 
 impl Wheel {
@@ -709,6 +747,7 @@ impl Wheel {
             slots: vec![Default::default(); Self::SLOTS.0 as usize],
             slot_index,
             slot_monotonic,
+            len: 0,
         }
     }
 
@@ -717,18 +756,41 @@ impl Wheel {
         slot_index: SlotIndex,
         reference_number: ReferenceNumber,
     ) -> Option<Arc<Timer>> {
-        self.slots[slot_index.0 as usize].cancel(reference_number)
+        let cancelled = self.slots[slot_index.0 as usize].cancel(reference_number);
+        if cancelled.is_some() {
+            self.len -= 1;
+        }
+
+        cancelled
     }
 
     fn drain<R>(&mut self, range: R) -> Drain<Arc<Timer>>
     where
         R: RangeBounds<usize>,
     {
-        self.slots[self.slot_index.0 as usize].drain(range)
+        let drain = self.slots[self.slot_index.0 as usize].drain(range);
+        self.len -= drain.len();
+
+        drain
     }
 
     fn drain_before_or_at(&mut self, max_monotonic: Monotonic) -> Drain<Arc<Timer>> {
-        self.slots[self.slot_index.0 as usize].drain_before_or_at(max_monotonic)
+        let drain = self.slots[self.slot_index.0 as usize].drain_before_or_at(max_monotonic);
+        self.len -= drain.len();
+
+        drain
+    }
+
+    /// Returns the time at which the first timer in the wheel is due
+    fn first_monotonic(&self) -> Option<Monotonic> {
+        if self.len == 0 {
+            return None;
+        }
+
+        // Slots are in order of time starting at the current slot
+        (0..Self::SLOTS.0)
+            .map(|offset| (self.slot_index + offset) % Self::SLOTS)
+            .find_map(|slot_index| self.slots[slot_index.0 as usize].first_monotonic())
     }
 
     fn is_empty(&self) -> bool {
@@ -758,7 +820,8 @@ impl Wheel {
     }
 
     fn start(&mut self, slot_index: SlotIndex, arc_timer: Arc<Timer>) {
-        self.slots[slot_index.0 as usize].start(arc_timer)
+        self.slots[slot_index.0 as usize].start(arc_timer);
+        self.len += 1;
     }
 }
 
@@ -36,12 +36,20 @@ pub fn main_internal() -> i32 {
     use crate::symbols::*;
 
     // Initialize atom table
-    if unsafe { InitializeLumenAtomTable(ATOM_TABLE, NUM_ATOMS) } == false {
+    if unsafe { InitializeLumenAtomIndex(&ATOM_INDEX) } == false {
         return 102;
     }
 
     // Initialize the dispatch table
-    if unsafe { InitializeLumenDispatchTable(SYMBOL_TABLE, NUM_SYMBOLS) } == false {
+    if unsafe {
+        InitializeLumenDispatchIndex(
+            SYMBOL_TABLE,
+            NUM_SYMBOLS,
+            SYMBOL_MODULES,
+            NUM_SYMBOL_MODULES,
+        )
+    } == false
+    {
         return 103;
     }
 
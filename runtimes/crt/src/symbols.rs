@@ -1,4 +1,4 @@
-use liblumen_core::symbols::FunctionSymbol;
+use liblumen_core::symbols::{FunctionSymbol, ModuleSymbols};
 
 extern "C" {
     /// This symbol is defined in the compiled executable,
@@ -17,6 +17,23 @@ extern "C" {
     #[link_name = "__LUMEN_SYMBOL_TABLE"]
     pub static SYMBOL_TABLE: *const FunctionSymbol;
 
+    /// This symbol is defined in the compiled executable,
+    /// and specifies the number of entries in the module index.
+    #[link_name = "__LUMEN_SYMBOL_MODULES_SIZE"]
+    pub static NUM_SYMBOL_MODULES: usize;
+
+    /// This symbol is defined in the compiled executable,
+    /// and provides a pointer to the module index of the symbol table.
+    /// Each entry gives the range of the symbol table occupied by the
+    /// symbols of a single module, and the index is sorted by module.
+    #[link_name = "__LUMEN_SYMBOL_MODULES"]
+    pub static SYMBOL_MODULES: *const ModuleSymbols;
+
     /// This function is defined in `liblumen_alloc::erts::apply`
-    pub fn InitializeLumenDispatchTable(table: *const FunctionSymbol, len: usize) -> bool;
+    pub fn InitializeLumenDispatchIndex(
+        table: *const FunctionSymbol,
+        len: usize,
+        modules: *const ModuleSymbols,
+        modules_len: usize,
+    ) -> bool;
 }
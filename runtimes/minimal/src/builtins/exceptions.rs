@@ -36,6 +36,13 @@ pub extern "C" fn builtin_trace_print(kind: Term, reason: Term, trace: &mut Trac
     trace
 }
 
+#[unwind(allowed)]
+#[export_name = "__lumen_builtin_trace.from_term"]
+pub extern "C" fn builtin_trace_from_term(term: Term) -> *mut Trace {
+    let trace = Trace::from_term(term);
+    Trace::into_raw(trace)
+}
+
 #[unwind(allowed)]
 #[export_name = "__lumen_builtin_trace.construct"]
 pub extern "C" fn builtin_trace_construct(trace: &mut Trace) -> Term {
@@ -101,7 +101,7 @@ pub extern "C" fn builtin_receive_start(timeout: Term) -> *mut ReceiveContext {
     // could keep it on the stack rather than heap allocate here
     let p = current_process();
     let context = Box::new(ReceiveContext::new(p.clone(), to));
-    let mbox = p.mailbox.lock();
+    let mbox = p.mailbox();
     mbox.borrow().recv_start();
     Box::into_raw(context)
 }
@@ -113,7 +113,7 @@ pub extern "C" fn builtin_receive_wait(ctx: *mut ReceiveContext) -> ReceiveState
     loop {
         {
             let p = current_process();
-            let mbox_lock = p.mailbox.lock();
+            let mbox_lock = p.mailbox();
             let mut mbox = mbox_lock.borrow_mut();
             if let Some(msg) = mbox.recv_peek() {
                 mbox.recv_increment();
@@ -124,7 +124,7 @@ pub extern "C" fn builtin_receive_wait(ctx: *mut ReceiveContext) -> ReceiveState
                 context.with_timeout();
                 break ReceiveState::Timeout;
             } else {
-                p.wait();
+                p.wait_for_message();
             }
         }
         // We put our yield here to ensure that we're not holding
@@ -148,7 +148,7 @@ pub extern "C" fn builtin_receive_message(ctx: *mut ReceiveContext) -> Term {
 pub extern "C" fn builtin_receive_done(ctx: *mut ReceiveContext) -> bool {
     let result = panic::catch_unwind(|| {
         let p = current_process();
-        let mbox_lock = p.mailbox.lock();
+        let mbox_lock = p.mailbox();
         let mut mbox = mbox_lock.borrow_mut();
 
         let mut context = unsafe { Box::from_raw(ctx) };
@@ -6,6 +6,8 @@ use std::path::Path;
 
 use clap::{App, AppSettings, Arg, SubCommand};
 
+use crate::sys::cpus;
+
 pub type ConfigResult<T> = std::result::Result<T, ConfigError>;
 //TODO: Needs to be HashMap<Atom, HashMap<Atom, Term>>
 pub type AppConfig = HashMap<String, HashMap<String, String>>;
@@ -51,6 +53,14 @@ pub struct Config {
     pub debug: bool,
     pub name: Option<String>,
     pub cookie: Option<String>,
+    /// The number of scheduler threads to run processes on
+    pub schedulers: usize,
+    /// Whether each scheduler thread should be bound to its own CPU
+    pub bind_schedulers: bool,
+    /// The maximum size of a process stack, in KiB
+    pub stack_size: Option<usize>,
+    /// The maximum number of unused process stacks kept by each scheduler for reuse
+    pub stack_pool_size: Option<usize>,
     pub command: Command,
     pub extra: Vec<String>,
 }
@@ -92,6 +102,26 @@ impl Config {
                      .help("The secret cookie to use in distributed mode")
                      .takes_value(true)
                      .env("COOKIE"))
+            .arg(Arg::with_name("schedulers")
+                     .long("schedulers")
+                     .help("The number of scheduler threads to start\n\
+                            Defaults to the number of logical CPUs available")
+                     .takes_value(true)
+                     .validator(is_valid_scheduler_count))
+            .arg(Arg::with_name("bind_schedulers")
+                     .long("bind-schedulers")
+                     .help("Bind each scheduler thread to its own logical CPU"))
+            .arg(Arg::with_name("stack_size")
+                     .long("stack-size")
+                     .help("The maximum size of a process stack, in KiB\n\
+                            Only the part of the stack a process uses is backed by memory")
+                     .takes_value(true)
+                     .validator(is_valid_stack_size))
+            .arg(Arg::with_name("stack_pool_size")
+                     .long("stack-pool-size")
+                     .help("The number of unused process stacks each scheduler keeps for reuse")
+                     .takes_value(true)
+                     .validator(is_valid_stack_pool_size))
             .arg(Arg::with_name("extra")
                      .last(true)
                      .multiple(true)
@@ -132,6 +162,15 @@ impl Config {
             debug: matches.is_present("debug"),
             name: matches.value_of("name").map(|v| v.to_string()),
             cookie: matches.value_of("cookie").map(|v| v.to_string()),
+            schedulers: matches
+                .value_of("schedulers")
+                .map(|v| v.parse().unwrap())
+                .unwrap_or_else(cpus::num_logical),
+            bind_schedulers: matches.is_present("bind_schedulers"),
+            stack_size: matches.value_of("stack_size").map(|v| v.parse().unwrap()),
+            stack_pool_size: matches
+                .value_of("stack_pool_size")
+                .map(|v| v.parse().unwrap()),
             command,
             extra: extra.iter().map(|v| v.to_string()).collect(),
         })
@@ -143,6 +182,27 @@ fn is_valid_node_name(_f: String) -> Result<(), String> {
     Ok(())
 }
 
+fn is_valid_scheduler_count(n: String) -> Result<(), String> {
+    match n.parse::<usize>() {
+        Ok(n) if n > 0 => Ok(()),
+        _ => Err("expected a positive integer".to_string()),
+    }
+}
+
+fn is_valid_stack_size(n: String) -> Result<(), String> {
+    match n.parse::<usize>() {
+        Ok(n) if n > 0 => Ok(()),
+        _ => Err("expected a positive size in KiB".to_string()),
+    }
+}
+
+fn is_valid_stack_pool_size(n: String) -> Result<(), String> {
+    match n.parse::<usize>() {
+        Ok(_) => Ok(()),
+        _ => Err("expected a non-negative integer".to_string()),
+    }
+}
+
 fn with_file<T>(v: Option<&OsStr>, default: T, fun: fn(String) -> T) -> ConfigResult<T> {
     match v {
         None => Ok(default),
@@ -24,7 +24,7 @@ pub mod process;
 pub mod scheduler;
 pub mod sys;
 
-use liblumen_alloc::erts::process::alloc::default_heap_size;
+use liblumen_alloc::erts::process::alloc::{self, default_heap_size};
 
 pub use lumen_rt_core::{
     base, binary_to_string, context, distribution, integer_to_string, proplist, registry, send,
@@ -47,7 +47,7 @@ fn main() -> impl ::std::process::Termination + 'static {
 fn main_internal(name: &str, version: &str, argv: Vec<String>) -> Result<(), ()> {
     self::env::init_argv_from_slice(std::env::args_os()).unwrap();
     // Load system configuration
-    let _config = match Config::from_argv(name.to_string(), version.to_string(), argv) {
+    let config = match Config::from_argv(name.to_string(), version.to_string(), argv) {
         Ok(config) => config,
         Err(err) => {
             panic!("Config error: {}", err);
@@ -58,15 +58,40 @@ fn main_internal(name: &str, version: &str, argv: Vec<String>) -> Result<(), ()>
     let mut bus: Bus<break_handler::Signal> = Bus::new(1);
     // Each thread needs a reader
     let mut rx1 = bus.add_rx();
-    // Initialize the break handler with the bus, which will broadcast on it
-    break_handler::init(bus);
+    // Initialize the break handler with the bus, which will broadcast on it, and wake up
+    // the main thread in case its scheduler is parked
+    break_handler::init(bus, std::thread::current());
 
     // Start logger
     let level_filter = Level::Info.to_level_filter();
     logging::init(level_filter).expect("Unexpected failure initializing logger");
 
+    // Process stacks are sized and pooled before any process is spawned
+    if let Some(stack_size) = config.stack_size {
+        let page_size = liblumen_core::sys::sysconf::pagesize();
+        let pages = (stack_size * 1024 + page_size - 1) / page_size;
+        alloc::set_stack_pages(pages);
+    }
+    if let Some(stack_pool_size) = config.stack_pool_size {
+        alloc::set_stack_pool_capacity(stack_pool_size);
+    }
+
+    // The main thread runs the first scheduler, the rest get their own threads
+    if config.bind_schedulers {
+        sys::cpus::bind_current_thread(0);
+    }
     let scheduler = scheduler::current();
     scheduler.spawn_init(default_heap_size()).unwrap();
+
+    let scheduler_threads =
+        match scheduler::SchedulerThreads::spawn(config.schedulers - 1, config.bind_schedulers) {
+            Ok(threads) => threads,
+            Err(err) => {
+                eprintln!("System error: unable to start schedulers: {}", err);
+                return Err(());
+            }
+        };
+
     loop {
         // Run the scheduler for a cycle
         let scheduled = scheduler.run_once();
@@ -100,10 +125,17 @@ fn main_internal(name: &str, version: &str, argv: Vec<String>) -> Result<(), ()>
         if scheduled {
             continue;
         }
-
-        break;
+        // Otherwise there was nothing to run or steal, but other schedulers may still
+        // be running processes which can spawn more work, or processes may be waiting
+        if scheduler::live_processes() == 0 {
+            break;
+        }
+        // Sleep until there is work, a timer is due, or a signal arrives
+        scheduler::park();
     }
 
+    scheduler_threads.stop();
+
     match scheduler.shutdown() {
         Ok(_) => Ok(()),
         Err(err) => {
@@ -1,12 +1,18 @@
+mod run_queue;
+
 use std::alloc::Layout;
 use std::any::Any;
 use std::ffi::c_void;
 use std::fmt::{self, Debug};
+use std::io;
 use std::mem;
 use std::ptr::{self, NonNull};
-use std::sync::atomic::{AtomicU64, Ordering};
-use std::sync::Arc;
+use std::sync::atomic::{self, AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Weak};
+use std::thread::{self, Thread};
+use std::time::Duration;
 
+use lazy_static::lazy_static;
 use log::info;
 
 use liblumen_core::locks::RwLock;
@@ -14,6 +20,7 @@ use liblumen_core::sys::dynamic_call::DynamicCallee;
 use liblumen_core::util::thread_local::ThreadLocalCell;
 
 use liblumen_alloc::erts::exception::ErlangException;
+use liblumen_alloc::erts::process::ffi::set_process_heap;
 use liblumen_alloc::erts::process::{CalleeSavedRegisters, Priority, Process, Status};
 use liblumen_alloc::erts::scheduler::{id, ID};
 use liblumen_alloc::erts::term::prelude::*;
@@ -24,12 +31,17 @@ use lumen_rt_core::process::spawn::options::Options;
 use lumen_rt_core::process::{log_exit, propagate_exit, CURRENT_PROCESS};
 use lumen_rt_core::registry::put_pid_to_process;
 use lumen_rt_core::scheduler::Scheduler as SchedulerTrait;
-use lumen_rt_core::scheduler::{self, run_queue, unregister, Run};
+use lumen_rt_core::scheduler::{self, unregister, Run};
 pub use lumen_rt_core::scheduler::{
     current, from_id, run_through, Scheduled, SchedulerDependentAlloc, Spawned,
 };
+use lumen_rt_core::time::monotonic;
 use lumen_rt_core::timer::Hierarchy;
 
+use crate::sys::cpus;
+
+use self::run_queue::RunQueues;
+
 // External thread locals owned by the generated code
 extern "C" {
     #[thread_local]
@@ -57,6 +69,114 @@ crate fn stop_waiting(process: &Process) {
     }
 }
 
+lazy_static! {
+    /// All of the schedulers in the system, which idle schedulers steal work from
+    static ref SCHEDULERS: RwLock<Vec<Weak<Scheduler>>> = Default::default();
+}
+
+/// The number of processes which have been spawned and have not yet exited
+static LIVE_PROCESSES: AtomicUsize = AtomicUsize::new(0);
+
+/// Set when the scheduler threads should stop
+static SHUTDOWN: AtomicBool = AtomicBool::new(false);
+
+/// The number of schedulers which are parked, or about to park
+static PARKED: AtomicUsize = AtomicUsize::new(0);
+
+/// Returns the number of processes which have been spawned and have not yet exited,
+/// the system is done when this reaches zero
+pub fn live_processes() -> usize {
+    LIVE_PROCESSES.load(Ordering::Acquire)
+}
+
+/// The threads running schedulers in addition to the scheduler of the main thread
+pub struct SchedulerThreads {
+    handles: Vec<thread::JoinHandle<()>>,
+}
+impl SchedulerThreads {
+    /// Starts `count` additional scheduler threads, binding the `n`th scheduler to
+    /// the `n`th CPU if `bind` is set. The main thread's scheduler is scheduler 0.
+    pub fn spawn(count: usize, bind: bool) -> io::Result<Self> {
+        let mut handles = Vec::with_capacity(count);
+        for n in 1..=count {
+            let handle = thread::Builder::new()
+                .name(format!("scheduler-{}", n))
+                .spawn(move || {
+                    if bind {
+                        cpus::bind_current_thread(n);
+                    }
+                    run_scheduler_thread()
+                })?;
+            handles.push(handle);
+        }
+
+        Ok(Self { handles })
+    }
+
+    /// Signals all scheduler threads to stop, and waits for them to do so
+    pub fn stop(self) {
+        SHUTDOWN.store(true, Ordering::SeqCst);
+        for handle in self.handles {
+            handle.thread().unpark();
+            let _ = handle.join();
+        }
+    }
+}
+
+fn run_scheduler_thread() {
+    let arc_dyn_scheduler = current();
+    let scheduler = arc_dyn_scheduler
+        .as_any()
+        .downcast_ref::<Scheduler>()
+        .unwrap();
+    while !SHUTDOWN.load(Ordering::Acquire) {
+        if !scheduler.run_once() {
+            // Nothing to run here or elsewhere
+            scheduler.park();
+        }
+    }
+    if let Err(err) = scheduler.shutdown() {
+        eprintln!("System error: {}", err);
+    }
+}
+
+/// Parks the current scheduler's thread until there is work for it, see `Scheduler::park`
+pub fn park() {
+    current()
+        .as_any()
+        .downcast_ref::<Scheduler>()
+        .unwrap()
+        .park()
+}
+
+/// Returns the schedulers in the system
+///
+/// They are upgraded up front, so that a scheduler can't be dropped while the
+/// registry is locked, as dropping it takes the lock
+fn schedulers() -> Vec<Arc<Scheduler>> {
+    SCHEDULERS.read().iter().filter_map(Weak::upgrade).collect()
+}
+
+/// Wakes up a parked scheduler, if any, so that it can steal work
+fn unpark_idle_scheduler() {
+    if PARKED.load(Ordering::SeqCst) == 0 {
+        return;
+    }
+    if let Some(scheduler) = schedulers()
+        .into_iter()
+        .find(|scheduler| scheduler.parked.load(Ordering::SeqCst))
+    {
+        scheduler.unpark();
+    }
+}
+
+/// Wakes up all parked schedulers, so they can notice that the system is done
+fn unpark_all_schedulers() {
+    for scheduler in schedulers() {
+        scheduler.unpark();
+    }
+}
+
 #[derive(Copy, Clone)]
 struct StackPointer(*mut u64);
 
@@ -129,10 +249,46 @@ pub unsafe extern "C" fn builtin_malloc(kind: u32, arity: usize) -> *mut u8 {
     }
 }
 
+/// Slow path for inline heap allocation in generated code, called when the
+/// young heap of the current process cannot fit a reservation of `bytes`.
+///
+/// The reservation is satisfied from a heap fragment if necessary, in which
+/// case the process is signaled to collect at its next opportunity.
+#[unwind(allowed)]
+#[export_name = "__lumen_builtin_heap_reserve"]
+pub unsafe extern "C" fn builtin_heap_reserve(bytes: usize) -> *mut u8 {
+    use liblumen_alloc::erts::process::ffi::{set_process_signal, ProcessSignal};
+    use liblumen_core::sys::sysconf::MIN_ALIGN;
+
+    let arc_dyn_scheduler = scheduler::current();
+    let s = arc_dyn_scheduler
+        .as_any()
+        .downcast_ref::<Scheduler>()
+        .unwrap();
+    let process = &s.current;
+    let layout = Layout::from_size_align_unchecked(bytes, MIN_ALIGN);
+
+    let result = process.alloc_nofrag_layout(layout.clone()).or_else(|_| {
+        let frag_result = process.alloc_fragment_layout(layout);
+        if frag_result.is_ok() {
+            set_process_signal(ProcessSignal::GarbageCollect);
+        }
+        frag_result
+    });
+
+    match result {
+        Ok(nn) => nn.as_ptr() as *mut u8,
+        Err(_) => ptr::null_mut(),
+    }
+}
+
 #[unwind(allowed)]
 #[export_name = "lumen_rt_scheduler_unregistered"]
 fn unregistered() -> Arc<dyn lumen_rt_core::scheduler::Scheduler> {
-    Arc::new(Scheduler::new().unwrap())
+    let scheduler = Arc::new(Scheduler::new().unwrap());
+    SCHEDULERS.write().push(Arc::downgrade(&scheduler));
+
+    scheduler
 }
 
 pub struct Scheduler {
@@ -140,13 +296,17 @@ pub struct Scheduler {
     pub hierarchy: RwLock<Hierarchy>,
     // References are always 64-bits even on 32-bit platforms
     reference_count: AtomicU64,
-    run_queues: RwLock<run_queue::Queues>,
+    run_queues: RunQueues,
     // Non-monotonic unique integers are scoped to the scheduler ID and then use this per-scheduler
     // `u64`.
     unique_integer: AtomicU64,
     root: Arc<Process>,
     init: ThreadLocalCell<Arc<Process>>,
     current: ThreadLocalCell<Arc<Process>>,
+    /// The thread running this scheduler, used to unpark it
+    thread: Thread,
+    /// Set while the scheduler is parked, or about to park
+    parked: AtomicBool,
 }
 // This guarantee holds as long as `init` and `current` are only
 // ever accessed by the scheduler when scheduling
@@ -170,7 +330,7 @@ impl Scheduler {
             ptr::null_mut(),
             0,
         ));
-        let run_queues = Default::default();
+        let run_queues = RunQueues::new();
         Scheduler::spawn_root(root.clone(), id, &run_queues)?;
 
         // Placeholder
@@ -198,13 +358,66 @@ impl Scheduler {
             hierarchy: Default::default(),
             reference_count: AtomicU64::new(0),
             unique_integer: AtomicU64::new(0),
+            thread: thread::current(),
+            parked: AtomicBool::new(false),
         })
     }
 
-    /// Returns true if the given process is in the current scheduler's run queue
-    #[cfg(test)]
-    pub fn is_run_queued(&self, value: &Arc<Process>) -> bool {
-        self.run_queues.read().contains(value)
+    /// Parks the scheduler's thread until a process is made runnable on it, another
+    /// scheduler has work to steal, or the next timer is due.
+    ///
+    /// Work may have been injected into another scheduler's queues after this one last
+    /// looked, so it tries to steal once more after announcing that it is parking, as
+    /// the injecting thread only wakes schedulers it sees parked.
+    ///
+    /// Must only be called by the scheduler's own thread.
+    pub fn park(&self) {
+        let next_timeout = self.hierarchy.read().next_timeout();
+
+        self.parked.store(true, Ordering::SeqCst);
+        PARKED.fetch_add(1, Ordering::SeqCst);
+        // Pairs with the fence in `unpark`, so that either the work that was made
+        // available is seen here, or `parked` is seen there
+        atomic::fence(Ordering::SeqCst);
+
+        let done = SHUTDOWN.load(Ordering::SeqCst) || LIVE_PROCESSES.load(Ordering::SeqCst) == 0;
+        if !done && !self.run_queues.has_runnable() && !self.steal() {
+            match next_timeout {
+                Some(next_timeout) => {
+                    if let Some(milliseconds) = next_timeout.checked_sub(monotonic::time()) {
+                        thread::park_timeout(Duration::from_millis(milliseconds.as_u64()));
+                    }
+                }
+                None => thread::park(),
+            }
+        }
+
+        PARKED.fetch_sub(1, Ordering::SeqCst);
+        self.parked.store(false, Ordering::SeqCst);
+    }
+
+    /// Wakes up a scheduler to run a process just injected into this scheduler's queues,
+    /// this may be called from any thread
+    ///
+    /// If this scheduler is busy, an idle one is woken instead, so that it can steal the
+    /// process rather than leave it waiting for this scheduler's current process to yield.
+    fn notify_injected(&self) {
+        // Pairs with the fence in `park`, so that either the parking scheduler sees the
+        // injected process when it steals, or it is seen parked here
+        atomic::fence(Ordering::SeqCst);
+        if self.parked.load(Ordering::SeqCst) {
+            self.unpark();
+        } else {
+            unpark_idle_scheduler();
+        }
+    }
+
+    /// Wakes up the scheduler if it is parked, this may be called from any thread
+    fn unpark(&self) {
+        atomic::fence(Ordering::SeqCst);
+        if self.parked.load(Ordering::SeqCst) {
+            self.thread.unpark();
+        }
     }
 }
 impl Debug for Scheduler {
@@ -220,6 +433,9 @@ impl Debug for Scheduler {
 impl Drop for Scheduler {
     fn drop(&mut self) {
         unregister(&self.id);
+        SCHEDULERS
+            .write()
+            .retain(|scheduler| scheduler.strong_count() > 0);
     }
 }
 impl PartialEq for Scheduler {
@@ -254,11 +470,11 @@ impl SchedulerTrait for Scheduler {
     }
 
     fn run_queue_len(&self, priority: Priority) -> usize {
-        self.run_queues.read().run_queue_len(priority)
+        self.run_queues.run_queue_len(priority)
     }
 
     fn run_queues_len(&self) -> usize {
-        self.run_queues.read().len()
+        self.run_queues.len()
     }
 
     fn schedule(&self, process: Process) -> Arc<Process> {
@@ -273,8 +489,12 @@ impl SchedulerTrait for Scheduler {
 
         let arc_process = Arc::new(process);
 
-        self.run_queues.write().enqueue(arc_process.clone());
+        // The process can be stolen and run as soon as it is enqueued, so it must be
+        // registered first
         put_pid_to_process(&arc_process);
+        LIVE_PROCESSES.fetch_add(1, Ordering::AcqRel);
+        self.run_queues.inject(arc_process.clone());
+        self.notify_injected();
 
         arc_process
     }
@@ -392,7 +612,28 @@ impl SchedulerTrait for Scheduler {
 
     fn stop_waiting(&self, process: &Process) {
         process.stop_waiting();
-        self.run_queues.write().stop_waiting(process);
+
+        // The process may have been stolen by another scheduler since the caller looked
+        // up its scheduler, but it can't migrate again once it is waiting, so now that
+        // its status has been changed, look it up again
+        match process.scheduler_id() {
+            Some(id) if id != self.id => {
+                if let Some(arc_dyn_scheduler) = from_id(&id) {
+                    let scheduler = arc_dyn_scheduler
+                        .as_any()
+                        .downcast_ref::<Scheduler>()
+                        .unwrap();
+                    if scheduler.run_queues.stop_waiting(process) {
+                        scheduler.notify_injected();
+                    }
+                }
+            }
+            _ => {
+                if self.run_queues.stop_waiting(process) {
+                    self.notify_injected();
+                }
+            }
+        }
     }
 }
 
@@ -428,10 +669,7 @@ impl Scheduler {
         self.hierarchy.write().timeout();
 
         loop {
-            let next = {
-                let mut rq = self.run_queues.write();
-                rq.dequeue()
-            };
+            let next = unsafe { self.run_queues.dequeue() };
 
             match next {
                 Run::Now(process) => {
@@ -481,12 +719,8 @@ impl Scheduler {
                     };
 
                     // Try to schedule it for the future
-                    //
-                    // Don't `if let` or `match` on the return from `requeue` as it will keep the
-                    // lock on the `run_queue`, causing a dead lock when `propagate_exit` calls
-                    // `Scheduler::stop_waiting` for any linked or monitoring process.
                     let option_exiting_arc_process =
-                        self.run_queues.write().requeue(requeue_arc_process);
+                        unsafe { self.run_queues.requeue(requeue_arc_process) };
 
                     // If the process is exiting, then handle the exit
                     if let Some(exiting_arc_process) = option_exiting_arc_process {
@@ -500,6 +734,9 @@ impl Scheduler {
                             }
                             _ => unreachable!(),
                         }
+                        if LIVE_PROCESSES.fetch_sub(1, Ordering::AcqRel) == 1 {
+                            unpark_all_schedulers();
+                        }
                     }
 
                     info!("exiting scheduler loop after run");
@@ -512,21 +749,26 @@ impl Scheduler {
                     info!("found process, but it is delayed");
                     continue;
                 }
+                Run::Waiting if self.steal() => {
+                    info!("all processes are waiting, stole a process to run");
+                    continue;
+                }
                 Run::Waiting => {
                     info!("exiting scheduler loop because waiting");
-                    // Return to main scheduler loop to check for signals and to re-enter from
-                    // `run_once` and increment timeouts to knock out of waiting.
-                    break true;
+                    // Return to main scheduler loop to check for signals, and to park until
+                    // a timer or another process knocks a process out of waiting.
+                    break false;
                 }
                 Run::None if self.current.pid() == self.root.pid() => {
+                    if self.steal() {
+                        info!("no processes remaining to schedule, stole a process to run");
+                        continue;
+                    }
                     info!("no processes remaining to schedule, exiting loop");
-                    // If no processes are available, then the scheduler should steal,
-                    // but if it can't/doesn't, then it must terminate, as there is
-                    // nothing we can swap to. When we break here, we're returning
-                    // to the core scheduler loop, which _must_ terminate, if it does
-                    // not, we'll just end up right back here again.
-                    //
-                    // TODO: stealing
+                    // If no processes are available here or on any other scheduler, then
+                    // there is nothing we can swap to. When we break here, we're returning
+                    // to the core scheduler loop, which decides whether to wait for more
+                    // work or to terminate.
                     break false;
                 }
                 Run::None => unreachable!(),
@@ -534,6 +776,38 @@ impl Scheduler {
         }
     }
 
+    /// Steals a runnable process from another scheduler, and migrates it to this one
+    ///
+    /// Returns `true` if a process was stolen
+    fn steal(&self) -> bool {
+        let schedulers = schedulers();
+        let len = schedulers.len();
+        // Start with the scheduler after this one, so that idle schedulers don't all
+        // converge on the same victim
+        let start = schedulers
+            .iter()
+            .position(|scheduler| scheduler.id == self.id)
+            .map(|position| position + 1)
+            .unwrap_or(0);
+
+        for victim in schedulers.iter().cycle().skip(start).take(len) {
+            if victim.id == self.id {
+                continue;
+            }
+            if let Some(arc_process) = victim.run_queues.steal() {
+                info!("stole process {:?}", arc_process.pid());
+                arc_process.schedule_with(self.id);
+                unsafe {
+                    self.run_queues.enqueue(arc_process);
+                }
+
+                return true;
+            }
+        }
+
+        false
+    }
+
     /// This function takes care of coordinating the scheduling of a new
     /// process/descheduling of the current process.
     ///
@@ -552,6 +826,8 @@ impl Scheduler {
             let mut new_status = new.status.write();
             *new_status = Status::Running;
         }
+        // Point generated code at the new process heap
+        set_process_heap(new.heap_bump_region());
 
         // Replace the previous process with the new as the currently scheduled process
         let _ = CURRENT_PROCESS.with(|cp| cp.replace(Some(new.clone())));
@@ -593,11 +869,12 @@ impl Scheduler {
     fn spawn_root(
         process: Arc<Process>,
         id: id::ID,
-        _run_queues: &RwLock<run_queue::Queues>,
+        _run_queues: &RunQueues,
     ) -> anyhow::Result<()> {
         process.schedule_with(id);
 
         *process.status.write() = Status::Running;
+        set_process_heap(process.heap_bump_region());
 
         let r13 = &process.registers.r13 as *const u64 as *mut _;
         unsafe {
@@ -0,0 +1,290 @@
+use std::collections::HashSet;
+use std::fmt::{self, Debug};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Arc;
+
+use crossbeam_deque::{Injector, Steal, Stealer, Worker};
+
+use liblumen_core::locks::Mutex;
+use liblumen_core::util::thread_local::ThreadLocalCell;
+
+use liblumen_alloc::erts::process::{Priority, Process, Status};
+
+use lumen_rt_core::scheduler::Run;
+
+/// The run queues of a single scheduler
+///
+/// Runnable processes are kept in a FIFO deque per priority, which is only pushed to and
+/// popped from by the scheduler which owns it, while other schedulers steal from the
+/// opposite end when they run out of work of their own. None of these operations take a
+/// lock.
+///
+/// Processes which become runnable on other threads, i.e. when spawned, or when woken up
+/// by a message, are pushed to the injector queue, which the owning scheduler drains into
+/// its deques before dequeuing, and which can also be stolen from.
+///
+/// Waiting processes are not runnable, so they are never stolen, and stay with the
+/// scheduler they last ran on until they are woken up.
+pub struct RunQueues {
+    max: ThreadLocalCell<Worker<Arc<Process>>>,
+    high: ThreadLocalCell<Worker<Arc<Process>>>,
+    normal_low: ThreadLocalCell<Worker<DelayedProcess>>,
+    max_stealer: Stealer<Arc<Process>>,
+    high_stealer: Stealer<Arc<Process>>,
+    normal_low_stealer: Stealer<DelayedProcess>,
+    injector: Injector<Arc<Process>>,
+    waiting: Mutex<HashSet<Arc<Process>>>,
+    /// The number of runnable processes in the queues, by priority
+    max_len: AtomicUsize,
+    high_len: AtomicUsize,
+    normal_low_len: AtomicUsize,
+}
+impl RunQueues {
+    pub fn new() -> Self {
+        let max = Worker::new_fifo();
+        let high = Worker::new_fifo();
+        let normal_low = Worker::new_fifo();
+
+        Self {
+            max_stealer: max.stealer(),
+            high_stealer: high.stealer(),
+            normal_low_stealer: normal_low.stealer(),
+            max: ThreadLocalCell::new(max),
+            high: ThreadLocalCell::new(high),
+            normal_low: ThreadLocalCell::new(normal_low),
+            injector: Injector::new(),
+            waiting: Mutex::new(HashSet::new()),
+            max_len: AtomicUsize::new(0),
+            high_len: AtomicUsize::new(0),
+            normal_low_len: AtomicUsize::new(0),
+        }
+    }
+
+    pub fn run_queue_len(&self, priority: Priority) -> usize {
+        self.len_for(priority).load(Ordering::Relaxed)
+    }
+
+    /// Returns `true` if any process in the queues is ready to run
+    pub fn has_runnable(&self) -> bool {
+        self.runnable_len() > 0
+    }
+
+    /// Returns the number of processes in the queues, including waiting processes
+    pub fn len(&self) -> usize {
+        self.runnable_len() + self.waiting.lock().len()
+    }
+
+    /// Enqueues a process from any thread
+    pub fn inject(&self, arc_process: Arc<Process>) {
+        self.len_for(arc_process.priority)
+            .fetch_add(1, Ordering::Relaxed);
+        self.injector.push(arc_process);
+    }
+
+    /// Enqueues a process on the owning scheduler
+    ///
+    /// # Safety
+    ///
+    /// Must only be called from the thread of the scheduler that owns these queues
+    pub unsafe fn enqueue(&self, arc_process: Arc<Process>) {
+        self.len_for(arc_process.priority)
+            .fetch_add(1, Ordering::Relaxed);
+        self.push_local(arc_process);
+    }
+
+    /// Dequeues the next process to run on the owning scheduler
+    ///
+    /// # Safety
+    ///
+    /// Must only be called from the thread of the scheduler that owns these queues
+    pub unsafe fn dequeue(&self) -> Run {
+        // Processes which became runnable elsewhere take their place in line by priority
+        while let Some(arc_process) = steal_one(|| self.injector.steal()) {
+            self.push_local(arc_process);
+        }
+
+        if let Some(arc_process) = self.max.pop() {
+            self.max_len.fetch_sub(1, Ordering::Relaxed);
+            Run::Now(arc_process)
+        } else if let Some(arc_process) = self.high.pop() {
+            self.high_len.fetch_sub(1, Ordering::Relaxed);
+            Run::Now(arc_process)
+        } else if let Some(mut delayed_process) = self.normal_low.pop() {
+            if delayed_process.delay == 0 {
+                self.normal_low_len.fetch_sub(1, Ordering::Relaxed);
+                Run::Now(delayed_process.arc_process)
+            } else {
+                delayed_process.delay -= 1;
+                self.normal_low.push(delayed_process);
+
+                Run::Delayed
+            }
+        } else if !self.waiting.lock().is_empty() {
+            Run::Waiting
+        } else {
+            Run::None
+        }
+    }
+
+    /// Steals a runnable process from these queues, for a scheduler which has run out of work
+    ///
+    /// The caller is responsible for migrating the process to its own scheduler
+    pub fn steal(&self) -> Option<Arc<Process>> {
+        let stolen = steal_one(|| self.injector.steal())
+            .or_else(|| steal_one(|| self.max_stealer.steal()))
+            .or_else(|| steal_one(|| self.high_stealer.steal()))
+            .or_else(|| {
+                steal_one(|| self.normal_low_stealer.steal())
+                    .map(|delayed_process| delayed_process.arc_process)
+            })?;
+        self.len_for(stolen.priority)
+            .fetch_sub(1, Ordering::Relaxed);
+
+        Some(stolen)
+    }
+
+    /// Puts a process which has just run back in the queues, according to its status
+    ///
+    /// Returns the process if it is not pushed back because it is exiting
+    ///
+    /// # Safety
+    ///
+    /// Must only be called from the thread of the scheduler that owns these queues
+    #[must_use]
+    pub unsafe fn requeue(&self, arc_process: Arc<Process>) -> Option<Arc<Process>> {
+        // The status is checked while holding the lock on the waiting set, so that a
+        // concurrent `stop_waiting` either sees the process in the set, or the process
+        // sees the status it set
+        let mut waiting = self.waiting.lock();
+        let next = Next::from_status(&arc_process.status.read());
+
+        match next {
+            Next::Wait => {
+                waiting.insert(arc_process);
+                None
+            }
+            Next::PushBack => {
+                drop(waiting);
+                self.enqueue(arc_process);
+                None
+            }
+            Next::Exit => Some(arc_process),
+        }
+    }
+
+    /// Moves a process which has been woken up from the waiting set to the run queues,
+    /// this may be called from any thread
+    ///
+    /// Returns `true` if the process was waiting in these queues
+    pub fn stop_waiting(&self, process: &Process) -> bool {
+        let woken = self.waiting.lock().take(process);
+        match woken {
+            Some(arc_process) => {
+                self.inject(arc_process);
+                true
+            }
+            None => false,
+        }
+    }
+
+    fn runnable_len(&self) -> usize {
+        self.max_len.load(Ordering::Relaxed)
+            + self.high_len.load(Ordering::Relaxed)
+            + self.normal_low_len.load(Ordering::Relaxed)
+    }
+
+    fn len_for(&self, priority: Priority) -> &AtomicUsize {
+        match priority {
+            Priority::Low | Priority::Normal => &self.normal_low_len,
+            Priority::High => &self.high_len,
+            Priority::Max => &self.max_len,
+        }
+    }
+
+    unsafe fn push_local(&self, arc_process: Arc<Process>) {
+        match arc_process.priority {
+            Priority::Low | Priority::Normal => {
+                self.normal_low.push(DelayedProcess::new(arc_process))
+            }
+            Priority::High => self.high.push(arc_process),
+            Priority::Max => self.max.push(arc_process),
+        }
+    }
+}
+impl Debug for RunQueues {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("RunQueues")
+            .field("max", &self.max_len)
+            .field("high", &self.high_len)
+            .field("normal_low", &self.normal_low_len)
+            .field("waiting", &self.waiting.lock().len())
+            .finish()
+    }
+}
+
+// This is safe to implement as long as the deques are only ever used by the scheduler
+// which owns them, every other operation is safe to use from any thread
+unsafe impl Sync for RunQueues {}
+
+fn steal_one<T>(steal: impl Fn() -> Steal<T>) -> Option<T> {
+    loop {
+        match steal() {
+            Steal::Success(value) => return Some(value),
+            Steal::Empty => return None,
+            Steal::Retry => continue,
+        }
+    }
+}
+
+enum Next {
+    Wait,
+    PushBack,
+    Exit,
+}
+
+impl Next {
+    fn from_status(status: &Status) -> Next {
+        match status {
+            Status::Runnable => Next::PushBack,
+            Status::Waiting => Next::Wait,
+            Status::Exited | Status::RuntimeException(_) => Next::Exit,
+            Status::SystemException(_) => {
+                unreachable!("System exception should have already been cleared")
+            }
+            Status::Running => {
+                unreachable!("Process.stop_running() should have been called before this")
+            }
+            Status::Unrunnable => {
+                unreachable!("runtime::process::runnable(process) show have been called before attempting to run a process with a scheduler")
+            }
+        }
+    }
+}
+
+type Delay = u8;
+
+/// A process in the `Priority::Normal` and `Priority::Low` run queue, which is only run when
+/// its delay is `0`, so that `Priority::Normal` processes are run more often.
+struct DelayedProcess {
+    delay: Delay,
+    arc_process: Arc<Process>,
+}
+
+impl DelayedProcess {
+    fn new(arc_process: Arc<Process>) -> DelayedProcess {
+        DelayedProcess {
+            delay: Self::priority_to_delay(arc_process.priority),
+            arc_process,
+        }
+    }
+
+    fn priority_to_delay(priority: Priority) -> Delay {
+        // BEAM can use pre-decrement (`--p->schedule_count`), but we can't in Rust, so use `delay`
+        // instead of `schedule_count` and decrement only if `Priority::Low`.
+        match priority {
+            Priority::Low => 7,
+            Priority::Normal => 0,
+            _ => unreachable!(),
+        }
+    }
+}
@@ -1,4 +1,4 @@
-use std::thread;
+use std::thread::{self, Thread};
 
 use bus::Bus;
 
@@ -41,7 +41,9 @@ impl From<usize> for Signal {
     }
 }
 
-pub fn init(mut bus: Bus<Signal>) {
+/// Starts the thread which broadcasts signals on `bus`, unparking `main` after each, so
+/// that it notices them even if its scheduler is idle
+pub fn init(mut bus: Bus<Signal>, main: Thread) {
     thread::spawn(move || {
         use signal_hook::iterator::Signals;
 
@@ -61,7 +63,10 @@ pub fn init(mut bus: Bus<Signal>) {
         for signal in signals.forever() {
             match Signal::from(signal as usize) {
                 Signal::Unknown => (),
-                sig => bus.broadcast(sig),
+                sig => {
+                    bus.broadcast(sig);
+                    main.unpark();
+                }
             }
         }
     });
@@ -39,6 +39,40 @@ pub fn num_total() -> usize {
     get_num_cpus()
 }
 
+/// Binds the current thread to the `n`th logical CPU available to this process.
+///
+/// Returns `false` if binding is not supported on this platform, or if it failed,
+/// in which case the thread is left free to run on any CPU.
+#[cfg(target_os = "linux")]
+pub fn bind_current_thread(n: usize) -> bool {
+    let size = std::mem::size_of::<libc::cpu_set_t>();
+    let mut available: libc::cpu_set_t = unsafe { std::mem::zeroed() };
+    if unsafe { libc::sched_getaffinity(0, size, &mut available) } != 0 {
+        return false;
+    }
+
+    // The available CPUs aren't necessarily contiguous, so find the `n`th one
+    let cpu = (0..libc::CPU_SETSIZE as usize)
+        .filter(|i| unsafe { libc::CPU_ISSET(*i, &available) })
+        .nth(n);
+
+    match cpu {
+        Some(cpu) => {
+            let mut set: libc::cpu_set_t = unsafe { std::mem::zeroed() };
+            unsafe {
+                libc::CPU_SET(cpu, &mut set);
+                libc::sched_setaffinity(0, size, &set) == 0
+            }
+        }
+        None => false,
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+pub fn bind_current_thread(_n: usize) -> bool {
+    false
+}
+
 #[cfg(not(any(target_os = "linux", target_os = "windows", target_os = "macos")))]
 #[inline]
 fn get_num_physical_cpus() -> usize {